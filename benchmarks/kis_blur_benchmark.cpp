@@ -36,6 +36,7 @@
 
 #include "kis_selection.h"
 #include <kis_iterator_ng.h>
+#include <kis_gaussian_kernel.h>
 
 void KisBlurBenchmark::initTestCase()
 {
@@ -87,6 +88,30 @@ void KisBlurBenchmark::benchmarkFilter()
     }
 }
 
+void KisBlurBenchmark::benchmarkGaussian_data()
+{
+    QTest::addColumn<qreal>("radius");
+    QTest::addColumn<bool>("useRecursive");
+
+    QTest::newRow("convolution-10") << 10.0 << false;
+    QTest::newRow("recursive-10") << 10.0 << true;
+    QTest::newRow("convolution-50") << 50.0 << false;
+    QTest::newRow("recursive-50") << 50.0 << true;
+    QTest::newRow("convolution-200") << 200.0 << false;
+    QTest::newRow("recursive-200") << 200.0 << true;
+}
+
+void KisBlurBenchmark::benchmarkGaussian()
+{
+    QFETCH(qreal, radius);
+    QFETCH(bool, useRecursive);
 
+    const QRect rc(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+
+    QBENCHMARK{
+        KisPaintDeviceSP dev = new KisPaintDevice(*m_device);
+        KisGaussianKernel::applyGaussian(dev, rc, radius, radius, QBitArray(), 0, useRecursive);
+    }
+}
 
 QTEST_MAIN(KisBlurBenchmark)
@@ -25,6 +25,9 @@
 #include "kis_transaction.h"
 #include <KoCompositeOpRegistry.h>
 #include "kis_datamanager.h"
+#include "kis_pixel_selection.h"
+#include "kis_selection_filters.h"
+#include "kis_morphology.h"
 
 
 #define NUM_CYCLES 50
@@ -290,4 +293,99 @@ void KisFilterSelectionsBenchmark::testBitBltSelections(int num)
         dbgKrita << "bitBlt with sel:\t\t\t" << avTime;
 }
 
+static KisPixelSelectionSP createBigSelection()
+{
+    KisPixelSelectionSP selection = new KisPixelSelection();
+
+    // a few hundreds of random rects, some of them semi-selected
+    srand(31524744);
+
+    for (int i = 0; i < 300; i++) {
+        const QRect rc(rand() % 4000, rand() % 4000,
+                       rand() % 600 + 1, rand() % 600 + 1);
+
+        selection->dataManager()->clear(rc.x(), rc.y(), rc.width(), rc.height(),
+                                        quint8(i % 3 ? 255 : rand() % 256));
+    }
+
+    return selection;
+}
+
+void KisFilterSelectionsBenchmark::testSelectionFilters_data()
+{
+    QTest::addColumn<QString>("filterName");
+    QTest::addColumn<int>("radius");
+
+    const QStringList filters = {"grow", "shrink", "border", "feather"};
+    const QList<int> radii = {1, 10, 100};
+
+    Q_FOREACH (const QString &filterName, filters) {
+        Q_FOREACH (int radius, radii) {
+            QTest::newRow(QString("%1-%2").arg(filterName).arg(radius).toLatin1()) << filterName << radius;
+        }
+    }
+
+    QTest::newRow("erode") << "erode" << 1;
+    QTest::newRow("dilate") << "dilate" << 1;
+}
+
+void KisFilterSelectionsBenchmark::testSelectionFilters()
+{
+    QFETCH(QString, filterName);
+    QFETCH(int, radius);
+
+    KisPixelSelectionSP selection = createBigSelection();
+
+    QScopedPointer<KisSelectionFilter> filter;
+
+    if (filterName == "grow") {
+        filter.reset(new KisGrowSelectionFilter(radius, radius));
+    } else if (filterName == "shrink") {
+        filter.reset(new KisShrinkSelectionFilter(radius, radius, false));
+    } else if (filterName == "border") {
+        filter.reset(new KisBorderSelectionFilter(radius, radius));
+    } else if (filterName == "feather") {
+        filter.reset(new KisFeatherSelectionFilter(radius));
+    } else if (filterName == "erode") {
+        filter.reset(new KisErodeSelectionFilter());
+    } else if (filterName == "dilate") {
+        filter.reset(new KisDilateSelectionFilter());
+    }
+
+    const QRect processRect = filter->changeRect(selection->selectedExactRect());
+
+    QBENCHMARK_ONCE {
+        filter->process(selection, processRect);
+    }
+}
+
+void KisFilterSelectionsBenchmark::testMorphology_data()
+{
+    QTest::addColumn<int>("shape");
+    QTest::addColumn<int>("radius");
+
+    const QList<int> radii = {1, 10, 100, 500};
+
+    Q_FOREACH (int radius, radii) {
+        QTest::newRow(QString("square-%1").arg(radius).toLatin1()) << int(KisMorphology::Square) << radius;
+        QTest::newRow(QString("diamond-%1").arg(radius).toLatin1()) << int(KisMorphology::Diamond) << radius;
+        QTest::newRow(QString("disk-%1").arg(radius).toLatin1()) << int(KisMorphology::Disk) << radius;
+    }
+}
+
+void KisFilterSelectionsBenchmark::testMorphology()
+{
+    QFETCH(int, shape);
+    QFETCH(int, radius);
+
+    KisPixelSelectionSP selection = createBigSelection();
+    const QRect processRect = selection->selectedExactRect().adjusted(-radius, -radius, radius, radius);
+
+    QBENCHMARK_ONCE {
+        KisMorphology::apply(selection, processRect,
+                             KisMorphology::Dilate, KisMorphology::Shape(shape),
+                             radius, radius);
+    }
+}
+
 QTEST_MAIN(KisFilterSelectionsBenchmark)
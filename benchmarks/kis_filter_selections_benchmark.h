@@ -34,6 +34,12 @@ private Q_SLOTS:
 
     void testAll();
 
+    void testSelectionFilters_data();
+    void testSelectionFilters();
+
+    void testMorphology_data();
+    void testMorphology();
+
 private:
     void initSelection();
     void initFilter(const QString &name);
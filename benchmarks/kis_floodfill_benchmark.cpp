@@ -17,6 +17,8 @@
  */
 
 #include <QTest>
+#include <QThread>
+#include <QThreadPool>
 
 #include <kundo2command.h>
 #include "kis_benchmark_values.h"
@@ -32,9 +34,13 @@
 #include "kis_floodfill_benchmark.h"
 
 #include <kis_fill_painter.h>
+#include <kis_pixel_selection.h>
+#include <floodfill/kis_scanline_fill.h>
 
 #include <KoCompositeOps.h>
 
+const int LARGE_IMAGE_SIZE = 8000;
+
 void KisFloodFillBenchmark::initTestCase()
 {
     m_colorSpace = KoColorSpaceRegistry::instance()->rgb8();
@@ -65,7 +71,17 @@ void KisFloodFillBenchmark::initTestCase()
         painter.paintEllipse(x+ 10, y+ 10, tilew, tileh);
     }
 
+    // the same, but large enough for the parallel fill to make sense
+    m_largeDevice = new KisPaintDevice(m_colorSpace);
+    KisPainter largePainter(m_largeDevice);
+    largePainter.setFillStyle(KisPainter::FillStyleForegroundColor);
+    largePainter.setPaintColor(m_color);
 
+    for (int i = 0; i < 40000; i++) {
+        x = rand() % LARGE_IMAGE_SIZE;
+        y = rand() % LARGE_IMAGE_SIZE;
+        largePainter.paintEllipse(x + 10, y + 10, tilew, tileh);
+    }
 }
 
 void KisFloodFillBenchmark::benchmarkFlood()
@@ -104,6 +120,60 @@ void KisFloodFillBenchmark::benchmarkFlood()
     //out.save("fill_output.png");
 }
 
+void KisFloodFillBenchmark::benchmarkFloodLarge_data()
+{
+    QTest::addColumn<bool>("useSelection");
+    QTest::addColumn<int>("numThreads");
+
+    const int idealThreadCount = QThread::idealThreadCount();
+
+    QTest::newRow("color-serial") << false << 0;
+    QTest::newRow("selection-serial") << true << 0;
+
+    for (int numThreads = 1; numThreads < idealThreadCount; numThreads *= 2) {
+        QTest::newRow(QString("color-parallel-%1").arg(numThreads).toLatin1()) << false << numThreads;
+        QTest::newRow(QString("selection-parallel-%1").arg(numThreads).toLatin1()) << true << numThreads;
+    }
+
+    QTest::newRow(QString("color-parallel-%1").arg(idealThreadCount).toLatin1()) << false << idealThreadCount;
+    QTest::newRow(QString("selection-parallel-%1").arg(idealThreadCount).toLatin1()) << true << idealThreadCount;
+}
+
+void KisFloodFillBenchmark::benchmarkFloodLarge()
+{
+    QFETCH(bool, useSelection);
+    QFETCH(int, numThreads);
+
+    const QRect boundingRect(0, 0, LARGE_IMAGE_SIZE, LARGE_IMAGE_SIZE);
+
+    KoColor fg(m_colorSpace);
+    fg.fromQColor(Qt::blue);
+
+    // numThreads == 0 means the old single-threaded scanline fill
+    const int oldMaxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+    if (numThreads > 0) {
+        QThreadPool::globalInstance()->setMaxThreadCount(numThreads);
+    }
+
+    QBENCHMARK {
+        KisPaintDeviceSP dev = new KisPaintDevice(*m_largeDevice);
+
+        KisScanlineFill fill(dev, QPoint(1, 1), boundingRect);
+        fill.setThreshold(15);
+        fill.setParallelMode(numThreads > 0 ?
+                             KisScanlineFill::ParallelAlways :
+                             KisScanlineFill::ParallelNever);
+
+        if (useSelection) {
+            KisPixelSelectionSP selection = new KisPixelSelection();
+            fill.fillSelection(selection);
+        } else {
+            fill.fillColor(fg);
+        }
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(oldMaxThreadCount);
+}
 
 void KisFloodFillBenchmark::cleanupTestCase()
 {
@@ -0,0 +1,133 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <QTest>
+
+#include "kis_kra_loading_benchmark.h"
+
+#include <QDomDocument>
+#include <QUuid>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <kis_image.h>
+#include <kis_kra_loader.h>
+#include <kis_kra_tags.h>
+
+using namespace KRA;
+
+const int NUM_GROUPS = 50;
+const int NUM_LAYERS_PER_GROUP = 99;
+const int MASK_EACH_NTH_LAYER = 10;
+
+namespace {
+
+void writeNode(QXmlStreamWriter &writer, const QString &tag, const QString &nodeType, int index)
+{
+    writer.writeStartElement(tag);
+    writer.writeAttribute(NAME, QString("Node %1").arg(index));
+    writer.writeAttribute(UUID, QUuid::createUuid().toString());
+    writer.writeAttribute(NODE_TYPE, nodeType);
+    writer.writeAttribute(FILE_NAME, QString("layer%1").arg(index));
+    writer.writeAttribute(X, "0");
+    writer.writeAttribute(Y, "0");
+    writer.writeAttribute(OPACITY, "255");
+    writer.writeAttribute(VISIBLE, "1");
+    writer.writeAttribute(LOCKED, "0");
+    writer.writeAttribute(COLLAPSED, "0");
+    writer.writeAttribute(COMPOSITE_OP, "normal");
+    writer.writeAttribute(CHANNEL_FLAGS, "");
+}
+
+}
+
+void KisKraLoadingBenchmark::initTestCase()
+{
+    QXmlStreamWriter writer(&m_mainDoc);
+    writer.setAutoFormatting(true);
+
+    writer.writeStartDocument();
+    writer.writeDTD("<!DOCTYPE DOC PUBLIC '-//KDE//DTD krita 2.0//EN' 'http://www.calligra.org/DTD/krita-2.0.dtd'>");
+    writer.writeStartElement("DOC");
+    writer.writeAttribute("syntaxVersion", "2");
+
+    writer.writeStartElement("IMAGE");
+    writer.writeAttribute(NAME, "benchmark");
+    writer.writeAttribute(MIME, NATIVE_MIMETYPE);
+    writer.writeAttribute(WIDTH, "1000");
+    writer.writeAttribute(HEIGHT, "1000");
+    writer.writeAttribute(COLORSPACE_NAME, "RGBA");
+
+    int index = 0;
+
+    writer.writeStartElement(LAYERS);
+    for (int i = 0; i < NUM_GROUPS; i++) {
+        writeNode(writer, LAYER, GROUP_LAYER, index++);
+        writer.writeStartElement(LAYERS);
+
+        for (int j = 0; j < NUM_LAYERS_PER_GROUP; j++) {
+            writeNode(writer, LAYER, PAINT_LAYER, index++);
+
+            if (j % MASK_EACH_NTH_LAYER == 0) {
+                writer.writeStartElement(MASKS);
+                writeNode(writer, MASK, TRANSPARENCY_MASK, index++);
+                writer.writeEndElement();
+                writer.writeEndElement();
+            }
+
+            writer.writeEndElement();
+        }
+
+        writer.writeEndElement();
+        writer.writeEndElement();
+    }
+    writer.writeEndElement();
+
+    writer.writeEndElement();
+    writer.writeEndElement();
+    writer.writeEndDocument();
+
+    qDebug() << "Generated maindoc.xml with" << index << "nodes," << m_mainDoc.size() << "bytes";
+}
+
+void KisKraLoadingBenchmark::benchmarkDomLoading()
+{
+    QBENCHMARK {
+        QDomDocument doc;
+        QVERIFY(doc.setContent(m_mainDoc));
+
+        KisKraLoader loader(0, 2);
+        KisImageSP image = loader.loadXML(doc.documentElement().firstChildElement("IMAGE"));
+        QVERIFY(image);
+    }
+}
+
+void KisKraLoadingBenchmark::benchmarkStreamLoading()
+{
+    QBENCHMARK {
+        QXmlStreamReader reader(m_mainDoc);
+        QVERIFY(reader.readNextStartElement());
+        QVERIFY(reader.readNextStartElement());
+
+        KisKraLoader loader(0, 2);
+        KisImageSP image = loader.loadXML(reader);
+        QVERIFY(image);
+    }
+}
+
+QTEST_MAIN(KisKraLoadingBenchmark)
@@ -144,6 +144,18 @@ void KisStrokeBenchmark::pixelbrush300pxRL()
     benchmarkRandomLines(presetFileName);
 }
 
+void KisStrokeBenchmark::pixelbrush300pxSpacing002()
+{
+    QString presetFileName = "autobrush_300px_spacing002.kpp";
+    benchmarkStroke(presetFileName);
+}
+
+void KisStrokeBenchmark::pixelbrush300pxSpacing002RL()
+{
+    QString presetFileName = "autobrush_300px_spacing002.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
 
 void KisStrokeBenchmark::sprayPixels()
 {
@@ -324,9 +336,45 @@ void KisStrokeBenchmark::colorsmudge()
 void KisStrokeBenchmark::colorsmudgeRL()
 {
     QString presetFileName = "colorsmudge.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
+void KisStrokeBenchmark::colorsmudgeSmearing()
+{
+    QString presetFileName = "colorsmudge_smearing_30px.kpp";
+    benchmarkStroke(presetFileName);
+}
+
+void KisStrokeBenchmark::colorsmudgeSmearingRL()
+{
+    QString presetFileName = "colorsmudge_smearing_30px.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
+void KisStrokeBenchmark::colorsmudgeDulling()
+{
+    QString presetFileName = "colorsmudge_dulling_30px.kpp";
+    benchmarkStroke(presetFileName);
+}
+
+void KisStrokeBenchmark::colorsmudgeDullingRL()
+{
+    QString presetFileName = "colorsmudge_dulling_30px.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
+void KisStrokeBenchmark::colorsmudgeOverlay()
+{
+    QString presetFileName = "colorsmudge_overlay_30px.kpp";
     benchmarkStroke(presetFileName);
 }
 
+void KisStrokeBenchmark::colorsmudgeOverlayRL()
+{
+    QString presetFileName = "colorsmudge_overlay_30px.kpp";
+    benchmarkRandomLines(presetFileName);
+}
+
 /*
 void KisStrokeBenchmark::predefinedBrush()
 {
@@ -72,6 +72,8 @@ private Q_SLOTS:
     // AutoBrush
     void pixelbrush300px();
     void pixelbrush300pxRL();
+    void pixelbrush300pxSpacing002();
+    void pixelbrush300pxSpacing002RL();
 
     // Soft brush benchmarks
     void softbrushDefault30();
@@ -120,6 +122,15 @@ private Q_SLOTS:
 
     void colorsmudge();
     void colorsmudgeRL();
+
+    void colorsmudgeSmearing();
+    void colorsmudgeSmearingRL();
+
+    void colorsmudgeDulling();
+    void colorsmudgeDullingRL();
+
+    void colorsmudgeOverlay();
+    void colorsmudgeOverlayRL();
 /*
     void predefinedBrush();
     void predefinedBrushRL();
@@ -0,0 +1,259 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <QTest>
+
+#include "kis_stroke_replay_benchmark.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include <KoCompositeOpRegistry.h>
+#include <KoCanvasResourceManager.h>
+
+#include <KisDocument.h>
+#include <KisPart.h>
+#include <kis_global.h>
+#include <kis_image.h>
+#include <kis_paint_layer.h>
+#include <kis_distance_information.h>
+#include <brushengine/kis_paint_information.h>
+#include <brushengine/kis_paintop_preset.h>
+
+#include "kis_canvas_resource_provider.h"
+#include "kis_resources_snapshot.h"
+#include "strokes/freehand_stroke.h"
+#include "kis_stroke_recording.h"
+#include "stroke_testing_utils.h"
+
+// the same intervals as KisToolFreehandHelper uses
+const qreal SPACING_UPDATE_INTERVAL = 50.0;
+const qreal TIMING_UPDATE_INTERVAL = 50.0;
+
+const QString DEFAULT_PRESET_FILE_NAME = "softbrush_30px.kpp";
+
+
+struct ReplayStatistics {
+    ReplayStatistics() : numDabs(0), paintTime(0), mergeTime(0) {}
+
+    int numDabs;
+    qint64 paintTime;
+    qint64 mergeTime;
+};
+
+/**
+ * Measures the time spent in the dab jobs and in the final merge
+ * of the indirect painting device
+ */
+class ReplayStrokeStrategy : public FreehandStrokeStrategy
+{
+public:
+    ReplayStrokeStrategy(KisResourcesSnapshotSP resources,
+                         PainterInfo *painterInfo,
+                         ReplayStatistics *stats)
+        : FreehandStrokeStrategy(resources->needsIndirectPainting(),
+                                 resources->indirectPaintingCompositeOp(),
+                                 resources, painterInfo,
+                                 kundo2_noi18n("replay stroke")),
+          m_stats(stats)
+    {
+    }
+
+    void doStrokeCallback(KisStrokeJobData *data) override {
+        QElapsedTimer timer;
+        timer.start();
+
+        FreehandStrokeStrategy::doStrokeCallback(data);
+
+        m_stats->paintTime += timer.nsecsElapsed();
+    }
+
+    void finishStrokeCallback() override {
+        m_stats->numDabs = painterInfos().first()->dragDistance->numPaintedDabs();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        FreehandStrokeStrategy::finishStrokeCallback();
+
+        m_stats->mergeTime = timer.nsecsElapsed();
+    }
+
+private:
+    ReplayStatistics *m_stats;
+};
+
+KisStrokeRecording::Stroke syntheticStroke(const QSize &size, int seed)
+{
+    KisStrokeRecording::Stroke stroke;
+
+    const int numEvents = 400;
+    const qreal eventInterval = 5.0;
+
+    const qreal y0 = size.height() * (0.2 + 0.15 * (seed % 5));
+    const qreal amplitude = 0.1 * size.height();
+
+    for (int i = 0; i < numEvents; i++) {
+        const qreal t = qreal(i) / (numEvents - 1);
+        const QPointF pos(size.width() * (0.05 + 0.9 * t),
+                          y0 + amplitude * std::sin(t * 4 * M_PI + seed));
+        const qreal pressure = 0.2 + 0.8 * std::sin(t * M_PI);
+
+        stroke.events.append(
+            KisPaintInformation(pos, pressure, 0, 0, 0, 0, 1.0, i * eventInterval, 0));
+    }
+
+    return stroke;
+}
+
+KisNodeSP findPaintLayer(KisNodeSP node)
+{
+    if (dynamic_cast<KisPaintLayer*>(node.data())) return node;
+
+    for (KisNodeSP child = node->firstChild(); child; child = child->nextSibling()) {
+        KisNodeSP layer = findPaintLayer(child);
+        if (layer) return layer;
+    }
+
+    return 0;
+}
+
+KisPaintOpPresetSP loadPreset(const QString &fileName)
+{
+    QString fullFileName = fileName;
+
+    if (!QFileInfo(fullFileName).exists()) {
+        fullFileName = QString(FILES_DATA_DIR) + QDir::separator() + fileName;
+    }
+
+    KisPaintOpPresetSP preset = new KisPaintOpPreset(fullFileName);
+    return preset->load() ? preset : 0;
+}
+
+void KisStrokeReplayBenchmark::benchmarkReplay()
+{
+    const QString recordingFileName = QString::fromLocal8Bit(qgetenv("KRITA_REPLAY_RECORDING"));
+    const QString imageFileName = QString::fromLocal8Bit(qgetenv("KRITA_REPLAY_IMAGE"));
+    QString presetFileName = QString::fromLocal8Bit(qgetenv("KRITA_REPLAY_PRESET"));
+
+    if (presetFileName.isEmpty()) {
+        presetFileName = DEFAULT_PRESET_FILE_NAME;
+    }
+
+    QScopedPointer<KisDocument> doc;
+    KisImageSP image;
+
+    if (!imageFileName.isEmpty()) {
+        doc.reset(KisPart::instance()->createDocument());
+        QVERIFY(doc->loadNativeFormat(imageFileName));
+        image = doc->image();
+    } else {
+        image = utils::createImage(0, QSize(3000, 2000));
+    }
+
+    QList<KisStrokeRecording::Stroke> strokes;
+
+    if (!recordingFileName.isEmpty()) {
+        KisStrokeRecording recording;
+        QVERIFY(recording.load(recordingFileName));
+
+        for (int i = 0; i < recording.numStrokes(); i++) {
+            if (recording.stroke(i).events.isEmpty()) continue;
+            strokes.append(recording.stroke(i));
+        }
+    } else {
+        for (int i = 0; i < 5; i++) {
+            strokes.append(syntheticStroke(image->bounds().size(), i));
+        }
+    }
+
+    KisPaintOpPresetSP preset = loadPreset(presetFileName);
+    QVERIFY(preset);
+
+    KisNodeSP node = findPaintLayer(image->root());
+    QVERIFY(node);
+
+    QScopedPointer<KoCanvasResourceManager> manager(
+        utils::createResourceManager(image, node, QString()));
+
+    QVariant i;
+    i.setValue(preset);
+    manager->setResource(KisCanvasResourceProvider::CurrentPaintOpPreset, i);
+
+    qint64 totalDabs = 0;
+    qint64 totalTime = 0;
+
+    for (int strokeIndex = 0; strokeIndex < strokes.size(); strokeIndex++) {
+        const KisStrokeRecording::Stroke &stroke = strokes[strokeIndex];
+        const KisPaintInformation &first = stroke.events.first();
+
+        KisResourcesSnapshotSP resources = new KisResourcesSnapshot(image, node, manager.data());
+
+        KisDistanceInitInfo startDistInfo(first.pos(),
+                                          first.currentTime(),
+                                          stroke.startAngle,
+                                          resources->needsSpacingUpdates() ? SPACING_UPDATE_INTERVAL : LONG_TIME,
+                                          resources->needsAirbrushing() ? TIMING_UPDATE_INTERVAL : LONG_TIME);
+
+        ReplayStatistics stats;
+
+        QElapsedTimer wallTimer;
+        wallTimer.start();
+
+        KisStrokeStrategy *strategy =
+            new ReplayStrokeStrategy(resources,
+                                     new KisPainterBasedStrokeStrategy::PainterInfo(startDistInfo.makeDistInfo()),
+                                     &stats);
+
+        KisStrokeId strokeId = image->startStroke(strategy);
+
+        if (stroke.events.size() == 1) {
+            image->addJob(strokeId, new FreehandStrokeStrategy::Data(node, 0, first));
+        } else {
+            for (int j = 1; j < stroke.events.size(); j++) {
+                image->addJob(strokeId,
+                              new FreehandStrokeStrategy::Data(node, 0,
+                                                               stroke.events[j - 1],
+                                                               stroke.events[j]));
+            }
+        }
+
+        image->endStroke(strokeId);
+        image->waitForDone();
+
+        const qint64 wallTime = wallTimer.nsecsElapsed();
+        const qreal paintTimeSec = qreal(stats.paintTime) / 1e9;
+
+        qDebug() << "stroke" << strokeIndex
+                 << "events:" << stroke.events.size()
+                 << "dabs:" << stats.numDabs
+                 << "dabs/s:" << (paintTimeSec > 0 ? qRound(stats.numDabs / paintTimeSec) : 0)
+                 << "paint (ms):" << qreal(stats.paintTime) / 1e6
+                 << "merge (ms):" << qreal(stats.mergeTime) / 1e6
+                 << "wall (ms):" << qreal(wallTime) / 1e6;
+
+        totalDabs += stats.numDabs;
+        totalTime += wallTime;
+    }
+
+    qDebug() << "total" << "strokes:" << strokes.size()
+             << "dabs:" << totalDabs
+             << "wall (ms):" << qreal(totalTime) / 1e6;
+}
+
+QTEST_MAIN(KisStrokeReplayBenchmark)
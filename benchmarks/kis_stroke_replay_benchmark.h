@@ -0,0 +1,41 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_STROKE_REPLAY_BENCHMARK_H
+#define KIS_STROKE_REPLAY_BENCHMARK_H
+
+#include <QtTest>
+
+/**
+ * Replays the strokes recorded with KRITA_STROKE_RECORDING through
+ * FreehandStrokeStrategy and reports dabs/s, merge time and total wall
+ * time per stroke. The input is taken from the environment:
+ *
+ * KRITA_REPLAY_RECORDING - the recording, a synthetic one is used if unset
+ * KRITA_REPLAY_IMAGE     - the .kra file to paint on, a blank image if unset
+ * KRITA_REPLAY_PRESET    - the preset, softbrush_30px.kpp if unset
+ */
+class KisStrokeReplayBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkReplay();
+};
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_transform_worker_benchmark.h"
+
+#include <QTest>
+#include <qmath.h>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include <kis_paint_device.h>
+#include <kis_transform_worker.h>
+#include <kis_filter_strategy.h>
+
+#define IMAGE_SIZE 2000
+
+
+static KisPaintDeviceSP createTestDevice(const QString &depthId)
+{
+    const KoColorSpace *cs =
+        KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), depthId, "");
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    // a few hundreds of semi-transparent rects of random colors
+    srand(31524744);
+
+    for (int i = 0; i < 300; i++) {
+        const QRect rc(rand() % IMAGE_SIZE, rand() % IMAGE_SIZE,
+                       rand() % 400 + 1, rand() % 400 + 1);
+
+        const QColor color(rand() % 256, rand() % 256, rand() % 256, rand() % 256);
+        dev->fill(rc & QRect(0, 0, IMAGE_SIZE, IMAGE_SIZE), KoColor(color, cs));
+    }
+
+    return dev;
+}
+
+static void addMatrixRows(const QList<qreal> &values)
+{
+    QStringList filters;
+    filters << "Box" << "Bilinear" << "Bicubic" << "Lanczos3";
+
+    QStringList depths;
+    depths << Integer8BitsColorDepthID.id()
+           << Integer16BitsColorDepthID.id()
+           << Float32BitsColorDepthID.id();
+
+    Q_FOREACH (const QString &filter, filters) {
+        Q_FOREACH (qreal value, values) {
+            Q_FOREACH (const QString &depth, depths) {
+                QTest::newRow(QString("%1-%2-%3").arg(filter).arg(value).arg(depth).toLatin1())
+                    << filter << value << depth;
+            }
+        }
+    }
+}
+
+void KisTransformWorkerBenchmark::benchmarkScale_data()
+{
+    QTest::addColumn<QString>("filterId");
+    QTest::addColumn<qreal>("scale");
+    QTest::addColumn<QString>("depthId");
+
+    addMatrixRows(QList<qreal>() << 0.25 << 0.734 << 1.387 << 3.0);
+}
+
+void KisTransformWorkerBenchmark::benchmarkScale()
+{
+    QFETCH(QString, filterId);
+    QFETCH(qreal, scale);
+    QFETCH(QString, depthId);
+
+    KisFilterStrategy *filter = KisFilterStrategyRegistry::instance()->value(filterId);
+    QVERIFY(filter);
+
+    KisPaintDeviceSP source = createTestDevice(depthId);
+
+    QBENCHMARK {
+        KisPaintDeviceSP dev = new KisPaintDevice(*source);
+
+        KisTransformWorker tw(dev, scale, scale,
+                              0.0, 0.0, 0.0, 0.0, 0.0,
+                              0, 0, 0, filter);
+        tw.run();
+    }
+}
+
+void KisTransformWorkerBenchmark::benchmarkRotate_data()
+{
+    QTest::addColumn<QString>("filterId");
+    QTest::addColumn<qreal>("angle");
+    QTest::addColumn<QString>("depthId");
+
+    addMatrixRows(QList<qreal>() << M_PI / 6.0 << 2.0 * M_PI / 3.0);
+}
+
+void KisTransformWorkerBenchmark::benchmarkRotate()
+{
+    QFETCH(QString, filterId);
+    QFETCH(qreal, angle);
+    QFETCH(QString, depthId);
+
+    KisFilterStrategy *filter = KisFilterStrategyRegistry::instance()->value(filterId);
+    QVERIFY(filter);
+
+    KisPaintDeviceSP source = createTestDevice(depthId);
+
+    QBENCHMARK {
+        KisPaintDeviceSP dev = new KisPaintDevice(*source);
+
+        KisTransformWorker tw(dev, 1.0, 1.0,
+                              0.0, 0.0, 0.0, 0.0, angle,
+                              0, 0, 0, filter);
+        tw.run();
+    }
+}
+
+QTEST_MAIN(KisTransformWorkerBenchmark)
@@ -0,0 +1,340 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_alpha_mask_pyramid.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <QCryptographicHash>
+#include <QGlobalStatic>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTransform>
+#include <QWeakPointer>
+
+#include <KoColorSpaceMaths.h>
+#include <kis_debug.h>
+#include <kis_global.h>
+
+#include "kis_qimage_pyramid.h"
+
+
+namespace {
+
+struct SharedPyramids {
+    QMutex lock;
+    QHash<QByteArray, QWeakPointer<const KisAlphaMaskPyramid>> pyramids;
+};
+
+Q_GLOBAL_STATIC(SharedPyramids, s_sharedPyramids)
+
+QByteArray tipImageKey(const QImage &image)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    const qint32 size[2] = {image.width(), image.height()};
+    hash.addData(reinterpret_cast<const char*>(size), sizeof(size));
+
+    for (int y = 0; y < image.height(); y++) {
+        hash.addData(reinterpret_cast<const char*>(image.constScanLine(y)), image.width() * 4);
+    }
+
+    return hash.result();
+}
+
+}
+
+KisAlphaMaskPyramid::KisAlphaMaskPyramid(const QImage &tipImage)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(!tipImage.isNull());
+
+    const QImage image = tipImage.convertToFormat(QImage::Format_ARGB32);
+
+    Level base;
+    base.width = image.width();
+    base.height = image.height();
+    base.data.resize(base.width * base.height);
+
+    quint8 *dst = base.data.data();
+
+    for (int y = 0; y < base.height; y++) {
+        const QRgb *src = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+
+        for (int x = 0; x < base.width; x++) {
+            *dst++ = KoColorSpaceMaths<quint8>::multiply(255 - qGray(src[x]), qAlpha(src[x]));
+        }
+    }
+
+    m_levels.append(base);
+
+    while (m_levels.last().width > 1 || m_levels.last().height > 1) {
+        appendDownscaledLevel();
+    }
+}
+
+KisAlphaMaskPyramid::~KisAlphaMaskPyramid()
+{
+}
+
+void KisAlphaMaskPyramid::appendDownscaledLevel()
+{
+    const Level &src = m_levels.last();
+
+    Level level;
+    level.width = qMax(1, src.width / 2);
+    level.height = qMax(1, src.height / 2);
+    level.data.resize(level.width * level.height);
+
+    const quint8 *srcData = src.data.constData();
+    quint8 *dst = level.data.data();
+
+    for (int y = 0; y < level.height; y++) {
+        const quint8 *row0 = srcData + 2 * y * src.width;
+        const quint8 *row1 = srcData + qMin(2 * y + 1, src.height - 1) * src.width;
+
+        for (int x = 0; x < level.width; x++) {
+            const int x0 = 2 * x;
+            const int x1 = qMin(2 * x + 1, src.width - 1);
+
+            *dst++ = (row0[x0] + row0[x1] + row1[x0] + row1[x1] + 2) >> 2;
+        }
+    }
+
+    m_levels.append(level);
+}
+
+QSharedPointer<const KisAlphaMaskPyramid> KisAlphaMaskPyramid::fetchShared(const QImage &tipImage)
+{
+    const QImage image = tipImage.convertToFormat(QImage::Format_ARGB32);
+    const QByteArray key = tipImageKey(image);
+
+    SharedPyramids *shared = s_sharedPyramids;
+
+    {
+        QMutexLocker l(&shared->lock);
+        QSharedPointer<const KisAlphaMaskPyramid> pyramid = shared->pyramids.value(key).toStrongRef();
+        if (pyramid) return pyramid;
+    }
+
+    QSharedPointer<const KisAlphaMaskPyramid> pyramid(new KisAlphaMaskPyramid(image));
+
+    QMutexLocker l(&shared->lock);
+
+    /**
+     * Another brush might have created the same pyramid while we were
+     * building ours, then use that one to keep the tip shared
+     */
+    QSharedPointer<const KisAlphaMaskPyramid> existing = shared->pyramids.value(key).toStrongRef();
+    if (existing) return existing;
+
+    for (auto it = shared->pyramids.begin(); it != shared->pyramids.end();) {
+        if (it.value().isNull()) {
+            it = shared->pyramids.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    shared->pyramids.insert(key, pyramid);
+
+    return pyramid;
+}
+
+KisAlphaMaskPyramid::Sampler KisAlphaMaskPyramid::sampler(KisDabShape const& shape, qreal subPixelX, qreal subPixelY) const
+{
+    Sampler sampler;
+    sampler.m_pyramid = this;
+    sampler.m_size = QSize(1, 1);
+    sampler.m_m11 = sampler.m_m22 = 1.0;
+    sampler.m_m12 = sampler.m_m21 = sampler.m_dx = sampler.m_dy = 0.0;
+    sampler.m_isIdentity = false;
+    sampler.m_level = -1;
+    sampler.m_levelBlend = 0.0f;
+
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(!m_levels.isEmpty(), sampler);
+
+    QTransform transform;
+    KisQImagePyramid::calculateParams(shape, subPixelX, subPixelY,
+                                      originalSize(),
+                                      &transform, &sampler.m_size);
+
+    bool invertible = false;
+    const QTransform inverted = transform.inverted(&invertible);
+    if (!invertible) return sampler;
+
+    sampler.m_m11 = inverted.m11();
+    sampler.m_m12 = inverted.m12();
+    sampler.m_m21 = inverted.m21();
+    sampler.m_m22 = inverted.m22();
+    sampler.m_dx = inverted.dx();
+    sampler.m_dy = inverted.dy();
+
+    sampler.m_isIdentity = transform.isIdentity() && sampler.m_size == originalSize();
+
+    /**
+     * The size of the footprint of a dab pixel in the original tip. For
+     * the squeezed dabs the mean of the two axes is used, which is a
+     * compromise between aliasing along the short axis and blurring
+     * along the long one.
+     */
+    const qreal footprintX = std::sqrt(pow2(sampler.m_m11) + pow2(sampler.m_m12));
+    const qreal footprintY = std::sqrt(pow2(sampler.m_m21) + pow2(sampler.m_m22));
+    const qreal footprint = std::sqrt(footprintX * footprintY);
+
+    const qreal lod = footprint > 1.0 ? std::log2(footprint) : 0.0;
+    const int lastLevel = m_levels.size() - 1;
+
+    sampler.m_level = qMin(int(lod), lastLevel);
+    sampler.m_levelBlend = sampler.m_level < lastLevel ? float(lod - sampler.m_level) : 0.0f;
+
+    if (sampler.m_levelBlend < 1.0f / 256) {
+        sampler.m_levelBlend = 0.0f;
+    }
+
+    return sampler;
+}
+
+void KisAlphaMaskPyramid::Sampler::sampleLevelRow(int levelIndex, int y, float weight, bool overwrite, float *dst) const
+{
+    const Level &level = m_pyramid->m_levels[levelIndex];
+    const Level &base = m_pyramid->m_levels.first();
+
+    const int width = level.width;
+    const int height = level.height;
+    const quint8 *data = level.data.constData();
+
+    const qreal kx = qreal(width) / base.width;
+    const qreal ky = qreal(height) / base.height;
+
+    // the center of the first pixel of the row in the level coordinates
+    const qreal u0 = (m_m11 * 0.5 + m_m21 * (y + 0.5) + m_dx) * kx - 0.5;
+    const qreal v0 = (m_m12 * 0.5 + m_m22 * (y + 0.5) + m_dy) * ky - 0.5;
+    const qreal du = m_m11 * kx;
+    const qreal dv = m_m12 * ky;
+
+    auto pixel = [data, width, height] (int px, int py) {
+        return px >= 0 && py >= 0 && px < width && py < height ? data[py * width + px] : 0;
+    };
+
+    const int dabWidth = m_size.width();
+
+    for (int x = 0; x < dabWidth; x++) {
+        const float u = u0 + x * du;
+        const float v = v0 + x * dv;
+
+        const int x0 = int(std::floor(u));
+        const int y0 = int(std::floor(v));
+
+        float value = 0.0f;
+
+        if (x0 >= -1 && y0 >= -1 && x0 < width && y0 < height) {
+            const float fx = u - x0;
+            const float fy = v - y0;
+
+            int a, b, c, d;
+
+            if (x0 >= 0 && y0 >= 0 && x0 + 1 < width && y0 + 1 < height) {
+                const quint8 *p = data + y0 * width + x0;
+                a = p[0];
+                b = p[1];
+                c = p[width];
+                d = p[width + 1];
+            } else {
+                a = pixel(x0, y0);
+                b = pixel(x0 + 1, y0);
+                c = pixel(x0, y0 + 1);
+                d = pixel(x0 + 1, y0 + 1);
+            }
+
+            const float top = a + fx * (b - a);
+            const float bottom = c + fx * (d - c);
+            value = top + fy * (bottom - top);
+        }
+
+        if (overwrite) {
+            dst[x] = weight * value;
+        } else {
+            dst[x] += weight * value;
+        }
+    }
+}
+
+void KisAlphaMaskPyramid::Sampler::sampleRow(int y, quint8 *dst) const
+{
+    const int dabWidth = m_size.width();
+
+    if (m_level < 0) {
+        memset(dst, 0, dabWidth);
+        return;
+    }
+
+    if (m_isIdentity) {
+        memcpy(dst, m_pyramid->m_levels.first().data.constData() + y * dabWidth, dabWidth);
+        return;
+    }
+
+    if (m_rowBuffer.size() < dabWidth) {
+        m_rowBuffer.resize(dabWidth);
+    }
+
+    float *buffer = m_rowBuffer.data();
+
+    sampleLevelRow(m_level, y, 1.0f - m_levelBlend, true, buffer);
+
+    if (m_levelBlend > 0.0f) {
+        sampleLevelRow(m_level + 1, y, m_levelBlend, false, buffer);
+    }
+
+    for (int x = 0; x < dabWidth; x++) {
+        dst[x] = quint8(qBound(0, int(buffer[x] + 0.5f), 255));
+    }
+}
+
+QSize KisAlphaMaskPyramid::originalSize() const
+{
+    return !m_levels.isEmpty() ?
+        QSize(m_levels.first().width, m_levels.first().height) : QSize();
+}
+
+int KisAlphaMaskPyramid::numLevels() const
+{
+    return m_levels.size();
+}
+
+QSize KisAlphaMaskPyramid::levelSize(int level) const
+{
+    return QSize(m_levels[level].width, m_levels[level].height);
+}
+
+const quint8* KisAlphaMaskPyramid::levelData(int level) const
+{
+    return m_levels[level].data.constData();
+}
+
+qint64 KisAlphaMaskPyramid::memoryUsage() const
+{
+    qint64 usage = 0;
+
+    Q_FOREACH (const Level &level, m_levels) {
+        usage += level.data.size();
+    }
+
+    return usage;
+}
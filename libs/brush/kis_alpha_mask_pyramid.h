@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_ALPHA_MASK_PYRAMID_H
+#define __KIS_ALPHA_MASK_PYRAMID_H
+
+#include <QImage>
+#include <QSharedPointer>
+#include <QSize>
+#include <QVector>
+
+#include <kis_dab_shape.h>
+#include <kritabrush_export.h>
+
+
+/**
+ * A mip pyramid of the alpha mask of a predefined brush tip (gbr, png,
+ * abr and the image pipes).
+ *
+ * KisQImagePyramid keeps ARGB32 levels and renders every dab through a
+ * QPainter into a new QImage, which is then converted into the mask
+ * pixel by pixel. For the mask brushes only the final 8-bit mask value
+ * of a pixel is needed, so this pyramid stores exactly that value:
+ *
+ *     mask = (255 - gray) * alpha
+ *
+ * The value is linear in the premultiplied color of the pixel, so
+ * filtering the mask gives the same result as filtering the color and
+ * converting it to the mask afterwards.
+ *
+ * The dabs are sampled from the two levels nearest to the scale of the
+ * dab with trilinear filtering, row by row, right into the buffer the
+ * caller applies to the dab. No QImage is created while painting.
+ *
+ * The pyramids are immutable and shared between all the brushes having
+ * the same tip image, see fetchShared().
+ */
+class BRUSH_EXPORT KisAlphaMaskPyramid
+{
+public:
+    class BRUSH_EXPORT Sampler
+    {
+    public:
+        /**
+         * The size of the dab, the same as KisQImagePyramid::imageSize()
+         * returns for the same shape
+         */
+        QSize size() const {
+            return m_size;
+        }
+
+        /**
+         * Writes size().width() mask values of row \p y of the dab
+         * into \p dst
+         */
+        void sampleRow(int y, quint8 *dst) const;
+
+    private:
+        friend class KisAlphaMaskPyramid;
+        Sampler() {}
+
+        void sampleLevelRow(int level, int y, float weight, bool overwrite, float *dst) const;
+
+    private:
+        const KisAlphaMaskPyramid *m_pyramid;
+        QSize m_size;
+
+        // the mapping of the dab pixels into the original tip
+        qreal m_m11, m_m12, m_m21, m_m22, m_dx, m_dy;
+        bool m_isIdentity;
+
+        int m_level;
+        float m_levelBlend;
+
+        mutable QVector<float> m_rowBuffer;
+    };
+
+public:
+    KisAlphaMaskPyramid(const QImage &tipImage);
+    ~KisAlphaMaskPyramid();
+
+    /**
+     * Returns the pyramid of the tip \p tipImage. If any brush has
+     * already created a pyramid for a tip with the same pixels, that
+     * pyramid is returned, otherwise a new one is created and
+     * registered. The registry doesn't own the pyramids, they are
+     * freed together with the last brush using them.
+     */
+    static QSharedPointer<const KisAlphaMaskPyramid> fetchShared(const QImage &tipImage);
+
+    /**
+     * Prepares sampling of a dab with \p shape. The sampler is valid
+     * while the pyramid exists.
+     */
+    Sampler sampler(KisDabShape const& shape, qreal subPixelX, qreal subPixelY) const;
+
+    QSize originalSize() const;
+
+    int numLevels() const;
+    QSize levelSize(int level) const;
+    const quint8* levelData(int level) const;
+
+    qint64 memoryUsage() const;
+
+private:
+    struct Level {
+        int width;
+        int height;
+        QVector<quint8> data;
+    };
+
+    void appendDownscaledLevel();
+
+private:
+    QVector<Level> m_levels;
+};
+
+typedef QSharedPointer<const KisAlphaMaskPyramid> KisAlphaMaskPyramidSP;
+
+#endif /* __KIS_ALPHA_MASK_PYRAMID_H */
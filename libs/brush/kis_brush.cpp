@@ -46,6 +46,7 @@
 #include <brushengine/kis_paint_information.h>
 #include <kis_fixed_paint_device.h>
 #include <kis_qimage_pyramid.h>
+#include <kis_alpha_mask_pyramid.h>
 #include <brushengine/kis_paintop_lod_limitations.h>
 
 
@@ -126,6 +127,7 @@ struct KisBrush::Private {
     QPointF hotSpot;
 
     mutable QSharedPointer<const KisQImagePyramid> brushPyramid;
+    mutable QSharedPointer<const KisAlphaMaskPyramid> maskPyramid;
 
     QImage brushTipImage;
 
@@ -169,6 +171,7 @@ KisBrush::KisBrush(const KisBrush& rhs)
      * reason why it is defined as const!
      */
     d->brushPyramid = rhs.d->brushPyramid;
+    d->maskPyramid = rhs.d->maskPyramid;
 
     // don't copy the boundary, it will be regenerated -- see bug 291910
 }
@@ -436,15 +439,32 @@ void KisBrush::notifyCachedDabPainted(const KisPaintInformation& info)
 }
 
 void KisBrush::prepareBrushPyramid() const
+{
+    prepareMaskPyramid();
+
+    if (brushType() == IMAGE || brushType() == PIPE_IMAGE) {
+        prepareImagePyramid();
+    }
+}
+
+void KisBrush::prepareImagePyramid() const
 {
     if (!d->brushPyramid) {
         d->brushPyramid = toQShared(new KisQImagePyramid(brushTipImage()));
     }
 }
 
+void KisBrush::prepareMaskPyramid() const
+{
+    if (!d->maskPyramid) {
+        d->maskPyramid = KisAlphaMaskPyramid::fetchShared(brushTipImage());
+    }
+}
+
 void KisBrush::clearBrushPyramid()
 {
     d->brushPyramid.clear();
+    d->maskPyramid.clear();
 }
 
 void KisBrush::mask(KisFixedPaintDeviceSP dst, KisDabShape const& shape, const KisPaintInformation& info , double subPixelX, double subPixelY, qreal softnessFactor) const
@@ -475,14 +495,14 @@ void KisBrush::generateMaskAndApplyMaskOrCreateDab(KisFixedPaintDeviceSP dst,
     Q_UNUSED(info_);
     Q_UNUSED(softnessFactor);
 
-    prepareBrushPyramid();
-    QImage outputImage = d->brushPyramid->createImage(KisDabShape(
-            shape.scale() * d->scale, shape.ratio(),
-            -normalizeAngle(shape.rotation() + d->angle)),
-        subPixelX, subPixelY);
+    prepareMaskPyramid();
+    const KisAlphaMaskPyramid::Sampler sampler =
+        d->maskPyramid->sampler(KisDabShape(shape.scale() * d->scale, shape.ratio(),
+                                            -normalizeAngle(shape.rotation() + d->angle)),
+                                subPixelX, subPixelY);
 
-    qint32 maskWidth = outputImage.width();
-    qint32 maskHeight = outputImage.height();
+    qint32 maskWidth = sampler.size().width();
+    qint32 maskHeight = sampler.size().height();
 
     dst->setRect(QRect(0, 0, maskWidth, maskHeight));
     dst->initialize();
@@ -499,11 +519,9 @@ void KisBrush::generateMaskAndApplyMaskOrCreateDab(KisFixedPaintDeviceSP dst,
     qint32 pixelSize = cs->pixelSize();
     quint8 *dabPointer = dst->data();
     quint8 *rowPointer = dabPointer;
-    quint8 *alphaArray = new quint8[maskWidth];
-    bool hasColor = this->hasColor();
+    QVector<quint8> alphaArray(maskWidth);
 
     for (int y = 0; y < maskHeight; y++) {
-        const quint8* maskPointer = outputImage.constScanLine(y);
         if (coloringInformation) {
             for (int x = 0; x < maskWidth; x++) {
                 if (color) {
@@ -517,30 +535,9 @@ void KisBrush::generateMaskAndApplyMaskOrCreateDab(KisFixedPaintDeviceSP dst,
             }
         }
 
-        if (hasColor) {
-            const quint8 *src = maskPointer;
-            quint8 *dst = alphaArray;
-            for (int x = 0; x < maskWidth; x++) {
-                const QRgb *c = reinterpret_cast<const QRgb*>(src);
-
-                *dst = KoColorSpaceMaths<quint8>::multiply(255 - qGray(*c), qAlpha(*c));
-                src += 4;
-                dst++;
-            }
-        }
-        else {
-            const quint8 *src = maskPointer;
-            quint8 *dst = alphaArray;
-            for (int x = 0; x < maskWidth; x++) {
-                const QRgb *c = reinterpret_cast<const QRgb*>(src);
+        sampler.sampleRow(y, alphaArray.data());
 
-                *dst = KoColorSpaceMaths<quint8>::multiply(255 - *src, qAlpha(*c));
-                src += 4;
-                dst++;
-            }
-        }
-
-        cs->applyAlphaU8Mask(rowPointer, alphaArray, maskWidth);
+        cs->applyAlphaU8Mask(rowPointer, alphaArray.constData(), maskWidth);
         rowPointer += maskWidth * pixelSize;
         dabPointer = rowPointer;
 
@@ -548,8 +545,6 @@ void KisBrush::generateMaskAndApplyMaskOrCreateDab(KisFixedPaintDeviceSP dst,
             coloringInformation->nextRow();
         }
     }
-
-    delete[] alphaArray;
 }
 
 KisFixedPaintDeviceSP KisBrush::paintDevice(const KoColorSpace * colorSpace,
@@ -562,7 +557,7 @@ KisFixedPaintDeviceSP KisBrush::paintDevice(const KoColorSpace * colorSpace,
     double angle = normalizeAngle(shape.rotation() + d->angle);
     double scale = shape.scale() * d->scale;
 
-    prepareBrushPyramid();
+    prepareImagePyramid();
     QImage outputImage = d->brushPyramid->createImage(
         KisDabShape(scale, shape.ratio(), -angle), subPixelX, subPixelY);
 
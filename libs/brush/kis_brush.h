@@ -318,6 +318,12 @@ public:
     virtual void setAngle(qreal _angle);
     qreal angle() const;
 
+    /**
+     * Prepares the pyramids the dabs are sampled from: the alpha mask
+     * pyramid used by mask() and, for the colored brushes, the QImage
+     * pyramid used by paintDevice(). Call it before using the brush
+     * from several threads.
+     */
     void prepareBrushPyramid() const;
     void clearBrushPyramid();
 
@@ -369,6 +375,9 @@ private:
     // Initialize our boundary
     void generateBoundary() const;
 
+    void prepareImagePyramid() const;
+    void prepareMaskPyramid() const;
+
     struct Private;
     Private* const d;
 
@@ -31,6 +31,7 @@
 #include "brushengine/kis_paint_information.h"
 #include <kis_fixed_paint_device.h>
 #include "kis_qimage_pyramid.h"
+#include "kis_alpha_mask_pyramid.h"
 
 void KisGbrBrushTest::testMaskGenerationNoColor()
 {
@@ -358,4 +359,112 @@ void KisGbrBrushTest::testQPainterTransformationBorder()
     }
 }
 
+void KisGbrBrushTest::testAlphaMaskPyramid()
+{
+    QImage image(41, 20, QImage::Format_ARGB32);
+    image.fill(0);
+
+    {
+        QPainter gc(&image);
+        gc.fillRect(QRect(5, 5, 30, 10), Qt::black);
+    }
+
+    KisAlphaMaskPyramid pyramid(image);
+
+    QCOMPARE(pyramid.originalSize(), QSize(41, 20));
+    QCOMPARE(pyramid.numLevels(), 6);
+    QCOMPARE(pyramid.levelSize(1), QSize(20, 10));
+    QCOMPARE(pyramid.levelSize(4), QSize(2, 1));
+    QCOMPARE(pyramid.levelSize(5), QSize(1, 1));
+
+    // the opaque black pixels become the opaque mask
+    QCOMPARE(int(pyramid.levelData(0)[10 * 41 + 20]), 255);
+    QCOMPARE(int(pyramid.levelData(0)[0]), 0);
+
+    // an unscaled dab is a copy of the base level
+    KisAlphaMaskPyramid::Sampler sampler = pyramid.sampler(KisDabShape(), 0.0, 0.0);
+    QCOMPARE(sampler.size(), QSize(41, 20));
+
+    QVector<quint8> row(sampler.size().width());
+
+    for (int y = 0; y < sampler.size().height(); y++) {
+        sampler.sampleRow(y, row.data());
+        QVERIFY(!memcmp(row.constData(), pyramid.levelData(0) + y * 41, 41));
+    }
+
+    // the size of a transformed dab is the same as in the QImage pyramid
+    const KisDabShape shape(0.7, 0.8, 0.3);
+    sampler = pyramid.sampler(shape, 0.3, 0.6);
+    QCOMPARE(sampler.size(), KisQImagePyramid::imageSize(QSize(41, 20), shape, 0.3, 0.6));
+
+    // the center of the rectangle stays opaque, the corners stay transparent
+    const int centerY = sampler.size().height() / 2;
+    row.resize(sampler.size().width());
+
+    sampler.sampleRow(centerY, row.data());
+    QVERIFY(row[sampler.size().width() / 2] >= 254);
+
+    sampler.sampleRow(0, row.data());
+    QCOMPARE(int(row[0]), 0);
+}
+
+void KisGbrBrushTest::testAlphaMaskPyramidSharing()
+{
+    KisGbrBrush brush1(QString(FILES_DATA_DIR) + QDir::separator() + "brush.gbr");
+    KisGbrBrush brush2(QString(FILES_DATA_DIR) + QDir::separator() + "brush.gbr");
+    KisGbrBrush brush3(QString(FILES_DATA_DIR) + QDir::separator() + "pepper.gbr");
+
+    QVERIFY(brush1.load());
+    QVERIFY(brush2.load());
+    QVERIFY(brush3.load());
+
+    KisAlphaMaskPyramidSP pyramid1 = KisAlphaMaskPyramid::fetchShared(brush1.brushTipImage());
+    KisAlphaMaskPyramidSP pyramid2 = KisAlphaMaskPyramid::fetchShared(brush2.brushTipImage());
+    KisAlphaMaskPyramidSP pyramid3 = KisAlphaMaskPyramid::fetchShared(brush3.brushTipImage());
+
+    QCOMPARE(pyramid1.data(), pyramid2.data());
+    QVERIFY(pyramid1.data() != pyramid3.data());
+
+    // the registry doesn't keep the pyramids alive
+    QWeakPointer<const KisAlphaMaskPyramid> weakPyramid = pyramid3;
+    pyramid3.clear();
+    QVERIFY(weakPyramid.isNull());
+}
+
+void KisGbrBrushTest::benchmarkMaskPyramidSampling_data()
+{
+    QTest::addColumn<int>("dabSize");
+
+    QTest::newRow("16px") << 16;
+    QTest::newRow("64px") << 64;
+    QTest::newRow("256px") << 256;
+    QTest::newRow("512px") << 512;
+    QTest::newRow("1024px") << 1024;
+}
+
+void KisGbrBrushTest::benchmarkMaskPyramidSampling()
+{
+    QFETCH(int, dabSize);
+
+    KisGbrBrush* brush = new KisGbrBrush(QString(FILES_DATA_DIR) + QDir::separator() + "testing_brush_512_bars.gbr");
+    brush->load();
+    QVERIFY(!brush->brushTipImage().isNull());
+    brush->prepareBrushPyramid();
+    qsrand(1);
+
+    const KoColorSpace* cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintInformation info(QPointF(100.0, 100.0), 0.5);
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+    KoColor c(Qt::black, cs);
+
+    const qreal scale = qreal(dabSize) / brush->width();
+
+    QBENCHMARK {
+        const qreal rotation = qreal(qrand()) / RAND_MAX * 2 * M_PI;
+        brush->mask(dab, c, KisDabShape(scale, 1.0, rotation), info, 0.3, 0.3, 1.0);
+    }
+
+    delete brush;
+}
+
 QTEST_MAIN(KisGbrBrushTest)
@@ -44,6 +44,12 @@ private Q_SLOTS:
     void testPyramidDabTransform();
 
     void testQPainterTransformationBorder();
+
+    void testAlphaMaskPyramid();
+    void testAlphaMaskPyramidSharing();
+
+    void benchmarkMaskPyramidSampling_data();
+    void benchmarkMaskPyramidSampling();
 };
 
 #endif
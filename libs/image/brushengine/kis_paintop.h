@@ -106,6 +106,17 @@ public:
         return true;
     }
 
+    /**
+     * Whether the paintop can paint a line that is rolled back
+     * afterwards (see FreehandStrokeStrategy::Data::SPECULATIVE_LINE).
+     * It is possible only when the paintop keeps no state between the
+     * dabs except the one stored in KisDistanceInformation. Default is
+     * false.
+     */
+    virtual bool supportsSpeculativePainting() const {
+        return false;
+    }
+
     /**
      * Split the coordinate into whole + fraction, where fraction is always >= 0.
      */
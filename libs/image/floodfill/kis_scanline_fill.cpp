@@ -21,6 +21,9 @@
 #include <KoAlwaysInline.h>
 
 #include <QStack>
+#include <QThread>
+#include <QtConcurrent>
+#include <type_traits>
 #include <KoColor.h>
 #include <KoColorSpace.h>
 #include <KoCompositeOpRegistry.h>
@@ -29,6 +32,8 @@
 #include "kis_pixel_selection.h"
 #include "kis_random_accessor_ng.h"
 #include "kis_fill_sanity_checks.h"
+#include "krita_utils.h"
+#include "kis_assert.h"
 
 
 template <class BaseClass>
@@ -262,6 +267,173 @@ public:
     }
 };
 
+namespace {
+
+/**
+ * The size of the blocks the bounding rect is split into in the
+ * parallel mode. Should be a multiple of the tile size, the blocks
+ * are aligned to the tiles of the destination device.
+ */
+const int parallelFillBlockSize = 256;
+
+/**
+ * In ParallelAuto mode the parallel fill is used only when the
+ * bounding rect is larger than this area
+ */
+const qint64 parallelFillMinimalArea = 2048 * 2048;
+
+struct LabelsUnionFind
+{
+    int addLabel() {
+        parent.append(parent.size());
+        return parent.size() - 1;
+    }
+
+    int find(int label) {
+        while (parent[label] != label) {
+            parent[label] = parent[parent[label]];
+            label = parent[label];
+        }
+        return label;
+    }
+
+    /**
+     * Does not compress the paths, so it can be called
+     * from several threads at the same time
+     */
+    int findConst(int label) const {
+        while (parent[label] != label) {
+            label = parent[label];
+        }
+        return label;
+    }
+
+    void unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+
+        if (a != b) {
+            parent[qMax(a, b)] = qMin(a, b);
+        }
+    }
+
+    QVector<int> parent;
+};
+
+/**
+ * A rectangular part of the bounding rect with all the fillable
+ * runs found in it. The runs are sorted by row and then by column,
+ * the runs of row \\p y lay in range [rowBegin(y), rowEnd(y)).
+ */
+struct FillBlock
+{
+    FillBlock() : labelOffset(0), isQueued(false), isScanned(false) {}
+
+    int rowBegin(int y) const {
+        return rowOffsets[y - rect.top()];
+    }
+
+    int rowEnd(int y) const {
+        return rowOffsets[y - rect.top() + 1];
+    }
+
+    QRect rect;
+    QVector<KisFillInterval> runs;
+    QVector<int> rowOffsets;
+    LabelsUnionFind labels;
+    int labelOffset;
+    bool isQueued;
+    bool isScanned;
+};
+
+/**
+ * Calls \\p func for every pair of horizontally overlapping runs
+ * from two rows. Both ranges must be sorted.
+ */
+template <class Func>
+void forEachOverlappingRun(const QVector<KisFillInterval> &runsA, int beginA, int endA,
+                           const QVector<KisFillInterval> &runsB, int beginB, int endB,
+                           Func func)
+{
+    int i = beginA;
+    int j = beginB;
+
+    while (i < endA && j < endB) {
+        const KisFillInterval &a = runsA[i];
+        const KisFillInterval &b = runsB[j];
+
+        if (a.end >= b.start && b.end >= a.start) {
+            func(i, j);
+        }
+
+        if (a.end < b.end) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+}
+
+/**
+ * Unites the labels of the runs continuing from \p left into the
+ * block \p right lying next to it
+ */
+void uniteHorizontalNeighbours(const FillBlock &left, const FillBlock &right, LabelsUnionFind *labels)
+{
+    for (int y = left.rect.top(); y <= left.rect.bottom(); y++) {
+        const int lastRun = left.rowEnd(y) - 1;
+        const int firstRun = right.rowBegin(y);
+
+        if (lastRun >= left.rowBegin(y) &&
+            firstRun < right.rowEnd(y) &&
+            left.runs[lastRun].end == left.rect.right() &&
+            right.runs[firstRun].start == right.rect.left()) {
+
+            labels->unite(left.labelOffset + lastRun,
+                          right.labelOffset + firstRun);
+        }
+    }
+}
+
+/**
+ * Unites the labels of the runs continuing from \p top into the
+ * block \p bottom lying below it
+ */
+void uniteVerticalNeighbours(const FillBlock &top, const FillBlock &bottom, LabelsUnionFind *labels)
+{
+    const int y = top.rect.bottom();
+
+    forEachOverlappingRun(top.runs, top.rowBegin(y), top.rowEnd(y),
+                          bottom.runs, bottom.rowBegin(y + 1), bottom.rowEnd(y + 1),
+                          [&] (int a, int b) {
+                              labels->unite(top.labelOffset + a,
+                                            bottom.labelOffset + b);
+                          });
+}
+
+/**
+ * Checks whether a run of \p block with label \p label touches
+ * the \p border rect lying inside the block
+ */
+bool touchesBorder(const FillBlock &block, const QRect &border, int label, LabelsUnionFind *labels)
+{
+    for (int y = border.top(); y <= border.bottom(); y++) {
+        for (int i = block.rowBegin(y); i < block.rowEnd(y); i++) {
+            const KisFillInterval &run = block.runs[i];
+
+            if (run.end >= border.left() && run.start <= border.right() &&
+                labels->find(block.labelOffset + i) == label) {
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+}
+
 struct Q_DECL_HIDDEN KisScanlineFill::Private
 {
     KisPaintDeviceSP device;
@@ -269,6 +441,7 @@ struct Q_DECL_HIDDEN KisScanlineFill::Private
     QPoint startPoint;
     QRect boundingRect;
     int threshold;
+    ParallelMode parallelMode;
 
     int rowIncrement;
     KisFillIntervalMap backwardMap;
@@ -298,6 +471,7 @@ KisScanlineFill::KisScanlineFill(KisPaintDeviceSP device, const QPoint &startPoi
     m_d->rowIncrement = 1;
 
     m_d->threshold = 0;
+    m_d->parallelMode = ParallelAuto;
 }
 
 KisScanlineFill::~KisScanlineFill()
@@ -309,6 +483,24 @@ void KisScanlineFill::setThreshold(int threshold)
     m_d->threshold = threshold;
 }
 
+void KisScanlineFill::setParallelMode(ParallelMode mode)
+{
+    m_d->parallelMode = mode;
+}
+
+bool KisScanlineFill::useParallelFill() const
+{
+    if (m_d->parallelMode == ParallelNever ||
+        !m_d->boundingRect.contains(m_d->startPoint)) {
+
+        return false;
+    }
+
+    return m_d->parallelMode == ParallelAlways ||
+        (QThread::idealThreadCount() > 1 &&
+         qint64(m_d->boundingRect.width()) * m_d->boundingRect.height() >= parallelFillMinimalArea);
+}
+
 template <class T>
 void KisScanlineFill::extendedPass(KisFillInterval *currentInterval, int srcRow, bool extendRight, T &pixelPolicy)
 {
@@ -466,6 +658,266 @@ void KisScanlineFill::runImpl(T &pixelPolicy)
     }
 }
 
+template <class PolicyFactory>
+void KisScanlineFill::runParallelImpl(KisPaintDeviceSP dstDevice, PolicyFactory createPolicy)
+{
+    typedef typename std::remove_pointer<decltype(createPolicy())>::type PolicyType;
+
+    const QRect &bounds = m_d->boundingRect;
+    const QPoint &startPoint = m_d->startPoint;
+    const int blockSize = parallelFillBlockSize;
+    const int pixelSize = m_d->device->pixelSize();
+
+    /**
+     * The blocks are written concurrently, so they should never share
+     * a tile of the destination device. Its tile grid starts at the
+     * offset of the device.
+     */
+    const QVector<QPair<int, int>> rows =
+        KritaUtils::splitIntoAlignedStripes(bounds.top(), bounds.bottom() + 1, dstDevice->y(), blockSize);
+    const QVector<QPair<int, int>> columns =
+        KritaUtils::splitIntoAlignedStripes(bounds.left(), bounds.right() + 1, dstDevice->x(), blockSize);
+
+    const int numColumns = columns.size();
+    const int numRows = rows.size();
+
+    QVector<FillBlock> blocks(numColumns * numRows);
+    int startBlockIndex = -1;
+
+    for (int row = 0; row < numRows; row++) {
+        for (int column = 0; column < numColumns; column++) {
+            const int index = row * numColumns + column;
+
+            blocks[index].rect =
+                QRect(QPoint(columns[column].first, rows[row].first),
+                      QPoint(columns[column].second - 1, rows[row].second - 1));
+
+            if (blocks[index].rect.contains(startPoint)) {
+                startBlockIndex = index;
+            }
+        }
+    }
+
+    KIS_SAFE_ASSERT_RECOVER_RETURN(startBlockIndex >= 0);
+
+    // the blocks are modified concurrently, avoid detaching them
+    FillBlock *blocksPtr = blocks.data();
+
+    /**
+     * The blocks are scanned in waves, starting with the block of the
+     * start point. The next wave consists of the blocks touched by the
+     * area of the start point known so far, so the blocks the fill can
+     * never reach are not even read.
+     */
+    LabelsUnionFind labels;
+    QVector<int> scannedBlocks;
+    QVector<int> wave;
+    int startRunLabel = -1;
+
+    wave << startBlockIndex;
+    blocks[startBlockIndex].isQueued = true;
+
+    while (!wave.isEmpty()) {
+
+        /**
+         * 1) Find the fillable runs in every block of the wave and
+         *    label the contiguous areas inside the blocks. The
+         *    device is only read here, so a const accessor is used
+         *    to avoid allocating or detaching any tiles.
+         */
+        QtConcurrent::blockingMap(wave, [&] (int index) {
+            FillBlock &block = blocksPtr[index];
+            QScopedPointer<PolicyType> pixelPolicy(createPolicy());
+            const QRect &rc = block.rect;
+
+            KisRandomConstAccessorSP srcIt = m_d->device->createRandomConstAccessorNG(rc.x(), rc.y());
+            block.rowOffsets.resize(rc.height() + 1);
+
+            for (int y = rc.top(); y <= rc.bottom(); y++) {
+                const int rowBegin = block.runs.size();
+                block.rowOffsets[y - rc.top()] = rowBegin;
+
+                KisFillInterval currentRun;
+                int numPixelsLeft = 0;
+                quint8 *dataPtr = 0;
+
+                for (int x = rc.left(); x <= rc.right(); x++) {
+                    if (numPixelsLeft <= 0) {
+                        srcIt->moveTo(x, y);
+                        numPixelsLeft = srcIt->numContiguousColumns(x) - 1;
+                        dataPtr = const_cast<quint8*>(srcIt->rawDataConst());
+                    } else {
+                        numPixelsLeft--;
+                        dataPtr += pixelSize;
+                    }
+
+                    if (pixelPolicy->calculateOpacity(dataPtr)) {
+                        if (!currentRun.isValid()) {
+                            currentRun = KisFillInterval(x, x, y);
+                        } else {
+                            currentRun.end = x;
+                        }
+                    } else if (currentRun.isValid()) {
+                        block.runs.append(currentRun);
+                        block.labels.addLabel();
+                        currentRun.invalidate();
+                    }
+                }
+
+                if (currentRun.isValid()) {
+                    block.runs.append(currentRun);
+                    block.labels.addLabel();
+                }
+
+                if (y > rc.top()) {
+                    forEachOverlappingRun(block.runs, block.rowBegin(y - 1), rowBegin,
+                                          block.runs, rowBegin, block.runs.size(),
+                                          [&block] (int a, int b) {
+                                              block.labels.unite(a, b);
+                                          });
+                }
+            }
+
+            block.rowOffsets[rc.height()] = block.runs.size();
+        });
+
+        /**
+         * 2) Merge the labels of the new blocks into the global ones
+         *    and unite the areas touching each other across the
+         *    borders of all the scanned blocks
+         */
+        Q_FOREACH (int index, wave) {
+            FillBlock &block = blocks[index];
+            block.labelOffset = labels.parent.size();
+            labels.parent.resize(block.labelOffset + block.runs.size());
+
+            for (int i = 0; i < block.runs.size(); i++) {
+                labels.parent[block.labelOffset + i] = block.labelOffset + block.labels.find(i);
+            }
+
+            block.isScanned = true;
+            scannedBlocks << index;
+        }
+
+        Q_FOREACH (int index, wave) {
+            const int row = index / numColumns;
+            const int column = index % numColumns;
+
+            if (column > 0 && blocks[index - 1].isScanned) {
+                uniteHorizontalNeighbours(blocks[index - 1], blocks[index], &labels);
+            }
+            if (column + 1 < numColumns && blocks[index + 1].isScanned) {
+                uniteHorizontalNeighbours(blocks[index], blocks[index + 1], &labels);
+            }
+            if (row > 0 && blocks[index - numColumns].isScanned) {
+                uniteVerticalNeighbours(blocks[index - numColumns], blocks[index], &labels);
+            }
+            if (row + 1 < numRows && blocks[index + numColumns].isScanned) {
+                uniteVerticalNeighbours(blocks[index], blocks[index + numColumns], &labels);
+            }
+        }
+
+        if (startRunLabel < 0) {
+            const FillBlock &startBlock = blocks[startBlockIndex];
+
+            for (int i = startBlock.rowBegin(startPoint.y()); i < startBlock.rowEnd(startPoint.y()); i++) {
+                const KisFillInterval &run = startBlock.runs[i];
+
+                if (run.start <= startPoint.x() && startPoint.x() <= run.end) {
+                    startRunLabel = startBlock.labelOffset + i;
+                    break;
+                }
+            }
+
+            if (startRunLabel < 0) return;
+        }
+
+        /**
+         * 3) Queue the blocks the area of the start point runs into.
+         *    The area may grow through a new block back into an old
+         *    one, so the borders of all the scanned blocks are checked.
+         */
+        const int startLabel = labels.find(startRunLabel);
+        wave.clear();
+
+        Q_FOREACH (int index, scannedBlocks) {
+            const FillBlock &block = blocks[index];
+            const int row = index / numColumns;
+            const int column = index % numColumns;
+
+            auto tryQueue = [&] (int neighbourIndex, const QRect &border) {
+                FillBlock &neighbour = blocks[neighbourIndex];
+
+                if (!neighbour.isQueued && touchesBorder(block, border, startLabel, &labels)) {
+                    neighbour.isQueued = true;
+                    wave << neighbourIndex;
+                }
+            };
+
+            const QRect &rc = block.rect;
+
+            if (column > 0) {
+                tryQueue(index - 1, QRect(rc.left(), rc.top(), 1, rc.height()));
+            }
+            if (column + 1 < numColumns) {
+                tryQueue(index + 1, QRect(rc.right(), rc.top(), 1, rc.height()));
+            }
+            if (row > 0) {
+                tryQueue(index - numColumns, QRect(rc.left(), rc.top(), rc.width(), 1));
+            }
+            if (row + 1 < numRows) {
+                tryQueue(index + numColumns, QRect(rc.left(), rc.bottom(), rc.width(), 1));
+            }
+        }
+    }
+
+    /**
+     * 4) Fill all the runs belonging to the area of the start point
+     */
+    const int startLabel = labels.find(startRunLabel);
+    const LabelsUnionFind &mergedLabels = labels;
+
+    QtConcurrent::blockingMap(scannedBlocks, [&] (int index) {
+        const FillBlock &block = blocksPtr[index];
+        QScopedPointer<PolicyType> pixelPolicy(createPolicy());
+
+        for (int i = 0; i < block.runs.size(); i++) {
+            if (mergedLabels.findConst(block.labelOffset + i) != startLabel) continue;
+
+            const KisFillInterval &run = block.runs[i];
+
+            int numPixelsLeft = 0;
+            quint8 *dataPtr = 0;
+
+            for (int x = run.start; x <= run.end; x++) {
+                if (numPixelsLeft <= 0) {
+                    pixelPolicy->m_srcIt->moveTo(x, run.row);
+                    numPixelsLeft = pixelPolicy->m_srcIt->numContiguousColumns(x) - 1;
+                    dataPtr = const_cast<quint8*>(pixelPolicy->m_srcIt->rawDataConst());
+                } else {
+                    numPixelsLeft--;
+                    dataPtr += pixelSize;
+                }
+
+                const quint8 opacity = pixelPolicy->calculateOpacity(dataPtr);
+                pixelPolicy->fillPixel(dataPtr, opacity, x, run.row);
+            }
+        }
+    });
+}
+
+template <class PolicyFactory>
+void KisScanlineFill::run(KisPaintDeviceSP dstDevice, PolicyFactory createPolicy)
+{
+    if (useParallelFill()) {
+        runParallelImpl(dstDevice, createPolicy);
+    } else {
+        typedef typename std::remove_pointer<decltype(createPolicy())>::type PolicyType;
+        QScopedPointer<PolicyType> pixelPolicy(createPolicy());
+        runImpl(*pixelPolicy);
+    }
+}
+
 void KisScanlineFill::fillColor(const KoColor &fillColor)
 {
     KisRandomConstAccessorSP it = m_d->device->createRandomConstAccessorNG(m_d->startPoint.x(), m_d->startPoint.y());
@@ -474,30 +926,40 @@ void KisScanlineFill::fillColor(const KoColor &fillColor)
     const int pixelSize = m_d->device->pixelSize();
 
     if (pixelSize == 1) {
-        SelectionPolicy<false, DifferencePolicyOptimized<quint8>, FillWithColor>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicyOptimized<quint8>, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     } else if (pixelSize == 2) {
-        SelectionPolicy<false, DifferencePolicyOptimized<quint16>, FillWithColor>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicyOptimized<quint16>, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     } else if (pixelSize == 4) {
-        SelectionPolicy<false, DifferencePolicyOptimized<quint32>, FillWithColor>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicyOptimized<quint32>, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     } else if (pixelSize == 8) {
-        SelectionPolicy<false, DifferencePolicyOptimized<quint64>, FillWithColor>
-              policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicyOptimized<quint64>, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     } else {
-        SelectionPolicy<false, DifferencePolicySlow, FillWithColor>
-              policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicySlow, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     }
 }
 
@@ -509,35 +971,45 @@ void KisScanlineFill::fillColor(const KoColor &fillColor, KisPaintDeviceSP exter
     const int pixelSize = m_d->device->pixelSize();
 
     if (pixelSize == 1) {
-        SelectionPolicy<false, DifferencePolicyOptimized<quint8>, FillWithColorExternal>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationDevice(externalDevice);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(externalDevice, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicyOptimized<quint8>, FillWithColorExternal>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationDevice(externalDevice);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     } else if (pixelSize == 2) {
-        SelectionPolicy<false, DifferencePolicyOptimized<quint16>, FillWithColorExternal>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationDevice(externalDevice);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(externalDevice, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicyOptimized<quint16>, FillWithColorExternal>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationDevice(externalDevice);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     } else if (pixelSize == 4) {
-        SelectionPolicy<false, DifferencePolicyOptimized<quint32>, FillWithColorExternal>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationDevice(externalDevice);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(externalDevice, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicyOptimized<quint32>, FillWithColorExternal>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationDevice(externalDevice);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     } else if (pixelSize == 8) {
-        SelectionPolicy<false, DifferencePolicyOptimized<quint64>, FillWithColorExternal>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationDevice(externalDevice);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(externalDevice, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicyOptimized<quint64>, FillWithColorExternal>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationDevice(externalDevice);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     } else {
-        SelectionPolicy<false, DifferencePolicySlow, FillWithColorExternal>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationDevice(externalDevice);
-        policy.setFillColor(fillColor);
-        runImpl(policy);
+        run(externalDevice, [&] () {
+            auto *policy = new SelectionPolicy<false, DifferencePolicySlow, FillWithColorExternal>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationDevice(externalDevice);
+            policy->setFillColor(fillColor);
+            return policy;
+        });
     }
 }
 
@@ -549,30 +1021,40 @@ void KisScanlineFill::fillSelection(KisPixelSelectionSP pixelSelection)
     const int pixelSize = m_d->device->pixelSize();
 
     if (pixelSize == 1) {
-        SelectionPolicy<true, DifferencePolicyOptimized<quint8>, CopyToSelection>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        run(pixelSelection, [&] () {
+            auto *policy = new SelectionPolicy<true, DifferencePolicyOptimized<quint8>, CopyToSelection>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationSelection(pixelSelection);
+            return policy;
+        });
     } else if (pixelSize == 2) {
-        SelectionPolicy<true, DifferencePolicyOptimized<quint16>, CopyToSelection>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        run(pixelSelection, [&] () {
+            auto *policy = new SelectionPolicy<true, DifferencePolicyOptimized<quint16>, CopyToSelection>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationSelection(pixelSelection);
+            return policy;
+        });
     } else if (pixelSize == 4) {
-        SelectionPolicy<true, DifferencePolicyOptimized<quint32>, CopyToSelection>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        run(pixelSelection, [&] () {
+            auto *policy = new SelectionPolicy<true, DifferencePolicyOptimized<quint32>, CopyToSelection>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationSelection(pixelSelection);
+            return policy;
+        });
     } else if (pixelSize == 8) {
-        SelectionPolicy<true, DifferencePolicyOptimized<quint64>, CopyToSelection>
-              policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        run(pixelSelection, [&] () {
+            auto *policy = new SelectionPolicy<true, DifferencePolicyOptimized<quint64>, CopyToSelection>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationSelection(pixelSelection);
+            return policy;
+        });
     } else {
-        SelectionPolicy<true, DifferencePolicySlow, CopyToSelection>
-              policy(m_d->device, srcColor, m_d->threshold);
-        policy.setDestinationSelection(pixelSelection);
-        runImpl(policy);
+        run(pixelSelection, [&] () {
+            auto *policy = new SelectionPolicy<true, DifferencePolicySlow, CopyToSelection>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setDestinationSelection(pixelSelection);
+            return policy;
+        });
     }
 }
 
@@ -582,30 +1064,40 @@ void KisScanlineFill::clearNonZeroComponent()
     KoColor srcColor(Qt::transparent, m_d->device->colorSpace());
 
     if (pixelSize == 1) {
-        SelectionPolicy<false, IsNonNullPolicyOptimized<quint8>, FillWithColor>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(srcColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, IsNonNullPolicyOptimized<quint8>, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(srcColor);
+            return policy;
+        });
     } else if (pixelSize == 2) {
-        SelectionPolicy<false, IsNonNullPolicyOptimized<quint16>, FillWithColor>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(srcColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, IsNonNullPolicyOptimized<quint16>, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(srcColor);
+            return policy;
+        });
     } else if (pixelSize == 4) {
-        SelectionPolicy<false, IsNonNullPolicyOptimized<quint32>, FillWithColor>
-            policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(srcColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, IsNonNullPolicyOptimized<quint32>, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(srcColor);
+            return policy;
+        });
     } else if (pixelSize == 8) {
-        SelectionPolicy<false, IsNonNullPolicyOptimized<quint64>, FillWithColor>
-              policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(srcColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, IsNonNullPolicyOptimized<quint64>, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(srcColor);
+            return policy;
+        });
     } else {
-        SelectionPolicy<false, IsNonNullPolicySlow, FillWithColor>
-              policy(m_d->device, srcColor, m_d->threshold);
-        policy.setFillColor(srcColor);
-        runImpl(policy);
+        run(m_d->device, [&] () {
+            auto *policy = new SelectionPolicy<false, IsNonNullPolicySlow, FillWithColor>
+                (m_d->device, srcColor, m_d->threshold);
+            policy->setFillColor(srcColor);
+            return policy;
+        });
     }
 }
 
@@ -30,6 +30,13 @@ class KisFillIntervalMap;
 
 class KRITAIMAGE_EXPORT KisScanlineFill
 {
+public:
+    enum ParallelMode {
+        ParallelAuto, ///< parallel fill is used for large bounding rects only
+        ParallelNever,
+        ParallelAlways
+    };
+
 public:
     KisScanlineFill(KisPaintDeviceSP device, const QPoint &startPoint, const QRect &boundingRect);
     ~KisScanlineFill();
@@ -64,6 +71,23 @@ public:
      */
     void setThreshold(int threshold);
 
+    /**
+     * Set if the fill should be split between several threads.
+     *
+     * In the parallel mode the bounding rect is split into blocks. The
+     * blocks are scanned in waves starting from the block of the start
+     * point: the contiguous areas are labelled in every block of a wave
+     * concurrently, the labels are merged across the borders of the
+     * blocks and the next wave gets the blocks the area of the start
+     * point runs into. Finally, the area is filled concurrently again.
+     *
+     * Please take into account that the parallel fill checks every pixel
+     * of the blocks it reaches, even when the filled area covers only a
+     * small part of them, so the default mode (ParallelAuto) enables it
+     * for large bounding rects only.
+     */
+    void setParallelMode(ParallelMode mode);
+
 private:
     friend class KisScanlineFillTest;
     Q_DISABLE_COPY(KisScanlineFill)
@@ -78,6 +102,14 @@ private:
     template <class T>
     void runImpl(T &pixelPolicy);
 
+    template <class PolicyFactory>
+    void runParallelImpl(KisPaintDeviceSP dstDevice, PolicyFactory createPolicy);
+
+    template <class PolicyFactory>
+    void run(KisPaintDeviceSP dstDevice, PolicyFactory createPolicy);
+
+    bool useParallelFill() const;
+
 private:
     void testingProcessLine(const KisFillInterval &processInterval);
     QVector<KisFillInterval> testingGetForwardIntervals() const;
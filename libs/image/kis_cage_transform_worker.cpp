@@ -370,12 +370,14 @@ void KisCageTransformWorker::run()
     }
 
     GridIterationTools::PaintDevicePolygonOp polygonOp(srcDev, tempDevice);
+    GridIterationTools::ParallelPolygonOp<GridIterationTools::PaintDevicePolygonOp> parallelOp(polygonOp);
     Private::MapIndexesOp indexesOp(m_d.data());
     GridIterationTools::iterateThroughGrid
-        <GridIterationTools::IncompletePolygonPolicy>(polygonOp, indexesOp,
+        <GridIterationTools::IncompletePolygonPolicy>(parallelOp, indexesOp,
                                                       m_d->gridSize,
                                                       m_d->validPoints,
                                                       transformedPoints);
+    parallelOp.finish();
 
     QRect rect = tempDevice->extent();
     KisPainter gc(m_d->dev);
@@ -432,12 +434,14 @@ QImage KisCageTransformWorker::runOnQImage(QPointF *newOffset)
     }
 
     GridIterationTools::QImagePolygonOp polygonOp(m_d->srcImage, tempImage, m_d->srcImageOffset, dstQImageOffset);
+    GridIterationTools::ParallelPolygonOp<GridIterationTools::QImagePolygonOp> parallelOp(polygonOp);
     Private::MapIndexesOp indexesOp(m_d.data());
     GridIterationTools::iterateThroughGrid
-        <GridIterationTools::IncompletePolygonPolicy>(polygonOp, indexesOp,
+        <GridIterationTools::IncompletePolygonPolicy>(parallelOp, indexesOp,
                                                       m_d->gridSize,
                                                       m_d->validPoints,
                                                       transformedPoints);
+    parallelOp.finish();
 
     {
         QPainter gc(&dstImage);
@@ -28,23 +28,49 @@
 #include "kis_math_toolbox.h"
 
 #include <QMutex>
+#include <QMutexLocker>
 #include <QVector>
 #include <QTextStream>
 #include <QFile>
 #include <QDir>
 
+#include <QtConcurrent>
+
 #include <fftw3.h>
 
-template<class _IteratorFactory_> class KisConvolutionWorkerFFT;
-class KisConvolutionWorkerFFTLock
-{
-private:
-    static QMutex fftwMutex;
-    template<class _IteratorFactory_> friend class KisConvolutionWorkerFFT;
-};
+#include "kis_fftw_plan_cache.h"
+
+namespace KisConvolutionWorkerFFTPrivate {
 
-QMutex KisConvolutionWorkerFFTLock::fftwMutex;
+/**
+ * The minimal size of the transform used for processing big areas
+ * block by block
+ */
+const int minimalBlockFFTSize = 512;
+
+/**
+ * Calculates the size of the transform and the size of the block
+ * written by each transform for one dimension of the area
+ */
+inline void calculateBlockGeometry(int areaSize, int padding,
+                                   int *fftSize, int *blockSize,
+                                   bool *useBlocks)
+{
+    const int singleBlockFFTSize = KisFFTWPlanCache::optimalSize(areaSize + padding);
+    const int preferredFFTSize =
+        KisFFTWPlanCache::optimalSize(qMax(minimalBlockFFTSize, 2 * padding));
+
+    if (singleBlockFFTSize <= preferredFFTSize) {
+        *fftSize = singleBlockFFTSize;
+        *blockSize = areaSize;
+    } else {
+        *fftSize = preferredFFTSize;
+        *blockSize = preferredFFTSize - padding;
+        *useBlocks = true;
+    }
+}
 
+}
 
 template<class _IteratorFactory_>
 class KisConvolutionWorkerFFT : public KisConvolutionWorker<_IteratorFactory_>
@@ -52,8 +78,7 @@ class KisConvolutionWorkerFFT : public KisConvolutionWorker<_IteratorFactory_>
 public:
     KisConvolutionWorkerFFT(KisPainter *painter, KoUpdater *progress)
         : KisConvolutionWorker<_IteratorFactory_>(painter, progress),
-          m_currentProgress(0),
-          m_kernelFFT(0)
+          m_currentProgress(0)
     {
     }
 
@@ -82,89 +107,73 @@ public:
         const quint32 halfKernelWidth = (kernel->width() - 1) / 2;
         const quint32 halfKernelHeight = (kernel->height() - 1) / 2;
 
-        m_fftWidth = areaSize.width() + 4 * halfKernelWidth;
-        m_fftHeight = areaSize.height() + 2 * halfKernelHeight;
-
         /**
-         * FIXME: check whether this "optimization" is needed to
-         * be uncommented. My tests showed about 30% better performance
-         * when the line is commented out (DK).
+         * Big areas are split into blocks which are convolved
+         * independently (overlap-save) and in parallel. All the blocks
+         * share the same size of the transform, so they use the same
+         * FFTW plans and the same spectrum of the kernel, both of which
+         * are also shared with the other jobs of the filter through
+         * KisFFTWPlanCache.
+         *
+         * The sizes of the transforms are rounded up to the ones having
+         * only small prime factors, since FFTW is the most efficient on
+         * them.
          */
-        //optimumDimensions(m_fftWidth, m_fftHeight);
-
+        int blockWidth = 0;
+        int blockHeight = 0;
+        int fftWidth = 0;
+        int fftHeight = 0;
+        bool useBlocks = false;
+
+        KisConvolutionWorkerFFTPrivate::calculateBlockGeometry(areaSize.width(), 4 * halfKernelWidth,
+                                                               &fftWidth, &blockWidth, &useBlocks);
+        KisConvolutionWorkerFFTPrivate::calculateBlockGeometry(areaSize.height(), 2 * halfKernelHeight,
+                                                               &fftHeight, &blockHeight, &useBlocks);
+
+        m_fftWidth = fftWidth;
+        m_fftHeight = fftHeight;
         m_fftLength = m_fftHeight * (m_fftWidth / 2 + 1);
         m_extraMem = (m_fftWidth % 2) ? 1 : 2;
 
-        // create and fill kernel
-        m_kernelFFT = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
-        memset(m_kernelFFT, 0, sizeof(fftw_complex) * m_fftLength);
-        fftFillKernelMatrix(kernel, m_kernelFFT);
+        KisFFTWPlanCache *planCache = KisFFTWPlanCache::instance();
+        m_plans = planCache->plans(m_fftWidth, m_fftHeight, useBlocks);
+        m_kernelFFT = planCache->kernelSpectrum(m_fftWidth, m_fftHeight, kernel);
+
+        addToProgress(10);
+        if (isInterrupted()) return;
 
         // find out which channels need convolving
         QList<KoChannelInfo*> convChannelList = this->convolvableChannelList(src);
 
-        m_channelFFT.resize(convChannelList.count());
-        for (auto i = m_channelFFT.begin(); i != m_channelFFT.end(); ++i) {
-            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
-        }
-
         const double kernelFactor = kernel->factor() ? kernel->factor() : 1;
         const double fftScale = 1.0 / (m_fftHeight * m_fftWidth) / kernelFactor;
 
         FFTInfo info (fftScale, convChannelList, kernel, this->m_painter->device()->colorSpace());
-        int cacheRowStride = m_fftWidth + m_extraMem;
 
-        fillCacheFromDevice(src,
-                            QRect(srcPos.x() - halfKernelWidth,
-                                  srcPos.y() - halfKernelHeight,
-                                  m_fftWidth,
-                                  m_fftHeight),
-                            cacheRowStride,
-                            info, dataRect);
-
-        addToProgress(10);
-        if (isInterrupted()) return;
-
-        // calculate number off fft operations required for progress reporting
-        const float progressPerFFT = (100 - 30) / (double)(convChannelList.count() * 2 + 1);
-
-        // perform FFT
-        fftw_plan fftwPlanForward, fftwPlanBackward;
-
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftwPlanForward = fftw_plan_dft_r2c_2d(m_fftHeight, m_fftWidth, (double*)m_kernelFFT, m_kernelFFT, FFTW_ESTIMATE);
-        fftwPlanBackward = fftw_plan_dft_c2r_2d(m_fftHeight, m_fftWidth, m_kernelFFT, (double*)m_kernelFFT, FFTW_ESTIMATE);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+        QVector<QRect> blocks;
+        for (int y = 0; y < areaSize.height(); y += blockHeight) {
+            for (int x = 0; x < areaSize.width(); x += blockWidth) {
+                blocks << QRect(x, y,
+                                qMin(blockWidth, areaSize.width() - x),
+                                qMin(blockHeight, areaSize.height() - y));
+            }
+        }
 
-        fftw_execute(fftwPlanForward);
-        addToProgress(progressPerFFT);
-        if (isInterrupted()) return;
+        m_progressPerBlock = (100 - 10) / qreal(blocks.size());
 
-        for (auto k = m_channelFFT.begin(); k != m_channelFFT.end(); ++k)
-        {
-            fftw_execute_dft_r2c(fftwPlanForward, (double*)(*k), *k);
-            addToProgress(progressPerFFT);
+        QtConcurrent::blockingMap(blocks, [&] (const QRect &block) {
             if (isInterrupted()) return;
 
-            fftMultiply(*k, m_kernelFFT);
-
-            fftw_execute_dft_c2r(fftwPlanBackward, *k, (double*)*k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
-        }
+            processBlock(src,
+                         srcPos + block.topLeft(),
+                         QRect(dstPos + block.topLeft(), block.size()),
+                         halfKernelWidth, halfKernelHeight,
+                         info, dataRect);
 
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftw_destroy_plan(fftwPlanForward);
-        fftw_destroy_plan(fftwPlanBackward);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+            addToProgress(m_progressPerBlock);
+        });
 
-
-        writeResultToDevice(QRect(dstPos.x(), dstPos.y(), areaSize.width(), areaSize.height()),
-                            cacheRowStride, halfKernelWidth, halfKernelHeight,
-                            info, dataRect);
-
-        addToProgress(20);
-        cleanUp();
+        m_kernelFFT.clear();
     }
 
     struct FFTInfo {
@@ -222,7 +231,8 @@ public:
                              const QRect &rect,
                              const int cacheRowStride,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<fftw_complex*> &channelFFT) {
 
         typename _IteratorFactory_::HLineConstIterator hitSrc =
             _IteratorFactory_::createHLineConstIterator(src,
@@ -234,7 +244,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt;
         }
@@ -313,7 +323,8 @@ public:
                              const int halfKernelWidth,
                              const int halfKernelHeight,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<fftw_complex*> &channelFFT) {
 
         typename _IteratorFactory_::HLineIterator hitDst =
             _IteratorFactory_::createHLineIterator(this->m_painter->device(),
@@ -327,7 +338,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt + initialOffset;
         }
@@ -399,34 +410,46 @@ public:
 
     }
 
-private:
-    void fftFillKernelMatrix(const KisConvolutionKernelSP kernel, fftw_complex *m_kernelFFT)
+    void processBlock(const KisPaintDeviceSP src,
+                      const QPoint &srcPos,
+                      const QRect &dstRect,
+                      const quint32 halfKernelWidth,
+                      const quint32 halfKernelHeight,
+                      const FFTInfo &info,
+                      const QRect &dataRect)
     {
-        // find central item
-        QPoint offset((kernel->width() - 1) / 2, (kernel->height() - 1) / 2);
+        QVector<fftw_complex*> channelFFT(info.numChannels());
+        for (auto i = channelFFT.begin(); i != channelFFT.end(); ++i) {
+            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
+        }
 
-        qint32 xShift = m_fftWidth - offset.x();
-        qint32 yShift = m_fftHeight - offset.y();
+        const int cacheRowStride = m_fftWidth + m_extraMem;
 
-        quint32 absXpos, absYpos;
+        fillCacheFromDevice(src,
+                            QRect(srcPos.x() - halfKernelWidth,
+                                  srcPos.y() - halfKernelHeight,
+                                  m_fftWidth,
+                                  m_fftHeight),
+                            cacheRowStride,
+                            info, dataRect, channelFFT);
 
-        for (quint32 y = 0; y < kernel->height(); y++)
+        for (auto k = channelFFT.begin(); k != channelFFT.end(); ++k)
         {
-            absYpos = y + yShift;
-            if (absYpos >= m_fftHeight)
-                absYpos -= m_fftHeight;
+            fftw_execute_dft_r2c(m_plans->forward, (double*)(*k), *k);
+            fftMultiply(*k, m_kernelFFT.data());
+            fftw_execute_dft_c2r(m_plans->backward, *k, (double*)*k);
+        }
 
-            for (quint32 x = 0; x < kernel->width(); x++)
-            {
-                absXpos = x + xShift;
-                if (absXpos >= m_fftWidth)
-                    absXpos -= m_fftWidth;
+        writeResultToDevice(dstRect,
+                            cacheRowStride, halfKernelWidth, halfKernelHeight,
+                            info, dataRect, channelFFT);
 
-                ((double*)m_kernelFFT)[(m_fftWidth + m_extraMem) * absYpos + absXpos] = kernel->data()->coeff(y, x);
-            }
+        Q_FOREACH (fftw_complex *channel, channelFFT) {
+            fftw_free(channel);
         }
     }
 
+private:
     void fftMultiply(fftw_complex* channel, fftw_complex* kernel)
     {
         // perform complex multiplication
@@ -448,38 +471,15 @@ private:
         }
     }
 
-    void optimumDimensions(quint32& w, quint32& h)
-    {
-        // FFTW is most efficient when array size is a factor of 2, 3, 5 or 7
-        quint32 optW = w, optH = h;
-
-        while ((optW % 2 != 0) || (optW % 3 != 0) || (optW % 5 != 0) || (optW % 7 != 0))
-            ++optW;
-
-        while ((optH % 2 != 0) || (optH % 3 != 0) || (optH % 5 != 0) || (optH % 7 != 0))
-            ++optH;
-
-        quint32 optAreaW = optW * h;
-        quint32 optAreaH = optH * w;
-
-        if (optAreaW < optAreaH) {
-            w = optW;
-        }
-        else {
-            h = optH;
-        }
-    }
-
     void fftLogMatrix(double* channel, const QString &f)
     {
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
+        QMutexLocker l(&m_mutex);
         QString filename(QDir::homePath() + "/log_" + f + ".txt");
         dbgKrita << "Log File Name: " << filename;
         QFile file (filename);
         if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
         {
             dbgKrita << "Failed";
-            KisConvolutionWorkerFFTLock::fftwMutex.unlock();
             return;
         }
 
@@ -496,11 +496,12 @@ private:
             }
             in << "\n";
         }
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
     }
 
     void addToProgress(float amount)
     {
+        QMutexLocker l(&m_mutex);
+
         m_currentProgress += amount;
 
         if (this->m_progress) {
@@ -510,32 +511,17 @@ private:
 
     bool isInterrupted()
     {
-        if (this->m_progress && this->m_progress->interrupted()) {
-            cleanUp();
-            return true;
-        }
-
-        return false;
+        return this->m_progress && this->m_progress->interrupted();
     }
 
-    void cleanUp()
-    {
-        // free kernel fft data
-        if (m_kernelFFT) {
-            fftw_free(m_kernelFFT);
-        }
-
-        Q_FOREACH (fftw_complex *channel, m_channelFFT) {
-            fftw_free(channel);
-        }
-        m_channelFFT.clear();
-    }
 private:
     quint32 m_fftWidth, m_fftHeight, m_fftLength, m_extraMem;
     float m_currentProgress;
+    float m_progressPerBlock;
+    QMutex m_mutex;
 
-    fftw_complex* m_kernelFFT;
-    QVector<fftw_complex*> m_channelFFT;
+    KisFFTWPlanCache::PlansSP m_plans;
+    KisFFTWPlanCache::SpectrumSP m_kernelFFT;
 };
 
 #endif
@@ -50,7 +50,8 @@ struct Q_DECL_HIDDEN KisDistanceInformation::Private {
         lastPaintInfoValid(false),
         lockedDrawingAngle(0.0),
         hasLockedDrawingAngle(false),
-        totalDistance(0.0) {}
+        totalDistance(0.0),
+        numPaintedDabs(0) {}
 
     // Accumulators of time/distance passed since the last painted dab
     QPointF accumDistance;
@@ -79,6 +80,7 @@ struct Q_DECL_HIDDEN KisDistanceInformation::Private {
     qreal lockedDrawingAngle;
     bool hasLockedDrawingAngle;
     qreal totalDistance;
+    int numPaintedDabs;
 };
 
 struct Q_DECL_HIDDEN KisDistanceInitInfo::Private {
@@ -371,11 +373,17 @@ bool KisDistanceInformation::isStarted() const
     return m_d->lastPaintInfoValid;
 }
 
+int KisDistanceInformation::numPaintedDabs() const
+{
+    return m_d->numPaintedDabs;
+}
+
 void KisDistanceInformation::registerPaintedDab(const KisPaintInformation &info,
                                                 const KisSpacingInformation &spacing,
                                                 const KisTimingInformation &timing)
 {
     m_d->totalDistance += KisAlgebra2D::norm(info.pos() - m_d->lastPosition);
+    m_d->numPaintedDabs++;
 
     m_d->lastPaintInformation = info;
     m_d->lastPaintInfoValid = true;
@@ -159,6 +159,11 @@ public:
      */
     bool isStarted() const;
 
+    /**
+     * \return the number of dabs registered with registerPaintedDab()
+     */
+    int numPaintedDabs() const;
+
     bool hasLockedDrawingAngle() const;
     qreal lockedDrawingAngle() const;
     void setLockedDrawingAngle(qreal angle);
@@ -0,0 +1,371 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_fftw_plan_cache.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <QGlobalStatic>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QStandardPaths>
+
+#include "kis_convolution_kernel.h"
+#include "kis_debug.h"
+
+Q_GLOBAL_STATIC(KisFFTWPlanCache, s_instance)
+
+namespace {
+
+/**
+ * The plans of all the sizes used during the session are not needed,
+ * the filters usually use only a few sizes at a time.
+ */
+const int maxCachedPlans = 16;
+
+/**
+ * The spectra of big kernels applied to big blocks may take a lot of
+ * memory, so we keep only a few recent ones.
+ */
+const int maxCachedSpectra = 8;
+const qint64 maxCachedSpectraMemory = 64 * 1024 * 1024;
+
+struct CachedPlans {
+    int width;
+    int height;
+    unsigned flags;
+    KisFFTWPlanCache::PlansSP plans;
+};
+
+struct CachedSpectrum {
+    int width;
+    int height;
+    QVector<qreal> kernelCoefficients;
+    KisFFTWPlanCache::SpectrumSP spectrum;
+    qint64 memory;
+};
+
+QVector<qreal> kernelCoefficients(const KisConvolutionKernelSP kernel)
+{
+    QVector<qreal> result;
+    result.reserve(2 + kernel->width() * kernel->height());
+
+    result << kernel->width();
+    result << kernel->height();
+
+    for (quint32 y = 0; y < kernel->height(); y++) {
+        for (quint32 x = 0; x < kernel->width(); x++) {
+            result << kernel->data()->coeff(y, x);
+        }
+    }
+
+    return result;
+}
+
+QString wisdomFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+        QDir::separator() + "fftw_wisdom.txt";
+}
+
+}
+
+struct KisFFTWPlanCache::Private
+{
+    /**
+     * Guards the cached plans and spectra
+     */
+    QMutex mutex;
+
+    /**
+     * The FFTW planner is not thread-safe: creating and destroying the
+     * plans and accessing the wisdom is serialized with this lock. The
+     * plans evicted from the cache may still be used by the workers, so
+     * they keep the lock alive until they are destroyed.
+     */
+    QSharedPointer<QMutex> plannerMutex = QSharedPointer<QMutex>(new QMutex);
+
+    QList<CachedPlans> plans;
+
+    QList<CachedSpectrum> spectra;
+    qint64 spectraMemory = 0;
+
+    QString wisdomFileName;
+    bool wisdomChanged = false;
+
+    PlansSP findPlans(int width, int height, unsigned flags);
+    PlansSP createPlans(int width, int height, unsigned flags);
+
+    void loadWisdom();
+    void saveWisdom();
+};
+
+KisFFTWPlanCache::PlansSP KisFFTWPlanCache::Private::findPlans(int width, int height, unsigned flags)
+{
+    for (int i = 0; i < plans.size(); i++) {
+        const CachedPlans &cached = plans[i];
+
+        if (cached.width == width &&
+            cached.height == height &&
+            cached.flags == flags) {
+
+            plans.move(i, 0);
+            return plans.first().plans;
+        }
+    }
+
+    return PlansSP();
+}
+
+KisFFTWPlanCache::PlansSP KisFFTWPlanCache::Private::createPlans(int width, int height, unsigned flags)
+{
+    const int length = height * (width / 2 + 1);
+
+    /**
+     * FFTW_MEASURE overwrites the arrays while planning, so we always plan
+     * on a scratch buffer. It has the same alignment as the buffers
+     * allocated by the worker, since both come from fftw_malloc().
+     */
+    fftw_complex *buffer = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * length);
+
+    Plans *plans = new Plans;
+    plans->forward = fftw_plan_dft_r2c_2d(height, width, (double*)buffer, buffer, flags);
+    plans->backward = fftw_plan_dft_c2r_2d(height, width, buffer, (double*)buffer, flags);
+
+    fftw_free(buffer);
+
+    QSharedPointer<QMutex> plannerMutex = this->plannerMutex;
+
+    return PlansSP(plans,
+        [plannerMutex] (Plans *plans) {
+            QMutexLocker l(plannerMutex.data());
+            fftw_destroy_plan(plans->forward);
+            fftw_destroy_plan(plans->backward);
+            delete plans;
+        });
+}
+
+void KisFFTWPlanCache::Private::loadWisdom()
+{
+    QFile file(wisdomFileName);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) return;
+
+    const QByteArray wisdom = file.readAll();
+
+    QMutexLocker l(plannerMutex.data());
+    if (!fftw_import_wisdom_from_string(wisdom.constData())) {
+        warnKrita << "WARNING: failed to load FFTW wisdom from" << file.fileName();
+    }
+}
+
+void KisFFTWPlanCache::Private::saveWisdom()
+{
+    QByteArray wisdom;
+
+    {
+        QMutexLocker l(plannerMutex.data());
+
+        char *wisdomString = fftw_export_wisdom_to_string();
+        if (!wisdomString) return;
+
+        wisdom = wisdomString;
+        free(wisdomString);
+    }
+
+    QDir().mkpath(QFileInfo(wisdomFileName).absolutePath());
+
+    QFile file(wisdomFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        warnKrita << "WARNING: failed to save FFTW wisdom into" << file.fileName();
+        return;
+    }
+
+    file.write(wisdom);
+}
+
+KisFFTWPlanCache::KisFFTWPlanCache()
+    : m_d(new Private)
+{
+    /**
+     * The name is resolved now, while the application object still
+     * exists: the wisdom is saved when the cache is destroyed on exit.
+     */
+    m_d->wisdomFileName = wisdomFileName();
+    m_d->loadWisdom();
+}
+
+KisFFTWPlanCache::~KisFFTWPlanCache()
+{
+    if (m_d->wisdomChanged) {
+        m_d->saveWisdom();
+    }
+}
+
+KisFFTWPlanCache* KisFFTWPlanCache::instance()
+{
+    return s_instance;
+}
+
+KisFFTWPlanCache::PlansSP KisFFTWPlanCache::plans(int width, int height, bool reusable)
+{
+    const unsigned flags = reusable ? FFTW_MEASURE : FFTW_ESTIMATE;
+
+    {
+        QMutexLocker l(&m_d->mutex);
+
+        PlansSP plans = m_d->findPlans(width, height, flags);
+        if (plans) return plans;
+    }
+
+    PlansSP plans;
+
+    {
+        QMutexLocker plannerLocker(m_d->plannerMutex.data());
+
+        /**
+         * Measuring may take a while, so check whether another thread
+         * has created the same plans while we were waiting for the
+         * planner
+         */
+        {
+            QMutexLocker l(&m_d->mutex);
+            plans = m_d->findPlans(width, height, flags);
+        }
+
+        if (plans) return plans;
+
+        plans = m_d->createPlans(width, height, flags);
+    }
+
+    /**
+     * The evicted plans must be destroyed after the lock is released,
+     * since their deleter takes the planner lock
+     */
+    QList<CachedPlans> evictedPlans;
+
+    QMutexLocker l(&m_d->mutex);
+
+    CachedPlans cached;
+    cached.width = width;
+    cached.height = height;
+    cached.flags = flags;
+    cached.plans = plans;
+
+    m_d->plans.prepend(cached);
+
+    while (m_d->plans.size() > maxCachedPlans) {
+        evictedPlans << m_d->plans.takeLast();
+    }
+
+    if (reusable) {
+        m_d->wisdomChanged = true;
+    }
+
+    return plans;
+}
+
+KisFFTWPlanCache::SpectrumSP
+KisFFTWPlanCache::kernelSpectrum(int width, int height, const KisConvolutionKernelSP kernel)
+{
+    const QVector<qreal> coefficients = kernelCoefficients(kernel);
+
+    {
+        QMutexLocker l(&m_d->mutex);
+
+        for (auto it = m_d->spectra.begin(); it != m_d->spectra.end(); ++it) {
+            if (it->width == width &&
+                it->height == height &&
+                it->kernelCoefficients == coefficients) {
+
+                const CachedSpectrum spectrum = *it;
+                m_d->spectra.erase(it);
+                m_d->spectra.prepend(spectrum);
+
+                return spectrum.spectrum;
+            }
+        }
+    }
+
+    const PlansSP plans = this->plans(width, height, false);
+
+    const int length = height * (width / 2 + 1);
+    const int rowStride = 2 * (width / 2 + 1);
+
+    SpectrumSP spectrum((fftw_complex*)fftw_malloc(sizeof(fftw_complex) * length), fftw_free);
+    memset(spectrum.data(), 0, sizeof(fftw_complex) * length);
+
+    // place the center of the kernel at the origin, wrapping it around
+    const int xShift = width - (kernel->width() - 1) / 2;
+    const int yShift = height - (kernel->height() - 1) / 2;
+
+    double *data = (double*)spectrum.data();
+
+    for (quint32 y = 0; y < kernel->height(); y++) {
+        const int absYpos = (y + yShift) % height;
+
+        for (quint32 x = 0; x < kernel->width(); x++) {
+            const int absXpos = (x + xShift) % width;
+            data[rowStride * absYpos + absXpos] = kernel->data()->coeff(y, x);
+        }
+    }
+
+    fftw_execute_dft_r2c(plans->forward, data, spectrum.data());
+
+    CachedSpectrum cached;
+    cached.width = width;
+    cached.height = height;
+    cached.kernelCoefficients = coefficients;
+    cached.spectrum = spectrum;
+    cached.memory = sizeof(fftw_complex) * length;
+
+    if (cached.memory <= maxCachedSpectraMemory) {
+        QMutexLocker l(&m_d->mutex);
+
+        m_d->spectra.prepend(cached);
+        m_d->spectraMemory += cached.memory;
+
+        while (m_d->spectra.size() > maxCachedSpectra ||
+               m_d->spectraMemory > maxCachedSpectraMemory) {
+
+            m_d->spectraMemory -= m_d->spectra.last().memory;
+            m_d->spectra.removeLast();
+        }
+    }
+
+    return spectrum;
+}
+
+int KisFFTWPlanCache::optimalSize(int size)
+{
+    for (int result = qMax(1, size);; result++) {
+        int value = result;
+
+        while (value % 2 == 0) value /= 2;
+        while (value % 3 == 0) value /= 3;
+        while (value % 5 == 0) value /= 5;
+        while (value % 7 == 0) value /= 7;
+
+        if (value == 1) return result;
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_FFTW_PLAN_CACHE_H
+#define __KIS_FFTW_PLAN_CACHE_H
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+#include <fftw3.h>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+/**
+ * A process-wide cache of FFTW plans and kernel spectra used by
+ * KisConvolutionWorkerFFT.
+ *
+ * All the plans are created for in-place 2D transforms of real data
+ * padded to 2 * (width / 2 + 1) doubles per row and allocated with
+ * fftw_malloc(). The FFTW planner is not thread-safe, so the planning
+ * happens under the cache's lock only. Executing a plan on new arrays
+ * (fftw_execute_dft_r2c()/fftw_execute_dft_c2r()) is thread-safe, so the
+ * returned plans may be used by any number of workers concurrently.
+ *
+ * Only a few recently used plans are kept in the cache. The plans are
+ * shared, so the ones evicted from the cache are destroyed when the last
+ * worker releases them.
+ *
+ * The plans requested as \p reusable are measured rather than estimated.
+ * The wisdom gathered by measuring them is saved into the application
+ * data directory when the cache is destroyed and loaded again in the
+ * next session.
+ */
+class KRITAIMAGE_EXPORT KisFFTWPlanCache
+{
+public:
+    struct Plans {
+        fftw_plan forward;
+        fftw_plan backward;
+    };
+
+    typedef QSharedPointer<const Plans> PlansSP;
+    typedef QSharedPointer<fftw_complex> SpectrumSP;
+
+public:
+    KisFFTWPlanCache();
+    ~KisFFTWPlanCache();
+
+    static KisFFTWPlanCache* instance();
+
+    /**
+     * Returns the forward (r2c) and backward (c2r) plans for the
+     * transform of \p width x \p height real values. The estimated and
+     * the measured plans of the same size are cached separately.
+     */
+    PlansSP plans(int width, int height, bool reusable);
+
+    /**
+     * Returns the forward transform of \p kernel wrapped around the
+     * origin of a \p width x \p height array. The spectra of the recently
+     * used kernels are kept in the cache, so the kernel is transformed
+     * only once for all the jobs of a filter.
+     */
+    SpectrumSP kernelSpectrum(int width, int height, const KisConvolutionKernelSP kernel);
+
+    /**
+     * Returns the smallest size not less than \p size which has no prime
+     * factors other than 2, 3, 5 and 7. FFTW is the most efficient on
+     * such sizes.
+     */
+    static int optimalSize(int size);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_FFTW_PLAN_CACHE_H */
@@ -79,6 +79,15 @@ bool KisFixedPaintDevice::initialize(quint8 defaultValue)
     return true;
 }
 
+void KisFixedPaintDevice::lazyGrowBufferWithoutInitialization()
+{
+    const int referenceSize = m_bounds.height() * m_bounds.width() * pixelSize();
+
+    if (m_data.size() < referenceSize) {
+        m_data.resize(referenceSize);
+    }
+}
+
 quint8* KisFixedPaintDevice::data()
 {
     return m_data.data();
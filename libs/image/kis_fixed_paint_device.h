@@ -92,6 +92,14 @@ public:
      */
     bool initialize(quint8 defaultValue = 0);
 
+    /**
+     * Grows the internal buffer to fit bounds() if it is too small.
+     * The buffer is never shrunk and its content is not initialized,
+     * so the device can be reused as a scratch buffer of varying size
+     * without reallocations.
+     */
+    void lazyGrowBufferWithoutInitialization();
+
     /**
      * @return a pointer to the beginning of the data associated with this fixed paint device.
      */
@@ -22,6 +22,13 @@
 #include "kis_convolution_kernel.h"
 #include <kis_convolution_painter.h>
 #include <QRect>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <KoUpdater.h>
+#include <KoColorSpace.h>
+#include <KoChannelInfo.h>
+#include "kis_paint_device.h"
 
 
 qreal KisGaussianKernel::sigmaFromRadius(qreal radius)
@@ -103,8 +110,19 @@ void KisGaussianKernel::applyGaussian(KisPaintDeviceSP device,
                                       const QRect& rect,
                                       qreal xRadius, qreal yRadius,
                                       const QBitArray &channelFlags,
-                                      KoUpdater *progressUpdater)
+                                      KoUpdater *progressUpdater,
+                                      bool allowRecursive)
 {
+    const bool useRecursive =
+        allowRecursive &&
+        (xRadius <= 0.0 || xRadius >= minimalRecursiveRadius()) &&
+        (yRadius <= 0.0 || yRadius >= minimalRecursiveRadius());
+
+    if (useRecursive) {
+        applyRecursiveGaussian(device, rect, xRadius, yRadius, channelFlags, progressUpdater);
+        return;
+    }
+
     QPoint srcTopLeft = rect.topLeft();
 
     if (xRadius > 0.0 && yRadius > 0.0) {
@@ -147,6 +165,294 @@ void KisGaussianKernel::applyGaussian(KisPaintDeviceSP device,
     }
 }
 
+qreal KisGaussianKernel::minimalRecursiveRadius()
+{
+    /**
+     * For smaller radii the kernel has just a few taps, so the
+     * convolution is both faster and more precise
+     */
+    return 10.0;
+}
+
+namespace {
+
+/**
+ * Coefficients of the fourth-order recursive Gaussian filter from
+ * R. Deriche, "Recursively implementing the Gaussian and its
+ * derivatives" (1993). The filter is a sum of a causal and an
+ * anti-causal part, the coefficients are normalized so that the
+ * DC gain of the filter is exactly 1.
+ */
+struct RecursiveGaussianCoeffs
+{
+    RecursiveGaussianCoeffs(qreal sigma) {
+        const qreal a0 = 1.680;
+        const qreal a1 = 3.735;
+        const qreal b0 = 1.783;
+        const qreal b1 = 1.723;
+        const qreal w0 = 0.6318;
+        const qreal w1 = 1.997;
+        const qreal c0 = -0.6803;
+        const qreal c1 = -0.2598;
+
+        const qreal cos0 = std::cos(w0 / sigma);
+        const qreal sin0 = std::sin(w0 / sigma);
+        const qreal cos1 = std::cos(w1 / sigma);
+        const qreal sin1 = std::sin(w1 / sigma);
+        const qreal exp0 = std::exp(-b0 / sigma);
+        const qreal exp1 = std::exp(-b1 / sigma);
+
+        n[0] = a0 + c0;
+        n[1] = exp1 * (c1 * sin1 - (c0 + 2 * a0) * cos1) +
+               exp0 * (a1 * sin0 - (2 * c0 + a0) * cos0);
+        n[2] = 2 * exp0 * exp1 * ((a0 + c0) * cos1 * cos0 - a1 * cos1 * sin0 - c1 * cos0 * sin1) +
+               c0 * pow2(exp0) + a0 * pow2(exp1);
+        n[3] = exp1 * pow2(exp0) * (c1 * sin1 - c0 * cos1) +
+               exp0 * pow2(exp1) * (a1 * sin0 - a0 * cos0);
+
+        d[0] = -2 * exp1 * cos1 - 2 * exp0 * cos0;
+        d[1] = 4 * cos1 * cos0 * exp0 * exp1 + pow2(exp1) + pow2(exp0);
+        d[2] = -2 * cos0 * exp0 * pow2(exp1) - 2 * cos1 * exp1 * pow2(exp0);
+        d[3] = pow2(exp0 * exp1);
+
+        m[0] = n[1] - d[0] * n[0];
+        m[1] = n[2] - d[1] * n[0];
+        m[2] = n[3] - d[2] * n[0];
+        m[3] = -d[3] * n[0];
+
+        const qreal denominator = 1.0 + d[0] + d[1] + d[2] + d[3];
+        const qreal causalGain = n[0] + n[1] + n[2] + n[3];
+        const qreal antiCausalGain = m[0] + m[1] + m[2] + m[3];
+        const qreal scale = denominator / (causalGain + antiCausalGain);
+
+        for (int i = 0; i < 4; i++) {
+            n[i] *= scale;
+            m[i] *= scale;
+        }
+
+        causalSteadyState = causalGain * scale / denominator;
+        antiCausalSteadyState = antiCausalGain * scale / denominator;
+    }
+
+    qreal n[4];
+    qreal m[4];
+    qreal d[4];
+
+    /// the response of each part to a constant signal of value 1.0
+    qreal causalSteadyState;
+    qreal antiCausalSteadyState;
+};
+
+/**
+ * Filters \p size samples placed \p stride floats apart. Both parts
+ * of the filter start in the steady state of the border sample, which
+ * is equivalent to repeating the border to infinity. The state is kept
+ * in double precision, because for large sigmas the poles come very
+ * close to the unit circle.
+ */
+void recursiveGaussian1D(float *data, int size, int stride, const RecursiveGaussianCoeffs &c)
+{
+    QVector<double> causal(size);
+
+    {
+        const float *ptr = data;
+
+        double x1 = *ptr, x2 = x1, x3 = x1;
+        double y1 = x1 * c.causalSteadyState, y2 = y1, y3 = y1, y4 = y1;
+
+        for (int i = 0; i < size; i++, ptr += stride) {
+            const double x0 = *ptr;
+            const double y0 =
+                c.n[0] * x0 + c.n[1] * x1 + c.n[2] * x2 + c.n[3] * x3 -
+                c.d[0] * y1 - c.d[1] * y2 - c.d[2] * y3 - c.d[3] * y4;
+
+            causal[i] = y0;
+
+            x3 = x2; x2 = x1; x1 = x0;
+            y4 = y3; y3 = y2; y2 = y1; y1 = y0;
+        }
+    }
+
+    {
+        float *ptr = data + (size - 1) * stride;
+
+        double x1 = *ptr, x2 = x1, x3 = x1, x4 = x1;
+        double y1 = x1 * c.antiCausalSteadyState, y2 = y1, y3 = y1, y4 = y1;
+
+        for (int i = size - 1; i >= 0; i--, ptr -= stride) {
+            const double y0 =
+                c.m[0] * x1 + c.m[1] * x2 + c.m[2] * x3 + c.m[3] * x4 -
+                c.d[0] * y1 - c.d[1] * y2 - c.d[2] * y3 - c.d[3] * y4;
+
+            x4 = x3; x3 = x2; x2 = x1; x1 = *ptr;
+            y4 = y3; y3 = y2; y2 = y1; y1 = y0;
+
+            *ptr = causal[i] + y0;
+        }
+    }
+}
+
+int findAlphaIndex(const KoColorSpace *cs)
+{
+    Q_FOREACH (const KoChannelInfo *channel, cs->channels()) {
+        if (channel->channelType() == KoChannelInfo::ALPHA) {
+            return channel->pos() / channel->size();
+        }
+    }
+    return -1;
+}
+
+}
+
+void KisGaussianKernel::applyRecursiveGaussian(KisPaintDeviceSP device,
+                                               const QRect& rect,
+                                               qreal xRadius, qreal yRadius,
+                                               const QBitArray &channelFlags,
+                                               KoUpdater *progressUpdater)
+{
+    if (rect.isEmpty() || (xRadius <= 0.0 && yRadius <= 0.0)) return;
+
+    const KoColorSpace *cs = device->colorSpace();
+    const int pixelSize = cs->pixelSize();
+    const int numChannels = cs->channelCount();
+    const int alphaIndex = findAlphaIndex(cs);
+
+    /**
+     * Read the same area the convolution would access, the pixels
+     * further away have almost no influence on the result anyway
+     */
+    const int halfWidth = xRadius > 0.0 ? kernelSizeFromRadius(xRadius) / 2 : 0;
+    const int halfHeight = yRadius > 0.0 ? kernelSizeFromRadius(yRadius) / 2 : 0;
+    const QRect srcRect = rect.adjusted(-halfWidth, -halfHeight, halfWidth, halfHeight);
+
+    const int width = srcRect.width();
+    const int height = srcRect.height();
+    const int rowStride = width * numChannels;
+
+    QVector<quint8> pixels(width * height * pixelSize);
+    device->readBytes(pixels.data(), srcRect);
+
+    QVector<float> buffer(width * height * numChannels);
+
+    /**
+     * Take the raw pointers before spawning the threads, so that
+     * the workers never touch the implicitly shared containers
+     */
+    quint8 *pixelsPtr = pixels.data();
+    float *bufferPtr = buffer.data();
+
+    QVector<int> rows(height);
+    for (int y = 0; y < height; y++) {
+        rows[y] = y;
+    }
+
+    QVector<int> columns(width);
+    for (int x = 0; x < width; x++) {
+        columns[x] = x;
+    }
+
+    /**
+     * The color channels are blurred premultiplied by alpha,
+     * the same way the convolution painter does it
+     */
+    QtConcurrent::blockingMap(rows, [&] (int y) {
+        QVector<float> channels(numChannels);
+        const quint8 *src = pixelsPtr + y * width * pixelSize;
+        float *dst = bufferPtr + y * rowStride;
+
+        for (int x = 0; x < width; x++) {
+            cs->normalisedChannelsValue(src, channels);
+
+            const float alpha = alphaIndex >= 0 ? channels[alphaIndex] : 1.0f;
+            for (int i = 0; i < numChannels; i++) {
+                dst[i] = i != alphaIndex ? channels[i] * alpha : channels[i];
+            }
+
+            src += pixelSize;
+            dst += numChannels;
+        }
+
+        if (xRadius > 0.0) {
+            const RecursiveGaussianCoeffs coeffs(sigmaFromRadius(xRadius));
+            for (int i = 0; i < numChannels; i++) {
+                recursiveGaussian1D(bufferPtr + y * rowStride + i, width, numChannels, coeffs);
+            }
+        }
+    });
+
+    if (progressUpdater) {
+        progressUpdater->setProgress(50);
+    }
+
+    if (yRadius > 0.0) {
+        const RecursiveGaussianCoeffs coeffs(sigmaFromRadius(yRadius));
+
+        QtConcurrent::blockingMap(columns, [&] (int x) {
+            for (int i = 0; i < numChannels; i++) {
+                recursiveGaussian1D(bufferPtr + x * numChannels + i, height, rowStride, coeffs);
+            }
+        });
+    }
+
+    const int dstOffsetX = rect.x() - srcRect.x();
+    const int dstOffsetY = rect.y() - srcRect.y();
+
+    QVector<int> dstRows(rect.height());
+    for (int y = 0; y < rect.height(); y++) {
+        dstRows[y] = y + dstOffsetY;
+    }
+
+    QtConcurrent::blockingMap(dstRows, [&] (int y) {
+        QVector<float> channels(numChannels);
+        quint8 *dst = pixelsPtr + (y * width + dstOffsetX) * pixelSize;
+        const float *src = bufferPtr + y * rowStride + dstOffsetX * numChannels;
+
+        for (int x = 0; x < rect.width(); x++) {
+            const float alpha = alphaIndex >= 0 ? qBound(0.0f, src[alphaIndex], 1.0f) : 1.0f;
+
+            if (!channelFlags.isEmpty()) {
+                cs->normalisedChannelsValue(dst, channels);
+            }
+
+            for (int i = 0; i < numChannels; i++) {
+                if (!channelFlags.isEmpty() && !channelFlags.testBit(i)) continue;
+
+                if (i == alphaIndex) {
+                    channels[i] = alpha;
+                } else {
+                    channels[i] = alpha > 0.0f ? src[i] / alpha : 0.0f;
+                }
+            }
+
+            cs->fromNormalisedChannelsValue(dst, channels);
+
+            src += numChannels;
+            dst += pixelSize;
+        }
+    });
+
+    /**
+     * Write back only the requested rect, the surrounding pixels
+     * have been read for context only
+     */
+    {
+        QVector<quint8> result(rect.width() * rect.height() * pixelSize);
+        const int dstRowSize = rect.width() * pixelSize;
+
+        for (int y = 0; y < rect.height(); y++) {
+            memcpy(result.data() + y * dstRowSize,
+                   pixelsPtr + ((y + dstOffsetY) * width + dstOffsetX) * pixelSize,
+                   dstRowSize);
+        }
+
+        device->writeBytes(result.constData(), rect);
+    }
+
+    if (progressUpdater) {
+        progressUpdater->setProgress(100);
+    }
+}
+
 Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic>
 KisGaussianKernel::createLoGMatrix(qreal radius)
 {
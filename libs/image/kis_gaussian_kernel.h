@@ -44,11 +44,38 @@ public:
     static qreal sigmaFromRadius(qreal radius);
     static int kernelSizeFromRadius(qreal radius);
 
+    /**
+     * Blurs \p rect of the device with a separable Gaussian kernel.
+     *
+     * If \p allowRecursive is true and the radii are not smaller than
+     * minimalRecursiveRadius(), the blur is done by
+     * applyRecursiveGaussian() instead of the convolution painter.
+     */
     static void applyGaussian(KisPaintDeviceSP device,
                               const QRect& rect,
                               qreal xRadius, qreal yRadius,
                               const QBitArray &channelFlags,
-                              KoUpdater *updater);
+                              KoUpdater *updater,
+                              bool allowRecursive = false);
+
+    /**
+     * Approximates applyGaussian() with a fourth-order recursive (IIR)
+     * filter by Deriche. The cost per pixel does not depend on the
+     * radius, the rows and columns are processed in parallel.
+     *
+     * The filter is not an exact Gaussian: for radii not smaller than
+     * minimalRecursiveRadius() the result differs from the convolution
+     * by less than 0.25% of the channel range (half a level in 8-bit
+     * color spaces). The pixels are read from the same area the
+     * convolution would access.
+     */
+    static void applyRecursiveGaussian(KisPaintDeviceSP device,
+                                       const QRect& rect,
+                                       qreal xRadius, qreal yRadius,
+                                       const QBitArray &channelFlags,
+                                       KoUpdater *updater);
+
+    static qreal minimalRecursiveRadius();
 
     static Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> createLoGMatrix(qreal radius);
 
@@ -23,12 +23,14 @@
 #include <algorithm>
 
 #include <QImage>
+#include <QtConcurrent>
 
 #include "kis_algebra_2d.h"
 #include "kis_four_point_interpolator_forward.h"
 #include "kis_four_point_interpolator_backward.h"
 #include "kis_iterator_ng.h"
 #include "kis_random_sub_accessor.h"
+#include "krita_utils.h"
 
 //#define DEBUG_PAINTING_POLYGONS
 
@@ -179,12 +181,30 @@ struct PaintDevicePolygonOp
     PaintDevicePolygonOp(KisPaintDeviceSP srcDev, KisPaintDeviceSP dstDev)
         : m_srcDev(srcDev), m_dstDev(dstDev) {}
 
+    /**
+     * Restricts the written pixels to \p rc. A null rect (default)
+     * disables the restriction.
+     */
+    void setClipRect(const QRect &rc) {
+        m_clipRect = rc;
+    }
+
+    /**
+     * The origin of the tile grid of the destination device
+     */
+    QPoint alignmentOrigin() const {
+        return QPoint(m_dstDev->x(), m_dstDev->y());
+    }
+
     void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon) {
         this->operator() (srcPolygon, dstPolygon, dstPolygon);
     }
 
     void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon, const QPolygonF &clipDstPolygon) {
         QRect boundRect = clipDstPolygon.boundingRect().toAlignedRect();
+        if (!m_clipRect.isNull()) {
+            boundRect &= m_clipRect;
+        }
         if (boundRect.isEmpty()) return;
 
         KisSequentialIterator dstIt(m_dstDev, boundRect);
@@ -227,6 +247,7 @@ struct PaintDevicePolygonOp
 
     KisPaintDeviceSP m_srcDev;
     KisPaintDeviceSP m_dstDev;
+    QRect m_clipRect;
 };
 
 struct QImagePolygonOp
@@ -238,8 +259,32 @@ struct QImagePolygonOp
           m_srcImageOffset(srcImageOffset),
           m_dstImageOffset(dstImageOffset),
           m_srcImageRect(m_srcImage.rect()),
-          m_dstImageRect(m_dstImage.rect())
+          m_dstImageRect(m_dstImage.rect()),
+          m_dstBits(m_dstImage.bits()),
+          m_dstBytesPerLine(m_dstImage.bytesPerLine())
     {
+        /**
+         * The pixels are written directly into the (already detached)
+         * image data, so that several copies of the op could write into
+         * different lines of the image concurrently.
+         */
+        KIS_ASSERT_RECOVER_NOOP(m_dstImage.depth() == 32);
+    }
+
+    /**
+     * Restricts the written pixels to \p rc, which is given in the
+     * coordinate system of the destination polygons. A null rect
+     * (default) disables the restriction.
+     */
+    void setClipRect(const QRect &rc) {
+        m_clipRect = rc;
+    }
+
+    /**
+     * QImage has no tiles, so any alignment of the clip rects is fine
+     */
+    QPoint alignmentOrigin() const {
+        return QPoint();
     }
 
     void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon) {
@@ -248,6 +293,9 @@ struct QImagePolygonOp
 
     void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon, const QPolygonF &clipDstPolygon) {
         QRect boundRect = clipDstPolygon.boundingRect().toAlignedRect();
+        if (!m_clipRect.isNull()) {
+            boundRect &= m_clipRect;
+        }
         KisFourPointInterpolatorBackward interp(srcPolygon, dstPolygon);
 
         for (int y = boundRect.top(); y <= boundRect.bottom(); y++) {
@@ -272,7 +320,8 @@ struct QImagePolygonOp
                     if (!m_dstImageRect.contains(srcPointI)) continue;
                     if (!m_srcImageRect.contains(dstPointI)) continue;
 
-                    m_dstImage.setPixel(srcPointI, m_srcImage.pixel(dstPointI));
+                    QRgb *dstLine = reinterpret_cast<QRgb*>(m_dstBits + srcPointI.y() * m_dstBytesPerLine);
+                    dstLine[srcPointI.x()] = m_srcImage.pixel(dstPointI);
                 }
             }
         }
@@ -299,6 +348,10 @@ struct QImagePolygonOp
 
     QRect m_srcImageRect;
     QRect m_dstImageRect;
+
+    uchar *m_dstBits;
+    int m_dstBytesPerLine;
+    QRect m_clipRect;
 };
 
 /*************************************************************/
@@ -595,6 +648,230 @@ void iterateThroughGrid(PolygonOp &polygonOp,
     }
 }
 
+
+/*************************************************************/
+/*      Parallel rendering of the grid cells                 */
+/*************************************************************/
+
+struct GridCell
+{
+    QPolygonF srcPolygon;
+    QPolygonF dstPolygon;
+    QPolygonF clipDstPolygon;
+    QRect dstBounds;
+};
+
+namespace Private {
+    inline int stripeIndex(int y, int stripeSize)
+    {
+        return y >= 0 ? y / stripeSize : -((-y - 1) / stripeSize) - 1;
+    }
+}
+
+/**
+ * Renders \p cells using copies of \p polygonOpPrototype
+ * (PaintDevicePolygonOp or QImagePolygonOp) in parallel.
+ *
+ * The destination is split into horizontal stripes aligned to the tile
+ * grid of the destination (see PolygonOp::alignmentOrigin()), so no tile
+ * is shared between two threads. Every stripe is rendered by a single
+ * thread, which processes all the cells touching the stripe in their
+ * original order, clipping them to the stripe. Therefore the result is
+ * exactly the same as if the cells were processed sequentially, including
+ * the pixels lying on the shared borders of the cells.
+ *
+ * If \p applyRect is not null, only the pixels inside it are written.
+ */
+template <class PolygonOp>
+void renderCells(const QVector<GridCell> &cells,
+                 const PolygonOp &polygonOpPrototype,
+                 const QRect &applyRect = QRect())
+{
+    const int stripeSize = 64;
+
+    QRect totalBounds;
+    Q_FOREACH (const GridCell &cell, cells) {
+        totalBounds |= cell.dstBounds;
+    }
+
+    if (!applyRect.isNull()) {
+        totalBounds &= applyRect;
+    }
+
+    if (totalBounds.isEmpty()) return;
+
+    const int originY = polygonOpPrototype.alignmentOrigin().y();
+
+    const QVector<QPair<int, int>> stripeRanges =
+        KritaUtils::splitIntoAlignedStripes(totalBounds.top(), totalBounds.bottom() + 1,
+                                            originY, stripeSize);
+
+    const int firstStripe = Private::stripeIndex(totalBounds.top() - originY, stripeSize);
+    QVector<QVector<int>> stripeCells(stripeRanges.size());
+
+    for (int i = 0; i < cells.size(); i++) {
+        const QRect rc = cells[i].dstBounds & totalBounds;
+        if (rc.isEmpty()) continue;
+
+        const int first = Private::stripeIndex(rc.top() - originY, stripeSize) - firstStripe;
+        const int last = Private::stripeIndex(rc.bottom() - originY, stripeSize) - firstStripe;
+
+        for (int stripe = first; stripe <= last; stripe++) {
+            stripeCells[stripe].append(i);
+        }
+    }
+
+    QVector<int> stripes;
+    for (int stripe = 0; stripe < stripeRanges.size(); stripe++) {
+        if (!stripeCells[stripe].isEmpty()) {
+            stripes.append(stripe);
+        }
+    }
+
+    const GridCell *cellsPtr = cells.constData();
+    const QVector<int> *stripeCellsPtr = stripeCells.constData();
+    const QPair<int, int> *stripeRangesPtr = stripeRanges.constData();
+
+    QtConcurrent::blockingMap(stripes, [&] (const int &stripe) {
+        const QPair<int, int> &range = stripeRangesPtr[stripe];
+        const QRect stripeRect(totalBounds.left(), range.first,
+                               totalBounds.width(), range.second - range.first);
+
+        PolygonOp polygonOp(polygonOpPrototype);
+        polygonOp.setClipRect(stripeRect);
+
+        const QVector<int> &indexes = stripeCellsPtr[stripe];
+        for (auto it = indexes.constBegin(); it != indexes.constEnd(); ++it) {
+            const GridCell &cell = cellsPtr[*it];
+            polygonOp(cell.srcPolygon, cell.dstPolygon, cell.clipDstPolygon);
+        }
+    });
+}
+
+/**
+ * A polygon op that renders the cells passed to it in parallel. It
+ * can be used with both processGrid() and iterateThroughGrid() in place
+ * of \p PolygonOp itself.
+ *
+ * The cells are collected into batches of at most \p maxBatchSize cells
+ * and every full batch is rendered with renderCells(), so the memory
+ * consumption doesn't depend on the size of the grid. The batches are
+ * rendered in the order of the cells, therefore the result is exactly
+ * the same as with the sequential \p PolygonOp. Call finish() after the
+ * iteration to render the last batch.
+ *
+ * If \p applyRect is not null, only the pixels inside it are written.
+ */
+template <class PolygonOp>
+struct ParallelPolygonOp
+{
+    ParallelPolygonOp(const PolygonOp &polygonOp,
+                      const QRect &applyRect = QRect(),
+                      int maxBatchSize = 4096)
+        : m_polygonOp(polygonOp),
+          m_applyRect(applyRect),
+          m_maxBatchSize(maxBatchSize)
+    {
+        m_cells.reserve(m_maxBatchSize);
+    }
+
+    void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon) {
+        this->operator() (srcPolygon, dstPolygon, dstPolygon);
+    }
+
+    void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon, const QPolygonF &clipDstPolygon) {
+        GridCell cell;
+        cell.dstBounds = clipDstPolygon.boundingRect().toAlignedRect();
+
+        if (cell.dstBounds.isEmpty()) return;
+        if (!m_applyRect.isNull() && !m_applyRect.intersects(cell.dstBounds)) return;
+
+        cell.srcPolygon = srcPolygon;
+        cell.dstPolygon = dstPolygon;
+        cell.clipDstPolygon = clipDstPolygon;
+
+        m_cells.append(cell);
+
+        if (m_cells.size() >= m_maxBatchSize) {
+            finish();
+        }
+    }
+
+    void finish() {
+        renderCells(m_cells, m_polygonOp, m_applyRect);
+        m_cells.resize(0);
+    }
+
+private:
+    PolygonOp m_polygonOp;
+    QRect m_applyRect;
+    int m_maxBatchSize;
+    QVector<GridCell> m_cells;
+};
+
+/**
+ * Returns the area of the destination covered by the cells of a complete
+ * grid that have at least one node moved between \p oldTransformedPoints
+ * and \p newTransformedPoints. Both the old and the new positions of the
+ * cells are included, so rerendering this area (after clearing it) gives
+ * the same result as rendering the whole grid anew.
+ */
+inline QRect changedCellsBounds(const QSize &gridSize,
+                                const QVector<QPointF> &oldTransformedPoints,
+                                const QVector<QPointF> &newTransformedPoints)
+{
+    KIS_ASSERT_RECOVER(oldTransformedPoints.size() == newTransformedPoints.size() &&
+                       newTransformedPoints.size() == gridSize.width() * gridSize.height()) {
+        return QRect();
+    }
+
+    QVector<bool> changedNodes(newTransformedPoints.size());
+    bool hasChanges = false;
+
+    for (int i = 0; i < newTransformedPoints.size(); i++) {
+        changedNodes[i] = oldTransformedPoints[i] != newTransformedPoints[i];
+        hasChanges |= changedNodes[i];
+    }
+
+    if (!hasChanges) return QRect();
+
+    qreal left = std::numeric_limits<qreal>::max();
+    qreal top = std::numeric_limits<qreal>::max();
+    qreal right = std::numeric_limits<qreal>::lowest();
+    qreal bottom = std::numeric_limits<qreal>::lowest();
+
+    auto accumulate = [&] (const QPointF &pt) {
+        left = qMin(left, pt.x());
+        top = qMin(top, pt.y());
+        right = qMax(right, pt.x());
+        bottom = qMax(bottom, pt.y());
+    };
+
+    for (int row = 0; row < gridSize.height() - 1; row++) {
+        for (int col = 0; col < gridSize.width() - 1; col++) {
+            const QVector<int> cellIndexes = calculateCellIndexes(col, row, gridSize);
+
+            bool cellChanged = false;
+            Q_FOREACH (int index, cellIndexes) {
+                cellChanged |= changedNodes[index];
+            }
+
+            if (!cellChanged) continue;
+
+            Q_FOREACH (int index, cellIndexes) {
+                accumulate(oldTransformedPoints[index]);
+                accumulate(newTransformedPoints[index]);
+            }
+        }
+    }
+
+    if (left > right || top > bottom) return QRect();
+
+    // one pixel margin for the subpixel adjustments of the polygons
+    return QRectF(QPointF(left, top), QPointF(right, bottom))
+        .toAlignedRect().adjusted(-1, -1, 1, 1);
+}
+
 }
 
 #endif /* __KIS_GRID_INTERPOLATION_TOOLS_H */
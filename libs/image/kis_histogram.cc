@@ -27,6 +27,8 @@
 #include "KoColorSpace.h"
 #include "kis_debug.h"
 #include "kis_iterator_ng.h"
+#include "kis_random_accessor_ng.h"
+#include "kis_incremental_histogram.h"
 
 KisHistogram::KisHistogram(const KisPaintLayerSP layer,
                            KoHistogramProducer *producer,
@@ -42,6 +44,7 @@ KisHistogram::KisHistogram(const KisPaintLayerSP layer,
     m_type = type;
     m_producer = producer;
     m_selection = false;
+    m_approximate = false;
     m_channel = 0;
 
     updateHistogram();
@@ -50,7 +53,8 @@ KisHistogram::KisHistogram(const KisPaintLayerSP layer,
 KisHistogram::KisHistogram(const KisPaintDeviceSP paintdev,
                            const QRect &bounds,
                            KoHistogramProducer *producer,
-                           const enumHistogramType type)
+                           const enumHistogramType type,
+                           bool approximate)
     : m_paintDevice(paintdev)
 {
     Q_ASSERT(producer);
@@ -60,6 +64,7 @@ KisHistogram::KisHistogram(const KisPaintDeviceSP paintdev,
     m_type = type;
 
     m_selection = false;
+    m_approximate = approximate;
     m_channel = 0;
 
     // TODO: Why does Krita crash when updateHistogram() is *not* called here?
@@ -85,11 +90,29 @@ void KisHistogram::updateHistogram()
         return;
     }
 
-    KisSequentialConstIterator srcIt(m_paintDevice, m_bounds);
     const KoColorSpace* cs = m_paintDevice->colorSpace();
 
     // Let the producer do it's work
     m_producer->clear();
+
+    const int step = KisIncrementalHistogram::samplingStep(m_bounds, m_approximate);
+
+    if (step > 1) {
+        KisRandomConstAccessorSP accessor =
+            m_paintDevice->createRandomConstAccessorNG(m_bounds.x(), m_bounds.y());
+
+        for (int y = m_bounds.top(); y <= m_bounds.bottom(); y += step) {
+            for (int x = m_bounds.left(); x <= m_bounds.right(); x += step) {
+                accessor->moveTo(x, y);
+                m_producer->addRegionToBin(accessor->oldRawData(), 0, 1, cs);
+            }
+        }
+
+        computeHistogram();
+        return;
+    }
+
+    KisSequentialConstIterator srcIt(m_paintDevice, m_bounds);
     int i;
 
     // XXX: the original code depended on their being a selection mask in the iterator
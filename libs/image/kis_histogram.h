@@ -109,10 +109,17 @@ public:
                  KoHistogramProducer *producer,
                  const enumHistogramType type);
 
+    /**
+     * If \p approximate is true, only the pixels lying on a regular grid
+     * are sampled (about a million of them for the whole \p bounds).
+     * That is enough for displaying the histogram and is much faster
+     * on big images.
+     */
     KisHistogram(KisPaintDeviceSP paintdev,
                  const QRect &bounds,
                  KoHistogramProducer *producer,
-                 const enumHistogramType type);
+                 const enumHistogramType type,
+                 bool approximate = false);
 
     virtual ~KisHistogram();
 
@@ -187,6 +194,7 @@ private:
     qint32 m_channel;
     double m_selFrom, m_selTo;
     bool m_selection;
+    bool m_approximate;
 
     QVector<Calculations> m_completeCalculations, m_selectionCalculations;
 };
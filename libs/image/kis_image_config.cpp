@@ -311,6 +311,17 @@ void KisImageConfig::setLazyFrameCreationEnabled(bool value)
     m_config.writeEntry("lazyFrameCreationEnabled", value);
 }
 
+bool KisImageConfig::useRecursiveBlurInLayerStyles(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useRecursiveBlurInLayerStyles", false) : false;
+}
+
+void KisImageConfig::setUseRecursiveBlurInLayerStyles(bool value)
+{
+    m_config.writeEntry("useRecursiveBlurInLayerStyles", value);
+}
+
 
 #if defined Q_OS_LINUX
 #include <sys/sysinfo.h>
@@ -453,3 +464,25 @@ void KisImageConfig::setUseLodForColorizeMask(bool value)
 {
     m_config.writeEntry("useLodForColorizeMask", value);
 }
+
+bool KisImageConfig::useMultiResolutionForColorizeMask(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useMultiResolutionForColorizeMask", false) : false;
+}
+
+void KisImageConfig::setUseMultiResolutionForColorizeMask(bool value)
+{
+    m_config.writeEntry("useMultiResolutionForColorizeMask", value);
+}
+
+int KisImageConfig::dabCacheMemoryLimit(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("dabCacheMemoryLimit", 32) : 32;
+}
+
+void KisImageConfig::setDabCacheMemoryLimit(int value)
+{
+    m_config.writeEntry("dabCacheMemoryLimit", value);
+}
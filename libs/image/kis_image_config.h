@@ -99,6 +99,9 @@ public:
     bool lazyFrameCreationEnabled(bool requestDefault = false) const;
     void setLazyFrameCreationEnabled(bool value);
 
+    bool useRecursiveBlurInLayerStyles(bool requestDefault = false) const;
+    void setUseRecursiveBlurInLayerStyles(bool value);
+
     bool showAdditionalOnionSkinsSettings(bool requestDefault = false) const;
     void setShowAdditionalOnionSkinsSettings(bool value);
 
@@ -111,6 +114,12 @@ public:
     bool useLodForColorizeMask(bool requestDefault = false) const;
     void setUseLodForColorizeMask(bool value);
 
+    bool useMultiResolutionForColorizeMask(bool requestDefault = false) const;
+    void setUseMultiResolutionForColorizeMask(bool value);
+
+    int dabCacheMemoryLimit(bool requestDefault = false) const; // MiB
+    void setDabCacheMemoryLimit(int value);
+
 
 private:
     Q_DISABLE_COPY(KisImageConfig)
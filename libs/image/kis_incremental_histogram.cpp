@@ -0,0 +1,369 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_incremental_histogram.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <QtConcurrent>
+
+#include <KoColorSpace.h>
+#include <KoChannelInfo.h>
+
+#include "kis_paint_device.h"
+#include "kis_iterator_ng.h"
+#include "kis_random_accessor_ng.h"
+
+const int KisIncrementalHistogram::cellSize;
+const int KisIncrementalHistogram::approximatePixelsCount;
+
+namespace {
+
+const int binsPerChannel = 256;
+
+bool isU8ColorSpace(const KoColorSpace *cs)
+{
+    Q_FOREACH (const KoChannelInfo *channel, cs->channels()) {
+        if (channel->channelValueType() != KoChannelInfo::UINT8) {
+            return false;
+        }
+    }
+
+    return cs->pixelSize() == cs->channelCount();
+}
+
+inline void accumulatePixelsImpl(const quint8 *pixels, int numPixels, int pixelStride,
+                                 const KoColorSpace *cs, int channelCount, bool isU8,
+                                 quint32 *bins)
+{
+    if (isU8 && channelCount == 4) {
+        quint32 *bins0 = bins;
+        quint32 *bins1 = bins + binsPerChannel;
+        quint32 *bins2 = bins + 2 * binsPerChannel;
+        quint32 *bins3 = bins + 3 * binsPerChannel;
+
+        for (int i = 0; i < numPixels; i++) {
+            bins0[pixels[0]]++;
+            bins1[pixels[1]]++;
+            bins2[pixels[2]]++;
+            bins3[pixels[3]]++;
+            pixels += pixelStride;
+        }
+    } else if (isU8) {
+        for (int i = 0; i < numPixels; i++) {
+            for (int chan = 0; chan < channelCount; chan++) {
+                bins[chan * binsPerChannel + pixels[chan]]++;
+            }
+            pixels += pixelStride;
+        }
+    } else {
+        for (int i = 0; i < numPixels; i++) {
+            for (int chan = 0; chan < channelCount; chan++) {
+                bins[chan * binsPerChannel + cs->scaleToU8(pixels, chan)]++;
+            }
+            pixels += pixelStride;
+        }
+    }
+}
+
+inline int alignUp(int value, int step)
+{
+    const int rem = ((value % step) + step) % step;
+    return rem ? value + step - rem : value;
+}
+
+inline int alignDown(int value, int step)
+{
+    const int rem = ((value % step) + step) % step;
+    return value - rem;
+}
+
+}
+
+struct KisIncrementalHistogram::Private
+{
+    Private(bool _approximate) : approximate(_approximate) {}
+
+    bool approximate;
+    bool isValid = false;
+
+    QRect bounds;
+    const KoColorSpace *colorSpace = 0;
+    int step = 1;
+    int channelCount = 0;
+    int binsPerCell = 0;
+
+    QRect cellsRect;
+    int numCellColumns = 0;
+    int numCellRows = 0;
+
+    QVector<quint32> cellBins;
+    QVector<quint32> totalBins;
+
+    QRect cellRect(int index) const {
+        const int col = index % numCellColumns;
+        const int row = index / numCellColumns;
+
+        return QRect(cellsRect.x() + col * cellSize,
+                     cellsRect.y() + row * cellSize,
+                     cellSize, cellSize) & bounds;
+    }
+
+    void initGrid(const QRect &bounds);
+    void reset(KisPaintDeviceSP device, const QRect &bounds);
+    void resize(const QRect &bounds, QVector<bool> *isDirty);
+    void scanCell(KisPaintDeviceSP device, int index, bool isU8);
+};
+
+void KisIncrementalHistogram::Private::initGrid(const QRect &_bounds)
+{
+    bounds = _bounds;
+
+    cellsRect = QRect(QPoint(alignDown(bounds.left(), cellSize),
+                             alignDown(bounds.top(), cellSize)),
+                      QPoint(alignUp(bounds.right() + 1, cellSize) - 1,
+                             alignUp(bounds.bottom() + 1, cellSize) - 1));
+
+    numCellColumns = cellsRect.width() / cellSize;
+    numCellRows = cellsRect.height() / cellSize;
+}
+
+void KisIncrementalHistogram::Private::reset(KisPaintDeviceSP device, const QRect &_bounds)
+{
+    colorSpace = device->colorSpace();
+    step = KisIncrementalHistogram::samplingStep(_bounds, approximate);
+    channelCount = colorSpace->channelCount();
+    binsPerCell = channelCount * binsPerChannel;
+
+    initGrid(_bounds);
+
+    cellBins.fill(0, numCellColumns * numCellRows * binsPerCell);
+    totalBins.fill(0, binsPerCell);
+
+    isValid = true;
+}
+
+void KisIncrementalHistogram::Private::resize(const QRect &_bounds, QVector<bool> *isDirty)
+{
+    /**
+     * The cells are aligned to the device origin, not to the bounds, so
+     * when the bounds change, all the cells whose part of the bounds
+     * stays the same keep their bins. Only the cells on the border of
+     * the old and the new bounds need rescanning.
+     */
+    const QRect oldBounds = bounds;
+    const QRect oldCellsRect = cellsRect;
+    const int oldNumCellColumns = numCellColumns;
+    const QVector<quint32> oldCellBins = cellBins;
+
+    initGrid(_bounds);
+
+    const int numCells = numCellColumns * numCellRows;
+
+    cellBins.fill(0, numCells * binsPerCell);
+    totalBins.fill(0, binsPerCell);
+    isDirty->fill(false, numCells);
+
+    for (int i = 0; i < numCells; i++) {
+        const QRect rc = cellRect(i);
+        if (rc.isEmpty()) continue;
+
+        const QPoint cellOrigin(cellsRect.x() + (i % numCellColumns) * cellSize,
+                                cellsRect.y() + (i / numCellColumns) * cellSize);
+
+        if (oldCellsRect.contains(cellOrigin) &&
+            (QRect(cellOrigin, QSize(cellSize, cellSize)) & oldBounds) == rc) {
+
+            const int oldIndex =
+                (cellOrigin.y() - oldCellsRect.y()) / cellSize * oldNumCellColumns +
+                (cellOrigin.x() - oldCellsRect.x()) / cellSize;
+
+            const quint32 *src = oldCellBins.constData() + oldIndex * binsPerCell;
+            quint32 *dst = cellBins.data() + i * binsPerCell;
+            memcpy(dst, src, binsPerCell * sizeof(quint32));
+
+            for (int j = 0; j < binsPerCell; j++) {
+                totalBins[j] += dst[j];
+            }
+        } else {
+            (*isDirty)[i] = true;
+        }
+    }
+}
+
+void KisIncrementalHistogram::Private::scanCell(KisPaintDeviceSP device, int index, bool isU8)
+{
+    quint32 *bins = cellBins.data() + index * binsPerCell;
+    memset(bins, 0, binsPerCell * sizeof(quint32));
+
+    const QRect rc = cellRect(index);
+    if (rc.isEmpty()) return;
+
+    const int pixelSize = colorSpace->pixelSize();
+
+    if (step == 1) {
+        KisSequentialConstIterator it(device, rc);
+
+        int numPixels = 0;
+        do {
+            numPixels = it.nConseqPixels();
+            accumulatePixelsImpl(it.rawDataConst(), numPixels, pixelSize,
+                                 colorSpace, channelCount, isU8, bins);
+        } while (it.nextPixels(numPixels));
+
+    } else {
+        /**
+         * The sampling grid is aligned to the origin of the device, so
+         * rescanning a cell always samples the same pixels
+         */
+        KisRandomConstAccessorSP accessor =
+            device->createRandomConstAccessorNG(rc.x(), rc.y());
+
+        for (int y = alignUp(rc.top(), step); y <= rc.bottom(); y += step) {
+            for (int x = alignUp(rc.left(), step); x <= rc.right(); x += step) {
+                accessor->moveTo(x, y);
+                accumulatePixelsImpl(accessor->rawDataConst(), 1, pixelSize,
+                                     colorSpace, channelCount, isU8, bins);
+            }
+        }
+    }
+}
+
+KisIncrementalHistogram::KisIncrementalHistogram(bool approximate)
+    : m_d(new Private(approximate))
+{
+}
+
+KisIncrementalHistogram::~KisIncrementalHistogram()
+{
+}
+
+void KisIncrementalHistogram::update(KisPaintDeviceSP device, const QRect &bounds, const QVector<QRect> &dirtyRects)
+{
+    QVector<int> dirtyCells;
+
+    if (!m_d->isValid ||
+        !(*m_d->colorSpace == *device->colorSpace()) ||
+        m_d->step != samplingStep(bounds, m_d->approximate)) {
+
+        m_d->reset(device, bounds);
+
+        dirtyCells.reserve(m_d->numCellColumns * m_d->numCellRows);
+        for (int i = 0; i < m_d->numCellColumns * m_d->numCellRows; i++) {
+            dirtyCells << i;
+        }
+    } else {
+        QVector<bool> isDirty;
+
+        if (m_d->bounds != bounds) {
+            m_d->resize(bounds, &isDirty);
+        } else {
+            isDirty.fill(false, m_d->numCellColumns * m_d->numCellRows);
+        }
+
+        Q_FOREACH (const QRect &dirtyRect, dirtyRects) {
+            const QRect rc = dirtyRect & m_d->bounds;
+            if (rc.isEmpty()) continue;
+
+            const int firstCol = (rc.left() - m_d->cellsRect.left()) / cellSize;
+            const int lastCol = (rc.right() - m_d->cellsRect.left()) / cellSize;
+            const int firstRow = (rc.top() - m_d->cellsRect.top()) / cellSize;
+            const int lastRow = (rc.bottom() - m_d->cellsRect.top()) / cellSize;
+
+            for (int row = firstRow; row <= lastRow; row++) {
+                for (int col = firstCol; col <= lastCol; col++) {
+                    isDirty[row * m_d->numCellColumns + col] = true;
+                }
+            }
+        }
+
+        for (int i = 0; i < isDirty.size(); i++) {
+            if (isDirty[i]) {
+                dirtyCells << i;
+            }
+        }
+    }
+
+    if (dirtyCells.isEmpty()) return;
+
+    quint32 *totalBins = m_d->totalBins.data();
+    const int binsPerCell = m_d->binsPerCell;
+
+    auto addCellToTotal = [&] (int index, bool subtract) {
+        const quint32 *bins = m_d->cellBins.constData() + index * binsPerCell;
+
+        for (int i = 0; i < binsPerCell; i++) {
+            if (subtract) {
+                totalBins[i] -= bins[i];
+            } else {
+                totalBins[i] += bins[i];
+            }
+        }
+    };
+
+    Q_FOREACH (int index, dirtyCells) {
+        addCellToTotal(index, true);
+    }
+
+    // make sure the cells vector is detached before entering the threads
+    m_d->cellBins.data();
+
+    const bool isU8 = isU8ColorSpace(m_d->colorSpace);
+
+    QtConcurrent::blockingMap(dirtyCells, [&] (const int &index) {
+        m_d->scanCell(device, index, isU8);
+    });
+
+    Q_FOREACH (int index, dirtyCells) {
+        addCellToTotal(index, false);
+    }
+}
+
+void KisIncrementalHistogram::invalidate()
+{
+    m_d->isValid = false;
+}
+
+KisIncrementalHistogram::Bins KisIncrementalHistogram::bins() const
+{
+    Bins result(m_d->channelCount);
+
+    for (int chan = 0; chan < m_d->channelCount; chan++) {
+        const quint32 *bins = m_d->totalBins.constData() + chan * binsPerChannel;
+        result[chan].assign(bins, bins + binsPerChannel);
+    }
+
+    return result;
+}
+
+int KisIncrementalHistogram::samplingStep(const QRect &bounds, bool approximate)
+{
+    if (!approximate) return 1;
+
+    const qreal numPixels = qreal(bounds.width()) * bounds.height();
+    return qMax(1, int(std::ceil(std::sqrt(numPixels / approximatePixelsCount))));
+}
+
+void KisIncrementalHistogram::accumulatePixels(const quint8 *pixels, int numPixels, int pixelStride,
+                                               const KoColorSpace *colorSpace, quint32 *bins)
+{
+    accumulatePixelsImpl(pixels, numPixels, pixelStride,
+                         colorSpace, colorSpace->channelCount(), isU8ColorSpace(colorSpace),
+                         bins);
+}
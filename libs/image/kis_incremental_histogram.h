@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_INCREMENTAL_HISTOGRAM_H
+#define __KIS_INCREMENTAL_HISTOGRAM_H
+
+#include <vector>
+
+#include <QScopedPointer>
+#include <QVector>
+#include <QRect>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+class KoColorSpace;
+
+/**
+ * Calculates a histogram of the channels of a paint device, 256 bins per
+ * channel, with the channel values scaled to 8 bits. The channels are
+ * ordered as they are stored in the pixel.
+ *
+ * The bins are stored separately for each cell of the device (a square of
+ * KisIncrementalHistogram::cellSize pixels). update() rescans only the
+ * cells touched by the passed dirty rects. It subtracts their old
+ * contribution from the totals and adds the new one, so keeping the
+ * histogram of a big image up to date while painting costs only as much
+ * as the painted area.
+ *
+ * In the approximate mode only the pixels lying on a regular grid are
+ * sampled. The grid step is chosen so that about
+ * KisIncrementalHistogram::approximatePixelsCount pixels of the whole
+ * bounds are taken into account. That is enough for all the displaying
+ * purposes.
+ *
+ * The class is not thread-safe, calls to update() should be serialized
+ * by the user.
+ */
+class KRITAIMAGE_EXPORT KisIncrementalHistogram
+{
+public:
+    typedef std::vector<std::vector<quint32> > Bins;
+
+    static const int cellSize = 256;
+    static const int approximatePixelsCount = 1 << 20;
+
+public:
+    KisIncrementalHistogram(bool approximate = false);
+    ~KisIncrementalHistogram();
+
+    /**
+     * Brings the histogram of \p device inside \p bounds up to date.
+     * Only the cells touched by \p dirtyRects are rescanned, unless it is
+     * the first call or the color space of the device or the sampling
+     * step have changed since the previous call. When \p bounds change,
+     * only the cells on the border of the old and the new bounds are
+     * rescanned additionally, so \p bounds may well be the exact bounds
+     * of the device.
+     */
+    void update(KisPaintDeviceSP device, const QRect &bounds, const QVector<QRect> &dirtyRects);
+
+    /**
+     * Forces the next update() to rescan the whole device
+     */
+    void invalidate();
+
+    Bins bins() const;
+
+    /**
+     * Returns the distance between the sampled pixels in both directions
+     */
+    static int samplingStep(const QRect &bounds, bool approximate);
+
+    /**
+     * Adds \p numPixels pixels of \p colorSpace placed \p pixelStride bytes
+     * apart into \p bins, which are laid out channel by channel, 256 bins
+     * per channel. 8-bit color spaces take a fast path that doesn't call
+     * any virtual methods of the color space.
+     */
+    static void accumulatePixels(const quint8 *pixels, int numPixels, int pixelStride,
+                                 const KoColorSpace *colorSpace, quint32 *bins);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_INCREMENTAL_HISTOGRAM_H */
@@ -47,6 +47,17 @@ struct Q_DECL_HIDDEN KisLiquifyTransformWorker::Private
 
     struct MapIndexesOp;
 
+    struct PreviewCache {
+        QImage srcImage;
+        QPointF srcImageOffset;
+        QPointF dstImageOffset;
+        QVector<QPointF> originalPoints;
+        QVector<QPointF> transformedPoints;
+        QImage dstImage;
+    };
+
+    PreviewCache previewCache;
+
     template <class ProcessOp>
     void processTransformedPixelsBuildUp(ProcessOp op,
                                          const QPointF &base,
@@ -80,6 +91,8 @@ KisLiquifyTransformWorker::KisLiquifyTransformWorker(const QRect &srcBounds,
 KisLiquifyTransformWorker::KisLiquifyTransformWorker(const KisLiquifyTransformWorker &rhs)
     : m_d(new Private(*rhs.m_d.data()))
 {
+    // the preview cache belongs to the worker that generated it
+    m_d->previewCache = Private::PreviewCache();
 }
 
 KisLiquifyTransformWorker::~KisLiquifyTransformWorker()
@@ -438,11 +451,13 @@ void KisLiquifyTransformWorker::run(KisPaintDeviceSP device)
     using namespace GridIterationTools;
 
     PaintDevicePolygonOp polygonOp(srcDev, device);
+    ParallelPolygonOp<PaintDevicePolygonOp> parallelOp(polygonOp);
     Private::MapIndexesOp indexesOp(m_d.data());
-    iterateThroughGrid<AlwaysCompletePolygonPolicy>(polygonOp, indexesOp,
+    iterateThroughGrid<AlwaysCompletePolygonPolicy>(parallelOp, indexesOp,
                                                     m_d->gridSize,
                                                     m_d->originalPoints,
                                                     m_d->transformedPoints);
+    parallelOp.finish();
 }
 
 QRect KisLiquifyTransformWorker::approxChangeRect(const QRect &rc)
@@ -474,6 +489,7 @@ QRect KisLiquifyTransformWorker::approxNeedRect(const QRect &rc, const QRect &fu
 
 #include <functional>
 #include <QTransform>
+#include <QPainter>
 
 using PointMapFunction = std::function<QPointF (const QPointF&)>;
 
@@ -526,17 +542,62 @@ QImage KisLiquifyTransformWorker::runOnQImage(const QImage &srcImage,
 
     QRect dstBoundsI = dstBounds.toAlignedRect();
 
-    QImage dstImage(dstBoundsI.size(), srcImage.format());
-    dstImage.fill(0);
+    /**
+     * The preview is regenerated on every stroke of the liquify brush,
+     * which usually moves only a small part of the grid. If the source
+     * and the layout of the image are the same as in the previous call,
+     * we rerender only the area covered by the cells that have moved.
+     */
+    Private::PreviewCache &cache = m_d->previewCache;
+
+    const bool canUpdateIncrementally =
+        !cache.dstImage.isNull() &&
+        cache.dstImage.size() == dstBoundsI.size() &&
+        cache.dstImageOffset == dstQImageOffset &&
+        cache.srcImageOffset == srcImageOffset &&
+        cache.originalPoints == originalPointsLocal &&
+        cache.transformedPoints.size() == transformedPointsLocal.size() &&
+        cache.srcImage == srcImage;
+
+    QRect applyRect;
+
+    if (canUpdateIncrementally) {
+        applyRect = GridIterationTools::changedCellsBounds(m_d->gridSize,
+                                                           cache.transformedPoints,
+                                                           transformedPointsLocal);
+        if (applyRect.isEmpty()) {
+            return cache.dstImage;
+        }
+
+        // the same rounding as in QImagePolygonOp
+        const QRect imageRect =
+            applyRect.translated((-dstQImageOffset).toPoint()) & cache.dstImage.rect();
 
-    GridIterationTools::QImagePolygonOp polygonOp(srcImage, dstImage, srcImageOffset, dstQImageOffset);
+        QPainter gc(&cache.dstImage);
+        gc.setCompositionMode(QPainter::CompositionMode_Source);
+        gc.fillRect(imageRect, Qt::transparent);
+    } else {
+        cache.dstImage = QImage(dstBoundsI.size(), srcImage.format());
+        cache.dstImage.fill(0);
+    }
+
+    GridIterationTools::QImagePolygonOp polygonOp(srcImage, cache.dstImage, srcImageOffset, dstQImageOffset);
+    GridIterationTools::ParallelPolygonOp<GridIterationTools::QImagePolygonOp> parallelOp(polygonOp, applyRect);
     Private::MapIndexesOp indexesOp(m_d.data());
     GridIterationTools::iterateThroughGrid
-        <GridIterationTools::AlwaysCompletePolygonPolicy>(polygonOp, indexesOp,
+        <GridIterationTools::AlwaysCompletePolygonPolicy>(parallelOp, indexesOp,
                                                           m_d->gridSize,
                                                           originalPointsLocal,
                                                           transformedPointsLocal);
-    return dstImage;
+    parallelOp.finish();
+
+    cache.srcImage = srcImage;
+    cache.srcImageOffset = srcImageOffset;
+    cache.dstImageOffset = dstQImageOffset;
+    cache.originalPoints = originalPointsLocal;
+    cache.transformedPoints = transformedPointsLocal;
+
+    return cache.dstImage;
 }
 
 void KisLiquifyTransformWorker::toXML(QDomElement *e) const
@@ -0,0 +1,287 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_morphology.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <QRect>
+#include <QtMath>
+#include <QtConcurrent>
+
+#include "kis_paint_device.h"
+#include "kis_debug.h"
+#include "krita_utils.h"
+
+
+namespace {
+
+struct MaxOp {
+    static inline quint8 identity() { return 0; }
+    static inline quint8 apply(quint8 a, quint8 b) { return a > b ? a : b; }
+};
+
+struct MinOp {
+    static inline quint8 identity() { return 255; }
+    static inline quint8 apply(quint8 a, quint8 b) { return a < b ? a : b; }
+};
+
+/**
+ * Computes the min/max of \p src over a sliding window of (2 * radius + 1)
+ * elements. \p src should contain numOutputs + 2 * radius elements, the
+ * first window is centered at src[radius].
+ *
+ * The sequence is split into blocks of the window size. Every window
+ * covers the suffix of one block and the prefix of the next one, so
+ * its value is combined from the two precalculated running values.
+ */
+template <class Op>
+void vanHerkGilWerman(const quint8 *src, int srcStep,
+                      quint8 *dst, int dstStep,
+                      int numOutputs, int radius,
+                      quint8 *prefix, quint8 *suffix)
+{
+    const int window = 2 * radius + 1;
+    const int length = numOutputs + 2 * radius;
+
+    for (int blockStart = 0; blockStart < length; blockStart += window) {
+        const int blockEnd = qMin(blockStart + window, length);
+
+        quint8 value = src[blockStart * srcStep];
+        prefix[blockStart] = value;
+
+        for (int i = blockStart + 1; i < blockEnd; i++) {
+            value = Op::apply(value, src[i * srcStep]);
+            prefix[i] = value;
+        }
+
+        value = src[(blockEnd - 1) * srcStep];
+        suffix[blockEnd - 1] = value;
+
+        for (int i = blockEnd - 2; i >= blockStart; i--) {
+            value = Op::apply(value, src[i * srcStep]);
+            suffix[i] = value;
+        }
+    }
+
+    for (int i = 0; i < numOutputs; i++) {
+        dst[i * dstStep] = Op::apply(suffix[i], prefix[i + window - 1]);
+    }
+}
+
+/**
+ * Processes the rows [top, bottom) of the area. The pixels are read
+ * from \p src and the result is written into \p dst.
+ */
+template <class Op>
+void processStripe(KisPaintDeviceSP src, KisPaintDeviceSP dst,
+                   const QRect &rect, int top, int bottom,
+                   const QVector<QPoint> &rectangles,
+                   int xRadius, int yRadius,
+                   Qt::Orientations repeatBorders)
+{
+    const int width = rect.width();
+    const int numRows = bottom - top;
+
+    const int srcWidth = width + 2 * xRadius;
+    const int srcHeight = numRows + 2 * yRadius;
+    const int srcTop = top - yRadius;
+
+    QVector<quint8> srcBuffer(srcWidth * srcHeight, 0);
+    quint8 *srcPtr = srcBuffer.data();
+
+    // the stripe lies inside the rect, so the read rect is never empty
+    const QRect readRect = QRect(rect.x(), srcTop, width, srcHeight) & rect;
+
+    QVector<quint8> readBuffer(readRect.width() * readRect.height());
+    src->readBytes(readBuffer.data(), readRect);
+
+    for (int y = readRect.top(); y <= readRect.bottom(); y++) {
+        quint8 *rowPtr = srcPtr + (y - srcTop) * srcWidth;
+
+        memcpy(rowPtr + xRadius,
+               readBuffer.constData() + (y - readRect.top()) * width,
+               width);
+
+        if (repeatBorders & Qt::Horizontal) {
+            memset(rowPtr, rowPtr[xRadius], xRadius);
+            memset(rowPtr + xRadius + width, rowPtr[xRadius + width - 1], xRadius);
+        }
+    }
+
+    if (repeatBorders & Qt::Vertical) {
+        const quint8 *firstRow = srcPtr + (readRect.top() - srcTop) * srcWidth;
+        const quint8 *lastRow = srcPtr + (readRect.bottom() - srcTop) * srcWidth;
+
+        for (int y = srcTop; y < readRect.top(); y++) {
+            memcpy(srcPtr + (y - srcTop) * srcWidth, firstRow, srcWidth);
+        }
+
+        for (int y = readRect.bottom() + 1; y < srcTop + srcHeight; y++) {
+            memcpy(srcPtr + (y - srcTop) * srcWidth, lastRow, srcWidth);
+        }
+    }
+
+    QVector<quint8> resultBuffer(width * numRows, Op::identity());
+    QVector<quint8> columnsBuffer(srcWidth * numRows);
+    QVector<quint8> lineBuffer(width);
+    QVector<quint8> prefix(qMax(srcWidth, srcHeight));
+    QVector<quint8> suffix(qMax(srcWidth, srcHeight));
+
+    Q_FOREACH (const QPoint &rectangle, rectangles) {
+        const int rx = rectangle.x();
+        const int ry = rectangle.y();
+
+        const int firstColumn = xRadius - rx;
+        const int lastColumn = xRadius + width + rx; // exclusive
+
+        // vertical pass
+        for (int x = firstColumn; x < lastColumn; x++) {
+            vanHerkGilWerman<Op>(srcPtr + (yRadius - ry) * srcWidth + x, srcWidth,
+                                 columnsBuffer.data() + x, srcWidth,
+                                 numRows, ry,
+                                 prefix.data(), suffix.data());
+        }
+
+        // horizontal pass
+        for (int y = 0; y < numRows; y++) {
+            vanHerkGilWerman<Op>(columnsBuffer.constData() + y * srcWidth + firstColumn, 1,
+                                 lineBuffer.data(), 1,
+                                 width, rx,
+                                 prefix.data(), suffix.data());
+
+            quint8 *resultPtr = resultBuffer.data() + y * width;
+            const quint8 *linePtr = lineBuffer.constData();
+
+            for (int x = 0; x < width; x++) {
+                resultPtr[x] = Op::apply(resultPtr[x], linePtr[x]);
+            }
+        }
+    }
+
+    dst->writeBytes(resultBuffer.constData(), QRect(rect.x(), top, width, numRows));
+}
+
+template <class Op>
+void processImpl(KisPaintDeviceSP device, const QRect &rect,
+                 const QVector<QPoint> &rectangles,
+                 int xRadius, int yRadius,
+                 Qt::Orientations repeatBorders)
+{
+    /**
+     * The stripes read the pixels around them, so they read from a
+     * copy-on-write snapshot of the device, while the results are
+     * written into the device itself. The stripes consist of whole
+     * tile rows of the device, counted from its y offset, so two threads
+     * never write into the same tile. The stripes are made higher for
+     * big radii to limit the overhead of the rows read twice by the
+     * neighbouring stripes.
+     */
+    KisPaintDeviceSP src = new KisPaintDevice(*device);
+
+    const int tileSize = 64;
+    const int stripeSize = qMax(tileSize, (2 * yRadius + tileSize - 1) / tileSize * tileSize);
+
+    QVector<QPair<int, int>> stripes =
+        KritaUtils::splitIntoAlignedStripes(rect.top(), rect.bottom() + 1, device->y(), stripeSize);
+
+    QtConcurrent::blockingMap(stripes, [&] (const QPair<int, int> &stripe) {
+        processStripe<Op>(src, device, rect, stripe.first, stripe.second,
+                          rectangles, xRadius, yRadius, repeatBorders);
+    });
+}
+
+}
+
+namespace KisMorphology
+{
+
+QVector<QPoint> decompose(Shape shape, int xRadius, int yRadius)
+{
+    xRadius = qMax(0, xRadius);
+    yRadius = qMax(0, yRadius);
+
+    if (shape == Square || !xRadius) {
+        return QVector<QPoint>() << QPoint(xRadius, yRadius);
+    }
+
+    QVector<int> heights(xRadius + 1);
+
+    for (int x = 0; x <= xRadius; x++) {
+        if (shape == Disk) {
+            // the same sampling as KisSelectionFilter::computeBorder() uses
+            const qreal dx = x > 0 ? x - 0.5 : 0.0;
+            heights[x] = qFloor(qreal(yRadius) / xRadius * std::sqrt(qreal(xRadius * xRadius) - dx * dx) + 0.5);
+        } else /* if (shape == Diamond) */ {
+            heights[x] = qFloor(yRadius * (1.0 - qreal(x) / xRadius));
+        }
+    }
+
+    /**
+     * Every step of the outline of the shape gives a rectangle, the
+     * union of the rectangles is the shape itself
+     */
+    QVector<QPoint> rectangles;
+
+    for (int x = 0; x <= xRadius; x++) {
+        if (x == xRadius || heights[x] > heights[x + 1]) {
+            rectangles << QPoint(x, heights[x]);
+        }
+    }
+
+    /**
+     * Too many steps, approximate the shape with a subset of them.
+     * The widest and the highest rectangles are always kept, so the
+     * extents of the shape are preserved.
+     */
+    if (rectangles.size() > maxRectangles) {
+        QVector<QPoint> approximation;
+
+        for (int i = 0; i < maxRectangles; i++) {
+            const int index = qRound(qreal(i) * (rectangles.size() - 1) / (maxRectangles - 1));
+            approximation << rectangles[index];
+        }
+
+        rectangles = approximation;
+    }
+
+    return rectangles;
+}
+
+void apply(KisPaintDeviceSP device, const QRect &rect,
+           Operation operation, Shape shape,
+           int xRadius, int yRadius,
+           Qt::Orientations repeatBorders)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(device->pixelSize() == 1);
+    if (rect.isEmpty()) return;
+
+    xRadius = qMax(0, xRadius);
+    yRadius = qMax(0, yRadius);
+
+    const QVector<QPoint> rectangles = decompose(shape, xRadius, yRadius);
+
+    if (operation == Dilate) {
+        processImpl<MaxOp>(device, rect, rectangles, xRadius, yRadius, repeatBorders);
+    } else {
+        processImpl<MinOp>(device, rect, rectangles, xRadius, yRadius, repeatBorders);
+    }
+}
+
+}
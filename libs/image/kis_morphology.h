@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_MORPHOLOGY_H
+#define __KIS_MORPHOLOGY_H
+
+#include <QVector>
+#include <QPoint>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+class QRect;
+
+
+/**
+ * Grayscale dilation and erosion of alpha8 devices (selections).
+ *
+ * The structuring element is split into a union of rectangles
+ * centered at the origin. Every rectangle is applied as two separable
+ * passes of the van Herk/Gil-Werman algorithm, which costs three
+ * comparisons per pixel independently of the radius. The square needs
+ * a single rectangle. The disk (ellipse) and the diamond need one
+ * rectangle per step of their outline, which is exact for small radii.
+ * For bigger radii the number of rectangles is limited by
+ * maxRectangles, so the shape is approximated by an inscribed
+ * staircase and the cost per pixel stays constant.
+ *
+ * The area is processed in stripes aligned to the tiles of the device,
+ * the stripes are processed in parallel.
+ */
+namespace KisMorphology
+{
+    enum Operation {
+        Dilate,
+        Erode
+    };
+
+    enum Shape {
+        Square,
+        Diamond,
+        Disk
+    };
+
+    static const int maxRectangles = 16;
+
+    /**
+     * Returns the half-sizes of the rectangles the structuring element
+     * is decomposed into. x() is the horizontal radius of a rectangle,
+     * y() is the vertical one.
+     */
+    KRITAIMAGE_EXPORT QVector<QPoint> decompose(Shape shape, int xRadius, int yRadius);
+
+    /**
+     * Applies \p operation to the pixels of \p device inside \p rect.
+     *
+     * The pixels outside \p rect are not read. For the directions
+     * listed in \p repeatBorders the edge pixels of \p rect are
+     * repeated instead, in the other directions the pixels outside
+     * are considered to be zero.
+     */
+    KRITAIMAGE_EXPORT void apply(KisPaintDeviceSP device, const QRect &rect,
+                                 Operation operation, Shape shape,
+                                 int xRadius, int yRadius,
+                                 Qt::Orientations repeatBorders = 0);
+}
+
+#endif /* __KIS_MORPHOLOGY_H */
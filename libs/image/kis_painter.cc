@@ -34,7 +34,9 @@
 #endif
 
 #include <QImage>
+#include <QMutex>
 #include <QRect>
+#include <QRegion>
 #include <QString>
 #include <QStringList>
 #include <kundo2command.h>
@@ -51,10 +53,12 @@
 #include "kis_layer.h"
 #include "kis_paint_device.h"
 #include "kis_fixed_paint_device.h"
+#include "kis_rendered_dab.h"
 #include "kis_transaction.h"
 #include "kis_vec.h"
 #include "kis_iterator_ng.h"
 #include "kis_random_accessor_ng.h"
+#include "kis_scatter_writer.h"
 #include "kis_paintop.h"
 #include "kis_selection.h"
 #include "kis_fill_painter.h"
@@ -132,7 +136,12 @@ struct Q_DECL_HIDDEN KisPainter::Private {
                              qint32 *dstX,
                              qint32 *dstY);
 
+    KisPaintDeviceSP areaBackup;
+    QRegion backedUpRegion;
+    QMutex areaBackupLock;
+
     void fillPainterPathImpl(const QPainterPath& path, const QRect &requestedRect);
+    void backupArea(const QRect &rc);
 };
 
 KisPainter::KisPainter()
@@ -449,6 +458,53 @@ QVector<QRect> KisPainter::takeDirtyRegion()
 }
 
 
+void KisPainter::beginAreaBackup()
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(d->device);
+
+    QMutexLocker l(&d->areaBackupLock);
+    d->areaBackup = new KisPaintDevice(d->device->colorSpace());
+    d->backedUpRegion = QRegion();
+}
+
+QVector<QRect> KisPainter::revertAreaBackup()
+{
+    QMutexLocker l(&d->areaBackupLock);
+
+    QVector<QRect> rects;
+    if (!d->areaBackup) return rects;
+
+    rects = d->backedUpRegion.rects();
+
+    Q_FOREACH (const QRect &rc, rects) {
+        copyAreaOptimized(rc.topLeft(), d->areaBackup, d->device, rc);
+    }
+
+    d->areaBackup = 0;
+    d->backedUpRegion = QRegion();
+
+    return rects;
+}
+
+void KisPainter::Private::backupArea(const QRect &rc)
+{
+    if (!areaBackup) return;
+
+    /**
+     * The dabs of a line may be composited by several threads at once,
+     * but they never write into the same area
+     */
+    QMutexLocker l(&areaBackupLock);
+
+    const QRegion missingRegion = QRegion(rc) - backedUpRegion;
+
+    Q_FOREACH (const QRect &missingRect, missingRegion.rects()) {
+        KisPainter::copyAreaOptimized(missingRect.topLeft(), device, areaBackup, missingRect);
+    }
+
+    backedUpRegion += rc;
+}
+
 void KisPainter::addDirtyRect(const QRect & rc)
 {
     QRect r = rc.normalized();
@@ -532,6 +588,8 @@ void KisPainter::bitBltWithFixedSelection(qint32 dstX, qint32 dstY,
                                &srcWidth, &srcHeight,
                                &dstX, &dstY)) return;
 
+    d->backupArea(QRect(dstX, dstY, srcWidth, srcHeight));
+
     /* Create an intermediate byte array to hold information before it is written
     to the current paint device (d->device) */
     quint8* dstBytes = 0;
@@ -642,6 +700,8 @@ void KisPainter::bitBltImpl(qint32 dstX, qint32 dstY,
 
     QRect srcRect = QRect(srcX, srcY, srcWidth, srcHeight);
 
+    d->backupArea(QRect(dstX, dstY, srcWidth, srcHeight));
+
     if (d->compositeOp->id() == COMPOSITE_COPY) {
         if(!d->selection && d->isOpacityUnit &&
            srcX == dstX && srcY == dstY &&
@@ -825,6 +885,8 @@ void KisPainter::fill(qint32 x, qint32 y, qint32 width, qint32 height, const KoC
     if(width == 0 || height == 0 || d->device.isNull())
         return;
 
+    d->backupArea(QRect(x, y, width, height));
+
     KoColor srcColor(color, d->device->compositionSourceColorSpace());
     qint32  dstY          = y;
     qint32  rowsRemaining = height;
@@ -934,6 +996,8 @@ void KisPainter::bltFixed(qint32 dstX, qint32 dstY,
     Q_ASSERT(srcBounds.contains(srcRect));
     Q_UNUSED(srcRect); // only used in above assertion
 
+    d->backupArea(QRect(dstX, dstY, srcWidth, srcHeight));
+
     /* Create an intermediate byte array to hold information before it is written
     to the current paint device (aka: d->device) */
     quint8* dstBytes = 0;
@@ -990,6 +1054,79 @@ void KisPainter::bltFixed(const QPoint & pos, const KisFixedPaintDeviceSP srcDev
     bltFixed(pos.x(), pos.y(), srcDev, srcRect.x(), srcRect.y(), srcRect.width(), srcRect.height());
 }
 
+void KisPainter::bltFixed(const QRect &applyRect, const QList<KisRenderedDab> &allSrcDevices)
+{
+    if (applyRect.isEmpty() || allSrcDevices.isEmpty()) return;
+    if (d->device.isNull()) return;
+
+    d->backupArea(applyRect);
+
+    const int pixelSize = d->device->pixelSize();
+    const int dstRowStride = applyRect.width() * pixelSize;
+
+    QVector<quint8> dstBytes(applyRect.height() * dstRowStride);
+    d->device->readBytes(dstBytes.data(), applyRect);
+
+    QVector<quint8> selBytes;
+    int selPixelSize = 0;
+
+    if (d->selection) {
+        KisPaintDeviceSP selectionProjection(d->selection->projection());
+        selPixelSize = selectionProjection->pixelSize();
+
+        selBytes.resize(applyRect.width() * applyRect.height() * selPixelSize);
+        selectionProjection->readBytes(selBytes.data(), applyRect);
+    }
+
+    /**
+     * Use a local copy of the parameters, so the painter is never
+     * modified and the method can be called concurrently
+     */
+    KoCompositeOp::ParameterInfo paramInfo(d->paramInfo);
+
+    Q_FOREACH (const KisRenderedDab &dab, allSrcDevices) {
+        const QRect rc = dab.realBounds() & applyRect;
+        if (rc.isEmpty()) continue;
+
+        const QRect srcBounds = dab.device->bounds();
+        const int srcPixelSize = dab.device->pixelSize();
+        const int dstOffset =
+            (rc.y() - applyRect.y()) * applyRect.width() + rc.x() - applyRect.x();
+
+        paramInfo.dstRowStart   = dstBytes.data() + dstOffset * pixelSize;
+        paramInfo.dstRowStride  = dstRowStride;
+        paramInfo.srcRowStart   = dab.device->data() +
+            ((rc.y() - dab.offset.y()) * srcBounds.width() + rc.x() - dab.offset.x()) * srcPixelSize;
+        paramInfo.srcRowStride  = srcBounds.width() * srcPixelSize;
+        paramInfo.maskRowStart  = d->selection ? selBytes.constData() + dstOffset * selPixelSize : 0;
+        paramInfo.maskRowStride = d->selection ? applyRect.width() * selPixelSize : 0;
+        paramInfo.rows          = rc.height();
+        paramInfo.cols          = rc.width();
+
+        paramInfo.opacity = dab.opacity;
+        paramInfo.flow = dab.flow;
+        paramInfo._lastOpacityData = dab.averageOpacity;
+        paramInfo.lastOpacity = &paramInfo._lastOpacityData;
+
+        d->colorSpace->bitBlt(dab.device->colorSpace(), paramInfo, d->compositeOp, d->renderingIntent, d->conversionFlags);
+    }
+
+    d->device->writeBytes(dstBytes.constData(), applyRect);
+}
+
+KisRenderedDab KisPainter::renderedDab(KisFixedPaintDeviceSP dab, const QPoint &offset) const
+{
+    KisRenderedDab result;
+
+    result.device = dab;
+    result.offset = offset;
+    result.opacity = d->paramInfo.opacity;
+    result.flow = d->paramInfo.flow;
+    result.averageOpacity = *d->paramInfo.lastOpacity;
+
+    return result;
+}
+
 void KisPainter::bltFixedWithFixedSelection(qint32 dstX, qint32 dstY,
                                             const KisFixedPaintDeviceSP srcDev,
                                             const KisFixedPaintDeviceSP selection,
@@ -1021,6 +1158,8 @@ void KisPainter::bltFixedWithFixedSelection(qint32 dstX, qint32 dstY,
     Q_ASSERT(selBounds.contains(selRect));
     Q_UNUSED(selRect); // only used in above assertion
 
+    d->backupArea(QRect(dstX, dstY, srcWidth, srcHeight));
+
     /* Create an intermediate byte array to hold information before it is written
     to the current paint device (aka: d->device) */
     quint8* dstBytes = 0;
@@ -1615,7 +1754,10 @@ void KisPainter::drawLine(const QPointF& start, const QPointF& end, qreal width,
     denominator = 1.0/denominator;
 
     qreal projection,scanX,scanY,AA_;
-    KisRandomAccessorSP accessor = d->device->createRandomAccessorNG(x1, y1);
+    KisScatterWriter writer(d->device, KisScatterWriter::Composite);
+    writer.setCompositeOp(d->compositeOp, d->paramInfo, d->paintColor.colorSpace(),
+                          d->renderingIntent, d->conversionFlags);
+
     KisRandomConstAccessorSP selectionAccessor;
     if (d->selection) {
         selectionAccessor = d->selection->projection()->createRandomConstAccessorNG(x1, y1);
@@ -1639,7 +1781,6 @@ void KisPainter::drawLine(const QPointF& start, const QPointF& end, qreal width,
                 continue;
             }
 
-            accessor->moveTo(x, y);
             if (selectionAccessor) selectionAccessor->moveTo(x,y);
 
             if (!selectionAccessor || *selectionAccessor->oldRawData() > SELECTION_THRESHOLD) {
@@ -1649,10 +1790,12 @@ void KisPainter::drawLine(const QPointF& start, const QPointF& end, qreal width,
                     mycolor.colorSpace()->multiplyAlpha(mycolor.data(), 1.0 - (AA_-(halfWidth-1.0)), 1);
                 }
 
-                compositeOnePixel(accessor->rawData(), mycolor);
+                writer.addSample(x, y, mycolor.data());
             }
         }
     }
+
+    writer.flush();
 }
 
 /**/
@@ -2613,6 +2756,26 @@ quint8 KisPainter::opacity() const
     return quint8(d->paramInfo.opacity * 255.0f);
 }
 
+KisPainter::OpacityState KisPainter::opacityState() const
+{
+    OpacityState state;
+    state.opacity = d->paramInfo.opacity;
+    state.flow = d->paramInfo.flow;
+    state.meanOpacity = d->paramInfo._lastOpacityData;
+    state.meanIsOpacity = d->paramInfo.lastOpacity == &d->paramInfo.opacity;
+    return state;
+}
+
+void KisPainter::setOpacityState(const OpacityState &state)
+{
+    d->paramInfo.opacity = state.opacity;
+    d->paramInfo.flow = state.flow;
+    d->paramInfo._lastOpacityData = state.meanOpacity;
+    d->paramInfo.lastOpacity =
+        state.meanIsOpacity ? &d->paramInfo.opacity : &d->paramInfo._lastOpacityData;
+    d->isOpacityUnit = state.opacity == 1.0f;
+}
+
 void KisPainter::setCompositeOp(const KoCompositeOp * op)
 {
     d->compositeOp = op;
@@ -2763,6 +2926,17 @@ void KisPainter::renderMirrorMaskSafe(QRect rc, KisPaintDeviceSP dab, int sx, in
     renderMirrorMask(rc, dab, sx, sy, maskToProcess);
 }
 
+void KisPainter::renderMirrorMaskSafe(QRect rc, KisFixedPaintDeviceSP dab, KisFixedPaintDeviceSP mask, bool preserveMask)
+{
+    if (!d->mirrorHorizontally && !d->mirrorVertically) return;
+
+    KisFixedPaintDeviceSP maskToProcess = mask;
+    if (preserveMask) {
+        maskToProcess = new KisFixedPaintDevice(*mask);
+    }
+    renderMirrorMask(rc, dab, maskToProcess);
+}
+
 void KisPainter::renderMirrorMask(QRect rc, KisFixedPaintDeviceSP dab)
 {
     int x = rc.topLeft().x();
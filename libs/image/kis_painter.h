@@ -53,6 +53,7 @@ class KoPattern;
 class KisPaintInformation;
 class KisPaintOp;
 class KisDistanceInformation;
+struct KisRenderedDab;
 
 /**
  * KisPainter contains the graphics primitives necessary to draw on a
@@ -306,6 +307,31 @@ public:
      */
     void bltFixed(const QPoint & pos, const KisFixedPaintDeviceSP srcDev, const QRect & srcRect);
 
+    /**
+     * Composites the sequence of dabs \p allSrcDevices onto the current
+     * paint device. Only the pixels inside \p applyRect are touched, they
+     * are read and written through the tiled device just once. Every dab
+     * is composited with its own opacity, flow and average opacity, so
+     * the result is exactly the same as if the dabs were blitted one by
+     * one with bltFixed() in the same order.
+     *
+     * The method does not change the state of the painter, so it may be
+     * called from several threads at once as long as their \p applyRect
+     * areas are aligned to the tiles and do not overlap. The dirty rects
+     * are *not* registered, the caller should call addDirtyRect() itself.
+     *
+     * \see renderedDab()
+     */
+    void bltFixed(const QRect &applyRect, const QList<KisRenderedDab> &allSrcDevices);
+
+    /**
+     * Wraps \p dab placed at \p offset into a KisRenderedDab, which
+     * stores the current opacity, flow and average opacity of the
+     * painter. The dab can then be composited later with
+     * bltFixed(const QRect&, const QList<KisRenderedDab>&).
+     */
+    KisRenderedDab renderedDab(KisFixedPaintDeviceSP dab, const QPoint &offset) const;
+
     /**
      * Blasts a @param selection of srcWidth @param srcWidth and srcHeight @param srcHeight
      * of @param srcDev on the current paint device. There is parameters to control
@@ -407,6 +433,19 @@ public:
      */
     void renderMirrorMaskSafe(QRect rc, KisPaintDeviceSP dab, int sx, int sy, KisFixedPaintDeviceSP mask, bool preserveMask);
 
+    /**
+     * Convenience method for renderMirrorMask(), allows to choose whether
+     * we need to preserve our fixed mask or do the transformations in-place.
+     * The \p dab is always mirrored in-place.
+     *
+     * @param rc rectangle area covered by dab
+     * @param dab the device to render
+     * @param mask mask to use for rendering
+     * @param preserveMask states whether a temporary device should be
+     *                    created to do the transformations
+     */
+    void renderMirrorMaskSafe(QRect rc, KisFixedPaintDeviceSP dab, KisFixedPaintDeviceSP mask, bool preserveMask);
+
     /**
      * A complex method that re-renders a dab on an \p rc area.
      * The \p rc  area and all the dedicated mirroring areas are cleared
@@ -424,6 +463,22 @@ public:
       */
     QVector<QRect> takeDirtyRegion();
 
+    /**
+     * Starts keeping a copy of the pixels of the device before the
+     * painter changes them. Only the areas written by the blitting
+     * methods (bitBlt*(), bltFixed*(), fill()) are copied, and every
+     * pixel is copied only once.
+     *
+     * \see revertAreaBackup()
+     */
+    void beginAreaBackup();
+
+    /**
+     * Puts the backed up pixels back into the device and stops the
+     * backup started by beginAreaBackup(). Returns the restored rects.
+     */
+    QVector<QRect> revertAreaBackup();
+
     /**
      * Paint a line that connects the dots in points
      */
@@ -712,6 +767,21 @@ public:
     /// Returns the opacity that is used in painting
     quint8 opacity() const;
 
+    /**
+     * The opacity, the flow and the mean opacity of the stroke. The
+     * paintops change them with every dab, so a line that is going to
+     * be rolled back should restore them afterwards.
+     */
+    struct OpacityState {
+        float opacity;
+        float flow;
+        float meanOpacity;
+        bool meanIsOpacity;
+    };
+
+    OpacityState opacityState() const;
+    void setOpacityState(const OpacityState &state);
+
     /// Set the composite op for this painter
     void setCompositeOp(const KoCompositeOp * op);
     const KoCompositeOp * compositeOp();
@@ -37,11 +37,83 @@
 #include "kis_debug.h"
 #include "kis_image.h"
 #include "kis_fill_painter.h"
-#include "kis_outline_generator.h"
+#include "kis_tiled_outline_generator.h"
 #include <kis_iterator_ng.h>
 #include "kis_lod_transform.h"
 
 
+namespace {
+
+QPainterPath pathFromPolygons(const QVector<QPolygon> &polygons)
+{
+    QPainterPath path;
+
+    Q_FOREACH (const QPolygon &polygon, polygons) {
+        path.addPolygon(polygon);
+        path.closeSubpath();
+    }
+
+    return path;
+}
+
+inline bool isDegenerateCorner(const QPoint &a, const QPoint &b, const QPoint &c) {
+    const QPoint ab = b - a;
+    const QPoint bc = c - b;
+    return qint64(ab.x()) * bc.y() == qint64(ab.y()) * bc.x();
+}
+
+/**
+ * Snaps the vertices of \p polygon to the grid of \p gridSize
+ * pixels and removes the vertices that become redundant after
+ * that. Returns an empty polygon if the whole polygon collapses.
+ */
+QPolygon snapPolygonToGrid(const QPolygon &polygon, int gridSize)
+{
+    QPolygon result;
+    result.reserve(polygon.size());
+
+    Q_FOREACH (const QPoint &pt, polygon) {
+        const QPoint snapped(qRound(qreal(pt.x()) / gridSize) * gridSize,
+                             qRound(qreal(pt.y()) / gridSize) * gridSize);
+
+        if (!result.isEmpty() && result.last() == snapped) continue;
+
+        while (result.size() >= 2 &&
+               isDegenerateCorner(result[result.size() - 2], result.last(), snapped)) {
+
+            result.removeLast();
+        }
+
+        if (!result.isEmpty() && result.last() == snapped) continue;
+
+        result << snapped;
+    }
+
+    while (result.size() >= 2 && result.first() == result.last()) {
+        result.removeLast();
+    }
+
+    while (result.size() >= 3 &&
+           isDegenerateCorner(result[result.size() - 2], result.last(), result.first())) {
+
+        result.removeLast();
+    }
+
+    while (result.size() >= 3 &&
+           isDegenerateCorner(result.last(), result.first(), result[1])) {
+
+        result.remove(0);
+    }
+
+    if (result.size() < 3) {
+        result.clear();
+    }
+
+    return result;
+}
+
+}
+
 struct Q_DECL_HIDDEN KisPixelSelection::Private {
     KisSelectionWSP parentSelection;
 
@@ -49,6 +121,11 @@ struct Q_DECL_HIDDEN KisPixelSelection::Private {
     bool outlineCacheValid;
     QMutex outlineCacheMutex;
 
+    QVector<QPainterPath> simplifiedOutlineCaches;
+
+    KisTiledOutlineGenerator outlineGenerator;
+    QMutex outlineGeneratorMutex;
+
     bool thumbnailImageValid;
     QImage thumbnailImage;
     QTransform thumbnailImageTransform;
@@ -80,6 +157,7 @@ KisPixelSelection::KisPixelSelection(const KisPixelSelection& rhs)
     // parent selection is not supposed to be shared
     m_d->outlineCache = rhs.m_d->outlineCache;
     m_d->outlineCacheValid = rhs.m_d->outlineCacheValid;
+    m_d->simplifiedOutlineCaches = rhs.m_d->simplifiedOutlineCaches;
 
     m_d->thumbnailImageValid = rhs.m_d->thumbnailImageValid;
     m_d->thumbnailImage = rhs.m_d->thumbnailImage;
@@ -130,6 +208,7 @@ void KisPixelSelection::select(const QRect & rc, quint8 selectedness)
         } else {
             m_d->outlineCache -= path;
         }
+        m_d->simplifiedOutlineCaches.clear();
     }
     m_d->invalidateThumbnailImage();
 }
@@ -171,6 +250,7 @@ void KisPixelSelection::copyAlphaFrom(KisPaintDeviceSP src, const QRect &process
 
     m_d->outlineCacheValid = false;
     m_d->outlineCache = QPainterPath();
+    m_d->simplifiedOutlineCaches.clear();
     m_d->invalidateThumbnailImage();
 }
 
@@ -197,6 +277,7 @@ void KisPixelSelection::addSelection(KisPixelSelectionSP selection)
 
     if (m_d->outlineCacheValid) {
         m_d->outlineCache += selection->outlineCache();
+        m_d->simplifiedOutlineCaches.clear();
     }
 
     m_d->invalidateThumbnailImage();
@@ -226,6 +307,7 @@ void KisPixelSelection::subtractSelection(KisPixelSelectionSP selection)
 
     if (m_d->outlineCacheValid) {
         m_d->outlineCache -= selection->outlineCache();
+        m_d->simplifiedOutlineCaches.clear();
     }
 
     m_d->invalidateThumbnailImage();
@@ -250,6 +332,7 @@ void KisPixelSelection::intersectSelection(KisPixelSelectionSP selection)
 
     if (m_d->outlineCacheValid) {
         m_d->outlineCache &= selection->outlineCache();
+        m_d->simplifiedOutlineCaches.clear();
     }
 
     m_d->invalidateThumbnailImage();
@@ -270,6 +353,7 @@ void KisPixelSelection::clear(const QRect & r)
         path.addRect(r);
 
         m_d->outlineCache -= path;
+        m_d->simplifiedOutlineCaches.clear();
     }
 
     m_d->invalidateThumbnailImage();
@@ -282,6 +366,7 @@ void KisPixelSelection::clear()
 
     m_d->outlineCacheValid = true;
     m_d->outlineCache = QPainterPath();
+    m_d->simplifiedOutlineCaches.clear();
 
     // Empty the thumbnail image. It is a valid state.
     m_d->invalidateThumbnailImage();
@@ -308,6 +393,7 @@ void KisPixelSelection::invert()
         path.addRect(defaultBounds()->bounds());
 
         m_d->outlineCache = path - m_d->outlineCache;
+        m_d->simplifiedOutlineCaches.clear();
     }
 
     m_d->invalidateThumbnailImage();
@@ -323,6 +409,10 @@ void KisPixelSelection::moveTo(const QPoint &pt)
 
     if (m_d->outlineCacheValid) {
         m_d->outlineCache.translate(offset);
+
+        for (int i = 0; i < m_d->simplifiedOutlineCaches.size(); i++) {
+            m_d->simplifiedOutlineCaches[i].translate(offset);
+        }
     }
 
     if (m_d->thumbnailImageValid) {
@@ -368,28 +458,13 @@ QVector<QPolygon> KisPixelSelection::outline() const
         selectionExtent &= defaultBounds()->bounds();
     }
 
-    qint32 xOffset = selectionExtent.x();
-    qint32 yOffset = selectionExtent.y();
-    qint32 width = selectionExtent.width();
-    qint32 height = selectionExtent.height();
-
-    KisOutlineGenerator generator(colorSpace(), MIN_SELECTED);
-    // If the selection is small using a buffer is much faster
-    try {
-        quint8* buffer = new quint8[width*height];
-        readBytes(buffer, xOffset, yOffset, width, height);
-
-        QVector<QPolygon> paths = generator.outline(buffer, xOffset, yOffset, width, height);
-
-        delete[] buffer;
-        return paths;
-    }
-    catch(std::bad_alloc) {
-        // Allocating so much memory failed, so we fall through to the slow option.
-        warnKrita << "KisPixelSelection::outline ran out of memory allocating" << width << "*" << height << "bytes.";
-    }
-
-    return generator.outline(this, xOffset, yOffset, width, height);
+    /**
+     * The generator keeps the outline of the previous run, so only
+     * the stripes of the selection that have changed since then are
+     * traced again.
+     */
+    QMutexLocker locker(&m_d->outlineGeneratorMutex);
+    return m_d->outlineGenerator.outline(this, selectionExtent, MIN_SELECTED);
 }
 
 bool KisPixelSelection::isEmpty() const
@@ -408,6 +483,7 @@ void KisPixelSelection::setOutlineCache(const QPainterPath &cache)
     QMutexLocker locker(&m_d->outlineCacheMutex);
     m_d->outlineCache = cache;
     m_d->outlineCacheValid = true;
+    m_d->simplifiedOutlineCaches.clear();
     m_d->thumbnailImageValid = false;
 }
 
@@ -428,26 +504,44 @@ void KisPixelSelection::recalculateOutlineCache()
 {
     QMutexLocker locker(&m_d->outlineCacheMutex);
 
-    m_d->outlineCache = QPainterPath();
+    const QVector<QPolygon> polygons = outline();
+
+    m_d->outlineCache = pathFromPolygons(polygons);
+    m_d->simplifiedOutlineCaches.clear();
+
+    /**
+     * At low zoom levels most of the vertices of the outline of a
+     * huge selection fall into the same screen pixel, so we also
+     * prepare the outlines with the vertices snapped to coarser grids
+     */
+    for (int level = 1; level <= maxOutlineSimplificationLevel; level++) {
+        QVector<QPolygon> simplifiedPolygons;
+
+        Q_FOREACH (const QPolygon &polygon, polygons) {
+            const QPolygon simplified = snapPolygonToGrid(polygon, 1 << level);
+
+            if (!simplified.isEmpty()) {
+                simplifiedPolygons << simplified;
+            }
+        }
 
-    Q_FOREACH (const QPolygon &polygon, outline()) {
-        m_d->outlineCache.addPolygon(polygon);
-
-        /**
-         * The outline generation algorithm has a small bug, which
-         * results in the starting point be repeated twice in the
-         * beginning of the path, instead of being put to the
-         * end. Here we just explicitly close the path to workaround
-         * it.
-         *
-         * \see KisSelectionTest::testOutlineGeneration()
-         */
-        m_d->outlineCache.closeSubpath();
+        m_d->simplifiedOutlineCaches << pathFromPolygons(simplifiedPolygons);
     }
 
     m_d->outlineCacheValid = true;
 }
 
+QPainterPath KisPixelSelection::simplifiedOutlineCache(int level) const
+{
+    QMutexLocker locker(&m_d->outlineCacheMutex);
+
+    if (level <= 0 || level > m_d->simplifiedOutlineCaches.size()) {
+        return m_d->outlineCache;
+    }
+
+    return m_d->simplifiedOutlineCaches[level - 1];
+}
+
 bool KisPixelSelection::thumbnailImageValid() const
 {
     return m_d->thumbnailImageValid;
@@ -125,6 +125,23 @@ public:
     void setOutlineCache(const QPainterPath &cache);
     void invalidateOutlineCache();
 
+    /**
+     * The highest simplification level of the outline cache
+     */
+    static const int maxOutlineSimplificationLevel = 3;
+
+    /**
+     * Returns the outline cache simplified for painting at the scale
+     * of 1/2^level and lower: the vertices of the outline are snapped
+     * to the grid of 2^level pixels and the outlines of the tiny
+     * regions are dropped. Level 0 is the outline cache itself.
+     *
+     * The simplified outlines are generated by
+     * recalculateOutlineCache() only, so after the cache has been
+     * updated in place the function returns the full outline.
+     */
+    QPainterPath simplifiedOutlineCache(int level) const;
+
     bool thumbnailImageValid() const;
     QImage thumbnailImage() const;
     QTransform thumbnailImageTransform() const;
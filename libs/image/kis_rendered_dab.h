@@ -0,0 +1,58 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_RENDERED_DAB_H
+#define __KIS_RENDERED_DAB_H
+
+#include <QRect>
+
+#include "kis_types.h"
+#include "kis_fixed_paint_device.h"
+
+
+/**
+ * A dab that has been generated, but not yet composited onto the
+ * destination device. Besides the pixels it keeps the blending
+ * parameters the painter had when the dab was generated, so a
+ * sequence of dabs can be composited later in one go.
+ *
+ * \see KisPainter::renderedDab()
+ * \see KisPainter::bltFixed(const QRect&, const QList<KisRenderedDab>&)
+ */
+struct KisRenderedDab
+{
+    KisRenderedDab()
+        : opacity(1.0f),
+          flow(1.0f),
+          averageOpacity(1.0f)
+    {
+    }
+
+    KisFixedPaintDeviceSP device;
+    QPoint offset;
+
+    float opacity;
+    float flow;
+    float averageOpacity;
+
+    inline QRect realBounds() const {
+        return QRect(offset, device->bounds().size());
+    }
+};
+
+#endif /* __KIS_RENDERED_DAB_H */
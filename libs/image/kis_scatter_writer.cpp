@@ -0,0 +1,253 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_scatter_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QVector>
+
+#include <KoColorSpace.h>
+
+#include "kis_paint_device.h"
+#include "kis_random_accessor_ng.h"
+#include "kis_debug.h"
+
+
+namespace {
+
+struct Sample {
+    qint32 x;
+    qint32 y;
+    qint32 colorOffset;
+    quint8 opacity;
+};
+
+}
+
+struct KisScatterWriter::Private
+{
+    KisPaintDeviceSP device;
+    const KoColorSpace *colorSpace;
+    int pixelSize;
+    Mode mode;
+
+    const KoCompositeOp *compositeOp = 0;
+    KoCompositeOp::ParameterInfo compositeParams;
+    const KoColorSpace *srcColorSpace = 0;
+    KoColorConversionTransformation::Intent renderingIntent = KoColorConversionTransformation::internalRenderingIntent();
+    KoColorConversionTransformation::ConversionFlags conversionFlags = KoColorConversionTransformation::internalConversionFlags();
+
+    QVector<Sample> samples;
+    QVector<quint8> colors;
+
+    inline void writePixel(quint8 *dst, const Sample &sample);
+};
+
+inline void KisScatterWriter::Private::writePixel(quint8 *dst, const Sample &sample)
+{
+    const quint8 *color = colors.constData() + sample.colorOffset;
+
+    switch (mode) {
+    case Replace:
+        memcpy(dst, color, pixelSize);
+        break;
+    case AccumulateOpacity: {
+        const quint8 opacity = quint8(qMin<quint16>(OPACITY_OPAQUE_U8, sample.opacity + colorSpace->opacityU8(dst)));
+        memcpy(dst, color, pixelSize);
+        colorSpace->setOpacity(dst, opacity, 1);
+        break;
+    }
+    case MaxOpacity:
+        if (colorSpace->opacityU8(dst) < colorSpace->opacityU8(color)) {
+            memcpy(dst, color, pixelSize);
+        }
+        break;
+    case Composite: {
+        const float opacity = compositeParams.opacity;
+
+        compositeParams.dstRowStart = dst;
+        compositeParams.srcRowStart = color;
+
+        if (sample.opacity != OPACITY_OPAQUE_U8) {
+            compositeParams.opacity = opacity * sample.opacity / 255.0f;
+        }
+
+        colorSpace->bitBlt(srcColorSpace, compositeParams, compositeOp,
+                           renderingIntent, conversionFlags);
+
+        compositeParams.opacity = opacity;
+        break;
+    }
+    }
+}
+
+KisScatterWriter::KisScatterWriter(KisPaintDeviceSP device, Mode mode)
+    : m_d(new Private)
+{
+    m_d->device = device;
+    m_d->colorSpace = device->colorSpace();
+    m_d->pixelSize = device->pixelSize();
+    m_d->mode = mode;
+    m_d->srcColorSpace = m_d->colorSpace;
+}
+
+KisScatterWriter::~KisScatterWriter()
+{
+    KIS_SAFE_ASSERT_RECOVER_NOOP(m_d->samples.isEmpty() && "the samples should be flushed");
+}
+
+void KisScatterWriter::setCompositeOp(const KoCompositeOp *op,
+                                      const KoCompositeOp::ParameterInfo &params,
+                                      const KoColorSpace *srcColorSpace,
+                                      KoColorConversionTransformation::Intent renderingIntent,
+                                      KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    KIS_SAFE_ASSERT_RECOVER_NOOP(m_d->samples.isEmpty());
+
+    m_d->compositeOp = op;
+    m_d->compositeParams = params;
+    m_d->compositeParams.dstRowStride = 0;
+    m_d->compositeParams.srcRowStride = 0;
+    m_d->compositeParams.maskRowStart = 0;
+    m_d->compositeParams.maskRowStride = 0;
+    m_d->compositeParams.rows = 1;
+    m_d->compositeParams.cols = 1;
+    m_d->srcColorSpace = srcColorSpace ? srcColorSpace : m_d->colorSpace;
+    m_d->renderingIntent = renderingIntent;
+    m_d->conversionFlags = conversionFlags;
+}
+
+void KisScatterWriter::addSample(qint32 x, qint32 y, const quint8 *color, quint8 opacity)
+{
+    const int colorSize = m_d->mode == Composite ? m_d->srcColorSpace->pixelSize() : m_d->pixelSize;
+
+    /**
+     * The particles usually share the color, so the color of the
+     * previous sample is reused when possible
+     */
+    int colorOffset = m_d->colors.size() - colorSize;
+
+    if (colorOffset < 0 ||
+        memcmp(m_d->colors.constData() + colorOffset, color, colorSize) != 0) {
+
+        colorOffset = m_d->colors.size();
+        m_d->colors.resize(colorOffset + colorSize);
+        memcpy(m_d->colors.data() + colorOffset, color, colorSize);
+    }
+
+    Sample sample;
+    sample.x = x;
+    sample.y = y;
+    sample.colorOffset = colorOffset;
+    sample.opacity = opacity;
+
+    m_d->samples.append(sample);
+}
+
+int KisScatterWriter::numPendingSamples() const
+{
+    return m_d->samples.size();
+}
+
+void KisScatterWriter::flush()
+{
+    if (m_d->samples.isEmpty()) return;
+
+    KIS_SAFE_ASSERT_RECOVER(m_d->mode != Composite || m_d->compositeOp) {
+        m_d->samples.clear();
+        m_d->colors.clear();
+        return;
+    }
+
+    const int tileSize = 64;
+    const int offsetX = m_d->device->x();
+    const int offsetY = m_d->device->y();
+
+    auto tileCol = [offsetX, tileSize] (const Sample &s) {
+        return (s.x - offsetX) >= 0 ? (s.x - offsetX) / tileSize : -((offsetX - s.x - 1) / tileSize) - 1;
+    };
+
+    auto tileRow = [offsetY, tileSize] (const Sample &s) {
+        return (s.y - offsetY) >= 0 ? (s.y - offsetY) / tileSize : -((offsetY - s.y - 1) / tileSize) - 1;
+    };
+
+    /**
+     * The sort is stable, so the samples hitting the same pixel are
+     * still blended in the order they were added
+     */
+    std::stable_sort(m_d->samples.begin(), m_d->samples.end(),
+                     [&] (const Sample &lhs, const Sample &rhs) {
+                         const int lhsRow = tileRow(lhs);
+                         const int rhsRow = tileRow(rhs);
+                         return lhsRow < rhsRow || (lhsRow == rhsRow && tileCol(lhs) < tileCol(rhs));
+                     });
+
+    KisRandomAccessorSP accessor =
+        m_d->device->createRandomAccessorNG(m_d->samples.first().x, m_d->samples.first().y);
+
+    const int numSamples = m_d->samples.size();
+    const Sample *samples = m_d->samples.constData();
+
+    for (int groupStart = 0; groupStart < numSamples; ) {
+        const int col = tileCol(samples[groupStart]);
+        const int row = tileRow(samples[groupStart]);
+
+        int groupEnd = groupStart + 1;
+        while (groupEnd < numSamples &&
+               tileCol(samples[groupEnd]) == col &&
+               tileRow(samples[groupEnd]) == row) {
+
+            groupEnd++;
+        }
+
+        const int originX = col * tileSize + offsetX;
+        const int originY = row * tileSize + offsetY;
+
+        /**
+         * The wrapped devices may split the tile, then every pixel is
+         * looked up separately
+         */
+        accessor->moveTo(originX, originY);
+        const bool directAccess =
+            accessor->numContiguousColumns(originX) >= tileSize &&
+            accessor->numContiguousRows(originY) >= tileSize;
+
+        if (directAccess) {
+            quint8 *tileData = accessor->rawData();
+            const int rowStride = accessor->rowStride(originX, originY);
+
+            for (int i = groupStart; i < groupEnd; i++) {
+                const Sample &s = samples[i];
+                m_d->writePixel(tileData + (s.y - originY) * rowStride + (s.x - originX) * m_d->pixelSize, s);
+            }
+        } else {
+            for (int i = groupStart; i < groupEnd; i++) {
+                const Sample &s = samples[i];
+                accessor->moveTo(s.x, s.y);
+                m_d->writePixel(accessor->rawData(), s);
+            }
+        }
+
+        groupStart = groupEnd;
+    }
+
+    m_d->samples.clear();
+    m_d->colors.clear();
+}
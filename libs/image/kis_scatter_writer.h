@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_SCATTER_WRITER_H
+#define __KIS_SCATTER_WRITER_H
+
+#include <QScopedPointer>
+
+#include <KoColorSpaceConstants.h>
+#include <KoCompositeOp.h>
+#include <KoColorConversionTransformation.h>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+class KoColorSpace;
+
+
+/**
+ * Writes a lot of single pixels spread over a paint device, the way
+ * the particle-like paintops (spray, hairy, sketch) do.
+ *
+ * Writing such pixels through a random accessor costs a moveTo() and
+ * a tile lookup per pixel. The writer collects the samples instead and
+ * writes them in flush(). The samples are sorted by the tile they
+ * belong to, so every tile is looked up once and the pixels inside it
+ * are addressed directly. The order of the samples falling into the
+ * same pixel is preserved, so the result is exactly the same as if the
+ * samples were written one by one.
+ *
+ * The color of every sample should be in the color space of the device,
+ * unless a different source color space is passed to setCompositeOp().
+ */
+class KRITAIMAGE_EXPORT KisScatterWriter
+{
+public:
+    enum Mode {
+        /**
+         * The sample color overwrites the pixel, the opacity of
+         * the sample is ignored
+         */
+        Replace,
+
+        /**
+         * The sample color overwrites the pixel, the opacity of the
+         * pixel becomes the sum of the opacity of the sample and the
+         * old opacity of the pixel
+         */
+        AccumulateOpacity,
+
+        /**
+         * The sample color overwrites the pixel only if it is more
+         * opaque than the pixel
+         */
+        MaxOpacity,
+
+        /**
+         * The sample is composited onto the pixel with the composite
+         * op set by setCompositeOp(), the opacity of the sample is
+         * multiplied into the opacity of the op parameters
+         */
+        Composite
+    };
+
+public:
+    KisScatterWriter(KisPaintDeviceSP device, Mode mode = Replace);
+    ~KisScatterWriter();
+
+    /**
+     * Sets up the compositing for the Composite mode. The rows, columns
+     * and the pointers of \p params are ignored. The sample colors are
+     * expected to be in \p srcColorSpace, null means the color space of
+     * the device.
+     */
+    void setCompositeOp(const KoCompositeOp *op,
+                        const KoCompositeOp::ParameterInfo &params,
+                        const KoColorSpace *srcColorSpace = 0,
+                        KoColorConversionTransformation::Intent renderingIntent = KoColorConversionTransformation::internalRenderingIntent(),
+                        KoColorConversionTransformation::ConversionFlags conversionFlags = KoColorConversionTransformation::internalConversionFlags());
+
+    /**
+     * Adds a sample at (x, y). \p color is copied, so the caller may
+     * reuse its buffer right away.
+     */
+    void addSample(qint32 x, qint32 y, const quint8 *color, quint8 opacity = OPACITY_OPAQUE_U8);
+
+    /**
+     * The number of samples waiting for flush()
+     */
+    int numPendingSamples() const;
+
+    /**
+     * Writes all the pending samples into the device
+     */
+    void flush();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_SCATTER_WRITER_H */
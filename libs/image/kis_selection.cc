@@ -132,6 +132,19 @@ QPainterPath KisSelection::outlineCache() const
     return outline;
 }
 
+QPainterPath KisSelection::simplifiedOutlineCache(int level) const
+{
+    QPainterPath outline;
+
+    if (hasShapeSelection()) {
+        outline += m_d->shapeSelection->outlineCache();
+    } else if (m_d->pixelSelection->outlineCacheValid()) {
+        outline += m_d->pixelSelection->simplifiedOutlineCache(level);
+    }
+
+    return outline;
+}
+
 void KisSelection::recalculateOutlineCache()
 {
     Q_ASSERT(m_d->pixelSelection);
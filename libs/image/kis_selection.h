@@ -98,6 +98,11 @@ public:
     QPainterPath outlineCache() const;
     void recalculateOutlineCache();
 
+    /**
+     * \see KisPixelSelection::simplifiedOutlineCache()
+     */
+    QPainterPath simplifiedOutlineCache(int level) const;
+
 
     /**
      * Tells whether the cached thumbnail of the selection is still valid
@@ -0,0 +1,511 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tiled_outline_generator.h"
+
+#include <cstring>
+
+#include <QRect>
+#include <QHash>
+#include <QSet>
+#include <QtConcurrent>
+
+#include "kis_paint_device.h"
+#include "kis_debug.h"
+
+
+namespace {
+
+/**
+ * The contours go along the pixel borders, from one lattice vertex
+ * to another. The vertex (x, y) is the top-left corner of the pixel
+ * (x, y). The selected pixels are always kept on the right-hand side
+ * of the contour, so the outer contours go clockwise and the holes go
+ * counter-clockwise.
+ */
+enum Direction {
+    Right = 0,
+    Down,
+    Left,
+    Up
+};
+
+const int directionDX[4] = {1, 0, -1, 0};
+const int directionDY[4] = {0, 1, 0, -1};
+
+/**
+ * An edge is identified by its starting vertex and its direction
+ */
+typedef QPair<qint64, int> EdgeKey;
+
+inline EdgeKey edgeKey(int x, int y, int direction) {
+    return EdgeKey((qint64(x) << 32) | quint32(y), direction);
+}
+
+struct Chain {
+    QPolygon points;
+    bool closed = false;
+
+    /**
+     * For open chains: the first edge of the chain and the edge
+     * following its last one. The latter one belongs to another
+     * stripe, where it starts another chain.
+     */
+    EdgeKey head;
+    EdgeKey tail;
+};
+
+struct Stripe {
+    int top = 0;
+    int bottom = 0; // exclusive
+    bool isLast = false;
+
+    bool isValid = false;
+    quint64 hash = 0;
+    QVector<Chain> chains;
+};
+
+inline int nextStripeBorder(int y) {
+    const int stripeHeight = KisTiledOutlineGenerator::stripeHeight;
+    const int offset = ((y % stripeHeight) + stripeHeight) % stripeHeight;
+    return y - offset + stripeHeight;
+}
+
+quint64 hashBytes(const quint8 *data, int size)
+{
+    quint64 hash = 0xcbf29ce484222325ULL;
+
+    const int numWords = size / int(sizeof(quint64));
+    for (int i = 0; i < numWords; i++) {
+        quint64 word;
+        memcpy(&word, data + i * sizeof(quint64), sizeof(quint64));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+
+    for (int i = numWords * int(sizeof(quint64)); i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+inline bool isCollinear(const QPoint &a, const QPoint &b, const QPoint &c) {
+    return (a.x() == b.x() && b.x() == c.x()) ||
+           (a.y() == b.y() && b.y() == c.y());
+}
+
+/**
+ * Removes the duplicated and collinear vertices of an axis-aligned
+ * closed polygon
+ */
+QPolygon compressPolygon(const QPolygon &polygon)
+{
+    QPolygon result;
+    result.reserve(polygon.size());
+
+    Q_FOREACH (const QPoint &pt, polygon) {
+        if (!result.isEmpty() && result.last() == pt) continue;
+
+        while (result.size() >= 2 &&
+               isCollinear(result[result.size() - 2], result.last(), pt)) {
+
+            result.removeLast();
+        }
+
+        result << pt;
+    }
+
+    if (result.size() > 1 && result.first() == result.last()) {
+        result.removeLast();
+    }
+
+    while (result.size() >= 3 &&
+           isCollinear(result[result.size() - 2], result.last(), result.first())) {
+
+        result.removeLast();
+    }
+
+    while (result.size() >= 3 &&
+           isCollinear(result.last(), result.first(), result[1])) {
+
+        result.remove(0);
+    }
+
+    return result;
+}
+
+/**
+ * Traces the edges of a single stripe. The stripe owns:
+ *
+ * 1) horizontal edges lying on the row lines [top, bottom)
+ *    (the last stripe owns the row line 'bottom' as well);
+ *
+ * 2) vertical edges crossing the pixel rows [top, bottom).
+ *
+ * To resolve the vertices on the stripe borders the tracer needs one
+ * more pixel row above and below the stripe.
+ */
+class StripeTracer
+{
+public:
+    StripeTracer(const QRect &bounds, const Stripe &stripe)
+        : m_left(bounds.left()),
+          m_right(bounds.right() + 1),
+          m_top(stripe.top),
+          m_bottom(stripe.bottom),
+          m_isLast(stripe.isLast),
+          m_pixelsStride(bounds.width() + 2),
+          m_marksStride(bounds.width() + 1)
+    {
+    }
+
+    void readPixels(const KisPaintDevice *device, const QRect &bounds, quint8 defaultOpacity) {
+        const int numRows = m_bottom - m_top + 2;
+        m_pixels.fill(0, m_pixelsStride * numRows);
+
+        const QRect readRect =
+            QRect(m_left, m_top - 1, m_right - m_left, numRows) & bounds;
+
+        QVector<quint8> buffer(readRect.width() * readRect.height());
+        device->readBytes(buffer.data(), readRect);
+
+        const quint8 *srcPtr = buffer.constData();
+
+        for (int y = readRect.top(); y <= readRect.bottom(); y++) {
+            quint8 *dstPtr = m_pixels.data() + pixelIndex(readRect.left(), y);
+
+            for (int x = 0; x < readRect.width(); x++) {
+                *dstPtr++ = *srcPtr++ != defaultOpacity;
+            }
+        }
+    }
+
+    quint64 hash() const {
+        return hashBytes(m_pixels.constData(), m_pixels.size());
+    }
+
+    QVector<Chain> trace() {
+        QVector<Chain> chains;
+
+        m_marks.fill(0, m_marksStride * (m_bottom - m_top + 1));
+
+        /**
+         * First trace the chains crossing the stripe borders. Their
+         * heads can reside on the border rows only.
+         */
+        const int borderRows[2] = {m_top, m_bottom};
+
+        for (int i = 0; i < 2; i++) {
+            const int y = borderRows[i];
+
+            for (int x = m_left; x <= m_right; x++) {
+                const int edges = outgoingEdges(x, y);
+                if (!edges) continue;
+
+                for (int d = 0; d < 4; d++) {
+                    if ((edges & (1 << d)) &&
+                        isOwned(x, y, d) &&
+                        !isMarked(x, y, d) &&
+                        !hasOwnedPredecessor(x, y, d)) {
+
+                        chains << traceChain(x, y, d);
+                    }
+                }
+            }
+        }
+
+        /**
+         * All the edges left are parts of the contours lying
+         * completely inside the stripe
+         */
+        for (int y = m_top; y <= m_bottom; y++) {
+            for (int x = m_left; x <= m_right; x++) {
+                const int edges = outgoingEdges(x, y);
+                if (!edges) continue;
+
+                for (int d = 0; d < 4; d++) {
+                    if ((edges & (1 << d)) &&
+                        isOwned(x, y, d) &&
+                        !isMarked(x, y, d)) {
+
+                        chains << traceChain(x, y, d);
+                    }
+                }
+            }
+        }
+
+        return chains;
+    }
+
+private:
+    inline int pixelIndex(int x, int y) const {
+        return (y - m_top + 1) * m_pixelsStride + (x - m_left + 1);
+    }
+
+    inline bool isSelected(int x, int y) const {
+        return m_pixels[pixelIndex(x, y)];
+    }
+
+    inline int outgoingEdges(int x, int y) const {
+        const bool nw = isSelected(x - 1, y - 1);
+        const bool ne = isSelected(x, y - 1);
+        const bool sw = isSelected(x - 1, y);
+        const bool se = isSelected(x, y);
+
+        return (se && !ne) << Right |
+               (sw && !se) << Down |
+               (nw && !sw) << Left |
+               (ne && !nw) << Up;
+    }
+
+    inline int incomingEdges(int x, int y) const {
+        const bool nw = isSelected(x - 1, y - 1);
+        const bool ne = isSelected(x, y - 1);
+        const bool sw = isSelected(x - 1, y);
+        const bool se = isSelected(x, y);
+
+        return (sw && !nw) << Right |
+               (nw && !ne) << Down |
+               (ne && !se) << Left |
+               (se && !sw) << Up;
+    }
+
+    /**
+     * Prefer the right turns. It keeps the diagonally adjacent
+     * pixels in separate contours.
+     */
+    inline int nextDirection(int edges, int direction) const {
+        const int right = (direction + 1) & 3;
+        if (edges & (1 << right)) return right;
+        if (edges & (1 << direction)) return direction;
+
+        const int left = (direction + 3) & 3;
+        KIS_SAFE_ASSERT_RECOVER_NOOP(edges & (1 << left));
+        return left;
+    }
+
+    inline bool isOwned(int x, int y, int direction) const {
+        switch (direction) {
+        case Right:
+        case Left:
+            return (y >= m_top && y < m_bottom) || (m_isLast && y == m_bottom);
+        case Down:
+            return y >= m_top && y < m_bottom;
+        default: /* Up */
+            return y > m_top && y <= m_bottom;
+        }
+    }
+
+    bool hasOwnedPredecessor(int x, int y, int direction) const {
+        const int incoming = incomingEdges(x, y);
+        const int outgoing = outgoingEdges(x, y);
+
+        for (int d = 0; d < 4; d++) {
+            if ((incoming & (1 << d)) && nextDirection(outgoing, d) == direction) {
+                return isOwned(x - directionDX[d], y - directionDY[d], d);
+            }
+        }
+
+        return false;
+    }
+
+    inline quint8& marks(int x, int y) {
+        return m_marks[(y - m_top) * m_marksStride + (x - m_left)];
+    }
+
+    inline bool isMarked(int x, int y, int direction) {
+        return marks(x, y) & (1 << direction);
+    }
+
+    Chain traceChain(int x, int y, int direction) {
+        Chain chain;
+        chain.head = edgeKey(x, y, direction);
+        chain.points << QPoint(x, y);
+
+        forever {
+            marks(x, y) |= 1 << direction;
+
+            x += directionDX[direction];
+            y += directionDY[direction];
+
+            const int nextDir = nextDirection(outgoingEdges(x, y), direction);
+
+            if (!isOwned(x, y, nextDir)) {
+                chain.points << QPoint(x, y);
+                chain.tail = edgeKey(x, y, nextDir);
+                chain.closed = false;
+                break;
+            }
+
+            if (isMarked(x, y, nextDir)) {
+                chain.closed = true;
+                break;
+            }
+
+            if (nextDir != direction) {
+                chain.points << QPoint(x, y);
+            }
+
+            direction = nextDir;
+        }
+
+        return chain;
+    }
+
+private:
+    const int m_left;
+    const int m_right;
+    const int m_top;
+    const int m_bottom;
+    const bool m_isLast;
+
+    const int m_pixelsStride;
+    const int m_marksStride;
+
+    QVector<quint8> m_pixels;
+    QVector<quint8> m_marks;
+};
+
+}
+
+
+struct KisTiledOutlineGenerator::Private
+{
+    QRect bounds;
+    QVector<Stripe> stripes;
+};
+
+KisTiledOutlineGenerator::KisTiledOutlineGenerator()
+    : m_d(new Private)
+{
+}
+
+KisTiledOutlineGenerator::~KisTiledOutlineGenerator()
+{
+}
+
+void KisTiledOutlineGenerator::reset()
+{
+    m_d->bounds = QRect();
+    m_d->stripes.clear();
+}
+
+QVector<QPolygon> KisTiledOutlineGenerator::outline(const KisPaintDevice *device, const QRect &rect, quint8 defaultOpacity)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(device->pixelSize() == 1, QVector<QPolygon>());
+
+    if (rect.isEmpty()) {
+        reset();
+        return QVector<QPolygon>();
+    }
+
+    /**
+     * The stripes are aligned to the tile grid, so the stripes of
+     * the previous run can be reused if the columns of the traced
+     * area have not changed.
+     */
+    QHash<int, int> oldStripes;
+    if (rect.left() == m_d->bounds.left() && rect.right() == m_d->bounds.right()) {
+        for (int i = 0; i < m_d->stripes.size(); i++) {
+            oldStripes.insert(m_d->stripes[i].top, i);
+        }
+    }
+
+    QVector<Stripe> stripes;
+
+    for (int top = rect.top(); top <= rect.bottom(); ) {
+        const int bottom = qMin(nextStripeBorder(top), rect.bottom() + 1);
+        const bool isLast = bottom == rect.bottom() + 1;
+
+        const int oldIndex = oldStripes.value(top, -1);
+        if (oldIndex >= 0 &&
+            m_d->stripes[oldIndex].bottom == bottom &&
+            m_d->stripes[oldIndex].isLast == isLast) {
+
+            stripes << m_d->stripes[oldIndex];
+        } else {
+            Stripe stripe;
+            stripe.top = top;
+            stripe.bottom = bottom;
+            stripe.isLast = isLast;
+            stripes << stripe;
+        }
+
+        top = bottom;
+    }
+
+    QtConcurrent::blockingMap(stripes, [&] (Stripe &stripe) {
+        StripeTracer tracer(rect, stripe);
+        tracer.readPixels(device, rect, defaultOpacity);
+
+        const quint64 hash = tracer.hash();
+
+        if (!stripe.isValid || stripe.hash != hash) {
+            stripe.chains = tracer.trace();
+            stripe.hash = hash;
+            stripe.isValid = true;
+        }
+    });
+
+    m_d->bounds = rect;
+    m_d->stripes = stripes;
+
+    /**
+     * Stitch the chains crossing the stripe borders
+     */
+    QVector<QPolygon> result;
+    QHash<EdgeKey, const Chain*> chainHeads;
+    QVector<const Chain*> openChains;
+
+    for (int i = 0; i < m_d->stripes.size(); i++) {
+        const QVector<Chain> &chains = m_d->stripes[i].chains;
+
+        for (int j = 0; j < chains.size(); j++) {
+            const Chain &chain = chains[j];
+
+            if (chain.closed) {
+                result << compressPolygon(chain.points);
+            } else {
+                chainHeads.insert(chain.head, &chain);
+                openChains << &chain;
+            }
+        }
+    }
+
+    QSet<const Chain*> stitchedChains;
+
+    Q_FOREACH (const Chain *firstChain, openChains) {
+        if (stitchedChains.contains(firstChain)) continue;
+
+        QPolygon polygon;
+        const Chain *chain = firstChain;
+
+        do {
+            stitchedChains.insert(chain);
+            polygon += chain->points;
+            chain = chainHeads.value(chain->tail, 0);
+        } while (chain && chain != firstChain);
+
+        KIS_SAFE_ASSERT_RECOVER_NOOP(chain);
+
+        result << compressPolygon(polygon);
+    }
+
+    return result;
+}
@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_TILED_OUTLINE_GENERATOR_H
+#define __KIS_TILED_OUTLINE_GENERATOR_H
+
+#include <QScopedPointer>
+#include <QVector>
+#include <QPolygon>
+
+#include "kritaimage_export.h"
+
+class QRect;
+class KisPaintDevice;
+
+
+/**
+ * Generates the outline of an alpha8 device (a selection) in
+ * parallel.
+ *
+ * The traced area is split into horizontal stripes of
+ * stripeHeight rows, which are aligned to the tile grid of the
+ * device. Every stripe is traced on its own thread. The contours
+ * crossing stripe borders are traced as open chains, which are
+ * stitched together afterwards.
+ *
+ * The generator is incremental: it keeps the chains of every stripe
+ * together with a hash of the pixels the stripe was traced from. On
+ * the next call only the stripes whose pixels have changed are traced
+ * again, so the outline of a huge selection is updated in time
+ * proportional to the size of the change.
+ *
+ * The pixels are traced with 4-connectivity: diagonally adjacent
+ * pixels belong to different contours. All the pixels that are not
+ * equal to the default opacity are considered selected.
+ */
+class KRITAIMAGE_EXPORT KisTiledOutlineGenerator
+{
+public:
+    static const int stripeHeight = 64;
+
+public:
+    KisTiledOutlineGenerator();
+    ~KisTiledOutlineGenerator();
+
+    /**
+     * Traces the outline of \p device inside \p rect. The pixels
+     * outside \p rect are considered unselected.
+     *
+     * The function is not reentrant: the calls for the same
+     * generator must be serialized by the caller.
+     */
+    QVector<QPolygon> outline(const KisPaintDevice *device, const QRect &rect, quint8 defaultOpacity);
+
+    /**
+     * Drops the cached stripes, so the next call to outline() traces
+     * the whole area again
+     */
+    void reset();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_TILED_OUTLINE_GENERATOR_H */
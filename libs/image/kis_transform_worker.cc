@@ -26,6 +26,8 @@
 #include <klocalizedstring.h>
 
 #include <QTransform>
+#include <QMutex>
+#include <QtConcurrent>
 
 #include <KoColorSpace.h>
 #include <KoCompositeOpRegistry.h>
@@ -42,6 +44,7 @@
 #include "kis_progress_update_helper.h"
 #include "kis_pixel_selection.h"
 #include "kis_image.h"
+#include "krita_utils.h"
 
 
 KisTransformWorker::KisTransformWorker(KisPaintDeviceSP dev,
@@ -177,6 +180,18 @@ template <> void calcDimensions <KisVLineIteratorSP>
 
 }
 
+template <class iter> int lineOrigin(const KisPaintDevice *dev);
+
+template <> int lineOrigin <KisHLineIteratorSP>(const KisPaintDevice *dev)
+{
+    return dev->y();
+}
+
+template <> int lineOrigin <KisVLineIteratorSP>(const KisPaintDevice *dev)
+{
+    return dev->x();
+}
+
 template <class iter>
 void updateBounds(QRect &boundRect,
                   const KisFilterWeightsApplicator::LinePos &newBounds);
@@ -206,20 +221,44 @@ void KisTransformWorker::transformPass(KisPaintDevice *src, KisPaintDevice *dst,
     qint32 srcStart, srcLen, firstLine, numLines;
     calcDimensions<T>(m_boundRect, srcStart, srcLen, firstLine, numLines);
 
-    KisProgressUpdateHelper progressHelper(m_progressUpdater, portion, numLines);
     KisFilterWeightsBuffer buf(filterStrategy, qAbs(floatscale));
     KisFilterWeightsApplicator applicator(src, dst, floatscale, shear, dx, clampToEdge);
 
-    KisFilterWeightsApplicator::LinePos dstBounds;
+    /**
+     * Every line is read and written back in place independently from
+     * the others, so the lines can be processed in parallel. The lines
+     * are grouped into stripes of whole tiles of the destination device.
+     * The tile grid starts at the offset of the device, not at zero, so
+     * the stripes are aligned to that offset. Two threads then never
+     * write into the same tile.
+     */
+    const int tileSize = 64;
 
-    for (int i = firstLine; i < firstLine + numLines; i++) {
-        KisFilterWeightsApplicator::LinePos dstPos;
-        KisFilterWeightsApplicator::LinePos srcPos(srcStart, srcLen);
+    QVector<QPair<int, int>> stripes =
+        KritaUtils::splitIntoAlignedStripes(firstLine, firstLine + numLines,
+                                            lineOrigin<T>(dst), tileSize);
 
-        dstPos = applicator.processLine<T>(srcPos, i, &buf, filterStrategy->support());
-        dstBounds.unite(dstPos);
+    QVector<KisFilterWeightsApplicator::LinePos> linePositions(numLines);
+    KisFilterWeightsApplicator::LinePos *linePositionsPtr = linePositions.data();
+
+    KisProgressUpdateHelper progressHelper(m_progressUpdater, portion, stripes.size());
+    QMutex progressMutex;
+
+    QtConcurrent::blockingMap(stripes, [&] (const QPair<int, int> &stripe) {
+        for (int i = stripe.first; i < stripe.second; i++) {
+            KisFilterWeightsApplicator::LinePos srcPos(srcStart, srcLen);
+            linePositionsPtr[i - firstLine] =
+                applicator.processLine<T>(srcPos, i, &buf, filterStrategy->support());
+        }
 
+        QMutexLocker l(&progressMutex);
         progressHelper.step();
+    });
+
+    KisFilterWeightsApplicator::LinePos dstBounds;
+
+    Q_FOREACH (const KisFilterWeightsApplicator::LinePos &dstPos, linePositions) {
+        dstBounds.unite(dstPos);
     }
 
     updateBounds<T>(m_boundRect, dstBounds);
@@ -256,3 +256,27 @@ void KisUpdateTimeMonitor::reportUpdateFinished(const QRect &rect)
     }
     m_d->numUpdates++;
 }
+
+void KisUpdateTimeMonitor::reportDabCacheStatistics(int hits, int misses, qint64 savedTime)
+{
+    if (!m_d->loggingEnabled) return;
+    if (!hits && !misses) return;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    /**
+     * The paintops are destroyed after the stroke has been measured,
+     * so the dab cache statistics go into a separate log
+     */
+    QFile logFile(QString("log/dabcache.rdata"));
+    logFile.open(QIODevice::Append);
+    QTextStream stream(&logFile);
+
+    const qreal hitRate = qreal(hits) / (hits + misses);
+
+    stream << i18n("Dab Cache Hits:") << hits << "\t"
+           << i18n("Misses:") << misses << "\t"
+           << i18n("Hit Rate:") << QString::number(hitRate, 'f', 3) << "\t"
+           << i18n("Time Saved (ms):") << QString::number(qreal(savedTime) / 1000000, 'f', 3) << endl;
+    logFile.close();
+}
@@ -46,6 +46,13 @@ public:
     void reportJobFinished(void *key, const QVector<QRect> &rects);
     void reportUpdateFinished(const QRect &rect);
 
+    /**
+     * Reports how well the dab cache of a paintop worked during a
+     * stroke. \p savedTime is the time (in nanoseconds) the cache hits
+     * would have spent generating the dabs.
+     */
+    void reportDabCacheStatistics(int hits, int misses, qint64 savedTime);
+
 
 private:
     struct Private;
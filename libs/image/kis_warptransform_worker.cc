@@ -258,8 +258,10 @@ void KisWarpTransformWorker::run()
 
     FunctionTransformOp functionOp(m_warpMathFunction, m_origPoint, m_transfPoint, m_alpha);
     GridIterationTools::PaintDevicePolygonOp polygonOp(srcdev, m_dev);
-    GridIterationTools::processGrid(polygonOp, functionOp,
+    GridIterationTools::ParallelPolygonOp<GridIterationTools::PaintDevicePolygonOp> parallelOp(polygonOp);
+    GridIterationTools::processGrid(parallelOp, functionOp,
                                     srcBounds, pixelPrecision);
+    parallelOp.finish();
 }
 
 #include "krita_utils.h"
@@ -359,7 +361,9 @@ QImage KisWarpTransformWorker::transformQImage(WarpType warpType,
 
     const int pixelPrecision = 32;
     GridIterationTools::QImagePolygonOp polygonOp(srcImage, dstImage, srcQImageOffset, dstQImageOffset);
-    GridIterationTools::processGrid(polygonOp, functionOp, srcBounds.toAlignedRect(), pixelPrecision);
+    GridIterationTools::ParallelPolygonOp<GridIterationTools::QImagePolygonOp> parallelOp(polygonOp);
+    GridIterationTools::processGrid(parallelOp, functionOp, srcBounds.toAlignedRect(), pixelPrecision);
+    parallelOp.finish();
 
     return dstImage;
 }
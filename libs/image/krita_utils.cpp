@@ -84,6 +84,25 @@ namespace KritaUtils
         return patches;
     }
 
+    QVector<QPair<int, int>> splitIntoAlignedStripes(int start, int end, int origin, int stripeSize)
+    {
+        QVector<QPair<int, int>> stripes;
+
+        for (int i = start; i < end; ) {
+            const int offset = i - origin;
+
+            // the first grid line after i
+            const int nextStripeStart = origin +
+                (offset >= 0 ? offset / stripeSize + 1 : -((-offset - 1) / stripeSize)) * stripeSize;
+
+            const int stripeEnd = qMin(end, nextStripeStart);
+            stripes << qMakePair(i, stripeEnd);
+            i = stripeEnd;
+        }
+
+        return stripes;
+    }
+
     bool checkInTriangle(const QRectF &rect,
                          const QPolygonF &triangle)
     {
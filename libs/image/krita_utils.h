@@ -29,6 +29,7 @@ class QBitArray;
 class QPainter;
 
 #include <QVector>
+#include <QPair>
 #include "kritaimage_export.h"
 #include "kis_types.h"
 #include "krita_container_utils.h"
@@ -42,6 +43,16 @@ namespace KritaUtils
     QVector<QRect> KRITAIMAGE_EXPORT splitRectIntoPatches(const QRect &rc, const QSize &patchSize);
     QVector<QRect> KRITAIMAGE_EXPORT splitRegionIntoPatches(const QRegion &region, const QSize &patchSize);
 
+    /**
+     * Splits the range of lines [start, end) into stripes at the
+     * boundaries of a grid of \p stripeSize lines that starts at \p
+     * origin. The tiles of a paint device are aligned to its offset, so
+     * pass device->y() as the origin for rows (or device->x() for
+     * columns) and a multiple of the tile size as \p stripeSize to get
+     * stripes that never share a tile of that device.
+     */
+    QVector<QPair<int, int>> KRITAIMAGE_EXPORT splitIntoAlignedStripes(int start, int end, int origin, int stripeSize);
+
     QRegion KRITAIMAGE_EXPORT splitTriangles(const QPointF &center,
                                              const QVector<QPointF> &points);
     QRegion KRITAIMAGE_EXPORT splitPath(const QPainterPath &path);
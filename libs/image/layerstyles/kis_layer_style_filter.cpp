@@ -40,3 +40,9 @@ QString KisLayerStyleFilter::id() const
 {
     return m_d->id.id();
 }
+
+bool KisLayerStyleFilter::dependsOnLayerBounds(KisPSDLayerStyleSP style) const
+{
+    Q_UNUSED(style);
+    return false;
+}
@@ -59,6 +59,13 @@ public:
      */
     virtual QRect changedRect(const QRect & rect, KisPSDLayerStyleSP style, KisLayerStyleFilterEnvironment *env) const = 0;
 
+    /**
+     * Returns true if the result of the filter depends on the bounds of the
+     * whole layer, not only on the pixels inside \ref neededRect. The cached
+     * results of such filters are dropped every time the layer's bounds change.
+     */
+    virtual bool dependsOnLayerBounds(KisPSDLayerStyleSP style) const;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
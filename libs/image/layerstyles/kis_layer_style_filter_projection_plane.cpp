@@ -29,6 +29,22 @@
 #include "kis_painter.h"
 #include "kis_multiple_projection.h"
 
+#include <QBitArray>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegion>
+
+namespace {
+
+/**
+ * The limits keep the bookkeeping of the cache cheap. When they are
+ * exceeded, the cache falls back to a coarser, but still conservative,
+ * representation.
+ */
+const int maxValidRegionRects = 256;
+const int maxSourceDirtyRects = 64;
+
+}
 
 struct KisLayerStyleFilterProjectionPlane::Private
 {
@@ -39,8 +55,124 @@ struct KisLayerStyleFilterProjectionPlane::Private
     QScopedPointer<KisLayerStyleFilterEnvironment> environment;
 
     KisMultipleProjection projection;
+
+    /**
+     * The projection of the effect is persistent, so we keep track of the
+     * area where it is still valid. The walkers call changeRect() for
+     * every update of the layer, which is where we collect the dirty
+     * rects of the source. The next recalculate() drops the outputs they
+     * affect and recomputes only the requested area that is not valid
+     * anymore.
+     *
+     * The walkers call changeRect() when the update is queued, not when
+     * the source is recalculated. That is fine only when the source is
+     * the paint device of the layer: its pixels are already changed when
+     * the update is queued, so a walker that takes the dirty rects of a
+     * later update computes the effect from the final pixels. The
+     * projections of groups, of layers with masks and of the filter
+     * based layers are rendered by the walkers themselves, so for them
+     * the cache is not used at all (see canUseCache()).
+     *
+     * The result of the effect also depends on some properties of the
+     * layer, which don't change the pixels of its projection. If any of
+     * them changes, the whole cache is dropped.
+     */
+    QMutex cacheLock;
+    QRegion validRegion;
+    QVector<QRect> sourceDirtyRects;
+
+    KisPaintDeviceWSP cachedSource;
+    const KoColorSpace *cachedColorSpace = 0;
+    quint8 cachedOpacity = 0;
+    QBitArray cachedChannelFlags;
+    QRect cachedDefaultBounds;
+    QRect cachedLayerBounds;
+
+    qint64 recalculatedPixels = 0;
+
+    bool canUseCache(KisPaintDeviceSP src) const;
+    void addSourceDirtyRect(const QRect &rc);
+    void dropCache();
+    QRect takeRectToRecalculate(KisPaintDeviceSP src, const QRect &rect);
 };
 
+bool KisLayerStyleFilterProjectionPlane::Private::canUseCache(KisPaintDeviceSP src) const
+{
+    /**
+     * The low-resolution previews are short-living and are recalculated
+     * entirely. Their walkers pass the scaled rects to changeRect(),
+     * which only makes the cache drop more than needed.
+     */
+    return environment->currentLevelOfDetail() <= 0 &&
+        src && src == sourceLayer->paintDevice();
+}
+
+void KisLayerStyleFilterProjectionPlane::Private::addSourceDirtyRect(const QRect &rc)
+{
+    QMutexLocker l(&cacheLock);
+
+    sourceDirtyRects.append(rc);
+
+    if (sourceDirtyRects.size() > maxSourceDirtyRects) {
+        QRect bounds;
+        Q_FOREACH (const QRect &dirtyRect, sourceDirtyRects) {
+            bounds |= dirtyRect;
+        }
+
+        sourceDirtyRects.clear();
+        sourceDirtyRects.append(bounds);
+    }
+}
+
+void KisLayerStyleFilterProjectionPlane::Private::dropCache()
+{
+    QMutexLocker l(&cacheLock);
+
+    validRegion = QRegion();
+    sourceDirtyRects.clear();
+}
+
+QRect KisLayerStyleFilterProjectionPlane::Private::takeRectToRecalculate(KisPaintDeviceSP src, const QRect &rect)
+{
+    const QRect layerBounds =
+        filter->dependsOnLayerBounds(style) ? environment->layerBounds() : QRect();
+    const QRect defaultBounds = environment->defaultBounds();
+
+    QMutexLocker l(&cacheLock);
+
+    if (!cachedSource.isValid() ||
+        cachedSource != src.data() ||
+        cachedColorSpace != src->colorSpace() ||
+        cachedOpacity != sourceLayer->opacity() ||
+        cachedChannelFlags != sourceLayer->channelFlags() ||
+        cachedDefaultBounds != defaultBounds ||
+        cachedLayerBounds != layerBounds) {
+
+        cachedSource = src.data();
+        cachedColorSpace = src->colorSpace();
+        cachedOpacity = sourceLayer->opacity();
+        cachedChannelFlags = sourceLayer->channelFlags();
+        cachedDefaultBounds = defaultBounds;
+        cachedLayerBounds = layerBounds;
+
+        validRegion = QRegion();
+    }
+
+    Q_FOREACH (const QRect &dirtyRect, sourceDirtyRects) {
+        validRegion -= filter->changedRect(dirtyRect, style, environment.data());
+    }
+    sourceDirtyRects.clear();
+
+    const QRect result = (QRegion(rect) - validRegion).boundingRect();
+
+    validRegion += rect;
+    if (validRegion.rectCount() > maxValidRegionRects) {
+        validRegion = rect;
+    }
+
+    return result;
+}
+
 KisLayerStyleFilterProjectionPlane::
 KisLayerStyleFilterProjectionPlane(KisLayer *sourceLayer)
     : m_d(new Private)
@@ -58,6 +190,9 @@ void KisLayerStyleFilterProjectionPlane::setStyle(KisLayerStyleFilter *filter, K
 {
     m_d->filter.reset(filter);
     m_d->style = style;
+
+    QMutexLocker l(&m_d->cacheLock);
+    m_d->validRegion = QRegion();
 }
 
 QRect KisLayerStyleFilterProjectionPlane::recalculate(const QRect& rect, KisNodeSP filthyNode)
@@ -69,15 +204,38 @@ QRect KisLayerStyleFilterProjectionPlane::recalculate(const QRect& rect, KisNode
         return QRect();
     }
 
-    m_d->projection.clear(rect);
-    m_d->filter->processDirectly(m_d->sourceLayer->projection(),
+    KisPaintDeviceSP src = m_d->sourceLayer->projection();
+
+    QRect applyRect = rect;
+
+    if (m_d->canUseCache(src)) {
+        applyRect = m_d->takeRectToRecalculate(src, rect);
+    } else {
+        m_d->dropCache();
+    }
+
+    if (applyRect.isEmpty()) return rect;
+
+    {
+        QMutexLocker l(&m_d->cacheLock);
+        m_d->recalculatedPixels += qint64(applyRect.width()) * applyRect.height();
+    }
+
+    m_d->projection.clear(applyRect);
+    m_d->filter->processDirectly(src,
                                  &m_d->projection,
-                                 rect,
+                                 applyRect,
                                  m_d->style,
                                  m_d->environment.data());
     return rect;
 }
 
+qint64 KisLayerStyleFilterProjectionPlane::recalculatedPixels() const
+{
+    QMutexLocker l(&m_d->cacheLock);
+    return m_d->recalculatedPixels;
+}
+
 void KisLayerStyleFilterProjectionPlane::apply(KisPainter *painter, const QRect &rect)
 {
     m_d->projection.apply(painter->device(), rect);
@@ -107,6 +265,10 @@ QRect KisLayerStyleFilterProjectionPlane::changeRect(const QRect &rect, KisLayer
     }
 
     KIS_ASSERT_RECOVER_NOOP(pos == KisLayer::N_ABOVE_FILTHY);
+
+    // \p rect is the dirty area of the source layer, see Private::canUseCache()
+    m_d->addSourceDirtyRect(rect);
+
     return m_d->filter->changedRect(rect, m_d->style, m_d->environment.data());
 }
 
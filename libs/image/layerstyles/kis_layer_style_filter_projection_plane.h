@@ -43,6 +43,13 @@ public:
 
     KisPaintDeviceList getLodCapableDevices() const override;
 
+    /**
+     * The number of pixels the effect has been recalculated for since
+     * the creation of the plane. Used by the unittests to check that
+     * the cached areas are not recalculated.
+     */
+    qint64 recalculatedPixels() const;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
@@ -18,6 +18,8 @@
 
 #include "kis_layer_style_projection_plane.h"
 
+#include <QtConcurrent>
+
 #include "kis_global.h"
 #include "kis_layer_style_filter_projection_plane.h"
 #include "kis_psd_layer_style.h"
@@ -139,6 +141,17 @@ KisLayerStyleProjectionPlane::~KisLayerStyleProjectionPlane()
 {
 }
 
+qint64 KisLayerStyleProjectionPlane::recalculatedEffectPixels() const
+{
+    qint64 result = 0;
+
+    Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesBefore + m_d->stylesAfter) {
+        result += static_cast<KisLayerStyleFilterProjectionPlane*>(plane.data())->recalculatedPixels();
+    }
+
+    return result;
+}
+
 KisAbstractProjectionPlaneSP KisLayerStyleProjectionPlane::factoryObject(KisLayer *sourceLayer)
 {
     Q_ASSERT(sourceLayer);
@@ -151,13 +164,16 @@ QRect KisLayerStyleProjectionPlane::recalculate(const QRect& rect, KisNodeSP fil
     QRect result = sourcePlane->recalculate(rect, filthyNode);
 
     if (m_d->style->isEnabled()) {
-        Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesBefore) {
-            plane->recalculate(rect, filthyNode);
-        }
-
-        Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesAfter) {
+        /**
+         * All the effects read the projection of the source layer and
+         * write into their own projections only, so they can be
+         * calculated concurrently
+         */
+        QVector<KisAbstractProjectionPlaneSP> planes = m_d->stylesBefore + m_d->stylesAfter;
+
+        QtConcurrent::blockingMap(planes, [rect, filthyNode] (const KisAbstractProjectionPlaneSP &plane) {
             plane->recalculate(rect, filthyNode);
-        }
+        });
     }
 
     return result;
@@ -216,14 +232,24 @@ QRect KisLayerStyleProjectionPlane::changeRect(const QRect &rect, KisLayer::Posi
     QRect layerChangeRect = sourcePlane->changeRect(rect, pos);
     QRect changeRect = layerChangeRect;
 
-    if (m_d->style->isEnabled()) {
-        Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesBefore) {
-            changeRect |= plane->changeRect(layerChangeRect, KisLayer::N_ABOVE_FILTHY);
-        }
+    /**
+     * The effects collect the dirty areas of the source layer in their
+     * changeRect(), so we should notify them even when the style is
+     * disabled. Otherwise they would not know about the changes made
+     * while it was off.
+     */
+    QRect effectsChangeRect;
 
-        Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesAfter) {
-            changeRect |= plane->changeRect(layerChangeRect, KisLayer::N_ABOVE_FILTHY);
-        }
+    Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesBefore) {
+        effectsChangeRect |= plane->changeRect(layerChangeRect, KisLayer::N_ABOVE_FILTHY);
+    }
+
+    Q_FOREACH (const KisAbstractProjectionPlaneSP plane, m_d->stylesAfter) {
+        effectsChangeRect |= plane->changeRect(layerChangeRect, KisLayer::N_ABOVE_FILTHY);
+    }
+
+    if (m_d->style->isEnabled()) {
+        changeRect |= effectsChangeRect;
     }
 
     return changeRect;
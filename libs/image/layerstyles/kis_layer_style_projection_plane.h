@@ -53,6 +53,8 @@ private:
 
     void init(KisLayer *sourceLayer, KisPSDLayerStyleSP layerStyle);
 
+    qint64 recalculatedEffectPixels() const;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
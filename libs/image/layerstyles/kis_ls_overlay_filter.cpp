@@ -141,3 +141,12 @@ QRect KisLsOverlayFilter::changedRect(const QRect &rect, KisPSDLayerStyleSP styl
     Q_UNUSED(env);
     return rect;
 }
+
+bool KisLsOverlayFilter::dependsOnLayerBounds(KisPSDLayerStyleSP style) const
+{
+    const psd_layer_effects_overlay_base *config = getOverlayStruct(style);
+
+    return config && config->effectEnabled() &&
+        config->fillType() != psd_fill_solid_color &&
+        config->alignWithLayer();
+}
@@ -47,6 +47,7 @@ public:
 
     QRect neededRect(const QRect & rect, KisPSDLayerStyleSP style, KisLayerStyleFilterEnvironment *env) const override;
     QRect changedRect(const QRect & rect, KisPSDLayerStyleSP style, KisLayerStyleFilterEnvironment *env) const override;
+    bool dependsOnLayerBounds(KisPSDLayerStyleSP style) const override;
 
 private:
     const psd_layer_effects_overlay_base* getOverlayStruct(KisPSDLayerStyleSP style) const;
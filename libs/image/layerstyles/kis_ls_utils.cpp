@@ -33,6 +33,7 @@
 #include "kis_convolution_kernel.h"
 #include "kis_convolution_painter.h"
 #include "kis_gaussian_kernel.h"
+#include "kis_image_config.h"
 
 #include "kis_fill_painter.h"
 #include "kis_gradient_painter.h"
@@ -113,9 +114,16 @@ namespace KisLsUtils
                        const QRect &applyRect,
                        qreal radius)
     {
+        /**
+         * Drop shadows and glows tend to use huge radii, which
+         * the recursive filter handles in constant time per pixel
+         */
+        const bool useRecursive = KisImageConfig(true).useRecursiveBlurInLayerStyles();
+
         KisGaussianKernel::applyGaussian(selection, applyRect,
                                          radius, radius,
-                                         QBitArray(), 0);
+                                         QBitArray(), 0,
+                                         useRecursive);
     }
 
     namespace Private {
@@ -115,6 +115,9 @@ void KisColorizeStrokeStrategy::initStrokeCallback()
 
     KisMultiwayCut cut(m_d->filteredSource, m_d->dst, m_d->boundingRect);
 
+    KisImageConfig cfg(true);
+    cut.setUseMultiResolution(cfg.useMultiResolutionForColorizeMask());
+
     Q_FOREACH (const KeyStroke &stroke, m_d->keyStrokes) {
         cut.addKeyStroke(new KisPaintDevice(*stroke.dev), stroke.color);
     }
@@ -39,6 +39,11 @@
 #include "lazybrush/kis_lazy_fill_graph.h"
 #include "lazybrush/kis_lazy_fill_capacity_map.h"
 
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+#include <KoColorSpaceRegistry.h>
+
 #include "kis_sequential_iterator.h"
 #include <floodfill/kis_scanline_fill.h>
 
@@ -67,22 +72,30 @@ void normalizeAndInvertAlpha8Device(KisPaintDeviceSP dev, const QRect &rect)
                                    });
 }
 
-void cutOneWay(const KoColor &color,
-               KisPaintDeviceSP src,
-               KisPaintDeviceSP colorScribble,
-               KisPaintDeviceSP backgroundScribble,
-               KisPaintDeviceSP resultDevice,
-               KisPaintDeviceSP maskDevice,
-               const QRect &boundingRect)
+namespace {
+
+/**
+ * The value written into the mask device for the pixels
+ * that have got their color in a cut
+ */
+const quint8 cutMaskValue = 10 + (int(boost::black_color) << 4);
+
+/**
+ * Solves the max-flow on a graph covering \p boundingRect and fills
+ * the pixels of the color scribble's group with \p color
+ *
+ * @return the memory allocated for the graph's property maps in bytes
+ */
+qint64 cutOneWayImpl(const KoColor &color,
+                     KisPaintDeviceSP src,
+                     KisPaintDeviceSP colorScribble,
+                     KisPaintDeviceSP backgroundScribble,
+                     KisPaintDeviceSP resultDevice,
+                     KisPaintDeviceSP maskDevice,
+                     const QRect &boundingRect)
 {
     using namespace boost;
 
-    KIS_ASSERT_RECOVER_RETURN(src->pixelSize() == 1);
-    KIS_ASSERT_RECOVER_RETURN(colorScribble->pixelSize() == 1);
-    KIS_ASSERT_RECOVER_RETURN(backgroundScribble->pixelSize() == 1);
-    KIS_ASSERT_RECOVER_RETURN(maskDevice->pixelSize() == 1);
-    KIS_ASSERT_RECOVER_RETURN(*resultDevice->colorSpace() == *color.colorSpace());
-
     KisLazyFillCapacityMap capacityMap(src, colorScribble, backgroundScribble, maskDevice, boundingRect);
     KisLazyFillGraph &graph = capacityMap.graph();
 
@@ -124,8 +137,358 @@ void cutOneWay(const KoColor &color,
 
         if (label == black_color) {
             memcpy(dstIt.rawData(), color.data(), pixelSize);
-            *mskIt.rawData() = 10 + (int(label) << 4);
+            *mskIt.rawData() = cutMaskValue;
+        }
+    } while (dstIt.nextPixel() && mskIt.nextPixel());
+
+    return
+        qint64(groups.size()) * sizeof(default_color_type) +
+        qint64(residual_capacity.size()) * sizeof(int) +
+        qint64(distance_vec.size()) * sizeof(typename graph_traits<KisLazyFillGraph>::vertices_size_type) +
+        qint64(predecessor_vec.size()) * sizeof(typename graph_traits<KisLazyFillGraph>::edge_descriptor);
+}
+
+/**
+ * The rects smaller than this area are cut directly
+ */
+const qint64 multiResolutionBaseArea = 512 * 512;
+
+/**
+ * The size of the tiles refined on every level and the margin
+ * added around them to hide the seams between the tiles
+ */
+const int refinementTileSize = 128;
+const int refinementTileMargin = 16;
+
+inline int divFloor(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+inline QRect coarseRect(const QRect &rc) {
+    return QRect(QPoint(divFloor(rc.left(), 2), divFloor(rc.top(), 2)),
+                 QPoint(divFloor(rc.right(), 2), divFloor(rc.bottom(), 2)));
+}
+
+/**
+ * Downscales an alpha8 device twice. Every coarse pixel is either a
+ * minimum or a maximum of the four fine ones, so that thin lines of
+ * the source and thin scribbles do not disappear on coarse levels.
+ */
+KisPaintDeviceSP downscaleAlpha8Device(KisPaintDeviceSP dev, const QRect &rc, bool useMinimum)
+{
+    const QRect dstRect = coarseRect(rc);
+
+    QVector<quint8> src(rc.width() * rc.height());
+    dev->readBytes(src.data(), rc);
+
+    QVector<quint8> dst(dstRect.width() * dstRect.height(), useMinimum ? 255 : 0);
+    const quint8 *srcPtr = src.constData();
+
+    for (int y = rc.top(); y <= rc.bottom(); y++) {
+        quint8 *dstRow = dst.data() + (divFloor(y, 2) - dstRect.top()) * dstRect.width();
+
+        for (int x = rc.left(); x <= rc.right(); x++, srcPtr++) {
+            quint8 &value = dstRow[divFloor(x, 2) - dstRect.left()];
+            value = useMinimum ? qMin(value, *srcPtr) : qMax(value, *srcPtr);
+        }
+    }
+
+    KisPaintDeviceSP result = new KisPaintDevice(dev->colorSpace());
+    result->writeBytes(dst.constData(), dstRect);
+    return result;
+}
+
+/**
+ * Marks the pixels closer than two pixels to the border
+ * between the labels
+ */
+QVector<quint8> findLabelsBorder(const QVector<quint8> &labels, int width, int height)
+{
+    QVector<quint8> border(width * height, 0);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const quint8 label = labels[y * width + x];
+
+            for (int j = qMax(0, y - 1); j <= qMin(height - 1, y + 1); j++) {
+                for (int i = qMax(0, x - 1); i <= qMin(width - 1, x + 1); i++) {
+                    if (labels[j * width + i] != label) {
+                        border[y * width + x] = 1;
+                    }
+                }
+            }
+        }
+    }
+
+    QVector<quint8> dilatedBorder(border);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (!border[y * width + x]) continue;
+
+            for (int j = qMax(0, y - 1); j <= qMin(height - 1, y + 1); j++) {
+                for (int i = qMax(0, x - 1); i <= qMin(width - 1, x + 1); i++) {
+                    dilatedBorder[j * width + i] = 1;
+                }
+            }
+        }
+    }
+
+    return dilatedBorder;
+}
+
+/**
+ * Returns a buffer covering \p rect with 255 for the pixels that
+ * belong to the color scribble's group and 0 for the rest
+ */
+QVector<quint8> solveLabels(KisPaintDeviceSP src,
+                            KisPaintDeviceSP colorScribble,
+                            KisPaintDeviceSP backgroundScribble,
+                            KisPaintDeviceSP maskDevice,
+                            const QRect &rect,
+                            int level,
+                            QVector<CutPassStatistics> *statistics)
+{
+    const KoColorSpace *alpha8 = KoColorSpaceRegistry::instance()->alpha8();
+    const KoColor labelColor(Qt::white, alpha8);
+
+    QVector<quint8> labels(rect.width() * rect.height(), 0);
+
+    CutPassStatistics pass;
+    pass.level = level;
+    pass.rect = rect;
+
+    QElapsedTimer timer;
+
+    if (qint64(rect.width()) * rect.height() <= multiResolutionBaseArea ||
+        qMin(rect.width(), rect.height()) < 2 * refinementTileSize) {
+
+        timer.start();
+
+        KisPaintDeviceSP labelsDevice = new KisPaintDevice(alpha8);
+        KisPaintDeviceSP tempMask = new KisPaintDevice(*maskDevice);
+
+        pass.maxGraphMemory =
+            cutOneWayImpl(labelColor, src, colorScribble, backgroundScribble,
+                          labelsDevice, tempMask, rect);
+        pass.numTiles = 1;
+        pass.numRefinedTiles = 1;
+
+        labelsDevice->readBytes(labels.data(), rect);
+
+    } else {
+        const QRect coarse = coarseRect(rect);
+
+        const QVector<quint8> coarseLabels =
+            solveLabels(downscaleAlpha8Device(src, rect, true),
+                        downscaleAlpha8Device(colorScribble, rect, false),
+                        downscaleAlpha8Device(backgroundScribble, rect, false),
+                        downscaleAlpha8Device(maskDevice, rect, true),
+                        coarse, level + 1, statistics);
+
+        timer.start();
+
+        const QVector<quint8> coarseBorder =
+            findLabelsBorder(coarseLabels, coarse.width(), coarse.height());
+
+        struct RefinementTile {
+            RefinementTile() : refined(false), graphMemory(0) {}
+            QRect rect;
+            bool refined;
+            qint64 graphMemory;
+        };
+
+        QVector<RefinementTile> tiles;
+
+        for (int y = rect.top(); y <= rect.bottom(); y += refinementTileSize) {
+            for (int x = rect.left(); x <= rect.right(); x += refinementTileSize) {
+                RefinementTile tile;
+                tile.rect = QRect(x, y, refinementTileSize, refinementTileSize) & rect;
+                tiles << tile;
+            }
+        }
+
+        const quint8 *coarseLabelsPtr = coarseLabels.constData();
+        const quint8 *coarseBorderPtr = coarseBorder.constData();
+        quint8 *labelsPtr = labels.data();
+
+        auto coarseIndex = [coarse] (int x, int y) {
+            return (divFloor(y, 2) - coarse.top()) * coarse.width() + divFloor(x, 2) - coarse.left();
+        };
+
+        QtConcurrent::blockingMap(tiles, [&] (RefinementTile &tile) {
+            const QRect &rc = tile.rect;
+
+            const QRect coarseTileRect = coarseRect(rc);
+
+            for (int y = coarseTileRect.top(); y <= coarseTileRect.bottom() && !tile.refined; y++) {
+                const quint8 *borderPtr = coarseBorderPtr +
+                    (y - coarse.top()) * coarse.width() + coarseTileRect.left() - coarse.left();
+
+                for (int x = 0; x < coarseTileRect.width(); x++) {
+                    if (borderPtr[x]) {
+                        tile.refined = true;
+                        break;
+                    }
+                }
+            }
+
+            if (!tile.refined) {
+                /**
+                 * The tile is far from the border of the labels, so just
+                 * upscale the coarse labels. The pixels of the mask cannot
+                 * be filled by the cut, so they should be skipped.
+                 */
+                QVector<quint8> mask(rc.width() * rc.height());
+                maskDevice->readBytes(mask.data(), rc);
+                const quint8 *maskPtr = mask.constData();
+
+                for (int y = rc.top(); y <= rc.bottom(); y++) {
+                    quint8 *dstPtr = labelsPtr + (y - rect.top()) * rect.width() + rc.left() - rect.left();
+
+                    for (int x = rc.left(); x <= rc.right(); x++, dstPtr++, maskPtr++) {
+                        *dstPtr = *maskPtr ? 0 : coarseLabelsPtr[coarseIndex(x, y)];
+                    }
+                }
+
+                return;
+            }
+
+            /**
+             * Cut the tile at full resolution. The pixels far from the
+             * coarse border are used as scribbles for the cut.
+             */
+            const QRect solveRect =
+                rc.adjusted(-refinementTileMargin, -refinementTileMargin,
+                            refinementTileMargin, refinementTileMargin) & rect;
+
+            const int numPixels = solveRect.width() * solveRect.height();
+
+            QVector<quint8> aBuf(numPixels);
+            QVector<quint8> bBuf(numPixels);
+            colorScribble->readBytes(aBuf.data(), solveRect);
+            backgroundScribble->readBytes(bBuf.data(), solveRect);
+
+            quint8 *aPtr = aBuf.data();
+            quint8 *bPtr = bBuf.data();
+
+            for (int y = solveRect.top(); y <= solveRect.bottom(); y++) {
+                for (int x = solveRect.left(); x <= solveRect.right(); x++, aPtr++, bPtr++) {
+                    const int index = coarseIndex(x, y);
+                    if (coarseBorderPtr[index]) continue;
+
+                    if (coarseLabelsPtr[index]) {
+                        *aPtr = 255;
+                    } else {
+                        *bPtr = 255;
+                    }
+                }
+            }
+
+            KisPaintDeviceSP aDevice = new KisPaintDevice(alpha8);
+            aDevice->writeBytes(aBuf.constData(), solveRect);
+
+            KisPaintDeviceSP bDevice = new KisPaintDevice(alpha8);
+            bDevice->writeBytes(bBuf.constData(), solveRect);
+
+            QVector<quint8> maskBuf(numPixels);
+            maskDevice->readBytes(maskBuf.data(), solveRect);
+            KisPaintDeviceSP tempMask = new KisPaintDevice(alpha8);
+            tempMask->writeBytes(maskBuf.constData(), solveRect);
+
+            KisPaintDeviceSP tileLabels = new KisPaintDevice(alpha8);
+
+            tile.graphMemory =
+                cutOneWayImpl(labelColor, src, aDevice, bDevice,
+                              tileLabels, tempMask, solveRect);
+
+            for (int y = rc.top(); y <= rc.bottom(); y++) {
+                tileLabels->readBytes(labelsPtr + (y - rect.top()) * rect.width() + rc.left() - rect.left(),
+                                      rc.left(), y, rc.width(), 1);
+            }
+        });
+
+        pass.numTiles = tiles.size();
+
+        Q_FOREACH (const RefinementTile &tile, tiles) {
+            if (tile.refined) {
+                pass.numRefinedTiles++;
+                pass.maxGraphMemory = qMax(pass.maxGraphMemory, tile.graphMemory);
+            }
+        }
+    }
+
+    pass.time = timer.elapsed();
+
+    if (statistics) {
+        statistics->append(pass);
+    }
+
+    return labels;
+}
+
+}
+
+CutPassStatistics::CutPassStatistics()
+    : level(0),
+      numTiles(0),
+      numRefinedTiles(0),
+      time(0),
+      maxGraphMemory(0)
+{
+}
+
+void cutOneWay(const KoColor &color,
+               KisPaintDeviceSP src,
+               KisPaintDeviceSP colorScribble,
+               KisPaintDeviceSP backgroundScribble,
+               KisPaintDeviceSP resultDevice,
+               KisPaintDeviceSP maskDevice,
+               const QRect &boundingRect)
+{
+    KIS_ASSERT_RECOVER_RETURN(src->pixelSize() == 1);
+    KIS_ASSERT_RECOVER_RETURN(colorScribble->pixelSize() == 1);
+    KIS_ASSERT_RECOVER_RETURN(backgroundScribble->pixelSize() == 1);
+    KIS_ASSERT_RECOVER_RETURN(maskDevice->pixelSize() == 1);
+    KIS_ASSERT_RECOVER_RETURN(*resultDevice->colorSpace() == *color.colorSpace());
+
+    cutOneWayImpl(color, src, colorScribble, backgroundScribble,
+                  resultDevice, maskDevice, boundingRect);
+}
+
+void cutOneWayMultiResolution(const KoColor &color,
+                              KisPaintDeviceSP src,
+                              KisPaintDeviceSP colorScribble,
+                              KisPaintDeviceSP backgroundScribble,
+                              KisPaintDeviceSP resultDevice,
+                              KisPaintDeviceSP maskDevice,
+                              const QRect &boundingRect,
+                              QVector<CutPassStatistics> *statistics)
+{
+    KIS_ASSERT_RECOVER_RETURN(src->pixelSize() == 1);
+    KIS_ASSERT_RECOVER_RETURN(colorScribble->pixelSize() == 1);
+    KIS_ASSERT_RECOVER_RETURN(backgroundScribble->pixelSize() == 1);
+    KIS_ASSERT_RECOVER_RETURN(maskDevice->pixelSize() == 1);
+    KIS_ASSERT_RECOVER_RETURN(*resultDevice->colorSpace() == *color.colorSpace());
+
+    if (boundingRect.isEmpty()) return;
+
+    const QVector<quint8> labels =
+        solveLabels(src, colorScribble, backgroundScribble,
+                    maskDevice, boundingRect, 0, statistics);
+
+    KisSequentialIterator dstIt(resultDevice, boundingRect);
+    KisSequentialIterator mskIt(maskDevice, boundingRect);
+
+    const int pixelSize = resultDevice->pixelSize();
+    const quint8 *labelPtr = labels.constData();
+
+    do {
+        if (*labelPtr) {
+            memcpy(dstIt.rawData(), color.data(), pixelSize);
+            *mskIt.rawData() = cutMaskValue;
         }
+        labelPtr++;
     } while (dstIt.nextPixel() && mskIt.nextPixel());
 }
 
@@ -19,6 +19,9 @@
 #ifndef __KIS_LAZY_FILL_TOOLS_H
 #define __KIS_LAZY_FILL_TOOLS_H
 
+#include <QRect>
+#include <QVector>
+
 #include "kis_types.h"
 #include "kritaimage_export.h"
 #include <KoColor.h>
@@ -55,6 +58,47 @@ namespace KisLazyFillTools
                    KisPaintDeviceSP maskDevice,
                    const QRect &boundingRect);
 
+    /**
+     * Timings and memory consumption of one pass of
+     * cutOneWayMultiResolution()
+     */
+    struct KRITAIMAGE_EXPORT CutPassStatistics
+    {
+        CutPassStatistics();
+
+        int level; ///< 0 is the full resolution, every next level is twice smaller
+        QRect rect;
+        int numTiles;
+        int numRefinedTiles; ///< the tiles crossed by the label border
+        qint64 time; ///< in milliseconds, not counting the coarser passes
+        qint64 maxGraphMemory; ///< in bytes, the largest graph solved in the pass
+    };
+
+    /**
+     * The same as cutOneWay(), but solves the cut in a coarse-to-fine
+     * way. The devices are downscaled by 2 until the bounding rect
+     * becomes small enough for a direct cut. Then on every finer level
+     * the coarse labels are upscaled and only the tiles crossed by the
+     * border of the labels are cut again at higher resolution. These
+     * tiles are small and independent, so they are cut in parallel.
+     *
+     * The result may slightly differ from cutOneWay(), but the graphs
+     * are much smaller, so it needs much less memory and time on large
+     * images.
+     *
+     * If \p statistics is not null, the timings of every pass are
+     * appended to it, starting from the coarsest level.
+     */
+    KRITAIMAGE_EXPORT
+    void cutOneWayMultiResolution(const KoColor &color,
+                                  KisPaintDeviceSP src,
+                                  KisPaintDeviceSP colorScribble,
+                                  KisPaintDeviceSP backgroundScribble,
+                                  KisPaintDeviceSP resultDevice,
+                                  KisPaintDeviceSP maskDevice,
+                                  const QRect &boundingRect,
+                                  QVector<CutPassStatistics> *statistics = 0);
+
     /**
      * Returns one pixel from each connected component of \p src.
      *
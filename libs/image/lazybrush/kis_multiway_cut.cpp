@@ -26,6 +26,7 @@
 #include "kis_painter.h"
 #include "kis_lazy_fill_tools.h"
 #include "kis_sequential_iterator.h"
+#include "kis_debug.h"
 #include <floodfill/kis_scanline_fill.h>
 
 
@@ -40,6 +41,9 @@ struct KisMultiwayCut::Private
 
     QVector<KeyStroke> keyStrokes;
 
+    bool useMultiResolution;
+    QVector<CutPassStatistics> statistics;
+
     static void maskOutKeyStroke(KisPaintDeviceSP keyStrokeDevice, KisPaintDeviceSP mask, const QRect &boundingRect);
 };
 
@@ -52,6 +56,7 @@ KisMultiwayCut::KisMultiwayCut(KisPaintDeviceSP src,
     m_d->dst = dst;
     m_d->mask = new KisPaintDevice(KoColorSpaceRegistry::instance()->alpha8());
     m_d->boundingRect = boundingRect;
+    m_d->useMultiResolution = false;
 }
 
 KisMultiwayCut::~KisMultiwayCut()
@@ -64,6 +69,16 @@ void KisMultiwayCut::addKeyStroke(KisPaintDeviceSP dev, const KoColor &color)
 }
 
 
+void KisMultiwayCut::setUseMultiResolution(bool value)
+{
+    m_d->useMultiResolution = value;
+}
+
+QVector<CutPassStatistics> KisMultiwayCut::passStatistics() const
+{
+    return m_d->statistics;
+}
+
 void KisMultiwayCut::Private::maskOutKeyStroke(KisPaintDeviceSP keyStrokeDevice, KisPaintDeviceSP mask, const QRect &boundingRect)
 {
     KIS_ASSERT_RECOVER_RETURN(keyStrokeDevice->pixelSize() == 1);
@@ -106,6 +121,8 @@ void KisMultiwayCut::run()
 {
     KisPaintDeviceSP other(new KisPaintDevice(KoColorSpaceRegistry::instance()->alpha8()));
 
+    m_d->statistics.clear();
+
     /**
      * First sort all the key strokes in a way that all the
      * transparent strokes go to the beginning of the list.
@@ -139,13 +156,37 @@ void KisMultiwayCut::run()
             break;
         }
 
-        KisLazyFillTools::cutOneWay(current.color,
-                                    m_d->src,
-                                    current.dev,
-                                    other,
-                                    m_d->dst,
-                                    m_d->mask,
-                                    m_d->boundingRect);
+        if (m_d->useMultiResolution) {
+            QVector<CutPassStatistics> statistics;
+
+            KisLazyFillTools::cutOneWayMultiResolution(current.color,
+                                                       m_d->src,
+                                                       current.dev,
+                                                       other,
+                                                       m_d->dst,
+                                                       m_d->mask,
+                                                       m_d->boundingRect,
+                                                       &statistics);
+
+            Q_FOREACH (const CutPassStatistics &pass, statistics) {
+                dbgImage << "Lazy brush pass:"
+                         << "level" << pass.level
+                         << "rect" << pass.rect
+                         << "tiles" << pass.numRefinedTiles << "/" << pass.numTiles
+                         << "time" << pass.time << "ms"
+                         << "graph" << pass.maxGraphMemory / 1024 << "KiB";
+            }
+
+            m_d->statistics += statistics;
+        } else {
+            KisLazyFillTools::cutOneWay(current.color,
+                                        m_d->src,
+                                        current.dev,
+                                        other,
+                                        m_d->dst,
+                                        m_d->mask,
+                                        m_d->boundingRect);
+        }
 
         other->clear();
     }
@@ -23,6 +23,7 @@
 
 #include "kis_types.h"
 #include "kritaimage_export.h"
+#include "kis_lazy_fill_tools.h"
 
 class KoColor;
 
@@ -36,8 +37,23 @@ public:
 
     void addKeyStroke(KisPaintDeviceSP dev, const KoColor &color);
 
+    /**
+     * Use KisLazyFillTools::cutOneWayMultiResolution() instead of
+     * a plain full-resolution cut. Disabled by default, because the
+     * multi-resolution cut is approximate: a small portion of pixels
+     * along the borders of the areas may get a different label.
+     */
+    void setUseMultiResolution(bool value);
+
     void run();
 
+    /**
+     * Timings and memory consumption of all the passes of
+     * all the cuts done by the last run() call. Filled only in
+     * multi-resolution mode.
+     */
+    QVector<KisLazyFillTools::CutPassStatistics> passStatistics() const;
+
     KisPaintDeviceSP srcDevice() const;
     KisPaintDeviceSP dstDevice() const;
 
@@ -437,4 +437,71 @@ void KisConvolutionPainterTest::testGaussianDetailsFFTW()
     testGaussianDetails(true);
 }
 
+void KisConvolutionPainterTest::testGaussianRecursive()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect imageRect(0, 0, 400, 400);
+    const qreal radius = 20.0;
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(imageRect.adjusted(-100, -100, 100, 100), KoColor(Qt::black, cs));
+    dev->fill(QRect(100, 100, 200, 200), KoColor(Qt::white, cs));
+    dev->fill(QRect(150, 250, 20, 20), KoColor(Qt::red, cs));
+
+    KisPaintDeviceSP recursiveDev = new KisPaintDevice(*dev);
+
+    KisGaussianKernel::applyGaussian(dev, imageRect, radius, radius, QBitArray(), 0);
+    KisGaussianKernel::applyRecursiveGaussian(recursiveDev, imageRect, radius, radius, QBitArray(), 0);
+
+    QPoint errpoint;
+    QImage reference = dev->convertToQImage(0, imageRect);
+    QImage result = recursiveDev->convertToQImage(0, imageRect);
+
+    if (!TestUtil::compareQImages(errpoint, reference, result, 2, 2)) {
+        reference.save("gauss_recursive_reference.png");
+        result.save("gauss_recursive_result.png");
+        QFAIL(QString("Recursive gaussian differs too much from the convolution at %1,%2")
+              .arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+    }
+}
+
+void KisConvolutionPainterTest::testFFTWBlocks()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // big enough to be split into several blocks in both directions
+    const QRect imageRect(0, 0, 1300, 1100);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(imageRect, KoColor(Qt::black, cs));
+    dev->fill(QRect(100, 100, 900, 700), KoColor(Qt::white, cs));
+    dev->fill(QRect(480, 490, 60, 500), KoColor(Qt::red, cs));
+    dev->fill(QRect(1000, 50, 200, 1000), KoColor(Qt::transparent, cs));
+
+    KisCircleMaskGenerator* kas = new KisCircleMaskGenerator(15, 1.0, 5, 5, 2, false);
+    KisConvolutionKernelSP kernel = KisConvolutionKernel::fromMaskGenerator(kas);
+
+    KisPaintDeviceSP fftwDev = new KisPaintDevice(*dev);
+    KisPaintDeviceSP spatialDev = new KisPaintDevice(*dev);
+
+    KisConvolutionPainter fftwPainter(fftwDev, KisConvolutionPainter::FFTW);
+    fftwPainter.applyMatrix(kernel, dev, imageRect.topLeft(), imageRect.topLeft(),
+                            imageRect.size(), BORDER_REPEAT);
+
+    KisConvolutionPainter spatialPainter(spatialDev, KisConvolutionPainter::SPATIAL);
+    spatialPainter.applyMatrix(kernel, dev, imageRect.topLeft(), imageRect.topLeft(),
+                               imageRect.size(), BORDER_REPEAT);
+
+    QPoint errpoint;
+    QImage reference = spatialDev->convertToQImage(0, imageRect);
+    QImage result = fftwDev->convertToQImage(0, imageRect);
+
+    if (!TestUtil::compareQImages(errpoint, reference, result, 1, 1)) {
+        reference.save("fftw_blocks_reference.png");
+        result.save("fftw_blocks_result.png");
+        QFAIL(QString("Block FFT convolution differs from the spatial one at %1,%2")
+              .arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+    }
+}
+
 QTEST_MAIN(KisConvolutionPainterTest)
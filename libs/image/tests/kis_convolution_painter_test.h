@@ -56,6 +56,10 @@ private Q_SLOTS:
 
     void testGaussianDetailsSpatial();
     void testGaussianDetailsFFTW();
+
+    void testGaussianRecursive();
+
+    void testFFTWBlocks();
 };
 
 #endif
@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_incremental_histogram_test.h"
+
+#include <QTest>
+
+#include <cmath>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_incremental_histogram.h"
+
+inline int numAlignedSamples(int first, int last, int step)
+{
+    return int(std::floor(qreal(last) / step) - std::ceil(qreal(first) / step)) + 1;
+}
+
+void testIncrementalUpdateImpl(const KoColorSpace *cs, bool approximate,
+                               const QRect &bounds, const QVector<QRect> &dirtyRects)
+{
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(bounds, KoColor(Qt::red, cs));
+    dev->fill(QRect(bounds.x() + 600, bounds.y() + 100, 400, 300), KoColor(Qt::blue, cs));
+
+    KisIncrementalHistogram incremental(approximate);
+    incremental.update(dev, bounds, QVector<QRect>());
+
+    dev->fill(dirtyRects[0], KoColor(Qt::green, cs));
+    dev->fill(dirtyRects[1], KoColor(Qt::white, cs));
+
+    incremental.update(dev, bounds, dirtyRects);
+
+    KisIncrementalHistogram full(approximate);
+    full.update(dev, bounds, QVector<QRect>());
+
+    QVERIFY(incremental.bins() == full.bins());
+
+    const KisIncrementalHistogram::Bins bins = full.bins();
+    QCOMPARE(int(bins.size()), int(cs->channelCount()));
+
+    const int step = KisIncrementalHistogram::samplingStep(bounds, approximate);
+    const int numSamples =
+        numAlignedSamples(bounds.left(), bounds.right(), step) *
+        numAlignedSamples(bounds.top(), bounds.bottom(), step);
+
+    Q_FOREACH (const std::vector<quint32> &channel, bins) {
+        QCOMPARE(int(channel.size()), 256);
+
+        quint32 sum = 0;
+        for (quint32 value : channel) {
+            sum += value;
+        }
+        QCOMPARE(int(sum), numSamples);
+    }
+}
+
+void testIncrementalUpdateImpl(const KoColorSpace *cs, bool approximate)
+{
+    testIncrementalUpdateImpl(cs, approximate, QRect(0, 0, 1000, 700),
+                              QVector<QRect>() << QRect(10, 20, 30, 40) << QRect(550, 250, 300, 300));
+}
+
+void KisIncrementalHistogramTest::testIncrementalUpdate()
+{
+    testIncrementalUpdateImpl(KoColorSpaceRegistry::instance()->rgb8(), false);
+}
+
+void KisIncrementalHistogramTest::testIncrementalUpdate16()
+{
+    testIncrementalUpdateImpl(KoColorSpaceRegistry::instance()->rgb16(), false);
+}
+
+void KisIncrementalHistogramTest::testApproximate()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    QCOMPARE(KisIncrementalHistogram::samplingStep(QRect(0, 0, 1000, 700), true), 1);
+    QCOMPARE(KisIncrementalHistogram::samplingStep(QRect(0, 0, 4000, 3000), true), 4);
+    QCOMPARE(KisIncrementalHistogram::samplingStep(QRect(0, 0, 4000, 3000), false), 1);
+
+    testIncrementalUpdateImpl(cs, true);
+
+    /**
+     * On a big image the approximate histogram should still keep the
+     * proportions of the colors
+     */
+    const QRect bounds(0, 0, 4000, 3000);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(QRect(0, 0, 1000, 3000), KoColor(Qt::white, cs));
+    dev->fill(QRect(1000, 0, 3000, 3000), KoColor(Qt::black, cs));
+
+    KisIncrementalHistogram histogram(true);
+    histogram.update(dev, bounds, QVector<QRect>());
+
+    const KisIncrementalHistogram::Bins bins = histogram.bins();
+    const qreal whiteFraction = qreal(bins[0][255]) / (bins[0][0] + bins[0][255]);
+    QVERIFY(qAbs(whiteFraction - 0.25) < 0.01);
+}
+
+void KisIncrementalHistogramTest::testApproximateIncrementalUpdate()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    /**
+     * The dirty rects are not aligned to the sampling grid, and in the
+     * second case neither are the bounds
+     */
+    const QVector<QRect> dirtyRects =
+        QVector<QRect>() << QRect(1001, 1503, 37, 45) << QRect(2550, 253, 301, 299);
+
+    QCOMPARE(KisIncrementalHistogram::samplingStep(QRect(0, 0, 4000, 3000), true), 4);
+    testIncrementalUpdateImpl(cs, true, QRect(0, 0, 4000, 3000), dirtyRects);
+
+    QCOMPARE(KisIncrementalHistogram::samplingStep(QRect(-13, 7, 4000, 3000), true), 4);
+    testIncrementalUpdateImpl(cs, true, QRect(-13, 7, 4000, 3000), dirtyRects);
+}
+
+void KisIncrementalHistogramTest::testBoundsChange()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(QRect(100, 100, 700, 500), KoColor(Qt::red, cs));
+
+    KisIncrementalHistogram incremental(false);
+    incremental.update(dev, dev->exactBounds(), QVector<QRect>());
+
+    // grow the content of the device beyond the old bounds
+    const QRect dirtyRect(750, 300, 300, 400);
+    dev->fill(dirtyRect, KoColor(Qt::blue, cs));
+    incremental.update(dev, dev->exactBounds(), QVector<QRect>() << dirtyRect);
+
+    KisIncrementalHistogram full(false);
+    full.update(dev, dev->exactBounds(), QVector<QRect>());
+    QVERIFY(incremental.bins() == full.bins());
+
+    // and shrink it back
+    dev->clear(dirtyRect);
+    dev->clear(QRect(100, 100, 50, 500));
+    incremental.update(dev, dev->exactBounds(),
+                       QVector<QRect>() << dirtyRect << QRect(100, 100, 50, 500));
+
+    KisIncrementalHistogram full2(false);
+    full2.update(dev, dev->exactBounds(), QVector<QRect>());
+    QVERIFY(incremental.bins() == full2.bins());
+}
+
+QTEST_MAIN(KisIncrementalHistogramTest)
@@ -29,6 +29,7 @@
 
 #include "kis_transparency_mask.h"
 #include "kis_paint_layer.h"
+#include "kis_group_layer.h"
 #include "kis_image.h"
 #include "kis_painter.h"
 
@@ -496,4 +497,208 @@ void KisLayerStyleProjectionPlaneTest::testBevel()
     style->bevelAndEmboss()->setSoften(3);
     test(style, "bevel_pillow_up_soft");
 }
+
+void KisLayerStyleProjectionPlaneTest::testCachedUpdates()
+{
+    const QRect imageRect(0, 0, 300, 300);
+    const QRect fillRect(50, 50, 100, 100);
+    const QRect dabRect(130, 120, 40, 30);
+
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "styles test");
+
+    KisPaintLayerSP layer = new KisPaintLayer(image, "test", OPACITY_OPAQUE_U8);
+    image->addNode(layer);
+
+    KisPSDLayerStyleSP style(new KisPSDLayerStyle());
+    style->dropShadow()->setSize(15);
+    style->dropShadow()->setDistance(15);
+    style->dropShadow()->setOpacity(70);
+    style->dropShadow()->setEffectEnabled(true);
+
+    style->outerGlow()->setSize(10);
+    style->outerGlow()->setOpacity(70);
+    style->outerGlow()->setColor(Qt::green);
+    style->outerGlow()->setEffectEnabled(true);
+
+    style->colorOverlay()->setColor(Qt::blue);
+    style->colorOverlay()->setOpacity(50);
+    style->colorOverlay()->setEffectEnabled(true);
+
+    layer->paintDevice()->fill(fillRect, KoColor(Qt::red, cs));
+
+    KisLayerStyleProjectionPlane cachedPlane(layer.data(), style);
+    cachedPlane.changeRect(fillRect, KisLayer::N_FILTHY);
+    cachedPlane.recalculate(imageRect, layer);
+
+    layer->paintDevice()->fill(dabRect, KoColor(Qt::yellow, cs));
+
+    /**
+     * Only the area affected by the dab should be recalculated, the rest
+     * of the requested rect is taken from the cache
+     */
+    cachedPlane.changeRect(dabRect, KisLayer::N_FILTHY);
+    cachedPlane.recalculate(imageRect, layer);
+
+    KisLayerStyleProjectionPlane freshPlane(layer.data(), style);
+    freshPlane.recalculate(imageRect, layer);
+
+    KisPaintDeviceSP cachedProjection = new KisPaintDevice(cs);
+    {
+        KisPainter painter(cachedProjection);
+        cachedPlane.apply(&painter, imageRect);
+    }
+
+    KisPaintDeviceSP freshProjection = new KisPaintDevice(cs);
+    {
+        KisPainter painter(freshProjection);
+        freshPlane.apply(&painter, imageRect);
+    }
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, cachedProjection, freshProjection));
+
+    // the change of the layer's opacity should drop the cache
+    layer->setOpacity(128);
+
+    cachedPlane.recalculate(imageRect, layer);
+    freshPlane.recalculate(imageRect, layer);
+
+    cachedProjection->clear();
+    freshProjection->clear();
+
+    {
+        KisPainter painter(cachedProjection);
+        cachedPlane.apply(&painter, imageRect);
+    }
+
+    {
+        KisPainter painter(freshProjection);
+        freshPlane.apply(&painter, imageRect);
+    }
+
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, cachedProjection, freshProjection));
+}
+
+inline KisPSDLayerStyleSP createCachedUpdatesStyle()
+{
+    KisPSDLayerStyleSP style(new KisPSDLayerStyle());
+    style->dropShadow()->setSize(15);
+    style->dropShadow()->setDistance(15);
+    style->dropShadow()->setOpacity(70);
+    style->dropShadow()->setEffectEnabled(true);
+
+    style->stroke()->setSize(3);
+    style->stroke()->setColor(Qt::black);
+    style->stroke()->setEffectEnabled(true);
+
+    style->colorOverlay()->setColor(Qt::blue);
+    style->colorOverlay()->setOpacity(50);
+    style->colorOverlay()->setEffectEnabled(true);
+
+    return style;
+}
+
+void KisLayerStyleProjectionPlaneTest::testCachedUpdatesInImage()
+{
+    const QRect imageRect(0, 0, 300, 300);
+    const QRect fillRect(50, 50, 100, 100);
+    const QRect dabRect(130, 120, 40, 30);
+
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "styles test");
+
+    KisPaintLayerSP layer = new KisPaintLayer(image, "test", OPACITY_OPAQUE_U8);
+    layer->paintDevice()->fill(fillRect, KoColor(Qt::red, cs));
+    layer->setLayerStyle(createCachedUpdatesStyle());
+    image->addNode(layer);
+
+    image->initialRefreshGraph();
+
+    KisLayerStyleProjectionPlane *plane =
+        dynamic_cast<KisLayerStyleProjectionPlane*>(layer->projectionPlane().data());
+    QVERIFY(plane);
+
+    const qint64 initialPixels = plane->recalculatedEffectPixels();
+    QVERIFY(initialPixels > 0);
+
+    layer->paintDevice()->fill(dabRect, KoColor(Qt::yellow, cs));
+    layer->setDirty(dabRect);
+    image->waitForDone();
+
+    /**
+     * Without the cache every effect would recalculate at least the
+     * change rect of the whole style, the cached effects recalculate
+     * only their own change rects of the dab
+     */
+    const qint64 dabPixels = plane->recalculatedEffectPixels() - initialPixels;
+    const QRect styleChangeRect = plane->changeRect(dabRect, KisLayer::N_FILTHY);
+    const int numEffects = 10;
+
+    QVERIFY(dabPixels > 0);
+    QVERIFY(dabPixels < qint64(numEffects) * styleChangeRect.width() * styleChangeRect.height() / 2);
+
+    // an update of the same area again uses the cache of the rest of the layer
+    const qint64 secondPixels = plane->recalculatedEffectPixels();
+    layer->setDirty(dabRect);
+    image->waitForDone();
+    QVERIFY(plane->recalculatedEffectPixels() - secondPixels <= dabPixels);
+
+    // the result should be the same as the one of the uncached rendering
+    KisImageSP refImage = new KisImage(0, imageRect.width(), imageRect.height(), cs, "styles test");
+    KisPaintLayerSP refLayer = new KisPaintLayer(refImage, "test", OPACITY_OPAQUE_U8);
+    refLayer->paintDevice()->makeCloneFrom(layer->paintDevice(), imageRect);
+    refLayer->setLayerStyle(createCachedUpdatesStyle());
+    refImage->addNode(refLayer);
+    refImage->initialRefreshGraph();
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, image->projection(), refImage->projection()));
+}
+
+void KisLayerStyleProjectionPlaneTest::testGroupStyleUpdatesInImage()
+{
+    const QRect imageRect(0, 0, 300, 300);
+    const QRect fillRect(50, 50, 100, 100);
+    const QRect dabRect1(130, 120, 40, 30);
+    const QRect dabRect2(60, 140, 30, 40);
+
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.width(), imageRect.height(), cs, "styles test");
+
+    KisGroupLayerSP group = new KisGroupLayer(image, "group", OPACITY_OPAQUE_U8);
+    KisPaintLayerSP layer = new KisPaintLayer(image, "test", OPACITY_OPAQUE_U8);
+    layer->paintDevice()->fill(fillRect, KoColor(Qt::red, cs));
+    group->setLayerStyle(createCachedUpdatesStyle());
+
+    image->addNode(group);
+    image->addNode(layer, group);
+
+    image->initialRefreshGraph();
+
+    /**
+     * The projection of the group is rendered by the walkers, so the
+     * effects must never be calculated from a projection that has not
+     * been updated yet, even when the updates are queued together
+     */
+    layer->paintDevice()->fill(dabRect1, KoColor(Qt::yellow, cs));
+    layer->setDirty(dabRect1);
+    layer->paintDevice()->fill(dabRect2, KoColor(Qt::green, cs));
+    layer->setDirty(dabRect2);
+    image->waitForDone();
+
+    KisImageSP refImage = new KisImage(0, imageRect.width(), imageRect.height(), cs, "styles test");
+    KisGroupLayerSP refGroup = new KisGroupLayer(refImage, "group", OPACITY_OPAQUE_U8);
+    KisPaintLayerSP refLayer = new KisPaintLayer(refImage, "test", OPACITY_OPAQUE_U8);
+    refLayer->paintDevice()->makeCloneFrom(layer->paintDevice(), imageRect);
+    refGroup->setLayerStyle(createCachedUpdatesStyle());
+
+    refImage->addNode(refGroup);
+    refImage->addNode(refLayer, refGroup);
+    refImage->initialRefreshGraph();
+
+    QPoint errorPoint;
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, image->projection(), refImage->projection()));
+}
+
 QTEST_MAIN(KisLayerStyleProjectionPlaneTest)
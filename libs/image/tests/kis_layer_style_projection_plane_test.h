@@ -46,6 +46,10 @@ private Q_SLOTS:
 
     void testBevel();
 
+    void testCachedUpdates();
+    void testCachedUpdatesInImage();
+    void testGroupStyleUpdatesInImage();
+
 private:
     void test(KisPSDLayerStyleSP style, const QString testName);
 };
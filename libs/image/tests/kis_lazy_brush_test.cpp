@@ -1252,6 +1252,76 @@ void KisLazyBrushTest::testCutOnGraphDeviceMulti()
     KIS_DUMP_DEVICE_2(filteredMainDev, filterRect, "2filtered", "dd");
 }
 
+void KisLazyBrushTest::testCutOneWayMultiResolution()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColorSpace *alpha8 = KoColorSpaceRegistry::instance()->alpha8();
+
+    const QRect mainRect(0, 0, 1024, 768);
+
+    KisPaintDeviceSP mainDev = new KisPaintDevice(cs);
+    const KoColor lineColor(Qt::black, cs);
+
+    KisFillPainter gc(mainDev);
+    gc.fillRect(QRect(200, 150, 600, 6), lineColor);
+    gc.fillRect(QRect(200, 600, 600, 6), lineColor);
+    gc.fillRect(QRect(200, 150, 6, 456), lineColor);
+    gc.fillRect(QRect(794, 150, 6, 456), lineColor);
+    gc.fillRect(QRect(500, 150, 3, 200), lineColor);
+
+    KisPaintDeviceSP aLabelDev = new KisPaintDevice(alpha8);
+    aLabelDev->fill(QRect(300, 300, 40, 40), KoColor(Qt::black, alpha8));
+
+    KisPaintDeviceSP bLabelDev = new KisPaintDevice(alpha8);
+    bLabelDev->fill(QRect(50, 50, 40, 40), KoColor(Qt::black, alpha8));
+
+    KisPaintDeviceSP filteredMainDev = KisPainter::convertToAlphaAsAlpha(mainDev);
+    KisLazyFillTools::normalizeAndInvertAlpha8Device(filteredMainDev, mainRect);
+
+    const KoColor color(Qt::red, cs);
+
+    KisPaintDeviceSP directResult = new KisPaintDevice(cs);
+    KisPaintDeviceSP directMask = new KisPaintDevice(alpha8);
+
+    KisLazyFillTools::cutOneWay(color, filteredMainDev, aLabelDev, bLabelDev,
+                                directResult, directMask, mainRect);
+
+    KisPaintDeviceSP multiResult = new KisPaintDevice(cs);
+    KisPaintDeviceSP multiMask = new KisPaintDevice(alpha8);
+    QVector<KisLazyFillTools::CutPassStatistics> statistics;
+
+    KisLazyFillTools::cutOneWayMultiResolution(color, filteredMainDev, aLabelDev, bLabelDev,
+                                               multiResult, multiMask, mainRect, &statistics);
+
+    QVERIFY(statistics.size() >= 2);
+    QCOMPARE(statistics.last().level, 0);
+    QCOMPARE(statistics.last().rect, mainRect);
+    QVERIFY(statistics.last().numRefinedTiles < statistics.last().numTiles);
+
+    QColor c;
+    multiResult->pixel(400, 400, &c);
+    QCOMPARE(c, QColor(Qt::red));
+
+    multiResult->pixel(100, 100, &c);
+    QCOMPARE(c.alpha(), 0);
+
+    // the borders of the area may be found slightly differently
+    const int numPixels = mainRect.width() * mainRect.height();
+    QVector<quint8> directMaskBytes(numPixels);
+    QVector<quint8> multiMaskBytes(numPixels);
+    directMask->readBytes(directMaskBytes.data(), mainRect);
+    multiMask->readBytes(multiMaskBytes.data(), mainRect);
+
+    int numDifferentPixels = 0;
+    for (int i = 0; i < numPixels; i++) {
+        if (bool(directMaskBytes[i]) != bool(multiMaskBytes[i])) {
+            numDifferentPixels++;
+        }
+    }
+
+    QVERIFY(numDifferentPixels < numPixels / 100);
+}
+
 void KisLazyBrushTest::testLoG()
 {
     QImage mainImage(TestUtil::fetchDataFileLazy("fill1_main.png"));
@@ -33,6 +33,7 @@ private Q_SLOTS:
     void testCutOnGraph();
     void testCutOnGraphDevice();
     void testCutOnGraphDeviceMulti();
+    void testCutOneWayMultiResolution();
     void testLoG();
 
     void testSplitIntoConnectedComponents();
@@ -154,4 +154,47 @@ void KisLiquifyTransformWorkerTest::testIdentityTransform()
     TestUtil::checkQImage(result, "liquify_transform_test", "liquify_dev", "identity");
 }
 
+void KisLiquifyTransformWorkerTest::testIncrementalQImage()
+{
+    TestUtil::TestProgressBar bar;
+    KoProgressUpdater pu(&bar);
+    KoUpdaterPtr updater = pu.startSubtask();
+
+    QImage image(TestUtil::fetchDataFileLazy("test_transform_quality_second.png"));
+    image = image.convertToFormat(QImage::Format_ARGB32);
+
+    const int pixelPrecision = 8;
+    const QTransform imageToThumbTransform = QTransform::fromScale(0.5, 0.5);
+    const QPointF srcOffset(10, 10);
+
+    KisLiquifyTransformWorker worker(image.rect(),
+                                     updater,
+                                     pixelPrecision);
+
+    worker.translatePoints(QPointF(100,100),
+                           QPointF(50, 0),
+                           50, false, 0.2);
+
+    QPointF newOffset;
+    worker.runOnQImage(image, srcOffset, imageToThumbTransform, &newOffset);
+
+    // a small local stroke that doesn't change the bounds of the image
+    worker.translatePoints(QPointF(300,300),
+                           QPointF(5, 5),
+                           20, false, 0.2);
+
+    QPointF incrementalOffset;
+    QImage incrementalResult =
+        worker.runOnQImage(image, srcOffset, imageToThumbTransform, &incrementalOffset);
+
+    KisLiquifyTransformWorker freshWorker(worker);
+
+    QPointF fullOffset;
+    QImage fullResult =
+        freshWorker.runOnQImage(image, srcOffset, imageToThumbTransform, &fullOffset);
+
+    QCOMPARE(incrementalOffset, fullOffset);
+    QVERIFY(incrementalResult == fullResult);
+}
+
 QTEST_MAIN(KisLiquifyTransformWorkerTest)
@@ -28,6 +28,7 @@ private Q_SLOTS:
     void testPoints();
     void testPointsQImage();
     void testIdentityTransform();
+    void testIncrementalQImage();
 };
 
 #endif /* __KIS_LIQUIFY_TRANSFORM_WORKER_TEST_H */
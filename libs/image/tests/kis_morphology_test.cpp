@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_morphology_test.h"
+
+#include <QTest>
+#include <QtMath>
+#include <cmath>
+
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_morphology.h"
+
+
+void KisMorphologyTest::testDecompose()
+{
+    QCOMPARE(KisMorphology::decompose(KisMorphology::Square, 10, 5),
+             QVector<QPoint>() << QPoint(10, 5));
+
+    // radius 1 diamond is a cross
+    QCOMPARE(KisMorphology::decompose(KisMorphology::Diamond, 1, 1),
+             QVector<QPoint>() << QPoint(0, 1) << QPoint(1, 0));
+
+    QCOMPARE(KisMorphology::decompose(KisMorphology::Disk, 10, 5),
+             QVector<QPoint>() << QPoint(4, 5) << QPoint(7, 4) << QPoint(9, 3) << QPoint(10, 2));
+
+    // big shapes are approximated, but keep their extents
+    const QVector<QPoint> bigDisk = KisMorphology::decompose(KisMorphology::Disk, 500, 500);
+    QCOMPARE(bigDisk.size(), int(KisMorphology::maxRectangles));
+    QCOMPARE(bigDisk.first().y(), 500);
+    QCOMPARE(bigDisk.last().x(), 500);
+}
+
+bool shapeContains(KisMorphology::Shape shape, int xRadius, int yRadius, int dx, int dy)
+{
+    dx = qAbs(dx);
+    dy = qAbs(dy);
+
+    if (dx > xRadius || dy > yRadius) return false;
+
+    if (shape == KisMorphology::Diamond) {
+        return dy <= qFloor(yRadius * (1.0 - qreal(dx) / xRadius));
+    } else if (shape == KisMorphology::Disk) {
+        const qreal tmp = dx > 0 ? dx - 0.5 : 0.0;
+        return dy <= qFloor(qreal(yRadius) / xRadius * std::sqrt(xRadius * xRadius - tmp * tmp) + 0.5);
+    }
+
+    return true;
+}
+
+void testMorphologyImpl(KisMorphology::Operation operation, Qt::Orientations repeatBorders,
+                        const QPoint &deviceOffset = QPoint())
+{
+    // the rect spans three stripes
+    const QRect rect(10, 20, 90, 150);
+    const QRect deviceRect = rect.adjusted(-10, -10, 10, 10);
+
+    QVector<quint8> pixels(deviceRect.width() * deviceRect.height());
+
+    srand(78345);
+    for (int i = 0; i < pixels.size(); i++) {
+        const int value = rand() % 4;
+        pixels[i] = value == 0 ? 0 : value == 1 ? 255 : rand() % 256;
+    }
+
+    auto sourcePixel = [&] (int x, int y) -> quint8 {
+        if (repeatBorders & Qt::Horizontal) {
+            x = qBound(rect.left(), x, rect.right());
+        }
+        if (repeatBorders & Qt::Vertical) {
+            y = qBound(rect.top(), y, rect.bottom());
+        }
+        if (!rect.contains(x, y)) return 0;
+
+        return pixels[(y - deviceRect.y()) * deviceRect.width() + x - deviceRect.x()];
+    };
+
+    const QList<KisMorphology::Shape> shapes =
+        {KisMorphology::Square, KisMorphology::Diamond, KisMorphology::Disk};
+
+    Q_FOREACH (KisMorphology::Shape shape, shapes) {
+        for (int xRadius = 1; xRadius <= 7; xRadius += 3) {
+            for (int yRadius = 1; yRadius <= 9; yRadius += 4) {
+                KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->alpha8());
+                dev->setX(deviceOffset.x());
+                dev->setY(deviceOffset.y());
+                dev->writeBytes(pixels.constData(), deviceRect);
+
+                KisMorphology::apply(dev, rect, operation, shape, xRadius, yRadius, repeatBorders);
+
+                QVector<quint8> result(rect.width() * rect.height());
+                dev->readBytes(result.data(), rect);
+
+                for (int y = rect.top(); y <= rect.bottom(); y++) {
+                    for (int x = rect.left(); x <= rect.right(); x++) {
+                        quint8 expected = operation == KisMorphology::Dilate ? 0 : 255;
+
+                        for (int dy = -yRadius; dy <= yRadius; dy++) {
+                            for (int dx = -xRadius; dx <= xRadius; dx++) {
+                                if (!shapeContains(shape, xRadius, yRadius, dx, dy)) continue;
+
+                                const quint8 value = sourcePixel(x + dx, y + dy);
+                                expected = operation == KisMorphology::Dilate ?
+                                    qMax(expected, value) : qMin(expected, value);
+                            }
+                        }
+
+                        const quint8 actual =
+                            result[(y - rect.y()) * rect.width() + x - rect.x()];
+
+                        if (actual != expected) {
+                            qDebug() << "Failed: shape" << shape << "radius" << xRadius << yRadius
+                                     << "pixel" << x << y << "actual" << actual << "expected" << expected;
+                            QFAIL("the result differs from the reference");
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void KisMorphologyTest::testDilate()
+{
+    testMorphologyImpl(KisMorphology::Dilate, Qt::Horizontal);
+}
+
+void KisMorphologyTest::testErode()
+{
+    testMorphologyImpl(KisMorphology::Erode, Qt::Orientations());
+}
+
+void KisMorphologyTest::testErodeRepeatBorders()
+{
+    testMorphologyImpl(KisMorphology::Erode, Qt::Horizontal | Qt::Vertical);
+}
+
+void KisMorphologyTest::testDilateOffsetDevice()
+{
+    // the stripes follow the tiles of the device, not the image
+    testMorphologyImpl(KisMorphology::Dilate, Qt::Horizontal, QPoint(13, 37));
+}
+
+QTEST_MAIN(KisMorphologyTest)
@@ -37,6 +37,7 @@
 #include "kis_pixel_selection.h"
 #include "kis_fill_painter.h"
 #include <kis_fixed_paint_device.h>
+#include <kis_rendered_dab.h>
 #include "testutil.h"
 #include <kis_iterator_ng.h>
 
@@ -479,6 +480,150 @@ void KisPainterTest::testBitBltOldData()
     srcGc.deleteTransaction();
 }
 
+void KisPainterTest::testBltFixedRenderedDabs()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisPaintDeviceSP sequentialDev = new KisPaintDevice(cs);
+    KisPaintDeviceSP batchedDev = new KisPaintDevice(cs);
+
+    KisPainter sequentialGc(sequentialDev);
+    sequentialGc.setCompositeOp(COMPOSITE_ALPHA_DARKEN);
+
+    KisPainter batchedGc(batchedDev);
+    batchedGc.setCompositeOp(COMPOSITE_ALPHA_DARKEN);
+
+    QList<KisRenderedDab> dabs;
+    QRect totalRect;
+
+    srand(31337);
+
+    // overlapping dabs of different opacity and flow along a line
+    for (int i = 0; i < 20; i++) {
+        KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+        dab->setRect(QRect(0, 0, 70, 50));
+        dab->initialize();
+
+        quint8 *ptr = dab->data();
+        for (int j = 0; j < 70 * 50; j++) {
+            ptr[0] = rand() % 256;
+            ptr[1] = rand() % 256;
+            ptr[2] = rand() % 256;
+            ptr[3] = rand() % 256;
+            ptr += 4;
+        }
+
+        const QPoint offset(-30 + i * 13, -20 + i * 7);
+        const quint8 opacity = 50 + rand() % 206;
+        const quint8 flow = 50 + rand() % 206;
+
+        sequentialGc.setOpacityUpdateAverage(opacity);
+        sequentialGc.setFlow(flow);
+        sequentialGc.bltFixed(offset, dab, dab->bounds());
+
+        batchedGc.setOpacityUpdateAverage(opacity);
+        batchedGc.setFlow(flow);
+        dabs << batchedGc.renderedDab(dab, offset);
+
+        totalRect |= dabs.last().realBounds();
+    }
+
+    // split the area into (unaligned) parts to check clipping
+    for (int y = totalRect.top(); y <= totalRect.bottom(); y += 37) {
+        for (int x = totalRect.left(); x <= totalRect.right(); x += 53) {
+            batchedGc.bltFixed(QRect(x, y, 53, 37) & totalRect, dabs);
+        }
+    }
+
+    QVector<quint8> sequentialBytes(totalRect.width() * totalRect.height() * cs->pixelSize());
+    QVector<quint8> batchedBytes(sequentialBytes.size());
+
+    sequentialDev->readBytes(sequentialBytes.data(), totalRect);
+    batchedDev->readBytes(batchedBytes.data(), totalRect);
+
+    QVERIFY(batchedBytes == sequentialBytes);
+}
+
+void KisPainterTest::testAreaBackup()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisPaintDeviceSP dst = new KisPaintDevice(cs);
+    dst->fill(QRect(0, 0, 100, 100), KoColor(Qt::red, cs));
+
+    KisPaintDeviceSP reference = new KisPaintDevice(cs);
+    reference->makeCloneFrom(dst, dst->extent());
+
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+    dab->setRect(QRect(0, 0, 30, 30));
+    dab->initialize();
+    dab->fill(0, 0, 30, 30, KoColor(Qt::green, cs).data());
+
+    KisPaintDeviceSP src = new KisPaintDevice(cs);
+    src->fill(QRect(0, 0, 50, 20), KoColor(Qt::blue, cs));
+
+    KisPainter gc(dst);
+    gc.beginAreaBackup();
+
+    // the areas overlap each other and the filled area of the device
+    gc.bltFixed(85, 85, dab, 0, 0, 30, 30);
+    gc.bltFixed(100, 90, dab, 0, 0, 30, 30);
+    gc.bitBlt(70, 40, src, 0, 0, 50, 20);
+    gc.fill(10, 10, 20, 20, KoColor(Qt::yellow, cs));
+
+    QPoint errorPoint;
+    QVERIFY(!TestUtil::comparePaintDevices(errorPoint, dst, reference));
+
+    const QVector<QRect> rects = gc.revertAreaBackup();
+
+    QRegion restoredRegion;
+    Q_FOREACH (const QRect &rc, rects) {
+        restoredRegion += rc;
+    }
+
+    QCOMPARE(restoredRegion.boundingRect(), QRect(10, 10, 120, 110));
+    QVERIFY(TestUtil::comparePaintDevices(errorPoint, dst, reference));
+
+    // the backup is stopped by the revert
+    gc.fill(10, 10, 20, 20, KoColor(Qt::yellow, cs));
+    QVERIFY(gc.revertAreaBackup().isEmpty());
+    QVERIFY(!TestUtil::comparePaintDevices(errorPoint, dst, reference));
+}
+
+void KisPainterTest::testOpacityState()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    KisPainter gc(dev);
+    KisPainter refGc(dev);
+
+    gc.setOpacityUpdateAverage(100);
+    gc.setFlow(200);
+    refGc.setOpacityUpdateAverage(100);
+    refGc.setFlow(200);
+
+    const KisPainter::OpacityState state = gc.opacityState();
+
+    // a line that is going to be rolled back
+    gc.setOpacityUpdateAverage(50);
+    gc.setOpacityUpdateAverage(250);
+    gc.setFlow(10);
+
+    gc.setOpacityState(state);
+
+    gc.setOpacityUpdateAverage(80);
+    refGc.setOpacityUpdateAverage(80);
+
+    const KisPainter::OpacityState result = gc.opacityState();
+    const KisPainter::OpacityState refResult = refGc.opacityState();
+
+    QCOMPARE(gc.opacity(), refGc.opacity());
+    QCOMPARE(gc.flow(), refGc.flow());
+    QCOMPARE(result.meanIsOpacity, refResult.meanIsOpacity);
+    QCOMPARE(result.meanOpacity, refResult.meanOpacity);
+}
+
 void KisPainterTest::benchmarkBitBlt()
 {
     quint8 p = 128;
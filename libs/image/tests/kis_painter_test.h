@@ -51,6 +51,9 @@ private Q_SLOTS:
     void testSelectionBitBltEraseCompositeOp();
 
     void testBitBltOldData();
+    void testBltFixedRenderedDabs();
+    void testAreaBackup();
+    void testOpacityState();
     void benchmarkBitBlt();
     void benchmarkBitBltOldData();
 
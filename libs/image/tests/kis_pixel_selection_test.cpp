@@ -22,6 +22,7 @@
 
 #include <kis_debug.h>
 #include <QRect>
+#include <QPainter>
 
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
@@ -33,6 +34,7 @@
 #include "kis_pixel_selection.h"
 #include "testutil.h"
 #include "kis_fill_painter.h"
+#include "kis_sequential_iterator.h"
 #include "kis_transaction.h"
 #include "kis_surrogate_undo_adapter.h"
 #include "commands/kis_selection_commands.h"
@@ -378,5 +380,94 @@ void KisPixelSelectionTest::testOutlineCacheTransactions()
     }
 }
 
+void checkOutlineMatchesPixels(KisPixelSelectionSP psel)
+{
+    const QRect rc = psel->selectedExactRect().adjusted(-2, -2, 2, 2);
+
+    QImage outlineImage(rc.size(), QImage::Format_ARGB32);
+    outlineImage.fill(0);
+
+    QPainter gc(&outlineImage);
+    gc.translate(-rc.topLeft());
+    gc.fillPath(psel->outlineCache(), Qt::black);
+    gc.end();
+
+    QImage pixelsImage(rc.size(), QImage::Format_ARGB32);
+    pixelsImage.fill(0);
+
+    KisSequentialConstIterator it(psel, rc);
+    do {
+        if (*it.oldRawData() != MIN_SELECTED) {
+            pixelsImage.setPixel(it.x() - rc.x(), it.y() - rc.y(), qRgba(0, 0, 0, 255));
+        }
+    } while (it.nextPixel());
+
+    QCOMPARE(outlineImage, pixelsImage);
+}
+
+void KisPixelSelectionTest::testIncrementalOutline()
+{
+    KisPixelSelectionSP psel = new KisPixelSelection();
+
+    // a frame crossing several stripes, an island inside and two diagonal pixels
+    psel->select(QRect(10, 20, 300, 200), MAX_SELECTED);
+    psel->clear(QRect(30, 40, 200, 100));
+    psel->select(QRect(100, 70, 7, 9), MAX_SELECTED);
+    psel->select(QRect(150, 90, 1, 1), MAX_SELECTED);
+    psel->select(QRect(151, 91, 1, 1), MAX_SELECTED);
+
+    psel->invalidateOutlineCache();
+    psel->recalculateOutlineCache();
+    checkOutlineMatchesPixels(psel);
+
+    /**
+     * Change the pixels behind the back of the outline cache, the
+     * generator must retrace the changed stripes only, but still
+     * notice all the changes
+     */
+    {
+        KisFillPainter gc(psel);
+        gc.fillRect(QRect(50, 125, 20, 30), KoColor(Qt::white, KoColorSpaceRegistry::instance()->rgb8()), MAX_SELECTED);
+        gc.fillRect(QRect(200, 20, 30, 3), KoColor(Qt::white, KoColorSpaceRegistry::instance()->rgb8()), MIN_SELECTED);
+    }
+
+    psel->invalidateOutlineCache();
+    psel->recalculateOutlineCache();
+    checkOutlineMatchesPixels(psel);
+
+    // the selection grows downwards, so the columns stay the same
+    psel->select(QRect(10, 220, 300, 100), MAX_SELECTED);
+
+    psel->invalidateOutlineCache();
+    psel->recalculateOutlineCache();
+    checkOutlineMatchesPixels(psel);
+
+    KisPixelSelectionSP copy = new KisPixelSelection(*psel);
+    copy->invalidateOutlineCache();
+    copy->recalculateOutlineCache();
+    checkOutlineMatchesPixels(copy);
+}
+
+void KisPixelSelectionTest::testSimplifiedOutline()
+{
+    KisPixelSelectionSP psel = new KisPixelSelection();
+
+    psel->select(QRect(11, 11, 200, 100), MAX_SELECTED);
+    psel->select(QRect(300, 300, 2, 2), MAX_SELECTED);
+
+    psel->invalidateOutlineCache();
+    psel->recalculateOutlineCache();
+
+    QCOMPARE(psel->simplifiedOutlineCache(0), psel->outlineCache());
+    QCOMPARE(psel->simplifiedOutlineCache(0).boundingRect(), QRectF(11, 11, 291, 291));
+
+    // the vertices are snapped to the grid of 8 pixels and the tiny island disappears
+    QCOMPARE(psel->simplifiedOutlineCache(3).boundingRect(), QRectF(8, 8, 200, 104));
+
+    // the outline updated in place has no simplified versions
+    psel->select(QRect(400, 400, 10, 10), MAX_SELECTED);
+    QCOMPARE(psel->simplifiedOutlineCache(3), psel->outlineCache());
+}
+
 QTEST_MAIN(KisPixelSelectionTest)
 
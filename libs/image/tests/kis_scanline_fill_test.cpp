@@ -30,6 +30,7 @@
 #include <KoColorSpaceRegistry.h>
 #include "kis_types.h"
 #include "kis_paint_device.h"
+#include "kis_pixel_selection.h"
 
 
 void KisScanlineFillTest::testFillGeneral(const QVector<KisFillInterval> &initialBackwardIntervals,
@@ -295,4 +296,141 @@ void KisScanlineFillTest::testExternalFill()
     QCOMPARE(c, QColor(Qt::blue));
 }
 
+static KisPaintDeviceSP createNoiseDevice(const QRect &rc)
+{
+    KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+
+    const KoColor black(Qt::black, dev->colorSpace());
+    const KoColor white(Qt::white, dev->colorSpace());
+
+    dev->fill(rc, white);
+
+    /**
+     * Random noise makes lots of areas of weird shapes crossing
+     * the borders of the blocks of the parallel fill
+     */
+    srand(1234);
+
+    for (int y = rc.top(); y <= rc.bottom(); y++) {
+        for (int x = rc.left(); x <= rc.right(); x++) {
+            if (rand() % 100 < 38) {
+                dev->setPixel(x, y, black);
+            }
+        }
+    }
+
+    return dev;
+}
+
+void KisScanlineFillTest::testParallelFillSelection()
+{
+    const QRect boundingRect(-300, -200, 700, 600);
+    const QPoint startPoint(10, 10);
+
+    KisPaintDeviceSP dev = createNoiseDevice(boundingRect);
+    dev->setPixel(startPoint.x(), startPoint.y(), KoColor(Qt::white, dev->colorSpace()));
+
+    KisPixelSelectionSP serialSelection = new KisPixelSelection();
+    KisPixelSelectionSP parallelSelection = new KisPixelSelection();
+
+    // the blocks should follow the tiles of the destination, not the image
+    parallelSelection->setX(23);
+    parallelSelection->setY(-41);
+
+    {
+        KisScanlineFill fill(dev, startPoint, boundingRect);
+        fill.setThreshold(100);
+        fill.setParallelMode(KisScanlineFill::ParallelNever);
+        fill.fillSelection(serialSelection);
+    }
+
+    {
+        KisScanlineFill fill(dev, startPoint, boundingRect);
+        fill.setThreshold(100);
+        fill.setParallelMode(KisScanlineFill::ParallelAlways);
+        fill.fillSelection(parallelSelection);
+    }
+
+    QVERIFY(!serialSelection->selectedExactRect().isEmpty());
+    QCOMPARE(parallelSelection->selectedExactRect(), serialSelection->selectedExactRect());
+
+    QPoint errpoint;
+    QImage serialImage = serialSelection->convertToQImage(0, boundingRect);
+    QImage parallelImage = parallelSelection->convertToQImage(0, boundingRect);
+
+    if (!TestUtil::compareQImages(errpoint, serialImage, parallelImage)) {
+        serialImage.save("parallel_fill_selection_expected.png");
+        parallelImage.save("parallel_fill_selection_result.png");
+        QFAIL(QString("Parallel fill differs from the serial one at point %1,%2")
+              .arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+    }
+}
+
+void KisScanlineFillTest::testParallelFillColor()
+{
+    const QRect boundingRect(-300, -200, 700, 600);
+    const QPoint startPoint(10, 10);
+
+    KisPaintDeviceSP serialDev = createNoiseDevice(boundingRect);
+    serialDev->setPixel(startPoint.x(), startPoint.y(), KoColor(Qt::white, serialDev->colorSpace()));
+    KisPaintDeviceSP parallelDev = new KisPaintDevice(*serialDev);
+
+    const KoColor fillColor(Qt::blue, serialDev->colorSpace());
+
+    {
+        KisScanlineFill fill(serialDev, startPoint, boundingRect);
+        fill.setParallelMode(KisScanlineFill::ParallelNever);
+        fill.fillColor(fillColor);
+    }
+
+    {
+        KisScanlineFill fill(parallelDev, startPoint, boundingRect);
+        fill.setParallelMode(KisScanlineFill::ParallelAlways);
+        fill.fillColor(fillColor);
+    }
+
+    QColor c;
+    parallelDev->pixel(startPoint.x(), startPoint.y(), &c);
+    QCOMPARE(c, QColor(Qt::blue));
+
+    QPoint errpoint;
+    QImage serialImage = serialDev->convertToQImage(0, boundingRect);
+    QImage parallelImage = parallelDev->convertToQImage(0, boundingRect);
+
+    if (!TestUtil::compareQImages(errpoint, serialImage, parallelImage)) {
+        serialImage.save("parallel_fill_color_expected.png");
+        parallelImage.save("parallel_fill_color_result.png");
+        QFAIL(QString("Parallel fill differs from the serial one at point %1,%2")
+              .arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+    }
+}
+
+void KisScanlineFillTest::testParallelFillTouchesReachedTilesOnly()
+{
+    const QRect boundingRect(-3000, -3000, 6000, 6000);
+    const QPoint startPoint(50, 50);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+    dev->fill(QRect(0, 0, 100, 100), KoColor(Qt::black, dev->colorSpace()));
+    dev->fill(QRect(10, 10, 80, 80), KoColor(Qt::white, dev->colorSpace()));
+
+    const QRect extentBefore = dev->extent();
+
+    {
+        KisScanlineFill fill(dev, startPoint, boundingRect);
+        fill.setParallelMode(KisScanlineFill::ParallelAlways);
+        fill.fillColor(KoColor(Qt::blue, dev->colorSpace()));
+    }
+
+    // the blocks the fill cannot reach should not even be read
+    QCOMPARE(dev->extent(), extentBefore);
+
+    QColor c;
+    dev->pixel(startPoint.x(), startPoint.y(), &c);
+    QCOMPARE(c, QColor(Qt::blue));
+
+    dev->pixel(5, 5, &c);
+    QCOMPARE(c, QColor(Qt::black));
+}
+
 QTEST_MAIN(KisScanlineFillTest)
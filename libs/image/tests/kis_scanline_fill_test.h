@@ -39,6 +39,10 @@ private Q_SLOTS:
     void testClearNonZeroComponent();
     void testExternalFill();
 
+    void testParallelFillSelection();
+    void testParallelFillColor();
+    void testParallelFillTouchesReachedTilesOnly();
+
 private:
     void testFillGeneral(const QVector<KisFillInterval> &initialBackwardIntervals,
                          const QVector<QColor> &expectedResult,
@@ -0,0 +1,159 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "kis_scatter_writer_test.h"
+
+#include <QTest>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoCompositeOpRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_random_accessor_ng.h"
+#include "kis_scatter_writer.h"
+
+
+struct TestSample {
+    int x;
+    int y;
+    quint8 color[4];
+    quint8 opacity;
+};
+
+QVector<TestSample> generateSamples(const QRect &rect, int numSamples)
+{
+    QVector<TestSample> samples;
+
+    srand(31337);
+    for (int i = 0; i < numSamples; i++) {
+        TestSample s;
+        s.x = rect.x() + rand() % rect.width();
+        s.y = rect.y() + rand() % rect.height();
+        for (int c = 0; c < 4; c++) {
+            s.color[c] = rand() % 256;
+        }
+        s.opacity = rand() % 256;
+        samples << s;
+
+        // some samples hit the same pixel
+        if (i % 5 == 0) {
+            s.color[3] = rand() % 256;
+            s.opacity = rand() % 256;
+            samples << s;
+        }
+    }
+
+    return samples;
+}
+
+void writeReferenceSample(KisPaintDeviceSP dev, KisRandomAccessorSP accessor,
+                          KisScatterWriter::Mode mode, const TestSample &s)
+{
+    const KoColorSpace *cs = dev->colorSpace();
+
+    accessor->moveTo(s.x, s.y);
+    quint8 *dst = accessor->rawData();
+
+    switch (mode) {
+    case KisScatterWriter::Replace:
+        memcpy(dst, s.color, cs->pixelSize());
+        break;
+    case KisScatterWriter::AccumulateOpacity: {
+        const quint8 opacity = qMin(255, s.opacity + cs->opacityU8(dst));
+        memcpy(dst, s.color, cs->pixelSize());
+        cs->setOpacity(dst, opacity, 1);
+        break;
+    }
+    case KisScatterWriter::MaxOpacity:
+        if (cs->opacityU8(dst) < cs->opacityU8(s.color)) {
+            memcpy(dst, s.color, cs->pixelSize());
+        }
+        break;
+    case KisScatterWriter::Composite:
+        cs->compositeOp(COMPOSITE_OVER)->composite(dst, 0, s.color, 0, 0, 0, 1, 1, s.opacity);
+        break;
+    }
+}
+
+void testWriterImpl(KisScatterWriter::Mode mode, const QPoint &deviceOffset = QPoint())
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // the area covers the tiles on both sides of the origin
+    const QRect rect(-100, -70, 300, 200);
+    const QVector<TestSample> samples = generateSamples(rect, 5000);
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->setX(deviceOffset.x());
+    dev->setY(deviceOffset.y());
+    dev->fill(rect, KoColor(QColor(10, 200, 30, 100), cs));
+
+    KisPaintDeviceSP refDev = new KisPaintDevice(*dev);
+
+    KisScatterWriter writer(dev, mode);
+    if (mode == KisScatterWriter::Composite) {
+        writer.setCompositeOp(cs->compositeOp(COMPOSITE_OVER), KoCompositeOp::ParameterInfo());
+    }
+
+    KisRandomAccessorSP accessor = refDev->createRandomAccessorNG(0, 0);
+
+    Q_FOREACH (const TestSample &s, samples) {
+        writer.addSample(s.x, s.y, s.color, s.opacity);
+        writeReferenceSample(refDev, accessor, mode, s);
+    }
+
+    QCOMPARE(writer.numPendingSamples(), samples.size());
+    writer.flush();
+    QCOMPARE(writer.numPendingSamples(), 0);
+
+    const QRect checkRect = rect.adjusted(-1, -1, 1, 1);
+    QVector<quint8> result(checkRect.width() * checkRect.height() * cs->pixelSize());
+    QVector<quint8> expected(result.size());
+
+    dev->readBytes(result.data(), checkRect);
+    refDev->readBytes(expected.data(), checkRect);
+
+    QVERIFY(result == expected);
+}
+
+void KisScatterWriterTest::testReplace()
+{
+    testWriterImpl(KisScatterWriter::Replace);
+}
+
+void KisScatterWriterTest::testAccumulateOpacity()
+{
+    testWriterImpl(KisScatterWriter::AccumulateOpacity);
+}
+
+void KisScatterWriterTest::testMaxOpacity()
+{
+    testWriterImpl(KisScatterWriter::MaxOpacity);
+}
+
+void KisScatterWriterTest::testComposite()
+{
+    testWriterImpl(KisScatterWriter::Composite);
+}
+
+void KisScatterWriterTest::testDeviceOffset()
+{
+    testWriterImpl(KisScatterWriter::AccumulateOpacity, QPoint(13, -37));
+}
+
+QTEST_MAIN(KisScatterWriterTest)
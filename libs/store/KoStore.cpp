@@ -32,6 +32,8 @@
 #include <QUrl>
 #include <StoreDebug.h>
 
+#include <limits>
+
 #define DefaultFormat KoStore::Zip
 
 static KoStore::Backend determineBackend(QIODevice *dev)
@@ -148,10 +150,18 @@ bool KoStore::open(const QString & _name)
         d->size = 0;
         if (!openWrite(d->fileName))
             return false;
+
+        if (d->calculateChecksums) {
+            d->writeHash.reset(new QCryptographicHash(QCryptographicHash::Sha1));
+        }
     } else if (d->mode == Read) {
         debugStore << "Opening for reading" << d->fileName;
         if (!openRead(d->fileName))
             return false;
+
+        if (d->calculateChecksums && d->stream) {
+            d->stream = new KoStoreChecksumDevice(d->stream);
+        }
     } else
         return false;
 
@@ -175,6 +185,13 @@ bool KoStore::close()
         return false;
     }
 
+    if (d->writeHash) {
+        d->checksums.insert(d->fileName, d->writeHash->result());
+        d->writeHash.reset();
+    } else if (KoStoreChecksumDevice *checksumDevice = dynamic_cast<KoStoreChecksumDevice*>(d->stream)) {
+        d->checksums.insert(d->fileName, checksumDevice->finish());
+    }
+
     bool ret = d->mode == Write ? closeWrite() : closeRead();
 
     delete d->stream;
@@ -247,6 +264,7 @@ qint64 KoStore::write(const char* _data, qint64 _len)
     int nwritten = d->stream->write(_data, _len);
     Q_ASSERT(nwritten == (int)_len);
     d->size += nwritten;
+    d->addWrittenData(_data, nwritten);
 
     return nwritten;
 }
@@ -354,6 +372,100 @@ bool KoStorePrivate::extractFile(const QString &srcName, QIODevice &buffer)
     return true;
 }
 
+void KoStorePrivate::addWrittenData(const char *data, qint64 length)
+{
+    if (writeHash && length > 0) {
+        writeHash->addData(data, int(length));
+    }
+}
+
+KoStoreChecksumDevice::KoStoreChecksumDevice(QIODevice *device)
+    : m_device(device),
+      m_hash(QCryptographicHash::Sha1),
+      m_hashedSize(0)
+{
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+KoStoreChecksumDevice::~KoStoreChecksumDevice()
+{
+    delete m_device;
+}
+
+bool KoStoreChecksumDevice::seek(qint64 pos)
+{
+    if (pos > m_hashedSize && !hashUpTo(pos)) {
+        return false;
+    }
+
+    return QIODevice::seek(pos) && m_device->seek(pos);
+}
+
+qint64 KoStoreChecksumDevice::size() const
+{
+    return m_device->size();
+}
+
+bool KoStoreChecksumDevice::atEnd() const
+{
+    return pos() >= size();
+}
+
+QByteArray KoStoreChecksumDevice::finish()
+{
+    hashUpTo(std::numeric_limits<qint64>::max());
+    return m_hash.result();
+}
+
+bool KoStoreChecksumDevice::hashUpTo(qint64 pos)
+{
+    if (m_device->pos() != m_hashedSize && !m_device->seek(m_hashedSize)) {
+        return false;
+    }
+
+    char buffer[8 * 1024];
+
+    while (m_hashedSize < pos) {
+        const qint64 bytesRead = m_device->read(buffer, qMin(qint64(sizeof(buffer)), pos - m_hashedSize));
+        if (bytesRead <= 0) break;
+
+        m_hash.addData(buffer, int(bytesRead));
+        m_hashedSize += bytesRead;
+    }
+
+    return m_hashedSize >= pos;
+}
+
+qint64 KoStoreChecksumDevice::readData(char *data, qint64 maxSize)
+{
+    const qint64 start = pos();
+
+    if (m_device->pos() != start && !m_device->seek(start)) {
+        return -1;
+    }
+
+    const qint64 bytesRead = m_device->read(data, maxSize);
+
+    /**
+     * seek() never jumps over the data that has not been hashed yet,
+     * so only the tail of the block can be new
+     */
+    if (bytesRead > 0 && start + bytesRead > m_hashedSize) {
+        const qint64 offset = m_hashedSize - start;
+        m_hash.addData(data + offset, int(bytesRead - offset));
+        m_hashedSize = start + bytesRead;
+    }
+
+    return bytesRead;
+}
+
+qint64 KoStoreChecksumDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
 bool KoStore::seek(qint64 pos)
 {
     Q_D(KoStore);
@@ -415,6 +527,18 @@ void KoStore::setCompressionEnabled(bool /*e*/)
 {
 }
 
+void KoStore::setCalculateChecksums(bool value)
+{
+    Q_D(KoStore);
+    d->calculateChecksums = value;
+}
+
+QMap<QString, QByteArray> KoStore::checksums() const
+{
+    Q_D(const KoStore);
+    return d->checksums;
+}
+
 bool KoStore::isEncrypted()
 {
     return false;
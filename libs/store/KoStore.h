@@ -23,6 +23,7 @@
 
 #include <QByteArray>
 #include <QIODevice>
+#include <QMap>
 #include "kritastore_export.h"
 
 class QWidget;
@@ -284,6 +285,19 @@ public:
      */
     virtual void setCompressionEnabled(bool e);
 
+    /**
+     * Makes the store calculate the SHA1 checksum of every file opened
+     * after this call. The files being read are always hashed entirely,
+     * even if they are read only partially or with seeking.
+     */
+    void setCalculateChecksums(bool value);
+
+    /**
+     * @return the checksums of all the files closed since the checksums
+     * were enabled, mapped by their names in the store
+     */
+    QMap<QString, QByteArray> checksums() const;
+
 protected:
     KoStore(Mode mode, bool writeMimetype = true);
 
@@ -25,11 +25,47 @@
 
 #include <QStringList>
 #include <QStack>
+#include <QCryptographicHash>
+#include <QScopedPointer>
 
 #include <QUrl>
 
 class QWidget;
 
+/**
+ * Forwards the reading to another device and calculates the checksum of
+ * the whole content of that device. Seeking back doesn't hash the data
+ * twice and seeking forward hashes the skipped data, so the checksum
+ * doesn't depend on the way the file is read.
+ */
+class KoStoreChecksumDevice : public QIODevice
+{
+public:
+    KoStoreChecksumDevice(QIODevice *device);
+    ~KoStoreChecksumDevice() override;
+
+    bool seek(qint64 pos) override;
+    qint64 size() const override;
+    bool atEnd() const override;
+
+    /**
+     * Hashes the rest of the source device and returns the checksum
+     */
+    QByteArray finish();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    bool hashUpTo(qint64 pos);
+
+private:
+    QIODevice *m_device;
+    QCryptographicHash m_hash;
+    qint64 m_hashedSize;
+};
+
 class KoStorePrivate
 {
 public:
@@ -69,6 +105,9 @@ public:
 
     bool extractFile(const QString &sourceName, QIODevice &buffer);
 
+    /// Called by the backends for every block of data written into the current file
+    void addWrittenData(const char *data, qint64 length);
+
     KoStore *q;
     /**
      * original URL of the remote file
@@ -102,6 +141,11 @@ public:
     QStack<QString> directoryStack;
 
     bool writeMimetype; ///< true if the backend is allowed to create "mimetype" automatically.
+
+    bool calculateChecksums = false;
+    QMap<QString, QByteArray> checksums;
+    /// The checksum of the file currently opened for writing
+    QScopedPointer<QCryptographicHash> writeHash;
 };
 
 #endif
@@ -211,8 +211,10 @@ qint64 KoZipStore::write(const char* _data, qint64 _len)
     }
 
     d->size += _len;
-    if (m_pZip->writeData(_data, _len))     // writeData returns a bool!
+    if (m_pZip->writeData(_data, _len)) {   // writeData returns a bool!
+        d->addWrittenData(_data, _len);
         return _len;
+    }
     return 0;
 }
 
@@ -31,6 +31,7 @@
 #include <QDesktopWidget>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QLocale>
 #include <QMessageBox>
 #include <QMessageBox>
@@ -61,6 +62,7 @@
 #include "thememanager.h"
 #include "KisPrintJob.h"
 #include "KisDocument.h"
+#include "KisBatchConverter.h"
 #include "KisMainWindow.h"
 #include "KisAutoSaveRecoveryDialog.h"
 #include "KisPart.h"
@@ -462,24 +464,8 @@ bool KisApplication::start(const KisApplicationArguments &args)
             else {
 
                 if (exportAs) {
-                    QString outputMimetype = KisMimeDatabase::mimeTypeForFile(exportFileName);
-                    if (outputMimetype == "application/octetstream") {
-                        dbgKrita << i18n("Mimetype not found, try using the -mimetype option") << endl;
-                        return 1;
-                    }
-
-                    KisDocument *doc = KisPart::instance()->createDocument();
-                    doc->setFileBatchMode(m_batchRun);
-                    doc->openUrl(QUrl::fromLocalFile(fileName));
-
-                    qApp->processEvents(); // For vector layers to be updated
-
-                    doc->setFileBatchMode(true);
-                    if (!doc->exportDocumentSync(QUrl::fromLocalFile(exportFileName), outputMimetype.toLatin1())) {
-                        dbgKrita << "Could not export " << fileName << "to" << exportFileName << ":" << doc->errorMessage();
-                    }
-                    nPrinted++;
-                    QTimer::singleShot(0, this, SLOT(quit()));
+                    // all the files are exported at once after the loop
+                    continue;
                 }
                 else if (m_mainWindow) {
                     KisMainWindow::OpenFlags flags = m_batchRun ? KisMainWindow::BatchMode : KisMainWindow::None;
@@ -507,6 +493,54 @@ bool KisApplication::start(const KisApplicationArguments &args)
             }
         }
 
+        if (exportAs) {
+            QString outputMimetype = KisMimeDatabase::mimeTypeForFile(exportFileName);
+            if (outputMimetype == "application/octetstream") {
+                dbgKrita << i18n("Mimetype not found, try using the -mimetype option") << endl;
+                return 1;
+            }
+
+            KisBatchConverter converter;
+            if (args.exportJobs() > 0) {
+                converter.setMaxParallelJobs(args.exportJobs());
+            }
+
+            const QFileInfo exportFileInfo(exportFileName);
+
+            Q_FOREACH (const QString &fileName, args.filenames()) {
+                QString outputFileName = exportFileName;
+
+                if (argsCount > 1) {
+                    outputFileName =
+                        exportFileInfo.absoluteDir().absoluteFilePath(
+                            QFileInfo(fileName).completeBaseName() + "." + exportFileInfo.suffix());
+                }
+
+                converter.addJob(KisBatchConverter::Job(fileName, outputFileName, outputMimetype.toLatin1()));
+            }
+
+            converter.run();
+
+            Q_FOREACH (const KisBatchConverter::Result &result, converter.results()) {
+                if (result.isSuccess()) {
+                    nPrinted++;
+                } else {
+                    dbgKrita << "Could not export " << result.job.inputFile << "to" << result.job.outputFile << ":" << result.errorMessage;
+                }
+            }
+
+            if (!args.exportSummaryFileName().isEmpty()) {
+                QFile summaryFile(args.exportSummaryFileName());
+                if (summaryFile.open(QIODevice::WriteOnly)) {
+                    summaryFile.write(converter.summaryJson());
+                } else {
+                    dbgKrita << "Could not write the export summary to" << args.exportSummaryFileName();
+                }
+            }
+
+            QTimer::singleShot(0, this, SLOT(quit()));
+        }
+
         if (m_batchRun) {
             return nPrinted > 0;
         }
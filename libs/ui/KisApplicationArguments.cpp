@@ -39,6 +39,7 @@ struct Q_DECL_HIDDEN KisApplicationArguments::Private
         , print(false)
         , exportAs(false)
         , exportAsPdf(false)
+        , exportJobs(0)
     {
     }
 
@@ -50,6 +51,8 @@ struct Q_DECL_HIDDEN KisApplicationArguments::Private
     bool exportAs;
     bool exportAsPdf;
     QString exportFileName;
+    int exportJobs;
+    QString exportSummaryFileName;
 };
 
 KisApplicationArguments::KisApplicationArguments(const QApplication &app)
@@ -63,7 +66,9 @@ KisApplicationArguments::KisApplicationArguments(const QApplication &app)
     parser.addOption(QCommandLineOption(QStringList() << QLatin1String("dpi"), i18n("Override display DPI"), QLatin1String("dpiX,dpiY")));
     parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-pdf"), i18n("Only export to PDF and exit")));
     parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export"), i18n("Export to the given filename and exit")));
-    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-filename"), i18n("Filename for export/export-pdf"), QLatin1String("filename")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-filename"), i18n("Filename for export/export-pdf. When exporting several files, its directory and extension define where and in which format the files are exported"), QLatin1String("filename")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-jobs"), i18n("Number of files to export in parallel"), QLatin1String("number")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("export-summary"), i18n("Write a JSON summary with the status and timings of every exported file"), QLatin1String("filename")));
     parser.addPositionalArgument(QLatin1String("[file(s)]"), i18n("File(s) or URL(s) to open"));
     parser.process(app);
 
@@ -93,6 +98,8 @@ KisApplicationArguments::KisApplicationArguments(const QApplication &app)
     d->exportAs = parser.isSet("export");
     d->exportAsPdf = parser.isSet("export-pdf");
     d->exportFileName = parser.value("export-filename");
+    d->exportJobs = parser.value("export-jobs").toInt();
+    d->exportSummaryFileName = parser.value("export-summary");
 }
 
 KisApplicationArguments::KisApplicationArguments(const KisApplicationArguments &rhs)
@@ -106,6 +113,8 @@ KisApplicationArguments::KisApplicationArguments(const KisApplicationArguments &
     d->exportAs = rhs.exportAs();
     d->exportAsPdf = rhs.exportAsPdf();
     d->exportFileName = rhs.exportFileName();
+    d->exportJobs = rhs.exportJobs();
+    d->exportSummaryFileName = rhs.exportSummaryFileName();
 }
 
 KisApplicationArguments::~KisApplicationArguments()
@@ -122,6 +131,8 @@ void KisApplicationArguments::operator=(const KisApplicationArguments &rhs)
     d->exportAs = rhs.exportAs();
     d->exportAsPdf = rhs.exportAsPdf();
     d->exportFileName = rhs.exportFileName();
+    d->exportJobs = rhs.exportJobs();
+    d->exportSummaryFileName = rhs.exportSummaryFileName();
 }
 
 QByteArray KisApplicationArguments::serialize()
@@ -142,6 +153,8 @@ QByteArray KisApplicationArguments::serialize()
     ds << d->exportAs;
     ds << d->exportAsPdf;
     ds << d->exportFileName;
+    ds << d->exportJobs;
+    ds << d->exportSummaryFileName;
 
     buf.close();
 
@@ -170,6 +183,8 @@ KisApplicationArguments KisApplicationArguments::deserialize(QByteArray &seriali
     ds >> args.d->exportAs;
     ds >> args.d->exportAsPdf;
     ds >> args.d->exportFileName;
+    ds >> args.d->exportJobs;
+    ds >> args.d->exportSummaryFileName;
 
     buf.close();
 
@@ -216,6 +231,16 @@ QString KisApplicationArguments::exportFileName() const
     return d->exportFileName;
 }
 
+int KisApplicationArguments::exportJobs() const
+{
+    return d->exportJobs;
+}
+
+QString KisApplicationArguments::exportSummaryFileName() const
+{
+    return d->exportSummaryFileName;
+}
+
 KisApplicationArguments::KisApplicationArguments()
     : d(new Private)
 {
@@ -48,6 +48,8 @@ public:
     bool exportAs() const;
     bool exportAsPdf() const;
     QString exportFileName() const;
+    int exportJobs() const;
+    QString exportSummaryFileName() const;
 
 private:
 
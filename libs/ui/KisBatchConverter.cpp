@@ -0,0 +1,253 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisBatchConverter.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+
+#include "KisDocument.h"
+#include "KisPart.h"
+#include "kis_image.h"
+#include "kis_memory_statistics_server.h"
+#include "kis_debug.h"
+
+
+struct KisBatchConverter::Private
+{
+    struct RunningJob {
+        int resultIndex = -1;
+        QElapsedTimer exportTimer;
+    };
+
+    QList<Job> pendingJobs;
+    QVector<Result> results;
+    QHash<KisDocument*, RunningJob> runningJobs;
+
+    int maxParallelJobs = QThread::idealThreadCount();
+    qint64 wallTime = 0;
+    QEventLoop *eventLoop = 0;
+
+    bool tilesMemoryBudgetExceeded() const;
+    void finishJob(KisDocument *doc, KisImportExportFilter::ConversionStatus status, const QString &errorMessage);
+};
+
+bool KisBatchConverter::Private::tilesMemoryBudgetExceeded() const
+{
+    /**
+     * All the documents share the same tile data store, so we just
+     * check if the tiles already consume more than the user allowed
+     * them to before the swapper starts to kick in
+     */
+    KisMemoryStatisticsServer::Statistics stats =
+        KisMemoryStatisticsServer::instance()->fetchMemoryStatistics(0);
+
+    return stats.realMemorySize > stats.tilesSoftLimit;
+}
+
+void KisBatchConverter::Private::finishJob(KisDocument *doc, KisImportExportFilter::ConversionStatus status, const QString &errorMessage)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(runningJobs.contains(doc));
+
+    RunningJob runningJob = runningJobs.take(doc);
+
+    Result &result = results[runningJob.resultIndex];
+    result.status = status;
+    result.errorMessage = errorMessage;
+    result.exportTime = runningJob.exportTimer.elapsed();
+
+    doc->deleteLater();
+}
+
+KisBatchConverter::KisBatchConverter(QObject *parent)
+    : QObject(parent),
+      m_d(new Private)
+{
+}
+
+KisBatchConverter::~KisBatchConverter()
+{
+}
+
+void KisBatchConverter::addJob(const Job &job)
+{
+    m_d->pendingJobs.append(job);
+}
+
+void KisBatchConverter::setMaxParallelJobs(int value)
+{
+    m_d->maxParallelJobs = qMax(1, value);
+}
+
+int KisBatchConverter::maxParallelJobs() const
+{
+    return m_d->maxParallelJobs;
+}
+
+bool KisBatchConverter::run()
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(!m_d->eventLoop, false);
+
+    m_d->results.clear();
+
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+
+    QEventLoop loop;
+    m_d->eventLoop = &loop;
+
+    QTimer::singleShot(0, this, SLOT(slotStartPendingJobs()));
+    loop.exec();
+
+    m_d->eventLoop = 0;
+    m_d->wallTime = wallTimer.elapsed();
+
+    bool allSucceeded = true;
+    Q_FOREACH (const Result &result, m_d->results) {
+        allSucceeded &= result.isSuccess();
+    }
+
+    return allSucceeded;
+}
+
+void KisBatchConverter::slotStartPendingJobs()
+{
+    while (!m_d->pendingJobs.isEmpty() &&
+           m_d->runningJobs.size() < m_d->maxParallelJobs) {
+
+        /**
+         * If the tiles have already eaten all the memory, wait until one
+         * of the running jobs completes and releases its document
+         */
+        if (!m_d->runningJobs.isEmpty() && m_d->tilesMemoryBudgetExceeded()) {
+            break;
+        }
+
+        Result result;
+        result.job = m_d->pendingJobs.takeFirst();
+
+        QElapsedTimer loadTimer;
+        loadTimer.start();
+
+        KisDocument *doc = KisPart::instance()->createDocument();
+        doc->setFileBatchMode(true);
+
+        const bool loaded = doc->openUrl(QUrl::fromLocalFile(result.job.inputFile));
+
+        if (loaded) {
+            qApp->processEvents(); // For vector layers to be updated
+            doc->image()->waitForDone();
+        }
+
+        result.loadTime = loadTimer.elapsed();
+
+        if (!loaded) {
+            result.status = doc->importStatus();
+            result.errorMessage = doc->errorMessage();
+            delete doc;
+
+            m_d->results.append(result);
+            emit sigJobFinished(result);
+            continue;
+        }
+
+        Private::RunningJob runningJob;
+        runningJob.resultIndex = m_d->results.size();
+        runningJob.exportTimer.start();
+
+        m_d->results.append(result);
+        m_d->runningJobs.insert(doc, runningJob);
+
+        connect(doc, SIGNAL(sigCompleteBackgroundSaving(KritaUtils::ExportFileJob, KisImportExportFilter::ConversionStatus, QString)),
+                this, SLOT(slotExportCompleted(KritaUtils::ExportFileJob, KisImportExportFilter::ConversionStatus, QString)));
+
+        if (!doc->exportDocument(QUrl::fromLocalFile(result.job.outputFile), result.job.mimeType)) {
+            m_d->finishJob(doc, KisImportExportFilter::CreationError, doc->errorMessage());
+            emit sigJobFinished(m_d->results[runningJob.resultIndex]);
+        }
+    }
+
+    if (m_d->pendingJobs.isEmpty() && m_d->runningJobs.isEmpty()) {
+        emit sigAllJobsFinished();
+
+        if (m_d->eventLoop) {
+            m_d->eventLoop->quit();
+        }
+    }
+}
+
+void KisBatchConverter::slotExportCompleted(const KritaUtils::ExportFileJob &job, KisImportExportFilter::ConversionStatus status, const QString &errorMessage)
+{
+    Q_UNUSED(job);
+
+    KisDocument *doc = qobject_cast<KisDocument*>(sender());
+    KIS_SAFE_ASSERT_RECOVER_RETURN(doc && m_d->runningJobs.contains(doc));
+
+    const int resultIndex = m_d->runningJobs[doc].resultIndex;
+    m_d->finishJob(doc, status, errorMessage);
+    emit sigJobFinished(m_d->results[resultIndex]);
+
+    QTimer::singleShot(0, this, SLOT(slotStartPendingJobs()));
+}
+
+QVector<KisBatchConverter::Result> KisBatchConverter::results() const
+{
+    return m_d->results;
+}
+
+QByteArray KisBatchConverter::summaryJson() const
+{
+    QJsonArray jobs;
+    int numFailed = 0;
+
+    Q_FOREACH (const Result &result, m_d->results) {
+        QJsonObject object;
+        object["input"] = result.job.inputFile;
+        object["output"] = result.job.outputFile;
+        object["mimetype"] = QString::fromLatin1(result.job.mimeType);
+        object["success"] = result.isSuccess();
+        object["loadTimeMs"] = result.loadTime;
+        object["exportTimeMs"] = result.exportTime;
+
+        if (!result.isSuccess()) {
+            object["error"] = !result.errorMessage.isEmpty() ?
+                result.errorMessage :
+                KisImportExportFilter::conversionStatusString(result.status);
+            numFailed++;
+        }
+
+        jobs.append(object);
+    }
+
+    QJsonObject summary;
+    summary["jobs"] = jobs;
+    summary["total"] = m_d->results.size();
+    summary["failed"] = numFailed;
+    summary["parallelJobs"] = m_d->maxParallelJobs;
+    summary["wallTimeMs"] = m_d->wallTime;
+
+    return QJsonDocument(summary).toJson();
+}
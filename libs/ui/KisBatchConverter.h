@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISBATCHCONVERTER_H
+#define KISBATCHCONVERTER_H
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QVector>
+
+#include "KisImportExportFilter.h"
+#include "KisImportExportUtils.h"
+#include "kritaui_export.h"
+
+
+/**
+ * KisBatchConverter converts a list of documents into other formats
+ * without any user interaction (e.g. for "krita --export").
+ *
+ * Loading of the documents happens in the GUI thread one-by-one (the
+ * import filters cannot be run asynchronously), but saving is started
+ * in background, so up to maxParallelJobs() documents are being encoded
+ * at the same time. All the documents share the same tile data store,
+ * so a new document is not loaded while the memory consumed by the tiles
+ * is above the soft limit set up in the preferences.
+ *
+ * After the conversion, the timings and the status of every job are
+ * available via results() and summaryJson().
+ */
+class KRITAUI_EXPORT KisBatchConverter : public QObject
+{
+    Q_OBJECT
+public:
+    struct Job {
+        Job() {}
+        Job(const QString &_inputFile, const QString &_outputFile, const QByteArray &_mimeType)
+            : inputFile(_inputFile), outputFile(_outputFile), mimeType(_mimeType)
+        {
+        }
+
+        QString inputFile;
+        QString outputFile;
+        QByteArray mimeType;
+    };
+
+    struct Result {
+        Result()
+            : status(KisImportExportFilter::OK),
+              loadTime(0),
+              exportTime(0)
+        {
+        }
+
+        bool isSuccess() const {
+            return status == KisImportExportFilter::OK;
+        }
+
+        Job job;
+        KisImportExportFilter::ConversionStatus status;
+        QString errorMessage;
+
+        qint64 loadTime;
+        qint64 exportTime;
+    };
+
+public:
+    explicit KisBatchConverter(QObject *parent = 0);
+    ~KisBatchConverter() override;
+
+    void addJob(const Job &job);
+
+    /**
+     * The maximum number of documents that are being saved in background
+     * simultaneously. By default, equal to QThread::idealThreadCount().
+     */
+    void setMaxParallelJobs(int value);
+    int maxParallelJobs() const;
+
+    /**
+     * Runs all the added jobs and blocks until all of them are
+     * completed. The events are processed while waiting.
+     *
+     * @return true if all the jobs have been completed successfully
+     */
+    bool run();
+
+    QVector<Result> results() const;
+
+    /**
+     * A machine-readable JSON summary of the last run: per-job status,
+     * error message and timings (in milliseconds), and the totals
+     */
+    QByteArray summaryJson() const;
+
+Q_SIGNALS:
+    void sigJobFinished(const KisBatchConverter::Result &result);
+    void sigAllJobsFinished();
+
+private Q_SLOTS:
+    void slotStartPendingJobs();
+    void slotExportCompleted(const KritaUtils::ExportFileJob &job, KisImportExportFilter::ConversionStatus status, const QString &errorMessage);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISBATCHCONVERTER_H
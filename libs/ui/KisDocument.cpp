@@ -282,6 +282,7 @@ public:
 
     QTimer autoSaveTimer;
     QString lastErrorMessage; // see openFile()
+    KisImportExportFilter::ConversionStatus lastImportStatus = KisImportExportFilter::OK; // see openUrl()
     QString lastWarningMessage;
     int autoSaveDelay = 300; // in seconds, 0 to disable.
     bool modifiedAfterAutosave = false;
@@ -947,14 +948,17 @@ bool KisDocument::importDocument(const QUrl &_url)
 bool KisDocument::openUrl(const QUrl &_url, OpenFlags flags)
 {
     if (!_url.isLocalFile()) {
+        d->lastImportStatus = KisImportExportFilter::FileNotFound;
         return false;
     }
     dbgUI << "url=" << _url.url();
     d->lastErrorMessage.clear();
+    d->lastImportStatus = KisImportExportFilter::OK;
 
     // Reimplemented, to add a check for autosave files and to improve error reporting
     if (!_url.isValid()) {
         d->lastErrorMessage = i18n("Malformed URL\n%1", _url.url());  // ## used anywhere ?
+        d->lastImportStatus = KisImportExportFilter::FileNotFound;
         return false;
     }
 
@@ -981,6 +985,7 @@ bool KisDocument::openUrl(const QUrl &_url, OpenFlags flags)
                 QFile::remove(asf);
                 break;
             default: // Cancel
+                d->lastImportStatus = KisImportExportFilter::UserCancelled;
                 return false;
             }
         }
@@ -988,6 +993,11 @@ bool KisDocument::openUrl(const QUrl &_url, OpenFlags flags)
 
     bool ret = openUrlInternal(url);
 
+    if (!ret && d->lastImportStatus == KisImportExportFilter::OK) {
+        // e.g. the previous document refused to be closed
+        d->lastImportStatus = KisImportExportFilter::InternalError;
+    }
+
     if (autosaveOpened || flags & RecoveryFile) {
         setReadWrite(true); // enable save button
         setModified(true);
@@ -1051,7 +1061,12 @@ bool KisDocument::openFile()
 {
     //dbgUI <<"for" << localFilePath();
     if (!QFile::exists(localFilePath())) {
-        QMessageBox::critical(0, i18nc("@title:window", "Krita"), i18n("File %1 does not exist.", localFilePath()));
+        d->lastErrorMessage = i18n("File %1 does not exist.", localFilePath());
+        d->lastImportStatus = KisImportExportFilter::FileNotFound;
+
+        if (!fileBatchMode()) {
+            QMessageBox::critical(0, i18nc("@title:window", "Krita"), d->lastErrorMessage);
+        }
         return false;
     }
 
@@ -1090,9 +1105,11 @@ bool KisDocument::openFile()
     KisImportExportFilter::ConversionStatus status;
 
     status = d->importExportManager->importDocument(localFilePath(), typeName);
+    d->lastImportStatus = status;
+
     if (status != KisImportExportFilter::OK) {
         QString msg = KisImportExportFilter::conversionStatusString(status);
-        if (!msg.isEmpty()) {
+        if (!msg.isEmpty() && !fileBatchMode()) {
             DlgLoadMessages dlg(i18nc("@title:window", "Krita"),
                                 i18n("Could not open %2.\nReason: %1.", msg, prettyPathOrUrl()),
                                 errorMessage().split("\n") + warningMessage().split("\n"));
@@ -1101,10 +1118,12 @@ bool KisDocument::openFile()
         return false;
     }
     else if (!warningMessage().isEmpty()) {
-        DlgLoadMessages dlg(i18nc("@title:window", "Krita"),
-                            i18n("There were problems opening %1.", prettyPathOrUrl()),
-                            warningMessage().split("\n"));
-        dlg.exec();
+        if (!fileBatchMode()) {
+            DlgLoadMessages dlg(i18nc("@title:window", "Krita"),
+                                i18n("There were problems opening %1.", prettyPathOrUrl()),
+                                warningMessage().split("\n"));
+            dlg.exec();
+        }
         setUrl(QUrl());
     }
 
@@ -1269,6 +1288,11 @@ QString KisDocument::errorMessage() const
     return d->lastErrorMessage;
 }
 
+KisImportExportFilter::ConversionStatus KisDocument::importStatus() const
+{
+    return d->lastImportStatus;
+}
+
 void KisDocument::setWarningMessage(const QString& warningMsg)
 {
     d->lastWarningMessage = warningMsg;
@@ -1610,7 +1634,7 @@ KisImageSP KisDocument::savingImage() const
 }
 
 
-void KisDocument::setCurrentImage(KisImageSP image)
+void KisDocument::setCurrentImage(KisImageSP image, bool waitForInitialRefresh)
 {
     if (d->image) {
         // Disconnect existing sig/slot connections
@@ -1625,7 +1649,12 @@ void KisDocument::setCurrentImage(KisImageSP image)
     d->shapeController->setImage(image);
     setModified(false);
     connect(d->image, SIGNAL(sigImageModified()), this, SLOT(setImageModified()), Qt::UniqueConnection);
-    d->image->initialRefreshGraph();
+
+    if (waitForInitialRefresh) {
+        d->image->initialRefreshGraph();
+    } else {
+        d->image->refreshGraphAsync(0, d->image->bounds(), QRect());
+    }
 }
 
 void KisDocument::setImageModified()
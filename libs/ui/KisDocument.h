@@ -210,6 +210,12 @@ public:
      */
     QString errorMessage() const;
 
+    /**
+     * Return the status of the last openUrl() call. Like errorMessage(),
+     * this is mostly provided for non-interactive use.
+     */
+    KisImportExportFilter::ConversionStatus importStatus() const;
+
     /**
      * Sets the warning message to be shown to the user (use i18n()!)
      * when loading or saving fails.
@@ -519,8 +525,13 @@ public:
 
     /**
      * Set the current image to the specified image and turn undo on.
+     *
+     * If \p waitForInitialRefresh is false, the projection of the image
+     * is expected to be already valid (e.g. it has been loaded from the
+     * merged image cache of a .kra file), so the initial recomposition
+     * of the layer stack is started in background instead of blocking.
      */
-    void setCurrentImage(KisImageSP image);
+    void setCurrentImage(KisImageSP image, bool waitForInitialRefresh = true);
 
     KisUndoStore* createUndoStore();
 
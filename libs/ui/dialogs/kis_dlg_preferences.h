@@ -78,6 +78,7 @@ public:
     int favoritePresets();
     bool showCanvasMessages();
     bool compressKra();
+    bool saveMergedImageCache();
     bool toolOptionsInDocker();
     bool switchSelectionCtrlAlt();
     bool convertToImageColorspaceOnImport();
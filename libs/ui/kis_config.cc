@@ -1656,6 +1656,16 @@ void KisConfig::setCompressKra(bool compress)
     m_cfg.writeEntry("compressLayersInKra", compress);
 }
 
+bool KisConfig::saveMergedImageCache(bool defaultValue) const
+{
+    return (defaultValue ? false : m_cfg.readEntry("saveMergedImageCacheInKra", false));
+}
+
+void KisConfig::setSaveMergedImageCache(bool value)
+{
+    m_cfg.writeEntry("saveMergedImageCacheInKra", value);
+}
+
 bool KisConfig::toolOptionsInDocker(bool defaultValue) const
 {
     return (defaultValue ? true : m_cfg.readEntry("ToolOptionsInDocker", true));
@@ -1815,6 +1825,32 @@ void KisConfig::setStabilizerDelayedPaint(bool value)
     m_cfg.writeEntry("stabilizerDelayedPaint", value);
 }
 
+bool KisConfig::strokePrediction(bool defaultValue) const
+{
+    const bool defaultEnabled = false;
+
+    return defaultValue ?
+        defaultEnabled : m_cfg.readEntry("strokePrediction", defaultEnabled);
+}
+
+void KisConfig::setStrokePrediction(bool value)
+{
+    m_cfg.writeEntry("strokePrediction", value);
+}
+
+int KisConfig::strokePredictionHorizon(bool defaultValue) const
+{
+    const int defaultHorizon = 16;
+
+    return defaultValue ?
+        defaultHorizon : m_cfg.readEntry("strokePredictionHorizon", defaultHorizon);
+}
+
+void KisConfig::setStrokePredictionHorizon(int value)
+{
+    m_cfg.writeEntry("strokePredictionHorizon", value);
+}
+
 QString KisConfig::customFFMpegPath(bool defaultValue) const
 {
     return defaultValue ? QString() : m_cfg.readEntry("ffmpegExecutablePath", QString());
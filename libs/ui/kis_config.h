@@ -483,6 +483,9 @@ public:
     bool compressKra(bool defaultValue = false) const;
     void setCompressKra(bool compress);
 
+    bool saveMergedImageCache(bool defaultValue = false) const;
+    void setSaveMergedImageCache(bool value);
+
     bool toolOptionsInDocker(bool defaultValue = false) const;
     void setToolOptionsInDocker(bool inDocker);
 
@@ -516,6 +519,12 @@ public:
     bool stabilizerDelayedPaint(bool defaultValue = false) const;
     void setStabilizerDelayedPaint(bool value);
 
+    bool strokePrediction(bool defaultValue = false) const;
+    void setStrokePrediction(bool value);
+
+    int strokePredictionHorizon(bool defaultValue = false) const;
+    void setStrokePredictionHorizon(int value);
+
     QString customFFMpegPath(bool defaultValue = false) const;
     void setCustomFFMpegPath(const QString &value) const;
 
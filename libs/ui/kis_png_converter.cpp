@@ -35,6 +35,7 @@
 #include <zlib.h>
 
 #include <QBuffer>
+#include <QVector>
 #include <QFile>
 #include <QApplication>
 
@@ -1166,89 +1167,91 @@ KisImageBuilder_Result KisPNGConverter::buildFile(QIODevice* iodevice, const QRe
     // Write the PNG
     //     png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, 0);
 
-    // Fill the data structure
-    png_byte** row_pointers = new png_byte*[imageRect.height()];
-    int row = 0;
-    for (int y = imageRect.y(); y < imageRect.y() + imageRect.height(); y++, row++) {
-        KisHLineConstIteratorSP it = device->createHLineConstIteratorNG(imageRect.x(), y, imageRect.width());
-
-        row_pointers[row] = new png_byte[imageRect.width() * device->pixelSize()];
-
-        switch (color_type) {
-        case PNG_COLOR_TYPE_GRAY:
-        case PNG_COLOR_TYPE_GRAY_ALPHA:
-            if (color_nb_bits == 16) {
-                quint16 *dst = reinterpret_cast<quint16 *>(row_pointers[row]);
-                do {
-                    const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[1];
-                } while (it->nextPixel());
-            } else {
-                quint8 *dst = row_pointers[row];
+    /**
+     * The image is written row-by-row, so we never keep more than a
+     * single converted row in memory. For the interlaced images libpng
+     * needs every row once per pass, so we just convert it again.
+     */
+    const int numPasses = options.interlace ? png_set_interlace_handling(png_ptr) : 1;
+    QVector<png_byte> rowBuffer(imageRect.width() * device->pixelSize());
+
+    for (int pass = 0; pass < numPasses; pass++) {
+        for (int y = imageRect.y(); y < imageRect.y() + imageRect.height(); y++) {
+            KisHLineConstIteratorSP it = device->createHLineConstIteratorNG(imageRect.x(), y, imageRect.width());
+            png_byte *row = rowBuffer.data();
+
+            switch (color_type) {
+            case PNG_COLOR_TYPE_GRAY:
+            case PNG_COLOR_TYPE_GRAY_ALPHA:
+                if (color_nb_bits == 16) {
+                    quint16 *dst = reinterpret_cast<quint16 *>(row);
+                    do {
+                        const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
+                        *(dst++) = d[0];
+                        if (options.alpha) *(dst++) = d[1];
+                    } while (it->nextPixel());
+                } else {
+                    quint8 *dst = row;
+                    do {
+                        const quint8 *d = it->oldRawData();
+                        *(dst++) = d[0];
+                        if (options.alpha) *(dst++) = d[1];
+                    } while (it->nextPixel());
+                }
+                break;
+            case PNG_COLOR_TYPE_RGB:
+            case PNG_COLOR_TYPE_RGB_ALPHA:
+                if (color_nb_bits == 16) {
+                    quint16 *dst = reinterpret_cast<quint16 *>(row);
+                    do {
+                        const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
+                        *(dst++) = d[2];
+                        *(dst++) = d[1];
+                        *(dst++) = d[0];
+                        if (options.alpha) *(dst++) = d[3];
+                    } while (it->nextPixel());
+                } else {
+                    quint8 *dst = row;
+                    do {
+                        const quint8 *d = it->oldRawData();
+                        *(dst++) = d[2];
+                        *(dst++) = d[1];
+                        *(dst++) = d[0];
+                        if (options.alpha) *(dst++) = d[3];
+                    } while (it->nextPixel());
+                }
+                break;
+            case PNG_COLOR_TYPE_PALETTE: {
+                quint8 *dst = row;
+                KisPNGWriteStream writestream(dst, color_nb_bits);
                 do {
                     const quint8 *d = it->oldRawData();
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[1];
+                    int i;
+                    for (i = 0; i < num_palette; i++) {
+                        if (palette[i].red == d[2] &&
+                                palette[i].green == d[1] &&
+                                palette[i].blue == d[0]) {
+                            break;
+                        }
+                    }
+                    writestream.setNextValue(i);
                 } while (it->nextPixel());
             }
-            break;
-        case PNG_COLOR_TYPE_RGB:
-        case PNG_COLOR_TYPE_RGB_ALPHA:
-            if (color_nb_bits == 16) {
-                quint16 *dst = reinterpret_cast<quint16 *>(row_pointers[row]);
-                do {
-                    const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                    *(dst++) = d[2];
-                    *(dst++) = d[1];
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[3];
-                } while (it->nextPixel());
-            } else {
-                quint8 *dst = row_pointers[row];
-                do {
-                    const quint8 *d = it->oldRawData();
-                    *(dst++) = d[2];
-                    *(dst++) = d[1];
-                    *(dst++) = d[0];
-                    if (options.alpha) *(dst++) = d[3];
-                } while (it->nextPixel());
+                break;
+            default:
+                png_destroy_write_struct(&png_ptr, &info_ptr);
+                return KisImageBuilder_RESULT_UNSUPPORTED;
             }
-            break;
-        case PNG_COLOR_TYPE_PALETTE: {
-            quint8 *dst = row_pointers[row];
-            KisPNGWriteStream writestream(dst, color_nb_bits);
-            do {
-                const quint8 *d = it->oldRawData();
-                int i;
-                for (i = 0; i < num_palette; i++) {
-                    if (palette[i].red == d[2] &&
-                            palette[i].green == d[1] &&
-                            palette[i].blue == d[0]) {
-                        break;
-                    }
-                }
-                writestream.setNextValue(i);
-            } while (it->nextPixel());
-        }
-            break;
-        default:
-            delete[] row_pointers;
-            return KisImageBuilder_RESULT_UNSUPPORTED;
+
+            png_write_row(png_ptr, row);
         }
     }
 
-    png_write_image(png_ptr, row_pointers);
-
     // Writing is over
     png_write_end(png_ptr, info_ptr);
 
     // Free memory
     png_destroy_write_struct(&png_ptr, &info_ptr);
-    for (int y = 0; y < imageRect.height(); y++) {
-        delete[] row_pointers[y];
-    }
-    delete[] row_pointers;
 
     if (color_type == PNG_COLOR_TYPE_PALETTE) {
         delete [] palette;
@@ -97,6 +97,12 @@ void KisSelectionDecoration::selectionChanged()
 
             if (m_mode == Ants) {
                 m_outlinePath = selection->outlineCache();
+
+                m_simplifiedOutlinePaths.clear();
+                for (int level = 1; level <= KisPixelSelection::maxOutlineSimplificationLevel; level++) {
+                    m_simplifiedOutlinePaths << selection->simplifiedOutlineCache(level);
+                }
+
                 m_antsTimer->start();
             } else {
                 m_thumbnailImage = selection->thumbnailImage();
@@ -112,6 +118,7 @@ void KisSelectionDecoration::selectionChanged()
     } else {
         m_signalCompressor.stop();
         m_outlinePath = QPainterPath();
+        m_simplifiedOutlinePaths.clear();
         m_thumbnailImage = QImage();
         m_thumbnailImageTransform = QTransform();
         view()->canvasBase()->updateCanvas();
@@ -182,13 +189,29 @@ void KisSelectionDecoration::drawDecoration(QPainter& gc, const QRectF& updateRe
     } else /* if (m_mode == Ants) */ {
         gc.setRenderHints(QPainter::Antialiasing | QPainter::HighQualityAntialiasing, cfg.antialiasSelectionOutline());
 
+        /**
+         * When zoomed out, paint the outline simplified to the grid
+         * not finer than one screen pixel
+         */
+        const qreal zoom = converter->effectiveZoom();
+
+        int level = 0;
+        while (level < m_simplifiedOutlinePaths.size() &&
+               zoom <= 1.0 / (2 << level)) {
+
+            level++;
+        }
+
+        const QPainterPath &outlinePath =
+            level > 0 ? m_simplifiedOutlinePaths[level - 1] : m_outlinePath;
+
         // render selection outline in white
         gc.setPen(m_outlinePen);
-        gc.drawPath(m_outlinePath);
+        gc.drawPath(outlinePath);
 
         // render marching ants in black (above the white outline)
         gc.setPen(m_antsPen);
-        gc.drawPath(m_outlinePath);
+        gc.drawPath(outlinePath);
     }
     gc.restore();
 }
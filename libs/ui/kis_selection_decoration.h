@@ -58,6 +58,7 @@ private:
 private:
     KisSignalCompressor m_signalCompressor;
     QPainterPath m_outlinePath;
+    QVector<QPainterPath> m_simplifiedOutlinePaths;
     QImage m_thumbnailImage;
     QTransform m_thumbnailImageTransform;
     QTimer* m_antsTimer;
@@ -0,0 +1,146 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_batch_converter_test.h"
+
+#include <QTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <kis_image.h>
+#include <kis_paint_device.h>
+
+#include "KisBatchConverter.h"
+#include "KisDocument.h"
+#include "KisPart.h"
+#include <qimage_test_util.h>
+
+
+void KisBatchConverterTest::testMissingFiles()
+{
+    const QString dir = QString(FILES_OUTPUT_DIR) + QDir::separator();
+
+    KisBatchConverter converter;
+    converter.setMaxParallelJobs(2);
+
+    converter.addJob(KisBatchConverter::Job(dir + "batch_missing_1.kra", dir + "batch_missing_1.png", "image/png"));
+    converter.addJob(KisBatchConverter::Job(dir + "batch_missing_2.kra", dir + "batch_missing_2.png", "image/png"));
+    converter.addJob(KisBatchConverter::Job(dir + "batch_missing_3.kra", dir + "batch_missing_3.png", "image/png"));
+
+    QVERIFY(!converter.run());
+
+    QVector<KisBatchConverter::Result> results = converter.results();
+    QCOMPARE(results.size(), 3);
+
+    Q_FOREACH (const KisBatchConverter::Result &result, results) {
+        QVERIFY(!result.isSuccess());
+        QCOMPARE(result.status, KisImportExportFilter::FileNotFound);
+        QCOMPARE(result.exportTime, qint64(0));
+    }
+
+    QJsonDocument summary = QJsonDocument::fromJson(converter.summaryJson());
+    QVERIFY(summary.isObject());
+
+    QJsonObject root = summary.object();
+    QCOMPARE(root["total"].toInt(), 3);
+    QCOMPARE(root["failed"].toInt(), 3);
+    QCOMPARE(root["parallelJobs"].toInt(), 2);
+
+    QJsonArray jobs = root["jobs"].toArray();
+    QCOMPARE(jobs.size(), 3);
+    QCOMPARE(jobs[0].toObject()["input"].toString(), dir + "batch_missing_1.kra");
+    QCOMPARE(jobs[0].toObject()["success"].toBool(), false);
+    QVERIFY(jobs[0].toObject().contains("error"));
+}
+
+void KisBatchConverterTest::testConvertKraToPng()
+{
+    const QString source = QString(FILES_DATA_DIR) + QDir::separator() + "load_test2.kra";
+    const QString dir = QString(FILES_OUTPUT_DIR) + QDir::separator();
+    const int numJobs = 4;
+
+    QImage reference;
+    {
+        QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+        doc->setFileBatchMode(true);
+        QVERIFY(doc->openUrl(QUrl::fromLocalFile(source)));
+        QCOMPARE(doc->importStatus(), KisImportExportFilter::OK);
+
+        doc->image()->waitForDone();
+        reference = doc->image()->projection()->convertToQImage(0);
+    }
+
+    KisBatchConverter converter;
+    converter.setMaxParallelJobs(3);
+
+    for (int i = 0; i < numJobs; i++) {
+        const QString output = dir + QString("batch_convert_%1.png").arg(i);
+        QFile::remove(output);
+        converter.addJob(KisBatchConverter::Job(source, output, "image/png"));
+    }
+
+    QVERIFY(converter.run());
+
+    QVector<KisBatchConverter::Result> results = converter.results();
+    QCOMPARE(results.size(), numJobs);
+
+    Q_FOREACH (const KisBatchConverter::Result &result, results) {
+        QVERIFY(result.isSuccess());
+        QCOMPARE(result.status, KisImportExportFilter::OK);
+        QVERIFY(result.loadTime >= 0);
+        QVERIFY(result.exportTime >= 0);
+
+        QImage image(result.job.outputFile);
+        QVERIFY(!image.isNull());
+        QCOMPARE(image.size(), reference.size());
+
+        QPoint pt;
+        if (!TestUtil::compareQImages(pt,
+                                      reference.convertToFormat(QImage::Format_ARGB32),
+                                      image.convertToFormat(QImage::Format_ARGB32))) {
+            QFAIL(QString("Converted image differs from the source document at point %1,%2: %3")
+                  .arg(pt.x()).arg(pt.y()).arg(result.job.outputFile).toLatin1());
+        }
+    }
+
+    QJsonDocument summary = QJsonDocument::fromJson(converter.summaryJson());
+    QVERIFY(summary.isObject());
+
+    QJsonObject root = summary.object();
+    QCOMPARE(root["total"].toInt(), numJobs);
+    QCOMPARE(root["failed"].toInt(), 0);
+    QCOMPARE(root["parallelJobs"].toInt(), 3);
+    QVERIFY(root["wallTimeMs"].toDouble() >= 0);
+
+    QJsonArray jobs = root["jobs"].toArray();
+    QCOMPARE(jobs.size(), numJobs);
+
+    for (int i = 0; i < numJobs; i++) {
+        QJsonObject job = jobs[i].toObject();
+        QCOMPARE(job["input"].toString(), source);
+        QCOMPARE(job["output"].toString(), dir + QString("batch_convert_%1.png").arg(i));
+        QCOMPARE(job["mimetype"].toString(), QString("image/png"));
+        QCOMPARE(job["success"].toBool(), true);
+        QVERIFY(job["loadTimeMs"].toDouble() >= 0);
+        QVERIFY(job["exportTimeMs"].toDouble() >= 0);
+        QVERIFY(!job.contains("error"));
+    }
+}
+
+QTEST_MAIN(KisBatchConverterTest)
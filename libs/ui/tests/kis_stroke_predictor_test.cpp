@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "kis_stroke_predictor_test.h"
+
+#include "kis_stroke_predictor.h"
+#include "kis_paint_information.h"
+
+
+KisPaintInformation eventAt(const QPointF &pos, qreal time)
+{
+    return KisPaintInformation(pos, 0.7, 0, 0, 0, 0, 1.0, time, 0);
+}
+
+void KisStrokePredictorTest::testStraightLine()
+{
+    KisStrokePredictor predictor;
+    predictor.start();
+
+    KisPaintInformation result;
+
+    // one event is not enough for a prediction
+    predictor.addEvent(eventAt(QPointF(10, 20), 0));
+    QVERIFY(!predictor.predict(10, &result));
+
+    // the pen moves right with the speed of 1 px/ms
+    for (int i = 1; i <= 20; i++) {
+        predictor.addEvent(eventAt(QPointF(10 + 5 * i, 20), 5 * i));
+    }
+
+    QVERIFY(predictor.predict(10, &result));
+
+    QCOMPARE(result.pos().y(), 20.0);
+    // the smoothed speed is a bit overestimated
+    QVERIFY(result.pos().x() > 115.0);
+    QVERIFY(result.pos().x() < 125.0);
+    QCOMPARE(result.pressure(), 0.7);
+    QCOMPARE(result.currentTime(), 110.0);
+
+    predictor.addEvent(eventAt(QPointF(115, 20), 105));
+
+    KisStrokePredictor::Statistics stats = predictor.statistics();
+    QCOMPARE(stats.numPredictions, 1);
+    QVERIFY(stats.averagePredictionError < 1.0);
+
+    // the prediction distance is limited
+    predictor.setMaxPredictionDistance(3.0);
+    QVERIFY(predictor.predict(100, &result));
+    QCOMPARE(result.pos(), QPointF(118, 20));
+}
+
+void KisStrokePredictorTest::testStandingPen()
+{
+    KisStrokePredictor predictor;
+    predictor.start();
+
+    for (int i = 0; i < 10; i++) {
+        predictor.addEvent(eventAt(QPointF(10, 20), 5 * i));
+    }
+
+    KisPaintInformation result;
+    QVERIFY(!predictor.predict(10, &result));
+}
+
+void KisStrokePredictorTest::testLatency()
+{
+    KisStrokePredictor predictor;
+    predictor.start();
+
+    QTest::qSleep(20);
+    predictor.reportEventPainted(0);
+    predictor.reportEventPainted(predictor.elapsed());
+
+    KisStrokePredictor::Statistics stats = predictor.statistics();
+    QCOMPARE(stats.numLatencySamples, 2);
+    QVERIFY(stats.maxLatency >= 20);
+    QVERIFY(stats.averageLatency >= 10);
+}
+
+QTEST_MAIN(KisStrokePredictorTest)
@@ -0,0 +1,148 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_stroke_recording_test.h"
+
+#include <QBuffer>
+#include <QTemporaryDir>
+
+#include "kis_stroke_recording.h"
+#include "kis_paint_information.h"
+
+
+void KisStrokeRecordingTest::testRoundTrip()
+{
+    KisStrokeRecording recording;
+
+    recording.startStroke(0.5);
+    recording.addEvent(KisPaintInformation(QPointF(10.5, 20.25), 0.3, 10, -20, 90, 0.1, 1.0, 0, 0));
+    recording.addEvent(KisPaintInformation(QPointF(15.5, 22.25), 0.4, 11, -21, 91, 0.2, 1.0, 8.5, 0.7));
+    recording.endStroke();
+
+    recording.startStroke(0);
+    recording.addEvent(KisPaintInformation(QPointF(100, 200), 1.0, 0, 0, 0, 0, 1.0, 1000, 0));
+    recording.endStroke();
+
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    QVERIFY(recording.save(&buffer));
+
+    buffer.seek(0);
+
+    KisStrokeRecording loaded;
+    QVERIFY(loaded.load(&buffer));
+
+    QCOMPARE(loaded.numStrokes(), 2);
+    QCOMPARE(loaded.stroke(0).startAngle, 0.5);
+    QCOMPARE(loaded.stroke(0).events.size(), 2);
+    QCOMPARE(loaded.stroke(1).events.size(), 1);
+
+    const KisPaintInformation &pi = loaded.stroke(0).events[1];
+    QCOMPARE(pi.pos(), QPointF(15.5, 22.25));
+    QVERIFY(qAbs(pi.pressure() - 0.4) < 1e-6);
+    QVERIFY(qAbs(pi.xTilt() - 11) < 1e-6);
+    QVERIFY(qAbs(pi.yTilt() + 21) < 1e-6);
+    QVERIFY(qAbs(pi.rotation() - 91) < 1e-6);
+    QVERIFY(qAbs(pi.tangentialPressure() - 0.2) < 1e-6);
+    QVERIFY(qAbs(pi.drawingSpeed() - 0.7) < 1e-6);
+    QCOMPARE(pi.currentTime(), 8.5);
+
+    QCOMPARE(loaded.stroke(1).events[0].pos(), QPointF(100, 200));
+    QCOMPARE(loaded.stroke(1).events[0].currentTime(), 1000.0);
+}
+
+void KisStrokeRecordingTest::testBrokenData()
+{
+    KisStrokeRecording recording;
+    recording.startStroke(0);
+    recording.addEvent(KisPaintInformation(QPointF(10, 20), 0.5));
+    recording.endStroke();
+
+    QByteArray data;
+    {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(recording.save(&buffer));
+    }
+
+    // truncated recording
+    {
+        QByteArray truncated = data.left(data.size() - 4);
+        QBuffer buffer(&truncated);
+        buffer.open(QIODevice::ReadOnly);
+
+        KisStrokeRecording loaded;
+        QVERIFY(!loaded.load(&buffer));
+        QCOMPARE(loaded.numStrokes(), 0);
+    }
+
+    // not a recording at all
+    {
+        QByteArray garbage("this is not a stroke recording");
+        QBuffer buffer(&garbage);
+        buffer.open(QIODevice::ReadOnly);
+
+        KisStrokeRecording loaded;
+        QVERIFY(!loaded.load(&buffer));
+    }
+}
+
+void KisStrokeRecordingTest::testRecorder()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + "/strokes.rec";
+
+    KisStrokeRecording::Stroke stroke1;
+    stroke1.startAngle = 0.25;
+    stroke1.events << KisPaintInformation(QPointF(10, 20), 0.5)
+                   << KisPaintInformation(QPointF(30, 40), 0.7);
+
+    KisStrokeRecording::Stroke stroke2;
+    stroke2.events << KisPaintInformation(QPointF(50, 60), 1.0);
+
+    {
+        KisStrokeRecorder recorder(fileName);
+        QVERIFY(recorder.appendStroke(stroke1));
+
+        // the file is complete after every stroke
+        KisStrokeRecording loaded;
+        QVERIFY(loaded.load(fileName));
+        QCOMPARE(loaded.numStrokes(), 1);
+
+        QVERIFY(recorder.appendStroke(stroke2));
+
+        QVERIFY(loaded.load(fileName));
+        QCOMPARE(loaded.numStrokes(), 2);
+        QCOMPARE(loaded.stroke(0).startAngle, 0.25);
+        QCOMPARE(loaded.stroke(0).events.size(), 2);
+        QCOMPARE(loaded.stroke(1).events[0].pos(), QPointF(50, 60));
+    }
+
+    // a new session starts a new recording
+    {
+        KisStrokeRecorder recorder(fileName);
+        QVERIFY(recorder.appendStroke(stroke2));
+
+        KisStrokeRecording loaded;
+        QVERIFY(loaded.load(fileName));
+        QCOMPARE(loaded.numStrokes(), 1);
+    }
+}
+
+QTEST_MAIN(KisStrokeRecordingTest)
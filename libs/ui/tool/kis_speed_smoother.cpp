@@ -73,14 +73,25 @@ KisSpeedSmoother::~KisSpeedSmoother()
 {
 }
 
+void KisSpeedSmoother::clear()
+{
+    m_d->distances.clear();
+    m_d->lastPoint = QPointF();
+    m_d->lastSpeed = 0;
+}
+
 qreal KisSpeedSmoother::getNextSpeed(const QPointF &pt)
+{
+    return getNextSpeed(pt, qreal(m_d->timer.nsecsElapsed()) / 1000000);
+}
+
+qreal KisSpeedSmoother::getNextSpeed(const QPointF &pt, qreal time)
 {
     if (m_d->lastPoint.isNull()) {
         m_d->lastPoint = pt;
         return 0.0;
     }
 
-    qreal time = qreal(m_d->timer.nsecsElapsed()) / 1000000;
     qreal dist = kisDistance(pt, m_d->lastPoint);
     m_d->lastPoint = pt;
 
@@ -32,6 +32,16 @@ public:
 
     qreal getNextSpeed(const QPointF &pt);
 
+    /**
+     * Same as getNextSpeed(pt), but uses \p time (in milliseconds)
+     * instead of the internal timer. Used when the events are
+     * processed with their own timestamps, e.g. when predicting
+     * the stroke or replaying recorded events.
+     */
+    qreal getNextSpeed(const QPointF &pt, qreal time);
+
+    void clear();
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
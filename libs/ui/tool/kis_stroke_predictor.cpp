@@ -0,0 +1,202 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_stroke_predictor.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointF>
+#include <QVector>
+
+#include <brushengine/kis_paint_information.h>
+
+#include "kis_speed_smoother.h"
+#include "kis_global.h"
+
+// the events older than that are not used for the direction of the movement
+#define DIRECTION_TIME_WINDOW 30.0
+#define MAX_DIRECTION_EVENTS 5
+#define DEFAULT_MAX_PREDICTION_DISTANCE 32.0
+
+
+struct KisStrokePredictor::Private
+{
+    KisSpeedSmoother speedSmoother;
+
+    QVector<QPointF> positions;
+    QVector<qreal> times;
+    KisPaintInformation lastInfo;
+    qreal lastSpeed = 0.0;
+
+    qreal maxPredictionDistance = DEFAULT_MAX_PREDICTION_DISTANCE;
+
+    // the last prediction, kept to measure its error
+    bool hasPrediction = false;
+    QPointF predictionOrigin;
+    QPointF predictionVelocity;
+    qreal predictionTime = 0.0;
+    qreal predictionHorizon = 0.0;
+
+    QElapsedTimer clock;
+
+    mutable QMutex statisticsLock;
+    int numLatencySamples = 0;
+    qreal latencySum = 0.0;
+    qreal maxLatency = 0.0;
+    int numPredictions = 0;
+    qreal predictionErrorSum = 0.0;
+};
+
+KisStrokePredictor::KisStrokePredictor()
+    : m_d(new Private)
+{
+    m_d->clock.start();
+}
+
+KisStrokePredictor::~KisStrokePredictor()
+{
+}
+
+void KisStrokePredictor::start()
+{
+    m_d->speedSmoother.clear();
+    m_d->positions.clear();
+    m_d->times.clear();
+    m_d->lastSpeed = 0.0;
+    m_d->hasPrediction = false;
+
+    QMutexLocker l(&m_d->statisticsLock);
+    m_d->numLatencySamples = 0;
+    m_d->latencySum = 0.0;
+    m_d->maxLatency = 0.0;
+    m_d->numPredictions = 0;
+    m_d->predictionErrorSum = 0.0;
+
+    m_d->clock.restart();
+}
+
+qreal KisStrokePredictor::elapsed() const
+{
+    return qreal(m_d->clock.nsecsElapsed()) / 1000000;
+}
+
+void KisStrokePredictor::addEvent(const KisPaintInformation &pi)
+{
+    const QPointF pos = pi.pos();
+    const qreal time = pi.currentTime();
+
+    if (m_d->hasPrediction) {
+        const qreal dt = qMin(time - m_d->predictionTime, m_d->predictionHorizon);
+
+        if (dt > 0) {
+            const QPointF expected = m_d->predictionOrigin + m_d->predictionVelocity * dt;
+
+            QMutexLocker l(&m_d->statisticsLock);
+            m_d->numPredictions++;
+            m_d->predictionErrorSum += kisDistance(expected, pos);
+        }
+
+        m_d->hasPrediction = false;
+    }
+
+    m_d->lastSpeed = m_d->speedSmoother.getNextSpeed(pos, time);
+    m_d->lastInfo = pi;
+
+    m_d->positions.append(pos);
+    m_d->times.append(time);
+
+    if (m_d->positions.size() > MAX_DIRECTION_EVENTS) {
+        m_d->positions.removeFirst();
+        m_d->times.removeFirst();
+    }
+}
+
+bool KisStrokePredictor::predict(qreal horizon, KisPaintInformation *result)
+{
+    if (m_d->positions.size() < 2 || horizon <= 0) return false;
+
+    const int last = m_d->positions.size() - 1;
+    const qreal lastTime = m_d->times[last];
+
+    int first = last - 1;
+    while (first > 0 && lastTime - m_d->times[first - 1] <= DIRECTION_TIME_WINDOW) {
+        first--;
+    }
+
+    const QPointF direction = m_d->positions[last] - m_d->positions[first];
+    const qreal directionLength = kisDistance(m_d->positions[last], m_d->positions[first]);
+
+    if (directionLength < 1e-3 || lastTime <= m_d->times[first]) return false;
+
+    const qreal distance = qMin(m_d->lastSpeed * horizon, m_d->maxPredictionDistance);
+
+    // the pen is almost standing, nothing to predict
+    if (distance < 0.5) return false;
+
+    const QPointF unit = direction / directionLength;
+    const QPointF predictedPos = m_d->positions[last] + unit * distance;
+    const KisPaintInformation &lastInfo = m_d->lastInfo;
+
+    *result = KisPaintInformation(predictedPos,
+                                  lastInfo.pressure(),
+                                  lastInfo.xTilt(),
+                                  lastInfo.yTilt(),
+                                  lastInfo.rotation(),
+                                  lastInfo.tangentialPressure(),
+                                  lastInfo.perspective(),
+                                  lastTime + horizon,
+                                  lastInfo.drawingSpeed());
+
+    m_d->hasPrediction = true;
+    m_d->predictionOrigin = m_d->positions[last];
+    m_d->predictionVelocity = unit * (distance / horizon);
+    m_d->predictionTime = lastTime;
+    m_d->predictionHorizon = horizon;
+
+    return true;
+}
+
+void KisStrokePredictor::setMaxPredictionDistance(qreal distance)
+{
+    m_d->maxPredictionDistance = distance;
+}
+
+void KisStrokePredictor::reportEventPainted(qreal eventTime)
+{
+    const qreal latency = qMax(qreal(0.0), elapsed() - eventTime);
+
+    QMutexLocker l(&m_d->statisticsLock);
+    m_d->numLatencySamples++;
+    m_d->latencySum += latency;
+    m_d->maxLatency = qMax(m_d->maxLatency, latency);
+}
+
+KisStrokePredictor::Statistics KisStrokePredictor::statistics() const
+{
+    QMutexLocker l(&m_d->statisticsLock);
+
+    Statistics stats;
+    stats.numLatencySamples = m_d->numLatencySamples;
+    stats.averageLatency = m_d->numLatencySamples ? m_d->latencySum / m_d->numLatencySamples : 0.0;
+    stats.maxLatency = m_d->maxLatency;
+    stats.numPredictions = m_d->numPredictions;
+    stats.averagePredictionError = m_d->numPredictions ? m_d->predictionErrorSum / m_d->numPredictions : 0.0;
+
+    return stats;
+}
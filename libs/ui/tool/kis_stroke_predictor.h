@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_STROKE_PREDICTOR_H
+#define __KIS_STROKE_PREDICTOR_H
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+#include "kritaui_export.h"
+
+class KisPaintInformation;
+
+
+/**
+ * Extrapolates the path of the pen a few milliseconds ahead of the
+ * last input event, so that the freehand tool could paint speculative
+ * dabs where the pen is going to be, instead of waiting for the next
+ * event. The speculative dabs are rolled back by the stroke as soon as
+ * the real event arrives (see FreehandStrokeStrategy::Data::SPECULATIVE_LINE).
+ *
+ * The direction of the movement is taken from the last events, the
+ * speed is smoothed with KisSpeedSmoother. All the times are taken from
+ * KisPaintInformation::currentTime(), so the predictor gives the same
+ * results when recorded events are replayed offline.
+ *
+ * The predictor also collects the statistics needed for tuning the
+ * prediction: the latency between an event and the moment its dabs
+ * are painted and the error of the predictions.
+ */
+class KRITAUI_EXPORT KisStrokePredictor
+{
+public:
+    struct Statistics {
+        Statistics()
+            : numLatencySamples(0),
+              averageLatency(0),
+              maxLatency(0),
+              numPredictions(0),
+              averagePredictionError(0)
+        {
+        }
+
+        int numLatencySamples;
+        qreal averageLatency;
+        qreal maxLatency;
+
+        int numPredictions;
+        qreal averagePredictionError;
+    };
+
+public:
+    KisStrokePredictor();
+    ~KisStrokePredictor();
+
+    /**
+     * Resets the predictor for a new stroke and restarts the clock
+     * that should be in sync with the time of the stroke events
+     */
+    void start();
+
+    /**
+     * The time that has passed since start() in milliseconds
+     */
+    qreal elapsed() const;
+
+    /**
+     * Adds a real event of the stroke (in image coordinates)
+     */
+    void addEvent(const KisPaintInformation &pi);
+
+    /**
+     * Predicts the state of the pen \p horizon milliseconds after the
+     * last event. Returns false if there is not enough data or the pen
+     * is not moving.
+     */
+    bool predict(qreal horizon, KisPaintInformation *result);
+
+    /**
+     * Limits the distance between the last event and the predicted
+     * point. The default is 32 px.
+     */
+    void setMaxPredictionDistance(qreal distance);
+
+    /**
+     * Called by the stroke when the dabs of the event with time
+     * \p eventTime have been painted. Can be called from any thread.
+     */
+    void reportEventPainted(qreal eventTime);
+
+    Statistics statistics() const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+typedef QSharedPointer<KisStrokePredictor> KisStrokePredictorSP;
+
+#endif /* __KIS_STROKE_PREDICTOR_H */
@@ -0,0 +1,283 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_stroke_recording.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QIODevice>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+
+#include <brushengine/kis_paint_information.h>
+
+#include "kis_debug.h"
+
+// "KSRC"
+#define RECORDING_MAGIC 0x4b535243
+#define RECORDING_VERSION 2
+
+namespace {
+
+void initStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+}
+
+void writeHeader(QDataStream &stream)
+{
+    stream << quint32(RECORDING_MAGIC) << quint32(RECORDING_VERSION);
+}
+
+void writeStroke(QDataStream &stream, const KisStrokeRecording::Stroke &stroke)
+{
+    stream << stroke.startAngle;
+    stream << quint32(stroke.events.size());
+
+    Q_FOREACH (const KisPaintInformation &pi, stroke.events) {
+        stream << pi.pos().x() << pi.pos().y()
+               << pi.pressure()
+               << pi.xTilt() << pi.yTilt()
+               << pi.rotation()
+               << pi.tangentialPressure()
+               << pi.perspective()
+               << pi.drawingSpeed()
+               << pi.currentTime();
+    }
+}
+
+bool readStroke(QDataStream &stream, KisStrokeRecording::Stroke *stroke)
+{
+    quint32 numEvents = 0;
+
+    stream >> stroke->startAngle >> numEvents;
+    if (stream.status() != QDataStream::Ok) return false;
+
+    for (quint32 j = 0; j < numEvents; j++) {
+        qreal x, y, pressure, xTilt, yTilt, rotation;
+        qreal tangentialPressure, perspective, speed, time;
+
+        stream >> x >> y
+               >> pressure
+               >> xTilt >> yTilt
+               >> rotation
+               >> tangentialPressure
+               >> perspective
+               >> speed
+               >> time;
+
+        if (stream.status() != QDataStream::Ok) return false;
+
+        stroke->events.append(
+            KisPaintInformation(QPointF(x, y), pressure,
+                                xTilt, yTilt, rotation,
+                                tangentialPressure, perspective,
+                                time, speed));
+    }
+
+    return true;
+}
+
+}
+
+
+struct KisStrokeRecording::Private
+{
+    QVector<Stroke> strokes;
+    bool strokeStarted = false;
+};
+
+KisStrokeRecording::KisStrokeRecording()
+    : m_d(new Private)
+{
+}
+
+KisStrokeRecording::~KisStrokeRecording()
+{
+}
+
+void KisStrokeRecording::startStroke(qreal startAngle)
+{
+    KIS_SAFE_ASSERT_RECOVER_NOOP(!m_d->strokeStarted);
+
+    Stroke stroke;
+    stroke.startAngle = startAngle;
+    m_d->strokes.append(stroke);
+    m_d->strokeStarted = true;
+}
+
+void KisStrokeRecording::addEvent(const KisPaintInformation &pi)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN(m_d->strokeStarted);
+    m_d->strokes.last().events.append(pi);
+}
+
+void KisStrokeRecording::endStroke()
+{
+    KIS_SAFE_ASSERT_RECOVER_NOOP(m_d->strokeStarted);
+    m_d->strokeStarted = false;
+}
+
+int KisStrokeRecording::numStrokes() const
+{
+    return m_d->strokes.size();
+}
+
+const KisStrokeRecording::Stroke& KisStrokeRecording::stroke(int index) const
+{
+    return m_d->strokes[index];
+}
+
+void KisStrokeRecording::clear()
+{
+    m_d->strokes.clear();
+    m_d->strokeStarted = false;
+}
+
+bool KisStrokeRecording::save(QIODevice *device) const
+{
+    QDataStream stream(device);
+    initStream(stream);
+
+    writeHeader(stream);
+
+    Q_FOREACH (const Stroke &stroke, m_d->strokes) {
+        writeStroke(stream, stroke);
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool KisStrokeRecording::save(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        warnKrita << "Could not open stroke recording for writing:" << fileName;
+        return false;
+    }
+
+    return save(&file);
+}
+
+bool KisStrokeRecording::load(QIODevice *device)
+{
+    QDataStream stream(device);
+    initStream(stream);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+
+    stream >> magic >> version;
+
+    if (stream.status() != QDataStream::Ok ||
+        magic != RECORDING_MAGIC ||
+        version != RECORDING_VERSION) {
+
+        return false;
+    }
+
+    QVector<Stroke> strokes;
+
+    while (!stream.atEnd()) {
+        Stroke stroke;
+        if (!readStroke(stream, &stroke)) return false;
+
+        strokes.append(stroke);
+    }
+
+    m_d->strokes = strokes;
+    m_d->strokeStarted = false;
+
+    return true;
+}
+
+bool KisStrokeRecording::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        warnKrita << "Could not open stroke recording:" << fileName;
+        return false;
+    }
+
+    return load(&file);
+}
+
+QString KisStrokeRecording::recordingFileName()
+{
+    return QString::fromLocal8Bit(qgetenv("KRITA_STROKE_RECORDING"));
+}
+
+
+struct KisStrokeRecorder::Private
+{
+    QString fileName;
+    QFile file;
+    bool openFailed = false;
+    QMutex lock;
+};
+
+Q_GLOBAL_STATIC_WITH_ARGS(KisStrokeRecorder, s_recorder, (KisStrokeRecording::recordingFileName()))
+
+KisStrokeRecorder::KisStrokeRecorder(const QString &fileName)
+    : m_d(new Private)
+{
+    m_d->fileName = fileName;
+}
+
+KisStrokeRecorder::~KisStrokeRecorder()
+{
+}
+
+KisStrokeRecorder* KisStrokeRecorder::instance()
+{
+    static const bool isEnabled = !KisStrokeRecording::recordingFileName().isEmpty();
+    return isEnabled ? s_recorder : 0;
+}
+
+bool KisStrokeRecorder::appendStroke(const KisStrokeRecording::Stroke &stroke)
+{
+    QMutexLocker l(&m_d->lock);
+
+    if (m_d->openFailed) return false;
+
+    const bool isFirstStroke = !m_d->file.isOpen();
+
+    if (isFirstStroke) {
+        m_d->file.setFileName(m_d->fileName);
+
+        if (!m_d->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            warnKrita << "Could not open stroke recording for writing:" << m_d->fileName;
+            m_d->openFailed = true;
+            return false;
+        }
+    }
+
+    QDataStream stream(&m_d->file);
+    initStream(stream);
+
+    if (isFirstStroke) {
+        writeHeader(stream);
+    }
+
+    writeStroke(stream, stroke);
+    m_d->file.flush();
+
+    return stream.status() == QDataStream::Ok;
+}
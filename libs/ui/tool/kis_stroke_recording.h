@@ -0,0 +1,126 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_STROKE_RECORDING_H
+#define __KIS_STROKE_RECORDING_H
+
+#include <QScopedPointer>
+#include <QVector>
+
+#include "kritaui_export.h"
+
+class QIODevice;
+class QString;
+class KisPaintInformation;
+
+
+/**
+ * A compact binary record of the input events of freehand strokes.
+ *
+ * The freehand helpers write every finished stroke into a recording
+ * (see KisStrokeRecorder) when the KRITA_STROKE_RECORDING environment
+ * variable points to a file. The recording can later be replayed offline
+ * against any image and preset
+ * (see benchmarks/kis_stroke_replay_benchmark.cpp), so that the painting
+ * performance can be measured on exactly the same input.
+ *
+ * Only the values coming from the tablet are stored: position, pressure,
+ * tilt, rotation, tangential pressure, perspective, drawing speed and
+ * time, all in single precision. The random sources, the canvas
+ * rotation and the level of detail are not part of the recording.
+ *
+ * The file consists of a header followed by the strokes up to the end
+ * of the file, so new strokes can be appended to it without rewriting
+ * the previous ones.
+ */
+class KRITAUI_EXPORT KisStrokeRecording
+{
+public:
+    struct Stroke {
+        Stroke() : startAngle(0) {}
+
+        qreal startAngle;
+        QVector<KisPaintInformation> events;
+    };
+
+public:
+    KisStrokeRecording();
+    ~KisStrokeRecording();
+
+    void startStroke(qreal startAngle);
+    void addEvent(const KisPaintInformation &pi);
+    void endStroke();
+
+    int numStrokes() const;
+    const Stroke& stroke(int index) const;
+
+    void clear();
+
+    bool save(QIODevice *device) const;
+    bool save(const QString &fileName) const;
+
+    /**
+     * Replaces the strokes with the content of \p device. Returns false
+     * if the data is not a stroke recording or is truncated.
+     */
+    bool load(QIODevice *device);
+    bool load(const QString &fileName);
+
+    /**
+     * The file name set in KRITA_STROKE_RECORDING, empty if the
+     * recording is disabled
+     */
+    static QString recordingFileName();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+/**
+ * The writer of the recording set in KRITA_STROKE_RECORDING. It is
+ * shared by all the freehand helpers of the process.
+ *
+ * The file is truncated when the first stroke is written. Every stroke is
+ * appended to it and flushed right away, so the file stays complete even
+ * if Krita crashes later.
+ */
+class KRITAUI_EXPORT KisStrokeRecorder
+{
+public:
+    KisStrokeRecorder(const QString &fileName);
+    ~KisStrokeRecorder();
+
+    /**
+     * The recorder writing into KRITA_STROKE_RECORDING, null if the
+     * recording is disabled
+     */
+    static KisStrokeRecorder* instance();
+
+    /**
+     * Appends a finished stroke to the file. Can be called from any
+     * thread.
+     */
+    bool appendStroke(const KisStrokeRecording::Stroke &stroke);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_STROKE_RECORDING_H */
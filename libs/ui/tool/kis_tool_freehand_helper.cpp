@@ -39,6 +39,7 @@
 #include "kis_stabilized_events_sampler.h"
 #include "KisStabilizerDelayedPaintHelper.h"
 #include "kis_config.h"
+#include "kis_stroke_recording.h"
 
 
 #include <math.h>
@@ -101,6 +102,15 @@ struct KisToolFreehandHelper::Private
     KisStabilizedEventsSampler stabilizedSampler;
     KisStabilizerDelayedPaintHelper stabilizerDelayedPaintHelper;
 
+    // Prediction data
+    KisStrokePredictorSP predictor;
+    bool predictionEnabled;
+    int predictionHorizon;
+
+    // Input recording, enabled with KRITA_STROKE_RECORDING
+    KisStrokeRecorder *recorder;
+    KisStrokeRecording::Stroke recordedStroke;
+
     int canvasRotation;
     bool canvasMirroredH;
 
@@ -120,6 +130,11 @@ KisToolFreehandHelper::KisToolFreehandHelper(KisPaintingInformationBuilder *info
     m_d->smoothingOptions = KisSmoothingOptionsSP(
                 smoothingOptions ? smoothingOptions : new KisSmoothingOptions());
     m_d->canvasRotation = 0;
+    m_d->predictor.reset(new KisStrokePredictor());
+    m_d->predictionEnabled = false;
+    m_d->predictionHorizon = 0;
+
+    m_d->recorder = KisStrokeRecorder::instance();
 
     m_d->strokeTimeoutTimer.setSingleShot(true);
     connect(&m_d->strokeTimeoutTimer, SIGNAL(timeout()), SLOT(finishStroke()));
@@ -235,6 +250,7 @@ void KisToolFreehandHelper::initPaint(KoPointerEvent *event,
 {
     QPointF prevPoint = m_d->lastCursorPos.pushThroughHistory(pixelCoords);
     m_d->strokeTime.start();
+    m_d->predictor->start();
     KisPaintInformation pi =
         m_d->infoBuilder->startStroke(event, elapsedStrokeTime(), resourceManager);
     qreal startAngle = KisAlgebra2D::directionBetweenPoints(prevPoint, pixelCoords, 0.0);
@@ -272,6 +288,12 @@ void KisToolFreehandHelper::initPaintImpl(qreal startAngle,
 
     m_d->previousPaintInformation = pi;
 
+    if (m_d->recorder) {
+        m_d->recordedStroke = KisStrokeRecording::Stroke();
+        m_d->recordedStroke.startAngle = startAngle;
+        m_d->recordedStroke.events.append(pi);
+    }
+
     m_d->resources = new KisResourcesSnapshot(image,
                                               currentNode,
                                               resourceManager,
@@ -297,13 +319,28 @@ void KisToolFreehandHelper::initPaintImpl(qreal startAngle,
         m_d->recordingAdapter->startStroke(image, m_d->resources, startDistInfo);
     }
 
-    KisStrokeStrategy *stroke =
+    FreehandStrokeStrategy *stroke =
         new FreehandStrokeStrategy(m_d->resources->needsIndirectPainting(),
                                    m_d->resources->indirectPaintingCompositeOp(),
                                    m_d->resources, m_d->painterInfos, m_d->transactionText);
+    stroke->setStrokePredictor(m_d->predictor);
 
     m_d->strokeId = m_d->strokesFacade->startStroke(stroke);
 
+    /**
+     * The stabilizer delays the stroke on purpose and the multihand
+     * helpers transform the lines per painter, so the speculative
+     * lines are painted for the plain strokes only
+     */
+    KisConfig cfg;
+    m_d->predictionEnabled =
+        cfg.strokePrediction() &&
+        m_d->painterInfos.size() == 1 &&
+        !airbrushing &&
+        m_d->smoothingOptions->smoothingType() != KisSmoothingOptions::STABILIZER;
+    m_d->predictionHorizon = cfg.strokePredictionHorizon();
+    m_d->predictor->addEvent(pi);
+
     m_d->history.clear();
     m_d->distanceHistory.clear();
 
@@ -434,7 +471,38 @@ void KisToolFreehandHelper::paintEvent(KoPointerEvent *event)
 
     KisUpdateTimeMonitor::instance()->reportMouseMove(info.pos());
 
+    if (m_d->recorder) {
+        m_d->recordedStroke.events.append(info);
+    }
+
+    m_d->predictor->addEvent(info);
+
     paint(info);
+
+    if (m_d->predictionEnabled) {
+        paintSpeculativeLine();
+    }
+}
+
+void KisToolFreehandHelper::paintSpeculativeLine()
+{
+    KisPaintInformation predictedInfo;
+    if (!m_d->predictor->predict(m_d->predictionHorizon, &predictedInfo)) return;
+
+    /**
+     * With smoothing the real line ends one event behind, so the
+     * speculative line starts from there
+     */
+    const KisPaintInformation &startInfo =
+        m_d->smoothingOptions->smoothingType() == KisSmoothingOptions::NO_SMOOTHING ?
+        m_d->previousPaintInformation : m_d->olderPaintInformation;
+
+    FreehandStrokeStrategy::Data *data =
+        new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
+                                         0, startInfo, predictedInfo);
+    data->type = FreehandStrokeStrategy::Data::SPECULATIVE_LINE;
+
+    m_d->strokesFacade->addJob(m_d->strokeId, data);
 }
 
 void KisToolFreehandHelper::paint(KisPaintInformation &info)
@@ -631,6 +699,11 @@ void KisToolFreehandHelper::endPaint()
     if(m_d->recordingAdapter) {
         m_d->recordingAdapter->endStroke();
     }
+
+    if (m_d->recorder) {
+        m_d->recorder->appendStroke(m_d->recordedStroke);
+        m_d->recordedStroke = KisStrokeRecording::Stroke();
+    }
 }
 
 void KisToolFreehandHelper::cancelPaint()
@@ -657,6 +730,11 @@ void KisToolFreehandHelper::cancelPaint()
     m_d->strokesFacade->cancelStroke(m_d->strokeId);
     m_d->strokeId.clear();
 
+    // cancelled strokes are not recorded
+    if (m_d->recorder) {
+        m_d->recordedStroke = KisStrokeRecording::Stroke();
+    }
+
     if(m_d->recordingAdapter) {
         //FIXME: not implemented
         //m_d->recordingAdapter->cancelStroke();
@@ -962,6 +1040,11 @@ void KisToolFreehandHelper::paintBezierCurve(const KisPaintInformation &pi1,
     paintBezierCurve(0, pi1, control1, control2, pi2);
 }
 
+KisStrokePredictorSP KisToolFreehandHelper::strokePredictor() const
+{
+    return m_d->predictor;
+}
+
 int KisToolFreehandHelper::canvasRotation()
 {
     return m_d->canvasRotation;
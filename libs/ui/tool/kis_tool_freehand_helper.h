@@ -28,6 +28,7 @@
 #include <brushengine/kis_paintop_settings.h>
 #include "kis_smoothing_options.h"
 #include "strokes/freehand_stroke.h"
+#include "kis_stroke_predictor.h"
 
 class KoPointerEvent;
 class KoCanvasResourceManager;
@@ -80,6 +81,12 @@ public:
                                 const KoPointerEvent *event,
                                 const KisPaintOpSettingsSP globalSettings,
                                 KisPaintOpSettings::OutlineMode mode) const;
+    /**
+     * The predictor collects the latency statistics of the strokes
+     * even when the speculative painting is disabled
+     */
+    KisStrokePredictorSP strokePredictor() const;
+
     int canvasRotation();
     void setCanvasRotation(int rotation = 0);
     bool canvasMirroredH();
@@ -142,6 +149,8 @@ private:
     void paintBezierSegment(KisPaintInformation pi1, KisPaintInformation pi2,
                                                    QPointF tangent1, QPointF tangent2);
 
+    void paintSpeculativeLine();
+
     void stabilizerStart(KisPaintInformation firstPaintInfo);
     void stabilizerEnd();
     KisPaintInformation getStabilizedPaintInfo(const QQueue<KisPaintInformation> &queue,
@@ -22,10 +22,13 @@
 #include <brushengine/kis_paintop_preset.h>
 #include <brushengine/kis_paintop_settings.h>
 #include "kis_painter.h"
+#include "kis_paint_device.h"
+#include <brushengine/kis_paintop.h>
 
 #include "kis_update_time_monitor.h"
 
 #include <brushengine/kis_stroke_random_source.h>
+#include <brushengine/kis_random_source.h>
 
 
 struct FreehandStrokeStrategy::Private
@@ -34,6 +37,13 @@ struct FreehandStrokeStrategy::Private
 
     KisStrokeRandomSource randomSource;
     KisResourcesSnapshotSP resources;
+
+    KisStrokePredictorSP predictor;
+    bool hasLodBuddy = false;
+
+    // the painter that has painted the last speculative line
+    KisPainter *speculationPainter = 0;
+    KisNodeSP speculationNode;
 };
 
 FreehandStrokeStrategy::FreehandStrokeStrategy(bool needsIndirectPainting,
@@ -65,6 +75,9 @@ FreehandStrokeStrategy::FreehandStrokeStrategy(const FreehandStrokeStrategy &rhs
       m_d(new Private(*rhs.m_d))
 {
     m_d->randomSource.setLevelOfDetail(levelOfDetail);
+
+    m_d->speculationPainter = 0;
+    m_d->speculationNode = 0;
 }
 
 FreehandStrokeStrategy::~FreehandStrokeStrategy()
@@ -83,11 +96,84 @@ void FreehandStrokeStrategy::init(bool needsIndirectPainting,
     KisUpdateTimeMonitor::instance()->startStrokeMeasure();
 }
 
+void FreehandStrokeStrategy::setStrokePredictor(KisStrokePredictorSP predictor)
+{
+    m_d->predictor = predictor;
+}
+
+void FreehandStrokeStrategy::rollbackSpeculation()
+{
+    if (!m_d->speculationPainter) return;
+
+    const QVector<QRect> rects = m_d->speculationPainter->revertAreaBackup();
+    m_d->speculationNode->setDirty(rects);
+
+    m_d->speculationPainter = 0;
+    m_d->speculationNode = 0;
+}
+
+void FreehandStrokeStrategy::paintSpeculativeLine(Data *d, PainterInfo *info)
+{
+    /**
+     * Only the paintops that keep all their state in the distance
+     * information and the painter can paint speculatively, otherwise
+     * the rolled back line would still affect the real dabs
+     */
+    if (m_d->hasLodBuddy ||
+        !info->painter->paintOp() ||
+        !info->painter->paintOp()->supportsSpeculativePainting()) {
+
+        return;
+    }
+
+    /**
+     * The painter keeps a copy of only the areas the line writes into.
+     * The paintop also updates the opacity and the mean opacity of the
+     * painter with every dab, which the real dabs of the alpha darken
+     * mode depend on, so they are restored right after the line.
+     */
+    m_d->speculationPainter = info->painter;
+    m_d->speculationNode = d->node;
+
+    const KisPainter::OpacityState opacityState = info->painter->opacityState();
+    info->painter->beginAreaBackup();
+
+    KisDistanceInformation distance(*info->dragDistance);
+    KisRandomSourceSP rnd = new KisRandomSource(int(d->pi2.currentTime()));
+
+    d->pi1.setRandomSource(rnd);
+    d->pi2.setRandomSource(rnd);
+    info->painter->paintLine(d->pi1, d->pi2, &distance);
+
+    info->painter->setOpacityState(opacityState);
+
+    d->node->setDirty(info->painter->takeDirtyRegion());
+}
+
+void FreehandStrokeStrategy::finishStrokeCallback()
+{
+    rollbackSpeculation();
+    KisPainterBasedStrokeStrategy::finishStrokeCallback();
+}
+
+void FreehandStrokeStrategy::suspendStrokeCallback()
+{
+    rollbackSpeculation();
+    KisPainterBasedStrokeStrategy::suspendStrokeCallback();
+}
+
 void FreehandStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
 {
     Data *d = dynamic_cast<Data*>(data);
     PainterInfo *info = painterInfos()[d->painterInfoId];
 
+    rollbackSpeculation();
+
+    if (d->type == Data::SPECULATIVE_LINE) {
+        paintSpeculativeLine(d, info);
+        return;
+    }
+
     KisUpdateTimeMonitor::instance()->reportPaintOpPreset(info->painter->preset());
     KisRandomSourceSP rnd = m_d->randomSource.source();
 
@@ -133,11 +219,22 @@ void FreehandStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
         info->painter->fillPainterPath(d->path);}
         info->painter->drawPainterPath(d->path, d->pen);    
         break;
+    case Data::SPECULATIVE_LINE:
+        // handled above
+        break;
     };
 
     QVector<QRect> dirtyRects = info->painter->takeDirtyRegion();
     KisUpdateTimeMonitor::instance()->reportJobFinished(data, dirtyRects);
     d->node->setDirty(dirtyRects);
+
+    if (m_d->predictor && !m_d->hasLodBuddy &&
+        (d->type == Data::POINT || d->type == Data::LINE || d->type == Data::CURVE)) {
+
+        m_d->predictor->reportEventPainted(d->type == Data::POINT ?
+                                           d->pi1.currentTime() :
+                                           d->pi2.currentTime());
+    }
 }
 
 KisStrokeStrategy* FreehandStrokeStrategy::createLodClone(int levelOfDetail)
@@ -145,5 +242,13 @@ KisStrokeStrategy* FreehandStrokeStrategy::createLodClone(int levelOfDetail)
     if (!m_d->resources->presetAllowsLod()) return 0;
 
     FreehandStrokeStrategy *clone = new FreehandStrokeStrategy(*this, levelOfDetail);
+
+    /**
+     * The user sees the result of the LodN stroke, the LoD0 one is
+     * executed after the stroke is finished, so only the clone
+     * paints speculatively and measures the latency
+     */
+    m_d->hasLodBuddy = true;
+
     return clone;
 }
@@ -27,6 +27,7 @@
 #include <brushengine/kis_paint_information.h>
 #include "kis_lod_transform.h"
 #include "KoColor.h"
+#include "kis_stroke_predictor.h"
 
 
 
@@ -45,7 +46,14 @@ public:
             ELLIPSE,
             PAINTER_PATH,
             QPAINTER_PATH,
-            QPAINTER_PATH_FILL
+            QPAINTER_PATH_FILL,
+
+            /**
+             * A line to the predicted position of the pen. It is
+             * painted with a copy of the distance information and
+             * rolled back when the next job of the stroke arrives.
+             */
+            SPECULATIVE_LINE
         };
 
         Data(KisNodeSP _node, int _painterInfoId,
@@ -119,6 +127,7 @@ public:
                 pi1 = t.map(rhs.pi1);
                 break;
             case Data::LINE:
+            case Data::SPECULATIVE_LINE:
                 pi1 = t.map(rhs.pi1);
                 pi2 = t.map(rhs.pi2);
                 break;
@@ -187,6 +196,14 @@ public:
     ~FreehandStrokeStrategy() override;
 
     void doStrokeCallback(KisStrokeJobData *data) override;
+    void finishStrokeCallback() override;
+    void suspendStrokeCallback() override;
+
+    /**
+     * The predictor is notified when the real events have been
+     * painted, so that it could measure the latency of the stroke
+     */
+    void setStrokePredictor(KisStrokePredictorSP predictor);
 
     KisStrokeStrategy* createLodClone(int levelOfDetail) override;
 
@@ -195,6 +212,8 @@ protected:
 
 private:
     void init(bool needsIndirectPainting, const QString &indirectPaintingCompositeOp);
+    void paintSpeculativeLine(Data *d, PainterInfo *info);
+    void rollbackSpeculation();
 
 private:
     struct Private;
@@ -32,7 +32,10 @@
 #include "kis_canvas2.h"
 
 HistogramDockerWidget::HistogramDockerWidget(QWidget *parent, const char *name, Qt::WindowFlags f)
-    : QLabel(parent, f), m_paintDevice(nullptr), m_smoothHistogram(true)
+    : QLabel(parent, f), m_paintDevice(nullptr), m_smoothHistogram(true),
+      m_histogram(new KisIncrementalHistogram(true)),
+      m_computationRunning(false),
+      m_updatePending(false)
 {
     setObjectName(name);
 }
@@ -52,17 +55,44 @@ void HistogramDockerWidget::setPaintDevice(KisCanvas2* canvas)
         m_bounds = QRect();
         m_histogramData.clear();
     }
+
+    /**
+     * The thread computing the histogram of the previous image may still
+     * be running, so we don't touch its cache and just start a new one
+     */
+    m_histogram.reset(new KisIncrementalHistogram(true));
+    m_dirtyRegion = QRegion();
+}
+
+void HistogramDockerWidget::addDirtyRect(const QRect &rc)
+{
+    m_dirtyRegion += rc;
 }
 
 void HistogramDockerWidget::updateHistogram()
 {
     if (!m_paintDevice.isNull()) {
+        /**
+         * The cached histogram is updated incrementally, so the
+         * computations must go in the order of the image changes. We
+         * never run two of them at the same time.
+         */
+        if (m_computationRunning) {
+            m_updatePending = true;
+            return;
+        }
+
         KisPaintDeviceSP m_devClone = new KisPaintDevice(m_paintDevice->colorSpace());
 
         m_devClone->makeCloneFrom(m_paintDevice, m_bounds);
 
-        HistogramComputationThread *workerThread = new HistogramComputationThread(m_devClone, m_bounds);
+        HistogramComputationThread *workerThread =
+            new HistogramComputationThread(m_devClone, m_histogram, m_dirtyRegion.rects());
+        m_dirtyRegion = QRegion();
+        m_computationRunning = true;
+
         connect(workerThread, &HistogramComputationThread::resultReady, this, &HistogramDockerWidget::receiveNewHistogram);
+        connect(workerThread, &HistogramComputationThread::finished, this, &HistogramDockerWidget::slotComputationFinished);
         connect(workerThread, &HistogramComputationThread::finished, workerThread, &QObject::deleteLater);
         workerThread->start();
     } else {
@@ -77,6 +107,16 @@ void HistogramDockerWidget::receiveNewHistogram(HistVector *histogramData)
     update();
 }
 
+void HistogramDockerWidget::slotComputationFinished()
+{
+    m_computationRunning = false;
+
+    if (m_updatePending) {
+        m_updatePending = false;
+        updateHistogram();
+    }
+}
+
 void HistogramDockerWidget::paintEvent(QPaintEvent *event)
 {
     if (!m_histogramData.empty()) {
@@ -156,40 +196,18 @@ void HistogramDockerWidget::paintEvent(QPaintEvent *event)
 
 void HistogramComputationThread::run()
 {
-    const KoColorSpace *cs = m_dev->colorSpace();
-    quint32 channelCount = m_dev->channelCount();
-    quint32 pixelSize = m_dev->pixelSize();
-
-    quint32 imageSize = m_bounds.width() * m_bounds.height();
-    quint32 nSkip = 1 + (imageSize >> 20); //for speed use about 1M pixels for computing histograms
-
-    //allocate space for the histogram data
-    bins.resize((int)channelCount);
-    for (auto &bin : bins) {
-        bin.resize(std::numeric_limits<quint8>::max() + 1);
-    }
-
-    QRect bounds = m_dev->exactBounds();
-    if (bounds.isEmpty())
+    const QRect bounds = m_dev->exactBounds();
+    if (bounds.isEmpty()) {
+        /**
+         * The dirty rects are dropped here, so the cached bins cannot
+         * be trusted anymore
+         */
+        m_histogram->invalidate();
         return;
+    }
 
-    KisSequentialConstIterator it(m_dev, m_dev->exactBounds());
-    int i;
-    quint32 toSkip = nSkip;
-
-    do {
-        i = it.nConseqPixels();
-        const quint8* pixel = it.rawDataConst();
-        for (int k = 0; k < i; ++k) {
-            if (--toSkip == 0) {
-                for (int chan = 0; chan < (int)channelCount; ++chan) {
-                    bins[chan][cs->scaleToU8(pixel, chan)]++;
-                }
-                toSkip = nSkip;
-            }
-            pixel += pixelSize;
-        }
-    } while (it.nextPixels(i));
+    m_histogram->update(m_dev, bounds, m_dirtyRects);
+    bins = m_histogram->bins();
 
     emit resultReady(&bins);
 }
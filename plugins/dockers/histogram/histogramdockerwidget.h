@@ -23,19 +23,25 @@
 #include <QWidget>
 #include <QLabel>
 #include <QThread>
+#include <QRegion>
+#include <QSharedPointer>
 #include "kis_types.h"
+#include "kis_incremental_histogram.h"
 #include <vector>
 
 class KisCanvas2;
 
-typedef std::vector<std::vector<quint32> > HistVector; //Don't use QVector here - it's too slow for this purpose
+typedef KisIncrementalHistogram::Bins HistVector; //Don't use QVector here - it's too slow for this purpose
 
 
 class HistogramComputationThread : public QThread
 {
     Q_OBJECT
 public:
-    HistogramComputationThread(KisPaintDeviceSP _dev, const QRect& _bounds) : m_dev(_dev), m_bounds(_bounds)
+    HistogramComputationThread(KisPaintDeviceSP _dev,
+                               QSharedPointer<KisIncrementalHistogram> _histogram,
+                               const QVector<QRect> &_dirtyRects)
+        : m_dev(_dev), m_histogram(_histogram), m_dirtyRects(_dirtyRects)
     {}
 
     void run() override;
@@ -45,7 +51,8 @@ Q_SIGNALS:
 
 private:
     KisPaintDeviceSP m_dev;
-    QRect m_bounds;
+    QSharedPointer<KisIncrementalHistogram> m_histogram;
+    QVector<QRect> m_dirtyRects;
     HistVector bins;
 };
 
@@ -60,15 +67,29 @@ public:
     void setPaintDevice(KisCanvas2* canvas);
     void paintEvent(QPaintEvent *event) override;
 
+    /**
+     * Marks the area of the image that should be rescanned on the next
+     * update of the histogram
+     */
+    void addDirtyRect(const QRect &rc);
+
 public Q_SLOTS:
     void updateHistogram();
     void receiveNewHistogram(HistVector*);
 
+private Q_SLOTS:
+    void slotComputationFinished();
+
 private:
     KisPaintDeviceSP m_paintDevice;
     HistVector m_histogramData;
     QRect m_bounds;
     bool m_smoothHistogram;
+
+    QSharedPointer<KisIncrementalHistogram> m_histogram;
+    QRegion m_dirtyRegion;
+    bool m_computationRunning;
+    bool m_updatePending;
 };
 
 #endif // HISTOGRAMDOCKERWIDGET_H
@@ -59,6 +59,7 @@ KisFilterConfigurationSP KisGaussianBlurFilter::factoryConfiguration() const
     config->setProperty("horizRadius", 5);
     config->setProperty("vertRadius", 5);
     config->setProperty("lockAspect", true);
+    config->setProperty("useRecursive", false);
 
     return config;
 }
@@ -89,9 +90,12 @@ void KisGaussianBlurFilter::processImpl(KisPaintDeviceSP device,
         channelFlags = QBitArray(device->colorSpace()->channelCount(), true);
     }
 
+    const bool useRecursive = config->getBool("useRecursive", false);
+
     KisGaussianKernel::applyGaussian(device, rect,
                                      horizontalRadius, verticalRadius,
-                                     channelFlags, progressUpdater);
+                                     channelFlags, progressUpdater,
+                                     useRecursive);
 }
 
 QRect KisGaussianBlurFilter::neededRect(const QRect & rect, const KisFilterConfigurationSP _config, int lod) const
@@ -56,6 +56,7 @@ KisWdgGaussianBlur::KisWdgGaussianBlur(QWidget * parent) : KisConfigWidget(paren
     connect(m_widget->aspectButton, SIGNAL(keepAspectRatioChanged(bool)), this, SLOT(aspectLockChanged(bool)));
     connect(m_widget->horizontalRadius, SIGNAL(valueChanged(qreal)), SIGNAL(sigConfigurationItemChanged()));
     connect(m_widget->verticalRadius, SIGNAL(valueChanged(qreal)), SIGNAL(sigConfigurationItemChanged()));
+    connect(m_widget->chkRecursive, SIGNAL(toggled(bool)), SIGNAL(sigConfigurationItemChanged()));
 }
 
 KisWdgGaussianBlur::~KisWdgGaussianBlur()
@@ -69,6 +70,7 @@ KisPropertiesConfigurationSP KisWdgGaussianBlur::configuration() const
     config->setProperty("horizRadius", m_widget->horizontalRadius->value());
     config->setProperty("vertRadius", m_widget->verticalRadius->value());
     config->setProperty("lockAspect", m_widget->aspectButton->keepAspectRatio());
+    config->setProperty("useRecursive", m_widget->chkRecursive->isChecked());
     return config;
 }
 
@@ -84,6 +86,7 @@ void KisWdgGaussianBlur::setConfiguration(const KisPropertiesConfigurationSP con
     if (config->getProperty("lockAspect", value)) {
         m_widget->aspectButton->setKeepAspectRatio(value.toBool());
     }
+    m_widget->chkRecursive->setChecked(config->getBool("useRecursive", false));
 }
 
 void KisWdgGaussianBlur::horizontalRadiusChanged(qreal v)
@@ -26,6 +26,8 @@
 #include <ImfChannelList.h>
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
+#include <ImfThreading.h>
+#include <ImfTileDescription.h>
 
 #include <ImfStringAttribute.h>
 #include "exr_extra_tags.h"
@@ -35,6 +37,7 @@
 #include <QDomDocument>
 
 #include <QFileInfo>
+#include <QThread>
 
 #include <KoColorSpaceRegistry.h>
 #include <KoCompositeOpRegistry.h>
@@ -368,16 +371,55 @@ void multiplyAlpha(Pixel *pixel)
     }
 }
 
+/**
+ * OpenEXR (de)compresses the line blocks and tiles of a single
+ * readPixels()/writePixels() call in its own thread pool, so let it
+ * use all the cores we have
+ */
+int exrThreadCount()
+{
+    const int numThreads = QThread::idealThreadCount();
+
+    if (Imf::globalThreadCount() < numThreads) {
+        Imf::setGlobalThreadCount(numThreads);
+    }
+
+    return Imf::globalThreadCount();
+}
+
+/**
+ * The image is decoded in horizontal bands. For tiled files the band
+ * covers a whole row of EXR tiles, so every tile is decompressed only
+ * once, for scanline files we take a multiple of the line-block sizes
+ * used by the EXR compressors. Only the intermediate buffer is bounded
+ * by the band: the whole base level of the file is still decoded into
+ * the layer on import, the other mip levels are ignored.
+ */
+int decodingBandHeight(const Imf::Header &header)
+{
+    if (header.hasTileDescription()) {
+        return qMax(1, int(header.tileDescription().ySize));
+    }
+
+    return 64;
+}
+
 template<typename _T_>
 void EXRConverter::Private::decodeData4(Imf::InputFile& file, ExrPaintLayerInfo& info, KisPaintLayerSP layer, int width, int xstart, int ystart, int height, Imf::PixelType ptype)
 {
     typedef Rgba<_T_> Rgba;
+    typedef typename KoRgbTraits<_T_>::Pixel Pixel;
 
-    QVector<Rgba> pixels(width);
+    const int bandHeight = decodingBandHeight(file.header());
+
+    QVector<Rgba> pixels(width * bandHeight);
+    QVector<Pixel> dstPixels(width * bandHeight);
 
     bool hasAlpha = info.channelMap.contains("A");
 
-    for (int y = 0; y < height; ++y) {
+    for (int y = 0; y < height; y += bandHeight) {
+        const int numLines = qMin(bandHeight, height - y);
+
         Imf::FrameBuffer frameBuffer;
         Rgba* frameBufferData = (pixels.data()) - xstart - (ystart + y) * width;
         frameBuffer.insert(info.channelMap["R"].toLatin1().constData(),
@@ -400,17 +442,18 @@ void EXRConverter::Private::decodeData4(Imf::InputFile& file, ExrPaintLayerInfo&
         }
 
         file.setFrameBuffer(frameBuffer);
-        file.readPixels(ystart + y);
+        file.readPixels(ystart + y, ystart + y + numLines - 1);
+
         Rgba *rgba = pixels.data();
-        KisHLineIteratorSP it = layer->paintDevice()->createHLineIteratorNG(0, y, width);
-        do {
+        Pixel *dst = dstPixels.data();
+        const int numPixels = width * numLines;
+
+        for (int i = 0; i < numPixels; i++, rgba++, dst++) {
 
             if (hasAlpha) {
                 unmultiplyAlpha<RgbPixelWrapper<_T_> >(rgba);
             }
 
-            typename KoRgbTraits<_T_>::Pixel* dst = reinterpret_cast<typename KoRgbTraits<_T_>::Pixel*>(it->rawData());
-
             dst->red = rgba->r;
             dst->green = rgba->g;
             dst->blue = rgba->b;
@@ -419,10 +462,10 @@ void EXRConverter::Private::decodeData4(Imf::InputFile& file, ExrPaintLayerInfo&
             } else {
                 dst->alpha = 1.0;
             }
+        }
 
-
-            ++rgba;
-        } while (it->nextPixel());
+        layer->paintDevice()->writeBytes(reinterpret_cast<const quint8*>(dstPixels.constData()),
+                                         0, y, width, numLines);
     }
 
 }
@@ -436,7 +479,9 @@ void EXRConverter::Private::decodeData1(Imf::InputFile& file, ExrPaintLayerInfo&
     KIS_ASSERT_RECOVER_RETURN(
                 layer->paintDevice()->colorSpace()->colorModelId() == GrayAColorModelID);
 
-    QVector<pixel_type> pixels(width);
+    const int bandHeight = decodingBandHeight(file.header());
+
+    QVector<pixel_type> pixels(width * bandHeight);
 
     Q_ASSERT(info.channelMap.contains("G"));
     dbgFile << "G -> " << info.channelMap["G"];
@@ -445,7 +490,9 @@ void EXRConverter::Private::decodeData1(Imf::InputFile& file, ExrPaintLayerInfo&
     dbgFile << "Has Alpha:" << hasAlpha;
 
 
-    for (int y = 0; y < height; ++y) {
+    for (int y = 0; y < height; y += bandHeight) {
+        const int numLines = qMin(bandHeight, height - y);
+
         Imf::FrameBuffer frameBuffer;
         pixel_type* frameBufferData = (pixels.data()) - xstart - (ystart + y) * width;
         frameBuffer.insert(info.channelMap["G"].toLatin1().constData(),
@@ -461,23 +508,26 @@ void EXRConverter::Private::decodeData1(Imf::InputFile& file, ExrPaintLayerInfo&
         }
 
         file.setFrameBuffer(frameBuffer);
-        file.readPixels(ystart + y);
+        file.readPixels(ystart + y, ystart + y + numLines - 1);
 
+        /**
+         * The layout of the pixel is the same as in the color space,
+         * so we can convert the band in place
+         */
         pixel_type *srcPtr = pixels.data();
-        KisHLineIteratorSP it = layer->paintDevice()->createHLineIteratorNG(0, y, width);
-        do {
+        const int numPixels = width * numLines;
+
+        for (int i = 0; i < numPixels; i++, srcPtr++) {
 
             if (hasAlpha) {
                 unmultiplyAlpha<GrayPixelWrapper<_T_> >(srcPtr);
+            } else {
+                srcPtr->alpha = channel_type(1.0);
             }
+        }
 
-            pixel_type* dstPtr = reinterpret_cast<pixel_type*>(it->rawData());
-
-            dstPtr->gray = srcPtr->gray;
-            dstPtr->alpha = hasAlpha ? srcPtr->alpha : channel_type(1.0);
-
-            ++srcPtr;
-        } while (it->nextPixel());
+        layer->paintDevice()->writeBytes(reinterpret_cast<const quint8*>(pixels.constData()),
+                                         0, y, width, numLines);
     }
 
 }
@@ -566,7 +616,7 @@ bool EXRConverter::Private::checkExtraLayersInfoConsistent(const QDomDocument &d
 
 KisImageBuilder_Result EXRConverter::decode(const QString &filename)
 {
-    Imf::InputFile file(QFile::encodeName(filename));
+    Imf::InputFile file(QFile::encodeName(filename), exrThreadCount());
 
     Imath::Box2i dw = file.header().dataWindow();
     int width = dw.max.x - dw.min.x + 1;
@@ -893,12 +943,21 @@ struct ExrPixel_ {
     _T_ data[size];
 };
 
+/**
+ * The image is encoded in horizontal bands of this many lines. The
+ * value is a multiple of the line-block sizes used by all the EXR
+ * compressors (1, 16 and 32 lines), so OpenEXR can compress the
+ * blocks of a band in parallel, while the amount of memory used by
+ * the encoder stays bounded by the width of the image.
+ */
+const int EXR_ENCODING_BAND_HEIGHT = 64;
+
 class Encoder
 {
 public:
     virtual ~Encoder() {}
     virtual void prepareFrameBuffer(Imf::FrameBuffer*, int line) = 0;
-    virtual void encodeData(int line) = 0;
+    virtual void encodeData(int line, int numLines) = 0;
 
 };
 
@@ -906,10 +965,10 @@ template<typename _T_, int size, int alphaPos>
 class EncoderImpl : public Encoder
 {
 public:
-    EncoderImpl(Imf::OutputFile* _file, const ExrPaintLayerSaveInfo* _info, int width) : file(_file), info(_info), pixels(width), m_width(width) {}
+    EncoderImpl(Imf::OutputFile* _file, const ExrPaintLayerSaveInfo* _info, int width) : file(_file), info(_info), pixels(width * EXR_ENCODING_BAND_HEIGHT), m_width(width) {}
     ~EncoderImpl() override {}
     void prepareFrameBuffer(Imf::FrameBuffer*, int line) override;
-    void encodeData(int line) override;
+    void encodeData(int line, int numLines) override;
 private:
     typedef ExrPixel_<_T_, size> ExrPixel;
     Imf::OutputFile* file;
@@ -933,23 +992,27 @@ void EncoderImpl<_T_, size, alphaPos>::prepareFrameBuffer(Imf::FrameBuffer* fram
 }
 
 template<typename _T_, int size, int alphaPos>
-void EncoderImpl<_T_, size, alphaPos>::encodeData(int line)
+void EncoderImpl<_T_, size, alphaPos>::encodeData(int line, int numLines)
 {
-    ExrPixel *rgba = pixels.data();
-    KisHLineIteratorSP it = info->layer->paintDevice()->createHLineIteratorNG(0, line, m_width);
-    do {
-        const _T_* dst = reinterpret_cast < const _T_* >(it->oldRawData());
+    KIS_ASSERT_RECOVER_RETURN(numLines <= EXR_ENCODING_BAND_HEIGHT);
+    KIS_ASSERT_RECOVER_RETURN(info->layer->paintDevice()->pixelSize() == sizeof(ExrPixel));
 
-        for (int i = 0; i < size; ++i) {
-            rgba->data[i] = dst[i];
-        }
+    /**
+     * The layout of the EXR pixel is exactly the same as the one of
+     * the color space, so we can read the whole band directly
+     * into the frame buffer and premultiply it in place
+     */
+    info->layer->paintDevice()->readBytes(reinterpret_cast<quint8*>(pixels.data()),
+                                           0, line, m_width, numLines);
 
-        if (alphaPos != -1) {
+    if (alphaPos != -1) {
+        ExrPixel *rgba = pixels.data();
+        const int numPixels = m_width * numLines;
+
+        for (int i = 0; i < numPixels; i++, rgba++) {
             multiplyAlpha<_T_, ExrPixel, size, alphaPos>(rgba);
         }
-
-        ++rgba;
-    } while (it->nextPixel());
+    }
 }
 
 Encoder* encoder(Imf::OutputFile& file, const ExrPaintLayerSaveInfo& info, int width)
@@ -999,16 +1062,18 @@ void encodeData(Imf::OutputFile& file, const QList<ExrPaintLayerSaveInfo>& infor
         encoders.push_back(encoder(file, info, width));
     }
 
-    for (int y = 0; y < height; ++y) {
+    for (int y = 0; y < height; y += EXR_ENCODING_BAND_HEIGHT) {
+        const int numLines = qMin(EXR_ENCODING_BAND_HEIGHT, height - y);
+
         Imf::FrameBuffer frameBuffer;
         Q_FOREACH (Encoder* encoder, encoders) {
             encoder->prepareFrameBuffer(&frameBuffer, y);
         }
         file.setFrameBuffer(frameBuffer);
         Q_FOREACH (Encoder* encoder, encoders) {
-            encoder->encodeData(y);
+            encoder->encodeData(y, numLines);
         }
-        file.writePixels(1);
+        file.writePixels(numLines);
     }
     qDeleteAll(encoders);
 }
@@ -1056,7 +1121,7 @@ KisImageBuilder_Result EXRConverter::buildFile(const QString &filename, KisPaint
     info.pixelType = pixelType;
 
     // Open file for writing
-    Imf::OutputFile file(QFile::encodeName(filename), header);
+    Imf::OutputFile file(QFile::encodeName(filename), header, exrThreadCount());
 
     QList<ExrPaintLayerSaveInfo> informationObjects;
     informationObjects.push_back(info);
@@ -1298,7 +1363,7 @@ KisImageBuilder_Result EXRConverter::buildFile(const QString &filename, KisGroup
     }
 
     // Open file for writing
-    Imf::OutputFile file(QFile::encodeName(filename), header);
+    Imf::OutputFile file(QFile::encodeName(filename), header, exrThreadCount());
 
     encodeData(file, informationObjects, width, height);
     return KisImageBuilder_RESULT_OK;
@@ -23,6 +23,7 @@
 #include <QFileInfo>
 #include <QScopedPointer>
 #include <QUrl>
+#include <QXmlStreamReader>
 
 #include <KoStore.h>
 #include <KoStoreDevice.h>
@@ -36,6 +37,7 @@
 #include <kis_image.h>
 #include <kis_paint_layer.h>
 #include <kis_png_converter.h>
+#include <kis_config.h>
 #include <KisDocument.h>
 
 static const char CURRENT_DTD_VERSION[] = "2.0";
@@ -62,15 +64,13 @@ KisImageBuilder_Result KraConverter::buildImage(QIODevice *io)
         return KisImageBuilder_RESULT_FAILURE;
     }
 
+    // the merged image cache is validated against everything we load
+    m_store->setCalculateChecksums(KisKraLoader::hasMergedImageCache(m_store));
+
     bool success;
     {
         if (m_store->hasFile("root") || m_store->hasFile("maindoc.xml")) {   // Fallback to "old" file format (maindoc.xml)
-            KoXmlDocument doc;
-
-            bool ok = oldLoadAndParse(m_store, "root", doc);
-            if (ok)
-                ok = loadXML(doc, m_store);
-            if (!ok) {
+            if (!loadMainDocument(m_store)) {
                 return KisImageBuilder_RESULT_FAILURE;
             }
 
@@ -107,6 +107,11 @@ QList<KisPaintingAssistantSP> KraConverter::assistants()
     return m_assistants;
 }
 
+bool KraConverter::projectionLoadedFromCache() const
+{
+    return m_projectionLoadedFromCache;
+}
+
 KisImageBuilder_Result KraConverter::buildFile(QIODevice *io)
 {
     m_store = KoStore::createStore(io, KoStore::Write, m_doc->nativeFormatMimeType(), KoStore::Zip);
@@ -118,6 +123,12 @@ KisImageBuilder_Result KraConverter::buildFile(QIODevice *io)
 
     bool result = false;
 
+    const bool saveMergedImageCache =
+        !m_doc->isAutosaving() && KisConfig().saveMergedImageCache();
+
+    // the cache is validated against the checksums of all the saved files
+    m_store->setCalculateChecksums(saveMergedImageCache);
+
     m_kraSaver = new KisKraSaver(m_doc);
 
     result = saveRootDocuments(m_store);
@@ -135,6 +146,12 @@ KisImageBuilder_Result KraConverter::buildFile(QIODevice *io)
         qWarning() << "saving binary data failed";
     }
 
+    if (result && saveMergedImageCache) {
+        if (!m_kraSaver->saveMergedImageCache(m_store, m_image, m_doc->url().toLocalFile(), true)) {
+            qWarning() << "saving merged image cache failed";
+        }
+    }
+
     if (!m_store->finalize()) {
         return KisImageBuilder_RESULT_FAILURE;
     }
@@ -261,56 +278,81 @@ bool KraConverter::oldLoadAndParse(KoStore *store, const QString &filename, KoXm
     return true;
 }
 
-bool KraConverter::loadXML(const KoXmlDocument &doc, KoStore *store)
+bool KraConverter::loadMainDocument(KoStore *store)
 {
-    Q_UNUSED(store);
+    if (!store->open("root")) {
+        warnUI << "Entry root not found!";
+        m_doc->setErrorMessage(i18n("Could not find %1", QString("root")));
+        return false;
+    }
+
+    const QByteArray data = store->device()->readAll();
+    store->close();
 
-    KoXmlElement root;
-    KoXmlNode node;
+    /**
+     * The main document may contain thousands of nodes, so it is
+     * not converted into DOM. The pull-parser reads the layer stack
+     * directly into the image.
+     */
+    QXmlStreamReader reader(data);
+
+    bool hasDocType = false;
+
+    while (!reader.atEnd() && !reader.isStartElement()) {
+        reader.readNext();
+        if (reader.isDTD()) {
+            hasDocType = reader.dtdName() == QLatin1String("DOC");
+        }
+    }
 
-    if (doc.doctype().name() != "DOC") {
-       m_doc->setErrorMessage(i18n("The format is not supported or the file is corrupted"));
+    if (reader.hasError()) {
+        errUI << "Parsing error in root! Aborting!" << endl
+              << " In line: " << reader.lineNumber() << ", column: " << reader.columnNumber() << endl
+              << " Error message: " << reader.errorString() << endl;
+        m_doc->setErrorMessage(i18n("Parsing error in %1 at line %2, column %3\nError message: %4",
+                                    QString("root"), reader.lineNumber(), reader.columnNumber(),
+                                    reader.errorString()));
         return false;
     }
-    root = doc.documentElement();
-    int syntaxVersion = root.attribute("syntaxVersion", "3").toInt();
+
+    if (!hasDocType) {
+        m_doc->setErrorMessage(i18n("The format is not supported or the file is corrupted"));
+        return false;
+    }
+
+    const QStringRef syntaxVersionString = reader.attributes().value(QLatin1String("syntaxVersion"));
+    int syntaxVersion = !syntaxVersionString.isNull() ? syntaxVersionString.toInt() : 3;
     if (syntaxVersion > 2) {
-       m_doc->setErrorMessage(i18n("The file is too new for this version of Krita (%1).", syntaxVersion));
+        m_doc->setErrorMessage(i18n("The file is too new for this version of Krita (%1).", syntaxVersion));
         return false;
     }
 
-    if (!root.hasChildNodes()) {
-       m_doc->setErrorMessage(i18n("The file has no layers."));
+    if (!reader.readNextStartElement()) {
+        m_doc->setErrorMessage(i18n("The file has no layers."));
         return false;
     }
 
     m_kraLoader = new KisKraLoader(m_doc, syntaxVersion);
 
     // Legacy from the multi-image .kra file period.
-    for (node = root.firstChild(); !node.isNull(); node = node.nextSibling()) {
-        if (node.isElement()) {
-            if (node.nodeName() == "IMAGE") {
-                KoXmlElement elem = node.toElement();
-                if (!(m_image = m_kraLoader->loadXML(elem))) {
-                    if (m_kraLoader->errorMessages().isEmpty()) {
-                        m_doc->setErrorMessage(i18n("Unknown error."));
-                    }
-                    else {
-                        m_doc->setErrorMessage(m_kraLoader->errorMessages().join("\n"));
-                    }
-                    return false;
-                }
-                return true;
-            }
-            else {
-                if (m_kraLoader->errorMessages().isEmpty()) {
-                    m_doc->setErrorMessage(i18n("The file does not contain an image."));
-                }
-                return false;
-            }
+    if (reader.name() != QLatin1String("IMAGE")) {
+        if (m_kraLoader->errorMessages().isEmpty()) {
+            m_doc->setErrorMessage(i18n("The file does not contain an image."));
+        }
+        return false;
+    }
+
+    if (!(m_image = m_kraLoader->loadXML(reader))) {
+        if (m_kraLoader->errorMessages().isEmpty()) {
+            m_doc->setErrorMessage(i18n("Unknown error."));
+        }
+        else {
+            m_doc->setErrorMessage(m_kraLoader->errorMessages().join("\n"));
         }
+        return false;
     }
-    return false;
+
+    return true;
 }
 
 bool KraConverter::completeLoading(KoStore* store)
@@ -329,6 +371,9 @@ bool KraConverter::completeLoading(KoStore* store)
 
     m_kraLoader->loadBinaryData(store, m_image, m_doc->localFilePath(), true);
 
+    m_projectionLoadedFromCache =
+        m_kraLoader->loadMergedImageCache(store, m_image, m_doc->localFilePath(), true);
+
     m_image->unblockUpdates();
 
     bool retval = true;
@@ -51,6 +51,13 @@ public:
     vKisNodeSP activeNodes();
     QList<KisPaintingAssistantSP> assistants();
 
+    /**
+     * @return true if the projection of the loaded image has been
+     * seeded from the merged image cache, so the initial refresh of
+     * the image can be done in background
+     */
+    bool projectionLoadedFromCache() const;
+
 public Q_SLOTS:
 
     virtual void cancel();
@@ -62,7 +69,7 @@ private:
     QDomDocument createDomDocument();
     bool savePreview(KoStore *store);
     bool oldLoadAndParse(KoStore *store, const QString &filename, KoXmlDocument &xmldoc);
-    bool loadXML(const KoXmlDocument &doc, KoStore *store);
+    bool loadMainDocument(KoStore *store);
     bool completeLoading(KoStore *store);
 
     KisDocument *m_doc {0};
@@ -71,6 +78,7 @@ private:
     vKisNodeSP m_activeNodes;
     QList<KisPaintingAssistantSP> m_assistants;
     bool m_stop {false};
+    bool m_projectionLoadedFromCache {false};
 
     KoStore *m_store {0};
     KisKraSaver *m_kraSaver {0};
@@ -59,7 +59,7 @@ KisImportExportFilter::ConversionStatus KraImport::convert(KisDocument *document
         return KisImportExportFilter::InternalError;
         break;
     case KisImageBuilder_RESULT_OK:
-        document->setCurrentImage(kraConverter.image());
+        document->setCurrentImage(kraConverter.image(), !kraConverter.projectionLoadedFromCache());
         if (kraConverter.activeNodes().size() > 0) {
             document->setPreActivatedNode(kraConverter.activeNodes()[0]);
         }
@@ -26,6 +26,7 @@
 
 #include <QUrl>
 #include <QBuffer>
+#include <QXmlStreamReader>
 
 #include <KoStore.h>
 #include <KoColorSpaceRegistry.h>
@@ -192,6 +193,108 @@ KisKraLoader::~KisKraLoader()
 
 
 KisImageSP KisKraLoader::loadXML(const KoXmlElement& element)
+{
+    KisImageSP image = createImage(element);
+
+    if (image) {
+        loadNodes(element, image, const_cast<KisGroupLayer*>(image->rootLayer().data()));
+        loadImageProperties(element, image);
+    }
+
+    return image;
+}
+
+namespace {
+
+/**
+ * Creates a childless element with the same name and attributes as the
+ * current start element of \p reader
+ */
+QDomElement createElementFromStream(QDomDocument &doc, const QXmlStreamReader &reader)
+{
+    QDomElement element = doc.createElement(reader.qualifiedName().toString());
+
+    Q_FOREACH (const QXmlStreamAttribute &attribute, reader.attributes()) {
+        element.setAttribute(attribute.qualifiedName().toString(), attribute.value().toString());
+    }
+
+    return element;
+}
+
+/**
+ * Reads the whole subtree of the current start element of \p reader.
+ * Whitespace-only text is dropped the same way QDomDocument does.
+ */
+QDomElement readElementFromStream(QDomDocument &doc, QXmlStreamReader &reader)
+{
+    QDomElement element = createElementFromStream(doc, reader);
+
+    while (!reader.atEnd()) {
+        const QXmlStreamReader::TokenType token = reader.readNext();
+
+        if (token == QXmlStreamReader::EndElement) {
+            break;
+        } else if (token == QXmlStreamReader::StartElement) {
+            element.appendChild(readElementFromStream(doc, reader));
+        } else if (token == QXmlStreamReader::Characters && !reader.isWhitespace()) {
+            if (reader.isCDATA()) {
+                element.appendChild(doc.createCDATASection(reader.text().toString()));
+            } else {
+                element.appendChild(doc.createTextNode(reader.text().toString()));
+            }
+        }
+    }
+
+    return element;
+}
+
+bool isNodeListElement(const QXmlStreamReader &reader)
+{
+    return !reader.name().compare(LAYERS, Qt::CaseInsensitive) ||
+        !reader.name().compare(MASKS, Qt::CaseInsensitive);
+}
+
+}
+
+KisImageSP KisKraLoader::loadXML(QXmlStreamReader &reader)
+{
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(reader.isStartElement(), KisImageSP());
+
+    QDomDocument doc;
+    QDomElement element = createElementFromStream(doc, reader);
+
+    KisImageSP image = createImage(element);
+
+    /**
+     * The layer stack is created directly from the stream, everything
+     * else is small and is read into a DOM subtree, so it is handled
+     * exactly the same way as in the DOM-based loader
+     */
+    bool isFirstChild = true;
+
+    while (reader.readNextStartElement()) {
+        if (image && isFirstChild && isNodeListElement(reader)) {
+            loadNodes(reader, doc, image, const_cast<KisGroupLayer*>(image->rootLayer().data()));
+        } else {
+            element.appendChild(readElementFromStream(doc, reader));
+        }
+        isFirstChild = false;
+    }
+
+    if (reader.hasError()) {
+        m_d->errorMessages << i18n("Parsing error at line %1, column %2: %3",
+                                   reader.lineNumber(), reader.columnNumber(), reader.errorString());
+        return KisImageSP();
+    }
+
+    if (image) {
+        loadImageProperties(element, image);
+    }
+
+    return image;
+}
+
+KisImageSP KisKraLoader::createImage(const KoXmlElement& element)
 {
     QString attr;
     KisImageSP image = 0;
@@ -298,42 +401,47 @@ KisImageSP KisKraLoader::loadXML(const KoXmlElement& element)
             image = new KisImage(0, width, height, cs, name);
         }
         image->setResolution(xres, yres);
-        loadNodes(element, image, const_cast<KisGroupLayer*>(image->rootLayer().data()));
+        image->setProofingConfiguration(proofingConfig);
+    }
 
+    return image;
+}
 
-        KoXmlNode child;
-        for (child = element.lastChild(); !child.isNull(); child = child.previousSibling()) {
-            KoXmlElement e = child.toElement();
-            if(e.tagName() == CANVASPROJECTIONCOLOR) {
-                if (e.hasAttribute(COLORBYTEDATA)) {
-                    QByteArray colorData = QByteArray::fromBase64(e.attribute(COLORBYTEDATA).toLatin1());
-                    KoColor color((const quint8*)colorData.data(), image->colorSpace());
-                    image->setDefaultProjectionColor(color);
-                }
-            }
+void KisKraLoader::loadImageProperties(const KoXmlElement& element, KisImageSP image)
+{
+    KisProofingConfigurationSP proofingConfig = image->proofingConfiguration();
 
-            if(e.tagName()== PROOFINGWARNINGCOLOR) {
-                QDomDocument dom;
-                KoXml::asQDomElement(dom, e);
-                QDomElement eq = dom.firstChildElement();
-                proofingConfig->warningColor = KoColor::fromXML(eq.firstChildElement(), Integer8BitsColorDepthID.id());
+    KoXmlNode child;
+    for (child = element.lastChild(); !child.isNull(); child = child.previousSibling()) {
+        KoXmlElement e = child.toElement();
+        if(e.tagName() == CANVASPROJECTIONCOLOR) {
+            if (e.hasAttribute(COLORBYTEDATA)) {
+                QByteArray colorData = QByteArray::fromBase64(e.attribute(COLORBYTEDATA).toLatin1());
+                KoColor color((const quint8*)colorData.data(), image->colorSpace());
+                image->setDefaultProjectionColor(color);
             }
+        }
 
-            if (e.tagName().toLower() == "animation") {
-                loadAnimationMetadata(e, image);
-            }
+        if(e.tagName()== PROOFINGWARNINGCOLOR) {
+            QDomDocument dom;
+            KoXml::asQDomElement(dom, e);
+            QDomElement eq = dom.firstChildElement();
+            proofingConfig->warningColor = KoColor::fromXML(eq.firstChildElement(), Integer8BitsColorDepthID.id());
         }
 
-        image->setProofingConfiguration(proofingConfig);
+        if (e.tagName().toLower() == "animation") {
+            loadAnimationMetadata(e, image);
+        }
+    }
 
-        for (child = element.lastChild(); !child.isNull(); child = child.previousSibling()) {
-            KoXmlElement e = child.toElement();
-            if(e.tagName() == "compositions") {
-                loadCompositions(e, image);
-            }
+    image->setProofingConfiguration(proofingConfig);
+
+    for (child = element.lastChild(); !child.isNull(); child = child.previousSibling()) {
+        KoXmlElement e = child.toElement();
+        if(e.tagName() == "compositions") {
+            loadCompositions(e, image);
         }
     }
-    KoXmlNode child;
 
     for (child = element.lastChild(); !child.isNull(); child = child.previousSibling()) {
         KoXmlElement e = child.toElement();
@@ -347,8 +455,6 @@ KisImageSP KisKraLoader::loadXML(const KoXmlElement& element)
             loadAudio(e, image);
         }
     }
-
-    return image;
 }
 
 void KisKraLoader::loadBinaryData(KoStore * store, KisImageSP image, const QString & uri, bool external)
@@ -473,6 +579,73 @@ void KisKraLoader::loadBinaryData(KoStore * store, KisImageSP image, const QStri
     loadAssistants(store, uri, external);
 }
 
+bool KisKraLoader::hasMergedImageCache(KoStore *store)
+{
+    Q_FOREACH (const QString &directory, store->directoryList()) {
+        if (store->hasFile(directory + MERGED_IMAGE_CACHE_CHECKSUM_PATH)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool KisKraLoader::loadMergedImageCache(KoStore* store, KisImageSP image, const QString & uri, bool external)
+{
+    const QString imagePath = (external ? QString() : uri) + m_d->imageName;
+    QString location = imagePath + MERGED_IMAGE_CACHE_CHECKSUM_PATH;
+
+    if (!store->hasFile(location) || !store->open(location)) {
+        return false;
+    }
+
+    const QByteArray manifest = store->read(store->size());
+    store->close();
+
+    QMap<QString, QByteArray> savedChecksums;
+    if (!KRA::manifestToChecksums(manifest, &savedChecksums)) {
+        return false;
+    }
+
+    const QMap<QString, QByteArray> loadedChecksums =
+        KRA::projectionDependencies(store->checksums(), imagePath);
+
+    /**
+     * Every file we have just loaded must be the same as when the cache
+     * was saved. The saved files we haven't loaded don't influence the
+     * projection, unless they have been removed from the store.
+     */
+    for (auto it = loadedChecksums.constBegin(); it != loadedChecksums.constEnd(); ++it) {
+        if (savedChecksums.value(it.key()) != it.value()) {
+            dbgFile << "Merged image cache is outdated, skipping it:" << it.key() << "changed";
+            return false;
+        }
+    }
+
+    for (auto it = savedChecksums.constBegin(); it != savedChecksums.constEnd(); ++it) {
+        if (!loadedChecksums.contains(it.key()) && !store->hasFile(it.key())) {
+            dbgFile << "Merged image cache is outdated, skipping it:" << it.key() << "removed";
+            return false;
+        }
+    }
+
+    location = imagePath + MERGED_IMAGE_CACHE_PATH;
+
+    if (!store->open(location)) {
+        return false;
+    }
+
+    KisPaintDeviceSP dev = image->projection();
+    const bool result = dev->read(store->device());
+    store->close();
+
+    if (!result) {
+        dev->clear();
+    }
+
+    return result;
+}
+
 vKisNodeSP KisKraLoader::selectedNodes() const
 {
     return m_d->selectedNodes;
@@ -571,6 +744,32 @@ KisNodeSP KisKraLoader::loadNodes(const KoXmlElement& element, KisImageSP image,
     return parent;
 }
 
+void KisKraLoader::loadNodes(QXmlStreamReader &reader, QDomDocument &doc, KisImageSP image, KisNodeSP parent)
+{
+    /**
+     * The nodes are stored from the topmost to the lowermost one,
+     * so every new node is put under the already loaded siblings
+     */
+    while (reader.readNextStartElement()) {
+        KisNodeSP node = loadNode(createElementFromStream(doc, reader), image, parent);
+        if (node) {
+            image->nextLayerName(); // Make sure the nameserver is current with the number of nodes.
+            image->addNode(node, parent, KisNodeSP());
+        }
+
+        bool isFirstChild = true;
+
+        while (reader.readNextStartElement()) {
+            if (node && node->inherits("KisLayer") && isFirstChild && isNodeListElement(reader)) {
+                loadNodes(reader, doc, image, node);
+            } else {
+                reader.skipCurrentElement();
+            }
+            isFirstChild = false;
+        }
+    }
+}
+
 KisNodeSP KisKraLoader::loadNode(const KoXmlElement& element, KisImageSP image, KisNodeSP parent)
 {
     // Nota bene: If you add new properties to layers, you should
@@ -21,6 +21,7 @@
 
 class QString;
 class QStringList;
+class QXmlStreamReader;
 
 #include "KoXmlReaderForward.h"
 class KoStore;
@@ -51,8 +52,36 @@ public:
      */
     KisImageSP loadXML(const KoXmlElement& elem);
 
+    /**
+     * Same as loadXML(const KoXmlElement&), but reads the image directly
+     * from a pull-parser positioned at the start of the IMAGE element,
+     * without building the DOM for the layer stack. On return, the reader
+     * is positioned at the end of the IMAGE element.
+     */
+    KisImageSP loadXML(QXmlStreamReader &reader);
+
     void loadBinaryData(KoStore* store, KisImageSP image, const QString & uri, bool external);
 
+    /**
+     * @return true if the store contains a merged image cache. In such a
+     * case the checksums of the store should be enabled before anything
+     * is loaded from it, so that loadMergedImageCache() could check the
+     * cache.
+     */
+    static bool hasMergedImageCache(KoStore *store);
+
+    /**
+     * Loads the merged image cache (if present) into the projection of
+     * the image. The cache is loaded only if none of the files the
+     * projection depends on, that is maindoc.xml and everything in the
+     * directory of the image, has changed since the cache was saved.
+     * The files are checked with the checksums KoStore calculated while
+     * loading them, so it must be called after loadBinaryData().
+     *
+     * @return true if the projection has been loaded from the cache
+     */
+    bool loadMergedImageCache(KoStore* store, KisImageSP image, const QString & uri, bool external);
+
     vKisNodeSP selectedNodes() const;
 
     // it's neater to follow the same design as with selectedNodes, so let's have a getter here
@@ -71,8 +100,14 @@ private:
 
     void loadAnimationMetadata(const KoXmlElement& element, KisImageSP image);
 
+    KisImageSP createImage(const KoXmlElement& element);
+
+    void loadImageProperties(const KoXmlElement& element, KisImageSP image);
+
     KisNodeSP loadNodes(const KoXmlElement& element, KisImageSP image, KisNodeSP parent);
 
+    void loadNodes(QXmlStreamReader &reader, QDomDocument &doc, KisImageSP image, KisNodeSP parent);
+
     KisNodeSP loadNode(const KoXmlElement& elem, KisImageSP image, KisNodeSP parent);
 
     KisNodeSP loadPaintLayer(const KoXmlElement& elem, KisImageSP image, const QString& name, const KoColorSpace* cs, quint32 opacity);
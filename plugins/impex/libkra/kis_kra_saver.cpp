@@ -21,6 +21,7 @@
 #include "kis_kra_tags.h"
 #include "kis_kra_save_visitor.h"
 #include "kis_kra_savexml_visitor.h"
+#include "kis_kra_utils.h"
 
 #include <QDomDocument>
 #include <QDomElement>
@@ -40,6 +41,7 @@
 
 #include <kis_annotation.h>
 #include <kis_image.h>
+#include <kis_paint_device.h>
 #include <kis_image_animation_interface.h>
 #include <kis_group_layer.h>
 #include <kis_layer.h>
@@ -48,6 +50,7 @@
 #include <kis_painting_assistants_decoration.h>
 #include <kis_psd_layer_style_resource.h>
 #include "kis_png_converter.h"
+#include "kis_store_paintdevice_writer.h"
 #include "kis_keyframe_channel.h"
 #include <kis_time_range.h>
 #include "KisDocument.h"
@@ -286,6 +289,39 @@ bool KisKraSaver::saveBinaryData(KoStore* store, KisImageSP image, const QString
     return true;
 }
 
+bool KisKraSaver::saveMergedImageCache(KoStore *store, KisImageSP image, const QString &uri, bool external)
+{
+    const QString imagePath = (external ? QString() : uri) + m_d->imageName;
+    QString location = imagePath + MERGED_IMAGE_CACHE_PATH;
+
+    KisPaintDeviceSP dev = image->projection();
+
+    if (!store->open(location)) {
+        return false;
+    }
+
+    KisStorePaintDeviceWriter writer(store);
+    if (!dev->write(writer)) {
+        store->close();
+        return false;
+    }
+    store->close();
+
+    location = imagePath + MERGED_IMAGE_CACHE_CHECKSUM_PATH;
+
+    if (!store->open(location)) {
+        return false;
+    }
+
+    const QByteArray manifest =
+        KRA::checksumsToManifest(KRA::projectionDependencies(store->checksums(), imagePath));
+
+    const bool result = store->write(manifest) == manifest.size();
+    store->close();
+
+    return result;
+}
+
 QStringList KisKraSaver::errorMessages() const
 {
     return m_d->errorMessages;
@@ -44,6 +44,17 @@ public:
 
     bool saveBinaryData(KoStore* store, KisImageSP image, const QString & uri, bool external, bool includeMerge);
 
+    /**
+     * Saves the projection of the image in Krita's own tiled format,
+     * which is much faster to write and read than mergedimage.png.
+     * The cache is accompanied with a manifest listing the checksums of
+     * maindoc.xml and every file saved into the directory of the image,
+     * so the loader can check if it is still valid. Must be called after
+     * everything else is saved into the image directory, and the store
+     * must have its checksums enabled before maindoc.xml is saved.
+     */
+    bool saveMergedImageCache(KoStore *store, KisImageSP image, const QString &uri, bool external);
+
     /// @return a list with everthing that went wrong while saving
     QStringList errorMessages() const;
 
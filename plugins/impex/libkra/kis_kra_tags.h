@@ -40,6 +40,9 @@ const QString ICC_PROOFING_PATH = "/annotations/proofing/icc";
 const QString LAYER_STYLES_PATH = "/annotations/layerstyles.asl";
 const QString ASSISTANTS_PATH = "/assistants/";
 const QString LAYER_PATH = "/layers/";
+const QString MERGED_IMAGE_CACHE_PATH = "/mergedimage.cache";
+const QString MERGED_IMAGE_CACHE_CHECKSUM_PATH = "/mergedimage.cache.checksum";
+const QString MAIN_DOCUMENT_NAME = "maindoc.xml";
 
 const QString ADJUSTMENT_LAYER = "adjustmentlayer";
 const QString CHANNEL_FLAGS = "channelflags";
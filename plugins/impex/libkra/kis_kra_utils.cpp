@@ -18,6 +18,7 @@
  */
 
 #include "kis_kra_utils.h"
+#include "kis_kra_tags.h"
 
 QString KRA::flagsToString(const QBitArray& flags, int size, char trueToken, char falseToken, bool defaultTrue)
 {
@@ -42,3 +43,54 @@ QBitArray KRA::stringToFlags(const QString& string, int size, char token, bool d
     
     return flags;
 }
+
+QMap<QString, QByteArray> KRA::projectionDependencies(const QMap<QString, QByteArray> &storeChecksums, const QString &imagePath)
+{
+    QMap<QString, QByteArray> result;
+
+    const QString imagePrefix = imagePath + "/";
+    const QString cacheFile = imagePath + MERGED_IMAGE_CACHE_PATH;
+    const QString manifestFile = imagePath + MERGED_IMAGE_CACHE_CHECKSUM_PATH;
+
+    for (auto it = storeChecksums.constBegin(); it != storeChecksums.constEnd(); ++it) {
+        const QString &fileName = it.key();
+
+        if (fileName == MAIN_DOCUMENT_NAME ||
+            (fileName.startsWith(imagePrefix) &&
+             fileName != cacheFile &&
+             fileName != manifestFile)) {
+
+            result.insert(fileName, it.value());
+        }
+    }
+
+    return result;
+}
+
+QByteArray KRA::checksumsToManifest(const QMap<QString, QByteArray> &checksums)
+{
+    QByteArray result;
+
+    for (auto it = checksums.constBegin(); it != checksums.constEnd(); ++it) {
+        result += it.value().toHex() + ' ' + it.key().toUtf8() + '\n';
+    }
+
+    return result;
+}
+
+bool KRA::manifestToChecksums(const QByteArray &manifest, QMap<QString, QByteArray> *checksums)
+{
+    checksums->clear();
+
+    Q_FOREACH (const QByteArray &line, manifest.split('\n')) {
+        if (line.isEmpty()) continue;
+
+        const int separator = line.indexOf(' ');
+        if (separator <= 0) return false;
+
+        checksums->insert(QString::fromUtf8(line.mid(separator + 1)),
+                          QByteArray::fromHex(line.left(separator)));
+    }
+
+    return true;
+}
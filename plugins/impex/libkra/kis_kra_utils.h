@@ -21,12 +21,32 @@
 
 #include <QString>
 #include <QBitArray>
+#include <QMap>
+
+#include "kritalibkra_export.h"
 
 namespace KRA {
 
 QString   flagsToString(const QBitArray& flags, int size=-1, char trueToken='1', char falseToken='0', bool defaultTrue=true);
 QBitArray stringToFlags(const QString& string, int size=-1, char token='0', bool defaultTrue=true);
 
+/**
+ * Selects the checksums of the files the projection of the image stored
+ * in a .kra file depends on: maindoc.xml and everything inside the
+ * directory of the image, except the merged image cache itself.
+ *
+ * @param storeChecksums the checksums collected by KoStore
+ * @param imagePath the path of the image directory in the store
+ */
+KRITALIBKRA_EXPORT QMap<QString, QByteArray> projectionDependencies(const QMap<QString, QByteArray> &storeChecksums, const QString &imagePath);
+
+/**
+ * Converts the checksums into a list of lines in the "<sha1> <file>"
+ * format and back
+ */
+KRITALIBKRA_EXPORT QByteArray checksumsToManifest(const QMap<QString, QByteArray> &checksums);
+KRITALIBKRA_EXPORT bool manifestToChecksums(const QByteArray &manifest, QMap<QString, QByteArray> *checksums);
+
 }
 
 #endif // _KIS_KRA_UTILS_
@@ -38,6 +38,10 @@
 #include "kis_keyframe_channel.h"
 #include "kis_time_range.h"
 
+#include <QXmlStreamReader>
+#include <KoStore.h>
+#include "kis_kra_loader.h"
+
 void KisKraLoaderTest::initTestCase()
 {
     KisFilterRegistry::instance();
@@ -168,5 +172,54 @@ void KisKraLoaderTest::testLoadAnimated()
     QCOMPARE(dev->defaultPixel(), red);
 }
 
+void compareNodeTrees(KisNodeSP domNode, KisNodeSP streamNode)
+{
+    QVERIFY(domNode);
+    QVERIFY(streamNode);
+
+    QCOMPARE(streamNode->name(), domNode->name());
+    if (domNode->parent()) {
+        QCOMPARE(streamNode->uuid(), domNode->uuid());
+    }
+    QCOMPARE(QString(streamNode->metaObject()->className()), QString(domNode->metaObject()->className()));
+    QCOMPARE(streamNode->childCount(), domNode->childCount());
+
+    for (quint32 i = 0; i < domNode->childCount(); i++) {
+        compareNodeTrees(domNode->at(i), streamNode->at(i));
+    }
+}
+
+void KisKraLoaderTest::testStreamLoadingMatchesDom()
+{
+    QScopedPointer<KoStore> store(
+        KoStore::createStore(QString(FILES_DATA_DIR) + QDir::separator() + "load_test.kra",
+                             KoStore::Read, "", KoStore::Zip));
+    QVERIFY(!store->bad());
+
+    QVERIFY(store->open("root"));
+    const QByteArray mainDoc = store->device()->readAll();
+    store->close();
+
+    QDomDocument doc;
+    QVERIFY(doc.setContent(mainDoc));
+    KisKraLoader domLoader(0, 2);
+    KisImageSP domImage = domLoader.loadXML(doc.documentElement().firstChildElement("IMAGE"));
+    QVERIFY(domImage);
+
+    QXmlStreamReader reader(mainDoc);
+    QVERIFY(reader.readNextStartElement()); // DOC
+    QVERIFY(reader.readNextStartElement()); // IMAGE
+    KisKraLoader streamLoader(0, 2);
+    KisImageSP streamImage = streamLoader.loadXML(reader);
+    QVERIFY(streamImage);
+    QVERIFY(!reader.hasError());
+
+    QCOMPARE(streamImage->bounds(), domImage->bounds());
+    QCOMPARE(streamImage->colorSpace()->id(), domImage->colorSpace()->id());
+    QCOMPARE(streamImage->nlayers(), domImage->nlayers());
+    QCOMPARE(streamLoader.selectedNodes().size(), domLoader.selectedNodes().size());
+
+    compareNodeTrees(domImage->root(), streamImage->root());
+}
 
 QTEST_MAIN(KisKraLoaderTest)
@@ -546,4 +546,262 @@ void KisKraSaverTest::testRoundTripShapeSelection()
     QVERIFY(chk.testPassed());
 }
 
+#include <functional>
+#include <QBuffer>
+#include <QXmlStreamReader>
+#include <KoStore.h>
+#include "kis_kra_saver.h"
+#include "kis_kra_loader.h"
+#include "kis_kra_tags.h"
+#include "kis_kra_utils.h"
+
+namespace {
+
+const QString cacheTestImageName = "cache_test";
+
+KisImageSP createCacheTestImage(KisDocument *doc, int pixelWidth)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(new KisSurrogateUndoStore(), 256, 256, cs, cacheTestImageName);
+
+    KisPaintLayerSP layer = new KisPaintLayer(image, "paint", OPACITY_OPAQUE_U8);
+    layer->paintDevice()->fill(QRect(10, 10, 100, 100), KoColor(Qt::red, cs));
+    layer->paintDevice()->fill(QRect(110, 50, 100, 100), KoColor(Qt::blue, cs));
+    image->addNode(layer);
+
+    KisFilterConfigurationSP kfc = KisFilterRegistry::instance()->get("pixelize")->defaultConfiguration();
+    kfc->setProperty("pixelWidth", pixelWidth);
+    kfc->setProperty("pixelHeight", pixelWidth);
+    KisAdjustmentLayerSP adjustmentLayer = new KisAdjustmentLayer(image, "adjustment", kfc, 0);
+    image->addNode(adjustmentLayer);
+
+    doc->setCurrentImage(image);
+    doc->documentInfo()->setAboutInfo("title", cacheTestImageName);
+
+    image->initialRefreshGraph();
+
+    return image;
+}
+
+/**
+ * Saves the image the same way KraConverter does, optionally with
+ * the merged image cache
+ */
+QByteArray saveToKra(KisDocument *doc, KisImageSP image, bool withCache)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+
+    {
+        QScopedPointer<KoStore> store(KoStore::createStore(&buffer, KoStore::Write, "application/x-krita", KoStore::Zip));
+        store->setCalculateChecksums(withCache);
+
+        KisKraSaver saver(doc);
+
+        QDomDocument mainDoc = KisDocument::createDomDocument("krita", "DOC", "2.0");
+        mainDoc.documentElement().setAttribute("syntaxVersion", "2");
+        mainDoc.documentElement().appendChild(saver.saveXML(mainDoc, image));
+
+        store->open("root");
+        store->write(mainDoc.toByteArray());
+        store->close();
+
+        saver.saveBinaryData(store.data(), image, QString(), true, false);
+
+        if (withCache) {
+            saver.saveMergedImageCache(store.data(), image, QString(), true);
+        }
+
+        store->finalize();
+    }
+
+    return data;
+}
+
+/**
+ * Loads the image the same way KraConverter does
+ */
+KisImageSP loadFromKra(KisDocument *doc, QByteArray data, bool *loadedFromCache)
+{
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QScopedPointer<KoStore> store(KoStore::createStore(&buffer, KoStore::Read, "", KoStore::Zip));
+    store->setCalculateChecksums(KisKraLoader::hasMergedImageCache(store.data()));
+
+    store->open("root");
+    const QByteArray mainDoc = store->device()->readAll();
+    store->close();
+
+    QXmlStreamReader reader(mainDoc);
+    reader.readNextStartElement(); // DOC
+    reader.readNextStartElement(); // IMAGE
+
+    KisKraLoader loader(doc, 2);
+    KisImageSP image = loader.loadXML(reader);
+    if (!image) return image;
+
+    image->blockUpdates();
+    loader.loadBinaryData(store.data(), image, QString(), true);
+    *loadedFromCache = loader.loadMergedImageCache(store.data(), image, QString(), true);
+    image->unblockUpdates();
+
+    return image;
+}
+
+QByteArray extractFile(QByteArray data, const QString &fileName)
+{
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QScopedPointer<KoStore> store(KoStore::createStore(&buffer, KoStore::Read, "", KoStore::Zip));
+
+    QByteArray content;
+    store->extractFile(fileName, content);
+    return content;
+}
+
+QStringList cachedFiles(const QByteArray &data)
+{
+    QMap<QString, QByteArray> checksums;
+    KRA::manifestToChecksums(extractFile(data, cacheTestImageName + KRA::MERGED_IMAGE_CACHE_CHECKSUM_PATH), &checksums);
+    return checksums.keys();
+}
+
+/**
+ * Copies maindoc.xml, all the files of the image directory and the
+ * cache into a new store, passing them through \p modify on the way.
+ * The files \p modify returns a null array for are dropped.
+ */
+QByteArray copyKra(const QByteArray &data,
+                   std::function<QByteArray (const QString &, const QByteArray &)> modify)
+{
+    QStringList fileNames = cachedFiles(data);
+    fileNames << cacheTestImageName + KRA::MERGED_IMAGE_CACHE_PATH;
+    fileNames << cacheTestImageName + KRA::MERGED_IMAGE_CACHE_CHECKSUM_PATH;
+
+    QByteArray result;
+    QBuffer buffer(&result);
+    buffer.open(QIODevice::WriteOnly);
+
+    {
+        QScopedPointer<KoStore> store(KoStore::createStore(&buffer, KoStore::Write, "application/x-krita", KoStore::Zip));
+
+        Q_FOREACH (const QString &fileName, fileNames) {
+            const QByteArray content = modify(fileName, extractFile(data, fileName));
+
+            if (!content.isNull()) {
+                store->open(fileName);
+                store->write(content);
+                store->close();
+            }
+        }
+
+        store->finalize();
+    }
+
+    return result;
+}
+
+}
+
+void KisKraSaverTest::testMergedImageCacheValid()
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    KisImageSP image = createCacheTestImage(doc.data(), 10);
+
+    const QByteArray data = saveToKra(doc.data(), image, true);
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    bool loadedFromCache = false;
+    KisImageSP image2 = loadFromKra(doc2.data(), data, &loadedFromCache);
+    QVERIFY(image2);
+    QVERIFY(loadedFromCache);
+
+    // the projection comes from the cache, nothing has been recomposed yet
+    QVERIFY(TestUtil::comparePaintDevices(image->projection(), image2->projection()));
+
+    // a faithful copy of the file is still valid
+    const QByteArray copy = copyKra(data, [] (const QString &, const QByteArray &content) {
+        return content;
+    });
+
+    QScopedPointer<KisDocument> doc3(KisPart::instance()->createDocument());
+    KisImageSP image3 = loadFromKra(doc3.data(), copy, &loadedFromCache);
+    QVERIFY(image3);
+    QVERIFY(loadedFromCache);
+}
+
+void KisKraSaverTest::testMergedImageCacheStale()
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    KisImageSP image = createCacheTestImage(doc.data(), 10);
+    const QByteArray data = saveToKra(doc.data(), image, true);
+
+    QScopedPointer<KisDocument> otherDoc(KisPart::instance()->createDocument());
+    KisImageSP otherImage = createCacheTestImage(otherDoc.data(), 20);
+    const QByteArray otherData = saveToKra(otherDoc.data(), otherImage, false);
+
+    QStringList filterConfigs;
+    Q_FOREACH (const QString &fileName, cachedFiles(data)) {
+        if (fileName.endsWith(KRA::DOT_FILTERCONFIG)) {
+            filterConfigs << fileName;
+        }
+    }
+    QCOMPARE(filterConfigs.size(), 1);
+
+    const QByteArray otherFilterConfig = extractFile(otherData, filterConfigs.first());
+    QVERIFY(!otherFilterConfig.isEmpty());
+    QVERIFY(otherFilterConfig != extractFile(data, filterConfigs.first()));
+
+    bool loadedFromCache = true;
+
+    // the filter configuration of the adjustment layer has been changed
+    const QByteArray changedConfig = copyKra(data, [&] (const QString &fileName, const QByteArray &content) {
+        return fileName.endsWith(KRA::DOT_FILTERCONFIG) ? otherFilterConfig : content;
+    });
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    QVERIFY(loadFromKra(doc2.data(), changedConfig, &loadedFromCache));
+    QVERIFY(!loadedFromCache);
+
+    // the layer stack has been changed
+    const QByteArray changedMainDoc = copyKra(data, [&] (const QString &fileName, const QByteArray &content) {
+        return fileName == KRA::MAIN_DOCUMENT_NAME ?
+            QByteArray(content).replace("opacity=\"255\"", "opacity=\"128\"") : content;
+    });
+
+    QScopedPointer<KisDocument> doc3(KisPart::instance()->createDocument());
+    QVERIFY(loadFromKra(doc3.data(), changedMainDoc, &loadedFromCache));
+    QVERIFY(!loadedFromCache);
+
+    // the default pixel of the layer has been removed
+    const QByteArray removedDefaultPixel = copyKra(data, [&] (const QString &fileName, const QByteArray &content) {
+        return fileName.endsWith(".defaultpixel") ? QByteArray() : content;
+    });
+
+    QScopedPointer<KisDocument> doc4(KisPart::instance()->createDocument());
+    QVERIFY(loadFromKra(doc4.data(), removedDefaultPixel, &loadedFromCache));
+    QVERIFY(!loadedFromCache);
+}
+
+void KisKraSaverTest::testMergedImageCacheMissing()
+{
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+    KisImageSP image = createCacheTestImage(doc.data(), 10);
+
+    const QByteArray data = saveToKra(doc.data(), image, false);
+
+    QScopedPointer<KisDocument> doc2(KisPart::instance()->createDocument());
+    bool loadedFromCache = true;
+    KisImageSP image2 = loadFromKra(doc2.data(), data, &loadedFromCache);
+    QVERIFY(image2);
+    QVERIFY(!loadedFromCache);
+    QCOMPARE(image2->nlayers(), image->nlayers());
+
+    // the projection is recomposed as usual
+    image2->initialRefreshGraph();
+    QVERIFY(TestUtil::comparePaintDevices(image->projection(), image2->projection()));
+}
+
 QTEST_MAIN(KisKraSaverTest)
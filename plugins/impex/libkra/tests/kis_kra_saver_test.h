@@ -46,6 +46,10 @@ private Q_SLOTS:
     void testRoundTripShapeLayer();
     void testRoundTripShapeSelection();
 
+    void testMergedImageCacheValid();
+    void testMergedImageCacheStale();
+    void testMergedImageCacheMissing();
+
 };
 
 #endif
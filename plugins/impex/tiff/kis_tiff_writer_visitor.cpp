@@ -23,6 +23,8 @@
 #include <KoColorSpace.h>
 #include <KoID.h>
 
+#include <QVector>
+
 #include <KoConfig.h>
 #ifdef HAVE_OPENEXR
 #include <half.h>
@@ -58,6 +60,20 @@ namespace
         return false;
 
     }
+
+    template <typename T>
+    void copyPixelsToStrip(const quint8 *src, int numPixels, int srcPixelSize, tdata_t buff, uint8 nbcolorssamples, quint8* poses, bool alpha)
+    {
+        T *dst = reinterpret_cast<T *>(buff);
+        for (int p = 0; p < numPixels; p++, src += srcPixelSize) {
+            const T *d = reinterpret_cast<const T *>(src);
+            int i;
+            for (i = 0; i < nbcolorssamples; i++) {
+                *(dst++) = d[poses[i]];
+            }
+            if (alpha) *(dst++) = d[poses[i]];
+        }
+    }
 }
 
 KisTIFFWriterVisitor::KisTIFFWriterVisitor(TIFF*image, KisTIFFOptions* options)
@@ -70,62 +86,27 @@ KisTIFFWriterVisitor::~KisTIFFWriterVisitor()
 {
 }
 
-bool KisTIFFWriterVisitor::copyDataToStrips(KisHLineConstIteratorSP it, tdata_t buff, uint8 depth, uint16 sample_format, uint8 nbcolorssamples, quint8* poses)
+bool KisTIFFWriterVisitor::copyDataToStrips(const quint8 *src, int numPixels, int srcPixelSize, tdata_t buff, uint8 depth, uint16 sample_format, uint8 nbcolorssamples, quint8* poses)
 {
     if (depth == 32) {
         Q_ASSERT(sample_format == SAMPLEFORMAT_IEEEFP);
-        float *dst = reinterpret_cast<float *>(buff);
-        do {
-            const float *d = reinterpret_cast<const float *>(it->oldRawData());
-            int i;
-            for (i = 0; i < nbcolorssamples; i++) {
-                *(dst++) = d[poses[i]];
-            }
-            if (m_options->alpha) *(dst++) = d[poses[i]];
-        } while (it->nextPixel());
+        copyPixelsToStrip<float>(src, numPixels, srcPixelSize, buff, nbcolorssamples, poses, m_options->alpha);
         return true;
     }
     else if (depth == 16 ) {
         if (sample_format == SAMPLEFORMAT_IEEEFP) {
 #ifdef HAVE_OPENEXR
-            half *dst = reinterpret_cast<half *>(buff);
-            do {
-                const half *d = reinterpret_cast<const half *>(it->oldRawData());
-                int i;
-                for (i = 0; i < nbcolorssamples; i++) {
-                    *(dst++) = d[poses[i]];
-                }
-                if (m_options->alpha) *(dst++) = d[poses[i]];
-
-            } while (it->nextPixel());
+            copyPixelsToStrip<half>(src, numPixels, srcPixelSize, buff, nbcolorssamples, poses, m_options->alpha);
             return true;
 #endif
         }
         else {
-            quint16 *dst = reinterpret_cast<quint16 *>(buff);
-            do {
-                const quint16 *d = reinterpret_cast<const quint16 *>(it->oldRawData());
-                int i;
-                for (i = 0; i < nbcolorssamples; i++) {
-                    *(dst++) = d[poses[i]];
-                }
-                if (m_options->alpha) *(dst++) = d[poses[i]];
-
-            } while (it->nextPixel());
+            copyPixelsToStrip<quint16>(src, numPixels, srcPixelSize, buff, nbcolorssamples, poses, m_options->alpha);
             return true;
         }
     }
     else if (depth == 8) {
-        quint8 *dst = reinterpret_cast<quint8 *>(buff);
-        do {
-            const quint8 *d = it->oldRawData();
-            int i;
-            for (i = 0; i < nbcolorssamples; i++) {
-                *(dst++) = d[poses[i]];
-            }
-            if (m_options->alpha) *(dst++) = d[poses[i]];
-
-        } while (it->nextPixel());
+        copyPixelsToStrip<quint8>(src, numPixels, srcPixelSize, buff, nbcolorssamples, poses, m_options->alpha);
         return true;
     }
     return false;
@@ -171,7 +152,8 @@ bool KisTIFFWriterVisitor::saveLayerProjection(KisLayer *layer)
     // Use contiguous configuration
     TIFFSetField(image(), TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
     // Use 8 rows per strip
-    TIFFSetField(image(), TIFFTAG_ROWSPERSTRIP, 8);
+    const int rowsPerStrip = 8;
+    TIFFSetField(image(), TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
 
     // Save profile
     if (m_options->saveProfile) {
@@ -181,17 +163,27 @@ bool KisTIFFWriterVisitor::saveLayerProjection(KisLayer *layer)
             TIFFSetField(image(), TIFFTAG_ICCPROFILE, ba.size(), ba.constData());
         }
     }
+    /**
+     * The image is written strip-by-strip. Every strip is read from the
+     * device in one go, so neither the whole image nor per-line
+     * iterators are ever allocated.
+     */
     tsize_t stripsize = TIFFStripSize(image());
     tdata_t buff = _TIFFmalloc(stripsize);
     qint32 height = layer->image()->height();
     qint32 width = layer->image()->width();
+    const int pixelSize = pd->pixelSize();
+    QVector<quint8> band(width * rowsPerStrip * pixelSize);
     bool r = true;
-    for (int y = 0; y < height; y++) {
-        KisHLineConstIteratorSP it = pd->createHLineConstIteratorNG(0, y, width);
+    for (int y = 0; y < height; y += rowsPerStrip) {
+        const int numRows = qMin(rowsPerStrip, height - y);
+        const int numPixels = width * numRows;
+        pd->readBytes(band.data(), 0, y, width, numRows);
+
         switch (color_type) {
         case PHOTOMETRIC_MINISBLACK: {
                 quint8 poses[] = { 0, 1 };
-                r = copyDataToStrips(it, buff, depth, sample_format, 1, poses);
+                r = copyDataToStrips(band.constData(), numPixels, pixelSize, buff, depth, sample_format, 1, poses);
             }
             break;
         case PHOTOMETRIC_RGB: {
@@ -201,23 +193,26 @@ bool KisTIFFWriterVisitor::saveLayerProjection(KisLayer *layer)
                 } else {
                     poses[0] = 2; poses[1] = 1; poses[2] = 0; poses[3] = 3;
                 }
-                r = copyDataToStrips(it, buff, depth, sample_format, 3, poses);
+                r = copyDataToStrips(band.constData(), numPixels, pixelSize, buff, depth, sample_format, 3, poses);
             }
             break;
         case PHOTOMETRIC_SEPARATED: {
                 quint8 poses[] = { 0, 1, 2, 3, 4 };
-                r = copyDataToStrips(it, buff, depth, sample_format, 4, poses);
+                r = copyDataToStrips(band.constData(), numPixels, pixelSize, buff, depth, sample_format, 4, poses);
             }
             break;
         case PHOTOMETRIC_ICCLAB: {
                 quint8 poses[] = { 0, 1, 2, 3 };
-                r = copyDataToStrips(it, buff, depth, sample_format, 3, poses);
+                r = copyDataToStrips(band.constData(), numPixels, pixelSize, buff, depth, sample_format, 3, poses);
             }
             break;
             return false;
         }
-        if (!r) return false;
-        TIFFWriteScanline(image(), buff, y, (tsample_t) - 1);
+        if (!r) {
+            _TIFFfree(buff);
+            return false;
+        }
+        TIFFWriteEncodedStrip(image(), TIFFComputeStrip(image(), y, 0), buff, numRows * TIFFScanlineSize(image()));
     }
     _TIFFfree(buff);
     TIFFWriteDirectory(image());
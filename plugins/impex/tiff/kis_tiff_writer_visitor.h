@@ -110,7 +110,7 @@ private:
     inline TIFF* image() {
         return m_image;
     }
-    bool copyDataToStrips(KisHLineConstIteratorSP it, tdata_t buff, uint8 depth, uint16 sample_format, uint8 nbcolorssamples, quint8* poses);
+    bool copyDataToStrips(const quint8 *src, int numPixels, int srcPixelSize, tdata_t buff, uint8 depth, uint16 sample_format, uint8 nbcolorssamples, quint8* poses);
     bool saveLayerProjection(KisLayer *);
 private:
     TIFF* m_image;
@@ -19,6 +19,7 @@
 #include "kis_colorsmudgeop.h"
 
 #include <cmath>
+#include <cstring>
 #include <memory>
 #include <QRect>
 
@@ -26,6 +27,7 @@
 #include <KoColor.h>
 #include <KoColorProfile.h>
 #include <KoCompositeOpRegistry.h>
+#include <KoCompositeOp.h>
 
 #include <kis_brush.h>
 #include <kis_global.h>
@@ -45,7 +47,7 @@ KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPaint
     , m_firstRun(true)
     , m_image(image)
     , m_tempDev(painter->device()->createCompositionSourceDevice())
-    , m_backgroundPainter(new KisPainter(m_tempDev))
+    , m_fixedDab(painter->device()->createCompositionSourceDeviceFixed())
     , m_smudgePainter(new KisPainter(m_tempDev))
     , m_colorRatePainter(new KisPainter(m_tempDev))
     , m_smudgeRateOption()
@@ -80,7 +82,11 @@ KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPaint
 
     m_gradient = painter->gradient();
 
-    m_backgroundPainter->setCompositeOp(COMPOSITE_COPY);
+    /**
+     * The painters never paint on m_tempDev, they only carry the
+     * composite op, opacity and color set by the options, which are
+     * then used for composing m_fixedDab.
+     */
     // Smudge Painter works in default COMPOSITE_OVER mode
     m_colorRatePainter->setCompositeOp(painter->compositeOp()->id());
 
@@ -89,7 +95,6 @@ KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPaint
 
 KisColorSmudgeOp::~KisColorSmudgeOp()
 {
-    delete m_backgroundPainter;
     delete m_colorRatePainter;
     delete m_smudgePainter;
 }
@@ -111,6 +116,48 @@ void KisColorSmudgeOp::updateMask(const KisPaintInformation& info, double scale,
     KIS_ASSERT_RECOVER_NOOP(m_dstDabRect.size() == m_maskDab->bounds().size());
 }
 
+void KisColorSmudgeOp::copyIntoDab(KisPaintDeviceSP src, const QRect &srcRect)
+{
+    const KoColorSpace *dabColorSpace = m_fixedDab->colorSpace();
+
+    if (*src->colorSpace() == *dabColorSpace) {
+        src->readBytes(m_fixedDab->data(), srcRect);
+    } else {
+        const int numPixels = srcRect.width() * srcRect.height();
+
+        m_sourceBuffer.resize(numPixels * src->pixelSize());
+        src->readBytes(m_sourceBuffer.data(), srcRect);
+
+        src->colorSpace()->convertPixelsTo(m_sourceBuffer.constData(), m_fixedDab->data(),
+                                           dabColorSpace, numPixels,
+                                           KoColorConversionTransformation::internalRenderingIntent(),
+                                           KoColorConversionTransformation::internalConversionFlags());
+    }
+}
+
+void KisColorSmudgeOp::compositeIntoDab(const KoColorSpace *srcColorSpace,
+                                        const quint8 *src, int srcRowStride,
+                                        const KoCompositeOp *op, quint8 opacity)
+{
+    const KoColorSpace *dabColorSpace = m_fixedDab->colorSpace();
+    const QRect bounds = m_fixedDab->bounds();
+
+    KoCompositeOp::ParameterInfo params;
+    params.dstRowStart   = m_fixedDab->data();
+    params.dstRowStride  = bounds.width() * dabColorSpace->pixelSize();
+    params.srcRowStart   = src;
+    params.srcRowStride  = srcRowStride;
+    params.maskRowStart  = 0;
+    params.maskRowStride = 0;
+    params.rows          = bounds.height();
+    params.cols          = bounds.width();
+    params.opacity       = float(opacity) / 255.0f;
+
+    dabColorSpace->bitBlt(srcColorSpace, params, op,
+                          KoColorConversionTransformation::internalRenderingIntent(),
+                          KoColorConversionTransformation::internalConversionFlags());
+}
+
 inline void KisColorSmudgeOp::getTopLeftAligned(const QPointF &pos, const QPointF &hotSpot, qint32 *x, qint32 *y)
 {
     QPointF topLeft = pos - hotSpot;
@@ -204,44 +251,64 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
     QString oldCompositeOpId = painter()->compositeOp()->id();
     qreal   fpOpacity  = (qreal(oldOpacity) / 255.0) * m_opacityOption.getOpacityf(info);
 
+    /**
+     * The dab is composed in a contiguous buffer that is reused for
+     * all the dabs of the stroke, so the only accesses to the tiled
+     * devices left are reading the source area and writing the
+     * final dab. The composite ops work on whole rows of the buffer
+     * instead of the tile-sized chunks, which lets their vectorized
+     * implementations run on longer spans.
+     */
+    m_fixedDab->setRect(QRect(QPoint(), m_dstDabRect.size()));
+    m_fixedDab->lazyGrowBufferWithoutInitialization();
+
     if (m_image && m_overlayModeOption.isChecked()) {
         m_image->blockUpdates();
-        m_backgroundPainter->bitBlt(QPoint(), m_image->projection(), srcDabRect);
+        copyIntoDab(m_image->projection(), srcDabRect);
         m_image->unblockUpdates();
     }
     else {
-        // IMPORTANT: clear the temporary painting device to color black with zero opacity:
-        //            it will only clear the extents of the brush.
-        m_tempDev->clear(QRect(QPoint(), m_dstDabRect.size()));
+        // IMPORTANT: clear the dab to color black with zero opacity
+        memset(m_fixedDab->data(), 0, m_dstDabRect.width() * m_dstDabRect.height() * m_fixedDab->pixelSize());
     }
 
     if (m_smudgeRateOption.getMode() == KisSmudgeOption::SMEARING_MODE) {
-        m_smudgePainter->bitBlt(QPoint(), painter()->device(), srcDabRect);
+        KisPaintDeviceSP device = painter()->device();
+
+        m_sourceBuffer.resize(srcDabRect.width() * srcDabRect.height() * device->pixelSize());
+        device->readBytes(m_sourceBuffer.data(), srcDabRect);
+
+        compositeIntoDab(device->colorSpace(),
+                         m_sourceBuffer.constData(), srcDabRect.width() * device->pixelSize(),
+                         m_smudgePainter->compositeOp(), m_smudgePainter->opacity());
     } else {
         QPoint pt = (srcDabRect.topLeft() + hotSpot).toPoint();
+        KoColor color;
 
         if (m_smudgeRadiusOption.isChecked()) {
             qreal effectiveSize = 0.5 * (m_dstDabRect.width() + m_dstDabRect.height());
             m_smudgeRadiusOption.apply(*m_smudgePainter, info, effectiveSize, pt.x(), pt.y(), painter()->device());
 
-            KoColor color2 = m_smudgePainter->paintColor();
-            m_smudgePainter->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color2);
+            color = m_smudgePainter->paintColor();
 
         } else {
-            KoColor color = painter()->paintColor();
+            color = painter()->paintColor();
 
             // get the pixel on the canvas that lies beneath the hot spot
-            // of the dab and fill  the temporary paint device with that color
+            // of the dab and fill  the temporary dab with that color
 
             KisCrossDeviceColorPickerInt colorPicker(painter()->device(), color);
             colorPicker.pickColor(pt.x(), pt.y(), color.data());
-
-            m_smudgePainter->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color);
         }
+
+        // srcRowStride is set to zero to use the compositeOp with only a single color pixel
+        color.convertTo(m_fixedDab->colorSpace());
+        compositeIntoDab(color.colorSpace(), color.data(), 0,
+                         m_smudgePainter->compositeOp(), m_smudgePainter->opacity());
     }
 
     // if the user selected the color smudge option,
-    // we will mix some color into the temporary painting device (m_tempDev)
+    // we will mix some color into the temporary dab (m_fixedDab)
     if (m_colorRateOption.isChecked()) {
         // this will apply the opacity (selected by the user) to copyPainter
         // (but fit the rate inbetween the range 0.0 to (1.0-SmudgeRate))
@@ -250,11 +317,14 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
 
         // paint a rectangle with the current color (foreground color)
         // or a gradient color (if enabled)
-        // into the temporary painting device and use the user selected
+        // into the temporary dab and use the user selected
         // composite mode
         KoColor color = painter()->paintColor();
         m_gradientOption.apply(color, m_gradient, info);
-        m_colorRatePainter->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color);
+        color.convertTo(m_fixedDab->colorSpace());
+
+        compositeIntoDab(color.colorSpace(), color.data(), 0,
+                         m_colorRatePainter->compositeOp(), m_colorRatePainter->opacity());
     }
 
     // if color is disabled (only smudge) and "overlay mode" is enabled
@@ -273,12 +343,12 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
     // set opacity calculated by the rate option
     m_smudgeRateOption.apply(*painter(), info, 0.0, 1.0, fpOpacity);
 
-    // then blit the temporary painting device on the canvas at the current brush position
+    // then blit the temporary dab on the canvas at the current brush position
     // the alpha mask (maskDab) will be used here to only blit the pixels that are in the area (shape) of the brush
 
     painter()->setCompositeOp(COMPOSITE_COPY);
-    painter()->bitBltWithFixedSelection(m_dstDabRect.x(), m_dstDabRect.y(), m_tempDev, m_maskDab, m_dstDabRect.width(), m_dstDabRect.height());
-    painter()->renderMirrorMaskSafe(m_dstDabRect, m_tempDev, 0, 0, m_maskDab, !m_dabCache->needSeparateOriginal());
+    painter()->bltFixedWithFixedSelection(m_dstDabRect.x(), m_dstDabRect.y(), m_fixedDab, m_maskDab, m_dstDabRect.width(), m_dstDabRect.height());
+    painter()->renderMirrorMaskSafe(m_dstDabRect, m_fixedDab, m_maskDab, !m_dabCache->needSeparateOriginal());
 
     // restore orginal opacy and composite mode values
     painter()->setOpacity(oldOpacity);
@@ -20,6 +20,7 @@
 #define _KIS_COLORSMUDGEOP_H_
 
 #include <QRect>
+#include <QVector>
 
 #include <kis_brush_based_paintop.h>
 #include <kis_types.h>
@@ -37,6 +38,8 @@
 
 class QPointF;
 class KoAbstractGradient;
+class KoColorSpace;
+class KoCompositeOp;
 class KisBrushBasedPaintOpSettings;
 class KisPainter;
 
@@ -55,13 +58,24 @@ private:
     // Sets the m_maskDab _and m_maskDabRect
     void updateMask(const KisPaintInformation& info, double scale, double rotation, const QPointF &cursorPoint);
 
+    // Reads srcRect of src into m_fixedDab, converting the color space if needed
+    void copyIntoDab(KisPaintDeviceSP src, const QRect &srcRect);
+
+    // Composes the pixels of src over the whole m_fixedDab. With srcRowStride
+    // equal to zero src is a single pixel and must be in the color space of
+    // m_fixedDab, because the conversion would read a whole row of pixels
+    void compositeIntoDab(const KoColorSpace *srcColorSpace,
+                          const quint8 *src, int srcRowStride,
+                          const KoCompositeOp *op, quint8 opacity);
+
     inline void getTopLeftAligned(const QPointF &pos, const QPointF &hotSpot, qint32 *x, qint32 *y);
 
 private:
     bool                      m_firstRun;
     KisImageWSP               m_image;
     KisPaintDeviceSP          m_tempDev;
-    KisPainter*               m_backgroundPainter;
+    KisFixedPaintDeviceSP     m_fixedDab;
+    QVector<quint8>           m_sourceBuffer;
     KisPainter*               m_smudgePainter;
     KisPainter*               m_colorRatePainter;
     const KoAbstractGradient* m_gradient;
@@ -24,6 +24,7 @@
 #include "kis_brushop.h"
 
 #include <QRect>
+#include <QtConcurrent>
 
 #include <kis_image.h>
 #include <kis_vec.h>
@@ -42,12 +43,14 @@
 #include <kis_fixed_paint_device.h>
 #include <kis_lod_transform.h>
 #include <kis_paintop_plugin_utils.h>
+#include <krita_utils.h>
 
 
 KisBrushOp::KisBrushOp(const KisPaintOpSettingsSP settings, KisPainter *painter, KisNodeSP node, KisImageSP image)
     : KisBrushBasedPaintOp(settings, painter)
     , m_opacityOption(node)
     , m_hsvTransformation(0)
+    , m_dabBatchingActive(false)
 {
     Q_UNUSED(image);
     Q_ASSERT(settings);
@@ -161,11 +164,24 @@ KisSpacingInformation KisBrushOp::paintAt(const KisPaintInformation& info)
         warnKrita << "KisBrushOp: dab bounds is not dab rect. See bug 327156" << dab->bounds().size() << dabRect.size();
     }
 
-    painter()->bltFixed(dabRect.topLeft(), dab, dab->bounds());
+    if (m_dabBatchingActive) {
+        /**
+         * The dab cache reuses its device for the next dab, so we
+         * store a (copy-on-write) copy of it
+         */
+        m_pendingDabs.append(painter()->renderedDab(new KisFixedPaintDevice(*dab), dabRect.topLeft()));
+
+        if (m_pendingDabs.size() >= maxPendingDabs) {
+            renderPendingDabs();
+        }
+    } else {
+        painter()->bltFixed(dabRect.topLeft(), dab, dab->bounds());
+
+        painter()->renderMirrorMaskSafe(dabRect,
+                                        dab,
+                                        !m_dabCache->needSeparateOriginal());
+    }
 
-    painter()->renderMirrorMaskSafe(dabRect,
-                                    dab,
-                                    !m_dabCache->needSeparateOriginal());
     painter()->setOpacity(origOpacity);
 
     return effectiveSpacing(scale, rotation, &m_airbrushOption, &m_spacingOption, info);
@@ -183,6 +199,14 @@ KisTimingInformation KisBrushOp::updateTimingImpl(const KisPaintInformation &inf
     return KisPaintOpPluginUtils::effectiveTiming(&m_airbrushOption, &m_rateOption, info);
 }
 
+bool KisBrushOp::supportsSpeculativePainting() const
+{
+    // the pipe brushes switch to the next image with every dab
+    return m_brush &&
+        m_brush->brushType() != PIPE_MASK &&
+        m_brush->brushType() != PIPE_IMAGE;
+}
+
 void KisBrushOp::paintLine(const KisPaintInformation& pi1, const KisPaintInformation& pi2, KisDistanceInformation *currentDistance)
 {
     if (m_sharpnessOption.isChecked() && m_brush && (m_brush->width() == 1) && (m_brush->height() == 1)) {
@@ -204,6 +228,80 @@ void KisBrushOp::paintLine(const KisPaintInformation& pi1, const KisPaintInforma
     painter()->renderMirrorMask(rc, m_lineCacheDevice);
     }
     else {
+        /**
+         * The dabs of the line are generated sequentially, but their
+         * composition is postponed and done in parallel afterwards.
+         * Mirrored dabs are painted right away by the painter, so
+         * the batching is not used with mirroring.
+         */
+        m_dabBatchingActive = !painter()->hasMirroring();
         KisPaintOp::paintLine(pi1, pi2, currentDistance);
+        m_dabBatchingActive = false;
+
+        renderPendingDabs();
+    }
+}
+
+void KisBrushOp::renderPendingDabs()
+{
+    if (m_pendingDabs.isEmpty()) return;
+
+    /**
+     * The area covered by the dabs is split into tiles and every tile
+     * is processed by a separate job. The job composites all the dabs
+     * touching its tile in the original order, so the result is the
+     * same as with sequential rendering, even when the dabs overlap.
+     * The tile grid of the device starts at its offset, so the job
+     * rects are aligned to it. Then the jobs never touch the same tile
+     * of the device and can be executed concurrently.
+     */
+    const int tileSize = 64;
+
+    QRect totalRect;
+    Q_FOREACH (const KisRenderedDab &dab, m_pendingDabs) {
+        totalRect |= dab.realBounds();
+    }
+
+    KisPaintDeviceSP dstDevice = painter()->device();
+
+    const QVector<QPair<int, int>> rows =
+        KritaUtils::splitIntoAlignedStripes(totalRect.top(), totalRect.bottom() + 1, dstDevice->y(), tileSize);
+    const QVector<QPair<int, int>> columns =
+        KritaUtils::splitIntoAlignedStripes(totalRect.left(), totalRect.right() + 1, dstDevice->x(), tileSize);
+
+    QVector<QRect> jobRects;
+
+    Q_FOREACH (const auto &row, rows) {
+        Q_FOREACH (const auto &column, columns) {
+            const QRect tileRect(QPoint(column.first, row.first),
+                                 QPoint(column.second - 1, row.second - 1));
+
+            // do not touch the pixels no dab covers, it might allocate new tiles
+            QRect jobRect;
+            Q_FOREACH (const KisRenderedDab &dab, m_pendingDabs) {
+                jobRect |= dab.realBounds() & tileRect;
+            }
+
+            if (!jobRect.isEmpty()) {
+                jobRects << jobRect;
+            }
+        }
     }
+
+    KisPainter *gc = painter();
+    const QList<KisRenderedDab> dabs = m_pendingDabs;
+
+    if (jobRects.size() == 1) {
+        gc->bltFixed(jobRects.first(), dabs);
+    } else {
+        QtConcurrent::blockingMap(jobRects, [gc, &dabs] (const QRect &rc) {
+            gc->bltFixed(rc, dabs);
+        });
+    }
+
+    Q_FOREACH (const KisRenderedDab &dab, m_pendingDabs) {
+        gc->addDirtyRect(dab.realBounds());
+    }
+
+    m_pendingDabs.clear();
 }
@@ -40,6 +40,7 @@
 #include <kis_pressure_spacing_option.h>
 #include <kis_pressure_rate_option.h>
 #include <kis_brush_based_paintop_settings.h>
+#include <kis_rendered_dab.h>
 
 class KisPainter;
 class KisColorSource;
@@ -55,6 +56,8 @@ public:
 
     void paintLine(const KisPaintInformation &pi1, const KisPaintInformation &pi2, KisDistanceInformation *currentDistance) override;
 
+    bool supportsSpeculativePainting() const override;
+
 protected:
     KisSpacingInformation paintAt(const KisPaintInformation& info) override;
 
@@ -62,6 +65,15 @@ protected:
 
     KisTimingInformation updateTimingImpl(const KisPaintInformation &info) const override;
 
+private:
+    /**
+     * The maximum number of dabs kept in memory before they are
+     * composited onto the device
+     */
+    static const int maxPendingDabs = 64;
+
+    void renderPendingDabs();
+
 private:
     KisColorSource *m_colorSource;
     KisAirbrushOption m_airbrushOption;
@@ -82,6 +94,9 @@ private:
     KoColorTransformation *m_hsvTransformation;
     KisPaintDeviceSP m_lineCacheDevice;
     KisPaintDeviceSP m_colorSourceDevice;
+
+    bool m_dabBatchingActive;
+    QList<KisRenderedDab> m_pendingDabs;
 };
 
 #endif // KIS_BRUSHOP_H_
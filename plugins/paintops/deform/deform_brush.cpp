@@ -23,19 +23,76 @@
 
 #include <KoColor.h>
 #include <KoColorSpace.h>
+#include <KoMixColorsOp.h>
 
 #include <QRect>
+#include <QtConcurrent>
 
 #include <kis_types.h>
 #include <kis_iterator_ng.h>
-#include <kis_cross_device_color_picker.h>
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <ctime>
+#include <limits>
+#include <numeric>
 #include <KoColorSpaceRegistry.h>
 
 const qreal degToRad = M_PI / 180.0;
 
+namespace {
+
+/**
+ * The dab is processed in bands of rows, the bands are split between
+ * the threads when the dab is big enough
+ */
+const int rowsPerJob = 16;
+const int parallelThreshold = 64 * 64;
+
+const int snapshotBlockSize = 64;
+
+inline int snapshotBlockIndex(int coord)
+{
+    return coord >= 0 ? coord / snapshotBlockSize : -((-coord - 1) / snapshotBlockSize) - 1;
+}
+
+struct SampleBounds {
+    qreal left = std::numeric_limits<qreal>::max();
+    qreal top = std::numeric_limits<qreal>::max();
+    qreal right = std::numeric_limits<qreal>::lowest();
+    qreal bottom = std::numeric_limits<qreal>::lowest();
+
+    inline void add(const QPointF &pt) {
+        left = qMin(left, pt.x());
+        top = qMin(top, pt.y());
+        right = qMax(right, pt.x());
+        bottom = qMax(bottom, pt.y());
+    }
+
+    inline void unite(const SampleBounds &rhs) {
+        left = qMin(left, rhs.left);
+        top = qMin(top, rhs.top);
+        right = qMax(right, rhs.right);
+        bottom = qMax(bottom, rhs.bottom);
+    }
+
+    inline bool isEmpty() const {
+        return left > right;
+    }
+
+    /**
+     * The rect of the source pixels the samples are read from. The
+     * bilinear filter reads the right and the bottom neighbours as well.
+     */
+    inline QRect sourceRect() const {
+        return QRect(QPoint(int(std::floor(left)), int(std::floor(top))),
+                     QPoint(int(std::floor(right)) + 1, int(std::floor(bottom)) + 1));
+    }
+};
+
+}
+
 
 DeformBrush::DeformBrush()
 {
@@ -160,10 +217,9 @@ KisFixedPaintDeviceSP DeformBrush::paintMask(KisFixedPaintDeviceSP dab,
         KisPaintDeviceSP layer,
         qreal scale,
         qreal rotation,
-        QPointF pos, qreal subPixelX, qreal subPixelY, int dabX, int dabY)
+        QPointF pos, qreal subPixelX, qreal subPixelY)
 {
     KisFixedPaintDeviceSP mask = new KisFixedPaintDevice(KoColorSpaceRegistry::instance()->alpha8());
-    KisCrossDeviceColorPicker colorPicker(layer, dab);
 
     qreal fWidth = maskWidth(scale);
     qreal fHeight = maskHeight(scale);
@@ -186,84 +242,240 @@ KisFixedPaintDeviceSP DeformBrush::paintMask(KisFixedPaintDeviceSP dab,
     qreal const majorAxis = 2.0 / fWidth;
     qreal const minorAxis = 2.0 / fHeight;
 
-    qreal distance;
-
     QTransform forwardRotationMatrix;
     forwardRotationMatrix.rotateRadians(-rotation);
     QTransform reverseRotationMatrix;
     reverseRotationMatrix.rotateRadians(rotation);
 
+    const DeformModes mode = DeformModes(m_properties->deform_action - 1);
+
     // if can't paint, stop
-    if (!setupAction(DeformModes(m_properties->deform_action - 1),
-                     pos, forwardRotationMatrix))
+    if (!setupAction(mode, pos, forwardRotationMatrix))
     {
         return 0;
     }
 
     mask->setRect(dab->bounds());
     mask->initialize();
-    quint8* maskPointer = mask->data();
-    qint8 maskPixelSize = mask->pixelSize();
+    quint8* maskData = mask->data();
 
-    quint8* dabPointer = dab->data();
-    int dabPixelSize = dab->colorSpace()->pixelSize();
+    const qreal density = m_sizeProperties->brush_density;
+    const bool useBilinear = m_properties->deform_use_bilinear;
 
-    for (int y = 0; y <  dstHeight; y++) {
-        for (int x = 0; x < dstWidth; x++) {
-            qreal maskX = x - centerX;
-            qreal maskY = y - centerY;
-            forwardRotationMatrix.map(maskX, maskY, &maskX, &maskY);
-            distance = norme(maskX * majorAxis, maskY * minorAxis);
+    m_samplePoints.resize(dstWidth * dstHeight);
+    QPointF *samplePoints = m_samplePoints.data();
 
-            if (distance > 1.0) {
-                // leave there OPACITY TRANSPARENT pixel (default pixel)
+    /**
+     * The first pass finds the positions in the source device every
+     * pixel of the dab should be sampled from. The pixels outside the
+     * ellipse of the brush are masked out, so they are not sampled at all.
+     */
+    auto computeSamplePoints = [&] (int firstRow, int lastRow) {
+        SampleBounds bounds;
 
-                colorPicker.pickOldColor(x + dabX, y + dabY, dabPointer);
-                dabPointer += dabPixelSize;
+        for (int y = firstRow; y < lastRow; y++) {
+            for (int x = 0; x < dstWidth; x++) {
+                const int index = y * dstWidth + x;
 
-                *maskPointer = OPACITY_TRANSPARENT_U8;
-                maskPointer += maskPixelSize;
-                continue;
-            }
+                qreal maskX = x - centerX;
+                qreal maskY = y - centerY;
+                forwardRotationMatrix.map(maskX, maskY, &maskX, &maskY);
+                const qreal distance = norme(maskX * majorAxis, maskY * minorAxis);
 
-            if (m_sizeProperties->brush_density != 1.0) {
-                if (m_sizeProperties->brush_density < drand48()) {
-                    dabPointer += dabPixelSize;
-                    *maskPointer = OPACITY_TRANSPARENT_U8;
-                    maskPointer += maskPixelSize;
+                if (distance > 1.0 ||
+                    (density != 1.0 && density < drand48())) {
+
+                    maskData[index] = OPACITY_TRANSPARENT_U8;
                     continue;
                 }
-            }
 
-            m_deformAction->transform(&maskX, &maskY, distance);
-            reverseRotationMatrix.map(maskX, maskY, &maskX, &maskY);
+                m_deformAction->transform(&maskX, &maskY, distance);
+                reverseRotationMatrix.map(maskX, maskY, &maskX, &maskY);
 
-            maskX += pos.x();
-            maskY += pos.y();
+                maskX += pos.x();
+                maskY += pos.y();
 
-            if (!m_properties->deform_use_bilinear) {
-                maskX = qRound(maskX);
-                maskY = qRound(maskY);
-            }
+                if (!useBilinear) {
+                    maskX = qRound(maskX);
+                    maskY = qRound(maskY);
+                }
 
-            if (m_properties->deform_use_old_data) {
-                colorPicker.pickOldColor(maskX, maskY, dabPointer);
-            }
-            else {
-                colorPicker.pickColor(maskX, maskY, dabPointer);
+                // the grow action may degenerate in the center of the brush
+                if (!qIsFinite(maskX) || !qIsFinite(maskY)) {
+                    maskData[index] = OPACITY_TRANSPARENT_U8;
+                    continue;
+                }
+
+                samplePoints[index] = QPointF(maskX, maskY);
+                bounds.add(samplePoints[index]);
+                maskData[index] = OPACITY_OPAQUE_U8;
             }
+        }
 
-            dabPointer += dabPixelSize;
+        return bounds;
+    };
 
-            *maskPointer = OPACITY_OPAQUE_U8;
-            maskPointer += maskPixelSize;
+    const int numJobs = (dstHeight + rowsPerJob - 1) / rowsPerJob;
+    QVector<int> jobs(numJobs);
+    std::iota(jobs.begin(), jobs.end(), 0);
 
-        }
+    const bool useThreads = dstWidth * dstHeight >= parallelThreshold;
+
+    /**
+     * The color action and the density use drand48(), so the points
+     * are computed in one thread then to keep the random sequence
+     */
+    const bool isRandomized = mode == DEFORM_COLOR || density != 1.0;
+
+    QVector<SampleBounds> jobBounds(numJobs);
+    SampleBounds *jobBoundsData = jobBounds.data();
+
+    auto computePointsJob = [&] (int job) {
+        const int firstRow = job * rowsPerJob;
+        jobBoundsData[job] = computeSamplePoints(firstRow, qMin(firstRow + rowsPerJob, dstHeight));
+    };
+
+    if (useThreads && !isRandomized) {
+        QtConcurrent::blockingMap(jobs, computePointsJob);
+    } else {
+        std::for_each(jobs.begin(), jobs.end(), computePointsJob);
     }
+
     m_counter++;
 
+    SampleBounds bounds;
+    Q_FOREACH (const SampleBounds &jobBound, jobBounds) {
+        bounds.unite(jobBound);
+    }
+
+    if (bounds.isEmpty()) {
+        return mask;
+    }
+
+    readSource(layer, bounds.sourceRect());
+
+    const KoColorSpace *srcColorSpace = layer->colorSpace();
+    const KoColorSpace *dstColorSpace = dab->colorSpace();
+    const bool needsConversion = !(*srcColorSpace == *dstColorSpace);
+    const KoMixColorsOp *mixOp = srcColorSpace->mixColorsOp();
+
+    const int srcPixelSize = srcColorSpace->pixelSize();
+    const int dabPixelSize = dstColorSpace->pixelSize();
+    const int srcRowStride = m_sourceRect.width() * srcPixelSize;
+    const quint8 *sourceData = m_sourceData.constData();
+    quint8 *dabData = dab->data();
+
+    /**
+     * The second pass samples the source pixels with the same bilinear
+     * filter KisRandomSubAccessor uses, but from the contiguous buffer,
+     * so it involves no tile lookups and can run in parallel.
+     */
+    auto samplePointsJob = [&] (int job) {
+        const int firstRow = job * rowsPerJob;
+        const int lastRow = qMin(firstRow + rowsPerJob, dstHeight);
+
+        QVector<quint8> mixedPixel(srcPixelSize);
+        const quint8 *pixels[4];
+        qint16 weights[4];
+
+        for (int y = firstRow; y < lastRow; y++) {
+            for (int x = 0; x < dstWidth; x++) {
+                const int index = y * dstWidth + x;
+                if (maskData[index] != OPACITY_OPAQUE_U8) continue;
+
+                const QPointF &pt = samplePoints[index];
+                const int sampleX = int(std::floor(pt.x()));
+                const int sampleY = int(std::floor(pt.y()));
+                const qreal hsub = pt.x() - sampleX;
+                const qreal vsub = pt.y() - sampleY;
+
+                weights[0] = qRound((1.0 - hsub) * (1.0 - vsub) * 255);
+                weights[1] = qRound((1.0 - vsub) * hsub * 255);
+                weights[2] = qRound(vsub * (1.0 - hsub) * 255);
+                weights[3] = qRound(hsub * vsub * 255);
+
+                pixels[0] = sourceData +
+                    (sampleY - m_sourceRect.y()) * srcRowStride +
+                    (sampleX - m_sourceRect.x()) * srcPixelSize;
+                pixels[1] = pixels[0] + srcPixelSize;
+                pixels[2] = pixels[0] + srcRowStride;
+                pixels[3] = pixels[2] + srcPixelSize;
+
+                quint8 *dst = dabData + index * dabPixelSize;
+
+                if (needsConversion) {
+                    mixOp->mixColors(pixels, weights, 4, mixedPixel.data());
+                    srcColorSpace->convertPixelsTo(mixedPixel.constData(), dst, dstColorSpace, 1,
+                                                   KoColorConversionTransformation::internalRenderingIntent(),
+                                                   KoColorConversionTransformation::internalConversionFlags());
+                } else {
+                    mixOp->mixColors(pixels, weights, 4, dst);
+                }
+            }
+        }
+    };
+
+    if (useThreads) {
+        QtConcurrent::blockingMap(jobs, samplePointsJob);
+    } else {
+        std::for_each(jobs.begin(), jobs.end(), samplePointsJob);
+    }
+
     return mask;
+}
+
+void DeformBrush::readSource(KisPaintDeviceSP layer, const QRect &rect)
+{
+    const int pixelSize = layer->pixelSize();
+
+    m_sourceRect = rect;
+    m_sourceData.resize(rect.width() * rect.height() * pixelSize);
+
+    if (!m_properties->deform_use_old_data) {
+        layer->readBytes(m_sourceData.data(), rect);
+        return;
+    }
+
+    if (!m_oldDataSnapshot) {
+        m_oldDataSnapshot = new KisPaintDevice(layer->colorSpace());
+    }
+
+    QVector<quint8> blockData(snapshotBlockSize * snapshotBlockSize * pixelSize);
+
+    for (int blockY = snapshotBlockIndex(rect.top()); blockY <= snapshotBlockIndex(rect.bottom()); blockY++) {
+        for (int blockX = snapshotBlockIndex(rect.left()); blockX <= snapshotBlockIndex(rect.right()); blockX++) {
+            const qint64 key = (qint64(blockY) << 32) | quint32(blockX);
+            if (m_snapshotBlocks.contains(key)) continue;
+
+            const QRect blockRect(blockX * snapshotBlockSize, blockY * snapshotBlockSize,
+                                  snapshotBlockSize, snapshotBlockSize);
+
+            KisHLineConstIteratorSP it =
+                layer->createHLineConstIteratorNG(blockRect.x(), blockRect.y(), blockRect.width());
+
+            quint8 *dst = blockData.data();
+
+            for (int row = 0; row < blockRect.height(); row++) {
+                int columnsLeft = blockRect.width();
+
+                while (columnsLeft > 0) {
+                    const int numPixels = qMin(it->nConseqPixels(), columnsLeft);
+                    memcpy(dst, it->oldRawData(), numPixels * pixelSize);
+
+                    dst += numPixels * pixelSize;
+                    columnsLeft -= numPixels;
+                    it->nextPixels(numPixels);
+                }
+
+                it->nextRow();
+            }
+
+            m_oldDataSnapshot->writeBytes(blockData.constData(), blockRect);
+            m_snapshotBlocks.insert(key);
+        }
+    }
 
+    m_oldDataSnapshot->readBytes(m_sourceData.data(), rect);
 }
 
 void DeformBrush::debugColor(const quint8* data, KoColorSpace * cs)
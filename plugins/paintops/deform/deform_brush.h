@@ -19,6 +19,9 @@
 #ifndef _DEFORM_BRUSH_H_
 #define _DEFORM_BRUSH_H_
 
+#include <QSet>
+#include <QVector>
+
 #include <kis_paint_device.h>
 #include <brushengine/kis_paint_information.h>
 
@@ -204,7 +207,7 @@ public:
 
     KisFixedPaintDeviceSP paintMask(KisFixedPaintDeviceSP dab, KisPaintDeviceSP layer,
                                     qreal scale, qreal rotation, QPointF pos,
-                                    qreal subPixelX, qreal subPixelY, int dabX, int dabY);
+                                    qreal subPixelX, qreal subPixelY);
 
     void setSizeProperties(BrushSizeOption * properties) {
         m_sizeProperties = properties;
@@ -233,9 +236,10 @@ private:
         return x * x + y * y;
     }
 
+    void readSource(KisPaintDeviceSP layer, const QRect &rect);
+
 
 private:
-    KisRandomSubAccessorSP m_srcAcc;
     bool m_firstPaint;
     qreal m_prevX, m_prevY;
     int m_counter;
@@ -246,6 +250,21 @@ private:
 
     DeformOption * m_properties;
     BrushSizeOption * m_sizeProperties;
+
+    /**
+     * The positions in the source device the pixels of the dab are
+     * sampled from and the pixels of the source covering all of them
+     */
+    QVector<QPointF> m_samplePoints;
+    QVector<quint8> m_sourceData;
+    QRect m_sourceRect;
+
+    /**
+     * The old data of the layer does not change during the stroke, so
+     * it is copied into the snapshot once per block of pixels
+     */
+    KisPaintDeviceSP m_oldDataSnapshot;
+    QSet<qint64> m_snapshotBlocks;
 };
 
 
@@ -129,9 +129,7 @@ KisSpacingInformation KisDeformPaintOp::paintAt(const KisPaintInformation& info)
     KisFixedPaintDeviceSP mask = m_deformBrush.paintMask(dab, m_dev,
                                  scale, rotation,
                                  info.pos(),
-                                 subPixelX, subPixelY,
-                                 x, y
-                                                        );
+                                 subPixelX, subPixelY);
 
     // this happens for the first dab of the move mode, we need more information for being able to move
     if (!mask) {
@@ -0,0 +1,205 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_deform_brush_test.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_paint_device.h>
+#include <kis_fixed_paint_device.h>
+#include <kis_transaction.h>
+#include <kis_cross_device_color_picker.h>
+
+#include "deform_brush.h"
+
+namespace {
+
+const qreal swirlAmount = 0.35;
+
+KisPaintDeviceSP createSourceDevice(const KoColorSpace *cs)
+{
+    QImage image(200, 200, QImage::Format_ARGB32);
+
+    for (int y = 0; y < image.height(); y++) {
+        for (int x = 0; x < image.width(); x++) {
+            image.setPixel(x, y, qRgba((x * 7) % 256, (y * 5) % 256, ((x + y) * 3) % 256, 255 - (x * y) % 97));
+        }
+    }
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->convertFromQImage(image, 0);
+    return dev;
+}
+
+/**
+ * Paints a swirl dab with DeformBrush and checks every pixel of it
+ * against the sampling the brush did before it got the bounded source
+ * buffer: one KisCrossDeviceColorPicker call per pixel of the ellipse
+ */
+void testPaintMaskImpl(const KoColorSpace *srcColorSpace,
+                       const KoColorSpace *dabColorSpace,
+                       bool useOldData, bool useBilinear)
+{
+    KisPaintDeviceSP dev = createSourceDevice(srcColorSpace);
+
+    /**
+     * In the old data mode the current data of the device is replaced,
+     * so only the old data may reach the dab
+     */
+    QScopedPointer<KisTransaction> transaction;
+    if (useOldData) {
+        transaction.reset(new KisTransaction(dev));
+        dev->fill(QRect(0, 0, 200, 200), KoColor(Qt::red, srcColorSpace));
+    }
+
+    DeformOption properties;
+    properties.deform_action = SWIRL_CW + 1;
+    properties.deform_amount = swirlAmount;
+    properties.deform_use_bilinear = useBilinear;
+    properties.deform_use_counter = false;
+    properties.deform_use_old_data = useOldData;
+
+    BrushSizeOption sizeProperties;
+    sizeProperties.brush_diameter = 80;
+    sizeProperties.brush_aspect = 0.7;
+    sizeProperties.brush_scale = 1.0;
+    sizeProperties.brush_rotation = 0.0;
+    sizeProperties.brush_spacing = 0.3;
+    sizeProperties.brush_density = 1.0;
+    sizeProperties.brush_jitter_movement = 0.0;
+    sizeProperties.brush_jitter_movement_enabled = false;
+
+    DeformBrush brush;
+    brush.setProperties(&properties);
+    brush.setSizeProperties(&sizeProperties);
+    brush.initDeformAction();
+
+    const qreal scale = 1.0;
+    const qreal rotation = 0.4;
+    const QPointF pos(97.3, 103.6);
+    const qreal subPixelX = 0.3;
+    const qreal subPixelY = 0.6;
+
+    brush.hotSpot(scale, rotation);
+
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(dabColorSpace);
+    KisFixedPaintDeviceSP mask = brush.paintMask(dab, dev, scale, rotation, pos, subPixelX, subPixelY);
+    QVERIFY(mask);
+
+    const int dstWidth = dab->bounds().width();
+    const int dstHeight = dab->bounds().height();
+    QCOMPARE(mask->bounds(), dab->bounds());
+
+    const qreal centerX = dstWidth * 0.5 + subPixelX;
+    const qreal centerY = dstHeight * 0.5 + subPixelY;
+    const qreal majorAxis = 2.0 / sizeProperties.brush_diameter;
+    const qreal minorAxis = 2.0 / (sizeProperties.brush_diameter * sizeProperties.brush_aspect);
+
+    QTransform forwardRotationMatrix;
+    forwardRotationMatrix.rotateRadians(-rotation);
+    QTransform reverseRotationMatrix;
+    reverseRotationMatrix.rotateRadians(rotation);
+
+    DeformRotation swirl;
+    swirl.setAlpha((360 * swirlAmount * 0.5) * 1.0 * (M_PI / 180.0));
+
+    KisCrossDeviceColorPicker colorPicker(dev, dab);
+
+    const int pixelSize = dabColorSpace->pixelSize();
+    QVector<quint8> expectedPixel(pixelSize);
+    int numOpaquePixels = 0;
+
+    for (int y = 0; y < dstHeight; y++) {
+        for (int x = 0; x < dstWidth; x++) {
+            const int index = y * dstWidth + x;
+            const quint8 maskValue = mask->data()[index];
+
+            qreal maskX = x - centerX;
+            qreal maskY = y - centerY;
+            forwardRotationMatrix.map(maskX, maskY, &maskX, &maskY);
+            const qreal normX = maskX * majorAxis;
+            const qreal normY = maskY * minorAxis;
+            const qreal distance = normX * normX + normY * normY;
+
+            if (distance > 1.0) {
+                QCOMPARE(maskValue, OPACITY_TRANSPARENT_U8);
+                continue;
+            }
+
+            QCOMPARE(maskValue, OPACITY_OPAQUE_U8);
+            numOpaquePixels++;
+
+            swirl.transform(&maskX, &maskY, distance);
+            reverseRotationMatrix.map(maskX, maskY, &maskX, &maskY);
+
+            maskX += pos.x();
+            maskY += pos.y();
+
+            if (!useBilinear) {
+                maskX = qRound(maskX);
+                maskY = qRound(maskY);
+            }
+
+            if (useOldData) {
+                colorPicker.pickOldColor(maskX, maskY, expectedPixel.data());
+            } else {
+                colorPicker.pickColor(maskX, maskY, expectedPixel.data());
+            }
+
+            const quint8 *dabPixel = dab->data() + index * pixelSize;
+            if (memcmp(dabPixel, expectedPixel.constData(), pixelSize) != 0) {
+                QFAIL(QString("Dab pixel (%1, %2) differs from the picked color").arg(x).arg(y).toLatin1());
+            }
+        }
+    }
+
+    QVERIFY(numOpaquePixels > 0);
+}
+
+}
+
+void KisDeformBrushTest::testOldData()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    testPaintMaskImpl(cs, cs, true, true);
+}
+
+void KisDeformBrushTest::testBilinear()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    testPaintMaskImpl(cs, cs, false, true);
+}
+
+void KisDeformBrushTest::testNearest()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    testPaintMaskImpl(cs, cs, false, false);
+}
+
+void KisDeformBrushTest::testBilinearColorConversion()
+{
+    const KoColorSpace *srcColorSpace = KoColorSpaceRegistry::instance()->rgb16();
+    const KoColorSpace *dabColorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    testPaintMaskImpl(srcColorSpace, dabColorSpace, false, true);
+}
+
+QTEST_MAIN(KisDeformBrushTest)
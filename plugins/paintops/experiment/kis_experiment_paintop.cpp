@@ -78,11 +78,20 @@ void KisExperimentPaintOp::paintRegion(const QRegion &changedRegion)
         m_path.setFillRule(Qt::WindingFill);
     }
 
+    /**
+     * The displacement moves every point of the path, so its edges
+     * should be regenerated. Otherwise the path only grows and the new
+     * edges have already been appended in paintLine().
+     */
+    if (m_displaceEnabled) {
+        m_pathEdges.reset(m_path);
+    }
+
     if (m_useMirroring) {
         m_originalPainter->setAntiAliasPolygonFill(!m_hardEdge);
 
         Q_FOREACH (const QRect & rect, changedRegion.rects()) {
-            m_originalPainter->fillPainterPath(m_path, rect);
+            m_originalPainter->fillPainterPath(m_pathEdges.clippedPath(rect, m_path.fillRule()), rect);
             painter()->renderDabWithMirroringNonIncremental(rect, m_originalDevice);
         }
     }
@@ -92,7 +101,7 @@ void KisExperimentPaintOp::paintRegion(const QRegion &changedRegion)
         painter()->setAntiAliasPolygonFill(!m_hardEdge);
 
         Q_FOREACH (const QRect & rect, changedRegion.rects()) {
-            painter()->fillPainterPath(m_path, rect);
+            painter()->fillPainterPath(m_pathEdges.clippedPath(rect, m_path.fillRule()), rect);
         }
     }
 }
@@ -126,6 +135,8 @@ void KisExperimentPaintOp::paintLine(const KisPaintInformation &pi1, const KisPa
         m_path.moveTo(pi1.pos());
         m_path.lineTo(pi2.pos());
 
+        m_pathEdges.reset(m_path);
+
         m_center = pi1.pos();
 
         m_savedUpdateDistance = 0;
@@ -163,6 +174,9 @@ void KisExperimentPaintOp::paintLine(const KisPaintInformation &pi1, const KisPa
                 m_savedPoints << pt;
 
                 m_path.quadTo(m_savedSmoothingPoint, pt);
+                if (!m_displaceEnabled) {
+                    m_pathEdges.quadTo(m_savedSmoothingPoint, pt);
+                }
                 m_savedSmoothingPoint = pos2;
 
                 m_savedSmoothingDistance = 0;
@@ -170,6 +184,9 @@ void KisExperimentPaintOp::paintLine(const KisPaintInformation &pi1, const KisPa
         }
         else {
             m_path.lineTo(pos2);
+            if (!m_displaceEnabled) {
+                m_pathEdges.lineTo(pos2);
+            }
             m_savedPoints << pos1;
             m_savedPoints << pos2;
         }
@@ -25,6 +25,7 @@
 
 #include "kis_experiment_paintop_settings.h"
 #include "kis_experimentop_option.h"
+#include "kis_path_edge_grid.h"
 
 class QPointF;
 class KisPainter;
@@ -80,6 +81,7 @@ private:
     QPointF m_center;
 
     QPainterPath m_path;
+    KisPathEdgeGrid m_pathEdges;
     ExperimentOption m_experimentOption;
 
     bool m_useMirroring;
@@ -0,0 +1,310 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_path_edge_grid.h"
+
+#include <QPolygonF>
+#include <QRect>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+/**
+ * The size of a cell of the grid, the same as the size of the tiles of
+ * a paint device
+ */
+const int cellSize = 64;
+
+inline int cellIndex(qreal coord)
+{
+    return int(std::floor(coord / cellSize));
+}
+
+/**
+ * Builds the clipped path out of separate pieces of the edges.
+ *
+ * The rasterizer accumulates the coverage of a pixel from the edges
+ * lying to the left of it, so any set of edges can be turned into a
+ * closed path without changing the coverage inside the clip rect: every
+ * chain of contiguous pieces is closed through a vertical line lying to
+ * the right of the rect. The horizontal pieces never change the coverage
+ * and are skipped.
+ */
+class ClippedPathBuilder
+{
+public:
+    ClippedPathBuilder(qreal closingX, Qt::FillRule fillRule)
+        : m_closingX(closingX)
+    {
+        m_path.setFillRule(fillRule);
+    }
+
+    void addSegment(const QPointF &p1, const QPointF &p2) {
+        if (p1.y() == p2.y()) return;
+
+        if (m_chain.isEmpty() || m_chain.last() != p1) {
+            flush();
+            m_chain << p1;
+        }
+
+        m_chain << p2;
+    }
+
+    QPainterPath path() {
+        flush();
+        return m_path;
+    }
+
+private:
+    void flush() {
+        if (m_chain.size() >= 2) {
+            m_chain << QPointF(m_closingX, m_chain.last().y());
+            m_chain << QPointF(m_closingX, m_chain.first().y());
+            m_path.addPolygon(m_chain);
+            m_path.closeSubpath();
+        }
+
+        m_chain.clear();
+    }
+
+private:
+    qreal m_closingX;
+    QPolygonF m_chain;
+    QPainterPath m_path;
+};
+
+/**
+ * Clips the edge by the horizontal band of \p clipRect. The parts lying
+ * to the left of the rect are projected onto its left border, the parts
+ * lying to the right of it are dropped. Neither of them changes the
+ * coverage inside the rect.
+ */
+void clipEdge(const QPointF &p1, const QPointF &p2, const QRectF &clipRect, ClippedPathBuilder *builder)
+{
+    if (p1.y() == p2.y()) return;
+
+    const qreal dy = p2.y() - p1.y();
+    const qreal tTop = (clipRect.top() - p1.y()) / dy;
+    const qreal tBottom = (clipRect.bottom() - p1.y()) / dy;
+    const qreal tMin = qMax(qreal(0.0), qMin(tTop, tBottom));
+    const qreal tMax = qMin(qreal(1.0), qMax(tTop, tBottom));
+
+    if (tMin >= tMax) return;
+
+    qreal params[4];
+    int numParams = 0;
+
+    params[numParams++] = tMin;
+
+    const qreal dx = p2.x() - p1.x();
+    if (dx != 0.0) {
+        const qreal tLeft = (clipRect.left() - p1.x()) / dx;
+        const qreal tRight = (clipRect.right() - p1.x()) / dx;
+
+        if (tLeft > tMin && tLeft < tMax) {
+            params[numParams++] = tLeft;
+        }
+        if (tRight > tMin && tRight < tMax) {
+            params[numParams++] = tRight;
+        }
+    }
+
+    params[numParams++] = tMax;
+    std::sort(params, params + numParams);
+
+    auto pointAt = [&p1, &p2] (qreal t) {
+        return t == 0.0 ? p1 : t == 1.0 ? p2 : p1 + t * (p2 - p1);
+    };
+
+    for (int i = 0; i < numParams - 1; i++) {
+        const QPointF a = pointAt(params[i]);
+        const QPointF b = pointAt(params[i + 1]);
+        const qreal midX = 0.5 * (a.x() + b.x());
+
+        if (midX < clipRect.left()) {
+            builder->addSegment(QPointF(clipRect.left(), a.y()), QPointF(clipRect.left(), b.y()));
+        } else if (midX <= clipRect.right()) {
+            builder->addSegment(a, b);
+        }
+    }
+}
+
+}
+
+
+KisPathEdgeGrid::KisPathEdgeGrid()
+{
+}
+
+KisPathEdgeGrid::~KisPathEdgeGrid()
+{
+}
+
+void KisPathEdgeGrid::reset(const QPainterPath &path)
+{
+    m_rows.clear();
+    m_closingEdges.clear();
+
+    Q_FOREACH (const QPolygonF &polygon, path.toSubpathPolygons()) {
+        if (polygon.isEmpty()) continue;
+
+        for (int i = 1; i < polygon.size(); i++) {
+            addEdge(polygon[i - 1], polygon[i]);
+        }
+
+        m_closingEdges << QLineF(polygon.last(), polygon.first());
+    }
+}
+
+void KisPathEdgeGrid::lineTo(const QPointF &pt)
+{
+    if (m_closingEdges.isEmpty()) {
+        m_closingEdges << QLineF(pt, pt);
+        return;
+    }
+
+    QLineF &closingEdge = m_closingEdges.last();
+    addEdge(closingEdge.p1(), pt);
+    closingEdge.setP1(pt);
+}
+
+void KisPathEdgeGrid::quadTo(const QPointF &control, const QPointF &end)
+{
+    if (m_closingEdges.isEmpty()) {
+        lineTo(end);
+        return;
+    }
+
+    QPainterPath quad(m_closingEdges.last().p1());
+    quad.quadTo(control, end);
+
+    const QList<QPolygonF> polygons = quad.toSubpathPolygons();
+    if (polygons.isEmpty()) return;
+
+    // the first point is the current end of the path
+    const QPolygonF &polygon = polygons.first();
+    for (int i = 1; i < polygon.size(); i++) {
+        lineTo(polygon[i]);
+    }
+}
+
+void KisPathEdgeGrid::addEdge(const QPointF &p1, const QPointF &p2)
+{
+    if (p1.y() == p2.y()) return;
+
+    /**
+     * Split the edge at the borders of the cells it passes through
+     */
+    QVector<qreal> params;
+    params << 0.0;
+
+    const qreal dy = p2.y() - p1.y();
+    const int lastRow = cellIndex(qMax(p1.y(), p2.y()));
+    for (int row = cellIndex(qMin(p1.y(), p2.y())) + 1; row <= lastRow; row++) {
+        const qreal t = (row * cellSize - p1.y()) / dy;
+        if (t > 0.0 && t < 1.0) {
+            params << t;
+        }
+    }
+
+    const qreal dx = p2.x() - p1.x();
+    if (dx != 0.0) {
+        const int lastColumn = cellIndex(qMax(p1.x(), p2.x()));
+        for (int column = cellIndex(qMin(p1.x(), p2.x())) + 1; column <= lastColumn; column++) {
+            const qreal t = (column * cellSize - p1.x()) / dx;
+            if (t > 0.0 && t < 1.0) {
+                params << t;
+            }
+        }
+    }
+
+    params << 1.0;
+    std::sort(params.begin(), params.end());
+
+    QPointF a = p1;
+
+    for (int i = 1; i < params.size(); i++) {
+        const QPointF b = params[i] == 1.0 ? p2 : p1 + params[i] * (p2 - p1);
+
+        if (a.y() != b.y()) {
+            const QPointF mid = 0.5 * (a + b);
+            addEdgePiece(cellIndex(mid.y()), cellIndex(mid.x()), a, b);
+        }
+
+        a = b;
+    }
+}
+
+void KisPathEdgeGrid::addEdgePiece(int row, int column, const QPointF &p1, const QPointF &p2)
+{
+    Cell &cell = m_rows[row][column];
+    cell.edges << QLineF(p1, p2);
+
+    if (!cell.spans.isEmpty() && cell.spans.last().y2 == p1.y()) {
+        cell.spans.last().y2 = p2.y();
+    } else {
+        VerticalSpan span = {p1.y(), p2.y()};
+        cell.spans << span;
+    }
+}
+
+QPainterPath KisPathEdgeGrid::clippedPath(const QRect &rect, Qt::FillRule fillRule) const
+{
+    /**
+     * The clip rect is a bit bigger than the requested one, so the
+     * antialiasing of the edges inside the rect is not affected by the
+     * clipping.
+     */
+    const QRectF clipRect = QRectF(rect).adjusted(-2, -2, 2, 2);
+
+    ClippedPathBuilder builder(clipRect.right() + 1, fillRule);
+
+    const int lastRow = cellIndex(clipRect.bottom());
+    const int firstColumn = cellIndex(clipRect.left());
+    const int lastColumn = cellIndex(clipRect.right());
+
+    for (int row = cellIndex(clipRect.top()); row <= lastRow; row++) {
+        auto rowIt = m_rows.constFind(row);
+        if (rowIt == m_rows.constEnd()) continue;
+
+        for (auto it = rowIt->constBegin(); it != rowIt->constEnd() && it.key() <= lastColumn; ++it) {
+            const Cell &cell = it.value();
+
+            if (it.key() < firstColumn) {
+                Q_FOREACH (const VerticalSpan &span, cell.spans) {
+                    const qreal y1 = qBound(clipRect.top(), span.y1, clipRect.bottom());
+                    const qreal y2 = qBound(clipRect.top(), span.y2, clipRect.bottom());
+                    builder.addSegment(QPointF(clipRect.left(), y1), QPointF(clipRect.left(), y2));
+                }
+            } else {
+                Q_FOREACH (const QLineF &edge, cell.edges) {
+                    clipEdge(edge.p1(), edge.p2(), clipRect, &builder);
+                }
+            }
+        }
+    }
+
+    Q_FOREACH (const QLineF &edge, m_closingEdges) {
+        clipEdge(edge.p1(), edge.p2(), clipRect, &builder);
+    }
+
+    return builder.path();
+}
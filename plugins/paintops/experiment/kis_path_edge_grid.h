@@ -0,0 +1,98 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_PATH_EDGE_GRID_H
+#define __KIS_PATH_EDGE_GRID_H
+
+#include <QHash>
+#include <QLineF>
+#include <QMap>
+#include <QPainterPath>
+#include <QVector>
+
+class QRect;
+
+/**
+ * The flattened edges of a path, bucketed into the cells of a grid.
+ *
+ * The experiment paintop fills the whole stroke path for every changed
+ * rect. KisPathEdgeGrid lets it build a path that fills the rect the
+ * same way, but consists only of the edges passing through the cells
+ * around the rect, so the cost of a step does not depend on the length
+ * of the stroke.
+ *
+ * The path grows with lineTo() and quadTo(); every subpath is treated
+ * as closed, like QPainter does when filling it.
+ */
+class KisPathEdgeGrid
+{
+public:
+    KisPathEdgeGrid();
+    ~KisPathEdgeGrid();
+
+    /**
+     * Replaces the content of the grid with the flattened \p path
+     */
+    void reset(const QPainterPath &path);
+
+    /**
+     * Extend the last subpath, see QPainterPath::lineTo() and
+     * QPainterPath::quadTo()
+     */
+    void lineTo(const QPointF &pt);
+    void quadTo(const QPointF &control, const QPointF &end);
+
+    /**
+     * Returns a path that, filled with \p fillRule, covers the pixels of
+     * \p rect exactly as the whole path does. Outside the rect the
+     * coverage of the returned path is undefined.
+     */
+    QPainterPath clippedPath(const QRect &rect, Qt::FillRule fillRule) const;
+
+private:
+    /**
+     * A cell keeps the pieces of the edges lying inside it. When the
+     * cell is completely to the left of a rect, each piece affects the
+     * rect only as a vertical segment on its left border, so the
+     * contiguous pieces are also kept merged into such segments.
+     */
+    struct VerticalSpan {
+        qreal y1;
+        qreal y2;
+    };
+
+    struct Cell {
+        QVector<QLineF> edges;
+        QVector<VerticalSpan> spans;
+    };
+
+    void addEdge(const QPointF &p1, const QPointF &p2);
+    void addEdgePiece(int row, int column, const QPointF &p1, const QPointF &p2);
+
+private:
+    QHash<int, QMap<int, Cell>> m_rows;
+
+    /**
+     * The edges implicitly closing every subpath: from its last point to
+     * the first one. They change with every new point of the path, so
+     * they are not bucketed.
+     */
+    QVector<QLineF> m_closingEdges;
+};
+
+#endif /* __KIS_PATH_EDGE_GRID_H */
@@ -0,0 +1,214 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_path_edge_grid_test.h"
+
+#include <QTest>
+
+#include <cmath>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoCompositeOpRegistry.h>
+
+#include <kis_paint_device.h>
+#include <kis_painter.h>
+
+#include "kis_path_edge_grid.h"
+
+namespace {
+
+/**
+ * Builds a self-intersecting spiral stroke the way the experiment
+ * paintop does: the path is started with a line and then only grows
+ */
+void buildStroke(QPainterPath *path, KisPathEdgeGrid *grid)
+{
+    const QPointF center(301.37, 298.71);
+
+    path->moveTo(center);
+    path->lineTo(center + QPointF(41.3, 7.9));
+    grid->reset(*path);
+
+    for (int i = 1; i < 160; i++) {
+        const qreal angle = 0.31 * i;
+        const qreal radius = 40.7 + 1.63 * i + 23.1 * std::sin(0.77 * i);
+        const QPointF pt = center + radius * QPointF(std::cos(angle), std::sin(angle));
+
+        if (i % 5 == 0) {
+            const QPointF control = 0.5 * (path->currentPosition() + pt) + QPointF(17.3, -11.9);
+            path->quadTo(control, pt);
+            grid->quadTo(control, pt);
+        } else {
+            path->lineTo(pt);
+            grid->lineTo(pt);
+        }
+    }
+}
+
+/**
+ * The grid works with the flattened path, so the reference is filled
+ * from the same polygons
+ */
+QPainterPath flattenedPath(const QPainterPath &path, Qt::FillRule fillRule)
+{
+    QPainterPath result;
+    result.setFillRule(fillRule);
+
+    Q_FOREACH (const QPolygonF &polygon, path.toSubpathPolygons()) {
+        result.addPolygon(polygon);
+        result.closeSubpath();
+    }
+
+    return result;
+}
+
+KisPaintDeviceSP fillPath(const QPainterPath &path, bool antialiasing)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    KisPainter painter(dev);
+    painter.setPaintColor(KoColor(Qt::black, cs));
+    painter.setFillStyle(KisPainter::FillStyleForegroundColor);
+    painter.setCompositeOp(COMPOSITE_COPY);
+    painter.setAntiAliasPolygonFill(antialiasing);
+    painter.fillPainterPath(path);
+
+    return dev;
+}
+
+/**
+ * Fills the path rect by rect, like KisExperimentPaintOp::paintRegion()
+ * does, with the rects not aligned to the cells of the grid
+ */
+KisPaintDeviceSP fillClippedPath(const KisPathEdgeGrid &grid, const QRect &bounds,
+                                 Qt::FillRule fillRule, bool antialiasing)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    KisPainter painter(dev);
+    painter.setPaintColor(KoColor(Qt::black, cs));
+    painter.setFillStyle(KisPainter::FillStyleForegroundColor);
+    painter.setCompositeOp(COMPOSITE_COPY);
+    painter.setAntiAliasPolygonFill(antialiasing);
+
+    const int rectWidth = 53;
+    const int rectHeight = 41;
+
+    for (int y = bounds.top(); y <= bounds.bottom(); y += rectHeight) {
+        for (int x = bounds.left(); x <= bounds.right(); x += rectWidth) {
+            const QRect rect(x, y, rectWidth, rectHeight);
+            painter.fillPainterPath(grid.clippedPath(rect, fillRule), rect);
+        }
+    }
+
+    return dev;
+}
+
+/**
+ * The pieces of the clipped edges may differ from the original ones in
+ * the last bits of the coordinates, so the antialiased pixels are
+ * allowed to differ by one level
+ */
+bool compareDevices(KisPaintDeviceSP dev1, KisPaintDeviceSP dev2, int tolerance)
+{
+    const QRect rc = dev1->exactBounds() | dev2->exactBounds();
+    const int pixelSize = dev1->pixelSize();
+
+    QVector<quint8> data1(rc.width() * rc.height() * pixelSize);
+    QVector<quint8> data2(rc.width() * rc.height() * pixelSize);
+    dev1->readBytes(data1.data(), rc);
+    dev2->readBytes(data2.data(), rc);
+
+    for (int i = 0; i < data1.size(); i++) {
+        if (qAbs(int(data1[i]) - int(data2[i])) > tolerance) {
+            const int pixel = i / pixelSize;
+            qDebug() << "Failed compare paint devices:"
+                     << rc.x() + pixel % rc.width() << rc.y() + pixel / rc.width()
+                     << "channel" << i % pixelSize << data1[i] << data2[i];
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void testFillImpl(Qt::FillRule fillRule, bool antialiasing)
+{
+    QPainterPath path;
+    KisPathEdgeGrid grid;
+    buildStroke(&path, &grid);
+
+    const QPainterPath reference = flattenedPath(path, fillRule);
+    const QRect bounds = reference.boundingRect().toAlignedRect().adjusted(-3, -3, 3, 3);
+
+    KisPaintDeviceSP refDev = fillPath(reference, antialiasing);
+    KisPaintDeviceSP dev = fillClippedPath(grid, bounds, fillRule, antialiasing);
+
+    QVERIFY(!refDev->exactBounds().isEmpty());
+    QVERIFY(compareDevices(refDev, dev, antialiasing ? 1 : 0));
+}
+
+}
+
+void KisPathEdgeGridTest::testWindingFill()
+{
+    testFillImpl(Qt::WindingFill, true);
+}
+
+void KisPathEdgeGridTest::testOddEvenFill()
+{
+    testFillImpl(Qt::OddEvenFill, true);
+}
+
+void KisPathEdgeGridTest::testHardEdge()
+{
+    testFillImpl(Qt::WindingFill, false);
+    testFillImpl(Qt::OddEvenFill, false);
+}
+
+void KisPathEdgeGridTest::testReset()
+{
+    /**
+     * The displacement regenerates the edges from a path that may
+     * consist of several subpaths
+     */
+    QPainterPath path;
+    path.addEllipse(QRectF(13.7, 21.3, 211.9, 143.1));
+    path.moveTo(97.1, -31.3);
+    path.lineTo(311.9, 187.3);
+    path.lineTo(-41.3, 203.7);
+    path.addRect(QRectF(131.3, 77.9, 171.1, 98.3));
+
+    KisPathEdgeGrid grid;
+    grid.lineTo(QPointF(1000, 1000));
+    grid.reset(path);
+
+    const QPainterPath reference = flattenedPath(path, Qt::OddEvenFill);
+    const QRect bounds = reference.boundingRect().toAlignedRect().adjusted(-3, -3, 3, 3);
+
+    KisPaintDeviceSP refDev = fillPath(reference, true);
+    KisPaintDeviceSP dev = fillClippedPath(grid, bounds, Qt::OddEvenFill, true);
+
+    QVERIFY(compareDevices(refDev, dev, 1));
+}
+
+QTEST_MAIN(KisPathEdgeGridTest)
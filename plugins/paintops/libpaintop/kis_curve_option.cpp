@@ -200,6 +200,24 @@ void KisCurveOption::replaceSensor(KisDynamicSensorSP s)
 {
     Q_ASSERT(s);
     m_sensorMap[s->sensorType()] = s;
+    rebuildEvaluationPlan();
+}
+
+void KisCurveOption::rebuildEvaluationPlan()
+{
+    m_evaluationPlan.clear();
+    m_evaluationPlan.reserve(m_sensorMap.size());
+
+    Q_FOREACH (KisDynamicSensorSP s, m_sensorMap) {
+        PlanEntry entry;
+        entry.sensor = s.data();
+        entry.kind =
+            s->isAdditive() ? AdditiveSensor :
+            s->isAbsoluteRotation() ? AbsoluteRotationSensor :
+            ScalingSensor;
+
+        m_evaluationPlan.append(entry);
+    }
 }
 
 KisDynamicSensorSP KisCurveOption::sensor(DynamicSensorType sensorType, bool active) const
@@ -311,6 +329,7 @@ void KisCurveOption::setCurve(DynamicSensorType sensorType, bool useSameCurve, c
 
         }
         m_useSameCurve = useSameCurve;
+        rebuildEvaluationPlan();
     }
 }
 
@@ -325,27 +344,38 @@ void KisCurveOption::setValue(qreal value)
     m_value = qBound(m_minValue, value, m_maxValue);
 }
 
+inline void KisCurveOption::evaluatePlan(const KisPaintInformation &info, ValueComponents *components) const
+{
+    const PlanEntry *it = m_evaluationPlan.constData();
+    const PlanEntry *end = it + m_evaluationPlan.size();
+
+    for (; it != end; ++it) {
+        KisDynamicSensor *s = it->sensor;
+        if (!s->isActive()) continue;
+
+        switch (it->kind) {
+        case AdditiveSensor:
+            components->additive += s->transferValue(s->value(info), true);
+            components->hasAdditive = true;
+            break;
+        case AbsoluteRotationSensor:
+            components->absoluteOffset = s->transferValue(s->value(info), false);
+            components->hasAbsoluteOffset = true;
+            break;
+        case ScalingSensor:
+            components->scaling *= s->transferValue(s->value(info), false);
+            components->hasScaling = true;
+            break;
+        }
+    }
+}
+
 KisCurveOption::ValueComponents KisCurveOption::computeValueComponents(const KisPaintInformation& info) const
 {
     ValueComponents components;
 
     if (m_useCurve) {
-        QVector<KisDynamicSensorSP> additiveSensors;
-
-        Q_FOREACH (KisDynamicSensorSP s, m_sensorMap.values()) {
-            if (s->isActive()) {
-                if (s->isAdditive()) {
-                    components.additive += s->parameter(info);
-                    components.hasAdditive = true;
-                } else if (s->isAbsoluteRotation()) {
-                    components.absoluteOffset = s->parameter(info);
-                    components.hasAbsoluteOffset =true;
-                } else {
-                    components.scaling *= s->parameter(info);
-                    components.hasScaling = true;
-                }
-            }
-        }
+        evaluatePlan(info, &components);
     }
 
     if (!m_separateCurveValue) {
@@ -189,11 +189,35 @@ protected:
     QMap<DynamicSensorType, KisDynamicSensorSP> m_sensorMap;
     QMap<DynamicSensorType, KisCubicCurve> m_curveCache;
 
+private:
+    /**
+     * The sensors of m_sensorMap flattened into a plain array together
+     * with the way they are combined. The kind of a sensor never changes,
+     * so it is resolved once here instead of two virtual calls per dab.
+     * The activity of the sensors is still checked on every evaluation,
+     * because the option widgets toggle it on the sensor objects directly.
+     */
+    enum SensorKind {
+        ScalingSensor,
+        AdditiveSensor,
+        AbsoluteRotationSensor
+    };
+
+    struct PlanEntry {
+        KisDynamicSensor *sensor;
+        SensorKind kind;
+    };
+
+    void rebuildEvaluationPlan();
+    inline void evaluatePlan(const KisPaintInformation &info, ValueComponents *components) const;
+
 private:
 
     qreal m_value;
     qreal m_minValue;
     qreal m_maxValue;
+
+    QVector<PlanEntry> m_evaluationPlan;
 };
 
 #endif
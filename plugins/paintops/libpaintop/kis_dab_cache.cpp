@@ -19,6 +19,7 @@
 #include "kis_dab_cache.h"
 
 #include <KoColor.h>
+#include <KoColorSpace.h>
 #include "kis_color_source.h"
 #include "kis_paint_device.h"
 #include "kis_brush.h"
@@ -28,18 +29,21 @@
 #include <kis_precision_option.h>
 #include <kis_fixed_paint_device.h>
 #include <brushengine/kis_paintop.h>
+#include <kis_auto_brush.h>
+#include <kis_global.h>
+#include <kis_update_time_monitor.h>
 
-#include <kundo2command.h>
+#include <cmath>
 
-struct PrecisionValues {
-    qreal angle;
-    qreal sizeFrac;
-    qreal subPixel;
-    qreal softnessFactor;
-};
+#include <QCryptographicHash>
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QtMath>
+
+#include <kundo2command.h>
 
 const qreal eps = 1e-6;
-static const PrecisionValues precisionLevels[] = {
+static const KisDabCache::QuantizationLimits precisionLevels[] = {
     {M_PI / 180, 0.05,   1, 0.01},
     {M_PI / 180, 0.01,   1, 0.01},
     {M_PI / 180,    0,   1, 0.01},
@@ -50,6 +54,7 @@ static const PrecisionValues precisionLevels[] = {
 struct KisDabCache::SavedDabParameters {
     KoColor color;
     qreal angle;
+    qreal ratio;
     int width;
     int height;
     qreal subPixelX;
@@ -58,11 +63,10 @@ struct KisDabCache::SavedDabParameters {
     int index;
     MirrorProperties mirrorProperties;
 
-    bool compare(const SavedDabParameters &rhs, int precisionLevel) const {
-        const PrecisionValues &prec = precisionLevels[precisionLevel];
-
+    bool compare(const SavedDabParameters &rhs, const QuantizationLimits &prec) const {
         return color == rhs.color &&
                qAbs(angle - rhs.angle) <= prec.angle &&
+               qAbs(ratio - rhs.ratio) <= qMax(prec.sizeFrac, eps) &&
                qAbs(width - rhs.width) <= (int)(prec.sizeFrac * width) &&
                qAbs(height - rhs.height) <= (int)(prec.sizeFrac * height) &&
                qAbs(subPixelX - rhs.subPixelX) <= prec.subPixel &&
@@ -74,6 +78,47 @@ struct KisDabCache::SavedDabParameters {
     }
 };
 
+namespace {
+
+/**
+ * Returns the key of the brush for the shared cache or an empty
+ * array if the brush cannot be identified across strokes, e.g. a
+ * temporary brush made from the clipboard
+ */
+QByteArray calculateBrushKey(KisBrushSP brush)
+{
+    // the auto brushes are completely defined by their XML
+    const bool isAutoBrush = dynamic_cast<KisAutoBrush*>(brush.data());
+    const QByteArray md5 = !isAutoBrush ? brush->md5() : QByteArray();
+
+    if (!isAutoBrush && md5.isEmpty()) {
+        return QByteArray();
+    }
+
+    QDomDocument doc;
+    QDomElement e = doc.createElement("Brush");
+    brush->toXML(doc, e);
+    doc.appendChild(e);
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(doc.toByteArray());
+    hash.addData(md5);
+
+    return hash.result();
+}
+
+inline int quantize(qreal value, qreal step)
+{
+    return qRound(value / qMax(step, eps));
+}
+
+inline int quantizeSize(int size, qreal sizeFrac)
+{
+    return sizeFrac > 0 ? qRound(std::log(qreal(size)) / std::log1p(sizeFrac)) : size;
+}
+
+}
+
 struct KisDabCache::Private {
 
     Private(KisBrushSP brush)
@@ -83,10 +128,14 @@ struct KisDabCache::Private {
           textureOption(0),
           precisionOption(0),
           subPixelPrecisionDisabled(false),
-          cachedDabParameters(new SavedDabParameters)
+          hasCustomLimits(false),
+          sharedCache(0),
+          cachedDabParameters(new SavedDabParameters),
+          cachedDabGenerationTime(0)
     {}
-    KisFixedPaintDeviceSP dab;
-    KisFixedPaintDeviceSP dabOriginal;
+    KisFixedPaintDeviceSP cachedDab;
+    KisFixedPaintDeviceSP postprocessedDab;
+    KisFixedPaintDeviceSP uncachedDab;
 
     KisBrushSP brush;
     KisPaintDeviceSP colorSourceDevice;
@@ -97,7 +146,16 @@ struct KisDabCache::Private {
     KisPrecisionOption *precisionOption;
     bool subPixelPrecisionDisabled;
 
+    bool hasCustomLimits;
+    QuantizationLimits customLimits;
+
+    KisDabLruCache *sharedCache;
+    QByteArray brushKey;
+
     SavedDabParameters *cachedDabParameters;
+    qint64 cachedDabGenerationTime;
+
+    Statistics statistics;
 };
 
 
@@ -105,10 +163,19 @@ struct KisDabCache::Private {
 KisDabCache::KisDabCache(KisBrushSP brush)
     : m_d(new Private(brush))
 {
+    m_d->brushKey = calculateBrushKey(brush);
+    if (!m_d->brushKey.isEmpty()) {
+        m_d->sharedCache = KisDabLruCache::instance();
+    }
 }
 
 KisDabCache::~KisDabCache()
 {
+    KisUpdateTimeMonitor::instance()->
+        reportDabCacheStatistics(m_d->statistics.hits,
+                                 m_d->statistics.misses,
+                                 m_d->statistics.savedTime);
+
     delete m_d->cachedDabParameters;
     delete m_d;
 }
@@ -138,6 +205,33 @@ void KisDabCache::disableSubpixelPrecision()
     m_d->subPixelPrecisionDisabled = true;
 }
 
+void KisDabCache::setQuantizationLimits(const QuantizationLimits &limits)
+{
+    m_d->hasCustomLimits = true;
+    m_d->customLimits = limits;
+}
+
+KisDabCache::QuantizationLimits KisDabCache::precisionLevelLimits(int precisionLevel)
+{
+    return precisionLevels[qBound(1, precisionLevel, 5) - 1];
+}
+
+void KisDabCache::setSharedCache(KisDabLruCache *cache)
+{
+    m_d->sharedCache = !m_d->brushKey.isEmpty() ? cache : 0;
+}
+
+KisDabCache::Statistics KisDabCache::statistics() const
+{
+    return m_d->statistics;
+}
+
+inline KisDabCache::QuantizationLimits KisDabCache::currentLimits() const
+{
+    return m_d->hasCustomLimits ? m_d->customLimits :
+        precisionLevelLimits(m_d->precisionOption ? m_d->precisionOption->precisionLevel() : 4);
+}
+
 inline KisDabCache::SavedDabParameters
 KisDabCache::getDabParameters(const KoColor& color,
                               KisDabShape const& shape,
@@ -150,6 +244,7 @@ KisDabCache::getDabParameters(const KoColor& color,
 
     params.color = color;
     params.angle = shape.rotation();
+    params.ratio = shape.ratio();
     params.width = m_d->brush->maskWidth(shape, subPixelX, subPixelY, info);
     params.height = m_d->brush->maskHeight(shape, subPixelX, subPixelY, info);
     params.subPixelX = subPixelX;
@@ -226,26 +321,79 @@ QRect KisDabCache::correctDabRectWhenFetchedFromCache(const QRect &dabRect,
 
 inline
 KisFixedPaintDeviceSP KisDabCache::tryFetchFromCache(const SavedDabParameters &params,
-        const KisPaintInformation& info,
-        QRect *dstDabRect)
+        const KoColorSpace *cs,
+        const QuantizationLimits &limits,
+        qint64 *generationTime)
 {
-    int precisionLevel = m_d->precisionOption ? m_d->precisionOption->precisionLevel() - 1 : 3;
+    if (m_d->cachedDab &&
+        *m_d->cachedDab->colorSpace() == *cs &&
+        params.compare(*m_d->cachedDabParameters, limits)) {
 
-    if (!params.compare(*m_d->cachedDabParameters, precisionLevel)) {
-        return 0;
+        *generationTime = m_d->cachedDabGenerationTime;
+        return m_d->cachedDab;
     }
 
-    if (needSeparateOriginal()) {
-        *m_d->dab = *m_d->dabOriginal;
-        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, m_d->dab->bounds().size());
-        postProcessDab(m_d->dab, dstDabRect->topLeft(), info);
+    if (!m_d->sharedCache) return 0;
+
+    KisFixedPaintDeviceSP dab =
+        m_d->sharedCache->fetch(sharedCacheKey(params, cs, limits), generationTime);
+
+    if (dab) {
+        m_d->cachedDab = dab;
+        *m_d->cachedDabParameters = params;
+        m_d->cachedDabGenerationTime = *generationTime;
     }
-    else {
-        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, m_d->dab->bounds().size());
+
+    return dab;
+}
+
+inline
+KisDabLruCache::Key KisDabCache::sharedCacheKey(const SavedDabParameters &params,
+                                                const KoColorSpace *cs,
+                                                const QuantizationLimits &limits) const
+{
+    KisDabLruCache::Key key;
+
+    key.brushKey = m_d->brushKey;
+    key.colorSpace = cs;
+    key.color = QByteArray(reinterpret_cast<const char*>(params.color.data()),
+                           params.color.colorSpace()->pixelSize());
+    key.width = quantizeSize(params.width, limits.sizeFrac);
+    key.height = quantizeSize(params.height, limits.sizeFrac);
+    key.angle = quantize(normalizeAngle(params.angle), limits.angle);
+    key.ratio = quantize(params.ratio, limits.sizeFrac);
+    key.softness = quantize(params.softnessFactor, limits.softnessFactor);
+    key.subPixelX = qFloor(params.subPixelX / qMax(limits.subPixel, eps));
+    key.subPixelY = qFloor(params.subPixelY / qMax(limits.subPixel, eps));
+    key.brushIndex = params.index;
+    key.horizontalMirror = params.mirrorProperties.horizontalMirror;
+    key.verticalMirror = params.mirrorProperties.verticalMirror;
+
+    return key;
+}
+
+inline
+KisFixedPaintDeviceSP KisDabCache::finishDab(KisFixedPaintDeviceSP dab,
+                                             const KoColorSpace *cs,
+                                             const QPoint &dabTopLeft,
+                                             const KisPaintInformation& info)
+{
+    /**
+     * The cached dabs are shared, so the postprocessing
+     * is done on a separate copy
+     */
+    if (needSeparateOriginal()) {
+        if (!m_d->postprocessedDab || *m_d->postprocessedDab->colorSpace() != *cs) {
+            m_d->postprocessedDab = new KisFixedPaintDevice(cs);
+        }
+
+        *m_d->postprocessedDab = *dab;
+        postProcessDab(m_d->postprocessedDab, dabTopLeft, info);
+
+        return m_d->postprocessedDab;
     }
 
-    m_d->brush->notifyCachedDabPainted(info);
-    return m_d->dab;
+    return dab;
 }
 
 qreal positiveFraction(qreal x) {
@@ -342,34 +490,80 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
     KoColor paintColor = colorSource && colorSource->isUniformColor() ?
                          colorSource->uniformColor() : color;
 
-    SavedDabParameters newParams = getDabParameters(paintColor,
-                                   shape, info,
-                                   position.subPixel.x(),
-                                   position.subPixel.y(),
-                                   softnessFactor,
-                                   mirrorProperties);
+    const bool isImageBrush =
+        m_d->brush->brushType() == IMAGE ||
+        m_d->brush->brushType() == PIPE_IMAGE;
 
-    if (!m_d->dab || *m_d->dab->colorSpace() != *cs) {
-        m_d->dab = new KisFixedPaintDevice(cs);
-    }
-    else if (cachingIsPossible) {
-        KisFixedPaintDeviceSP cachedDab =
-            tryFetchFromCache(newParams, info, dstDabRect);
+    if (cachingIsPossible && !isImageBrush) {
+        SavedDabParameters newParams = getDabParameters(paintColor,
+                                       shape, info,
+                                       position.subPixel.x(),
+                                       position.subPixel.y(),
+                                       softnessFactor,
+                                       mirrorProperties);
 
-        if (cachedDab) return cachedDab;
-    }
+        const QuantizationLimits limits = currentLimits();
 
-    if (m_d->brush->brushType() == IMAGE || m_d->brush->brushType() == PIPE_IMAGE) {
-        m_d->dab = m_d->brush->paintDevice(cs, shape, info,
-                                           position.subPixel.x(),
-                                           position.subPixel.y());
-    }
-    else if (cachingIsPossible) {
-        *m_d->cachedDabParameters = newParams;
-        m_d->brush->mask(m_d->dab, paintColor, shape,
+        qint64 generationTime = 0;
+        KisFixedPaintDeviceSP dab =
+            tryFetchFromCache(newParams, cs, limits, &generationTime);
+
+        if (dab) {
+            m_d->statistics.hits++;
+            m_d->statistics.savedTime += generationTime;
+
+            *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, dab->bounds().size());
+            m_d->brush->notifyCachedDabPainted(info);
+
+            return finishDab(dab, cs, dstDabRect->topLeft(), info);
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        /**
+         * Without the shared cache nobody else keeps the last dab,
+         * so its buffer can be reused
+         */
+        if (!m_d->sharedCache && m_d->cachedDab &&
+            *m_d->cachedDab->colorSpace() == *cs) {
+
+            dab = m_d->cachedDab;
+        } else {
+            dab = new KisFixedPaintDevice(cs);
+        }
+
+        m_d->brush->mask(dab, paintColor, shape,
                          info,
                          position.subPixel.x(), position.subPixel.y(),
                          softnessFactor);
+
+        if (!mirrorProperties.isEmpty()) {
+            dab->mirror(mirrorProperties.horizontalMirror,
+                        mirrorProperties.verticalMirror);
+        }
+
+        generationTime = timer.nsecsElapsed();
+        m_d->statistics.misses++;
+
+        m_d->cachedDab = dab;
+        *m_d->cachedDabParameters = newParams;
+        m_d->cachedDabGenerationTime = generationTime;
+
+        if (m_d->sharedCache) {
+            m_d->sharedCache->insert(sharedCacheKey(newParams, cs, limits),
+                                     dab, generationTime);
+        }
+
+        return finishDab(dab, cs, position.rect.topLeft(), info);
+    }
+
+    KisFixedPaintDeviceSP dab;
+
+    if (isImageBrush) {
+        dab = m_d->brush->paintDevice(cs, shape, info,
+                                      position.subPixel.x(),
+                                      position.subPixel.y());
     }
     else {
         if (!m_d->colorSourceDevice || *cs != *m_d->colorSourceDevice->colorSpace()) {
@@ -383,28 +577,26 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
         colorSource->colorize(m_d->colorSourceDevice, maskRect, info.pos().toPoint());
         delete m_d->colorSourceDevice->convertTo(cs);
 
-        m_d->brush->mask(m_d->dab, m_d->colorSourceDevice, shape,
+        if (!m_d->uncachedDab || *m_d->uncachedDab->colorSpace() != *cs) {
+            m_d->uncachedDab = new KisFixedPaintDevice(cs);
+        }
+
+        dab = m_d->uncachedDab;
+
+        m_d->brush->mask(dab, m_d->colorSourceDevice, shape,
                          info,
                          position.subPixel.x(), position.subPixel.y(),
                          softnessFactor);
     }
 
     if (!mirrorProperties.isEmpty()) {
-        m_d->dab->mirror(mirrorProperties.horizontalMirror,
-                         mirrorProperties.verticalMirror);
-    }
-
-    if (needSeparateOriginal()) {
-        if (!m_d->dabOriginal || *cs != *m_d->dabOriginal->colorSpace()) {
-            m_d->dabOriginal = new KisFixedPaintDevice(cs);
-        }
-
-        *m_d->dabOriginal = *m_d->dab;
+        dab->mirror(mirrorProperties.horizontalMirror,
+                    mirrorProperties.verticalMirror);
     }
 
-    postProcessDab(m_d->dab, position.rect.topLeft(), info);
+    postProcessDab(dab, position.rect.topLeft(), info);
 
-    return m_d->dab;
+    return dab;
 }
 
 void KisDabCache::postProcessDab(KisFixedPaintDeviceSP dab,
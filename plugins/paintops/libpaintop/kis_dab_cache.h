@@ -21,6 +21,7 @@
 
 #include "kritapaintop_export.h"
 #include "kis_brush.h"
+#include "kis_dab_lru_cache.h"
 
 class KisColorSource;
 class KisPressureSharpnessOption;
@@ -48,9 +49,40 @@ struct MirrorProperties;
  *  level.
  *
  *  The texturing and mirroring problems are solved.
+ *
+ *  Besides the last dab, the dabs are looked up in KisDabLruCache, which
+ *  is shared by all the paintops. The parameters of the dab are quantized
+ *  with the limits of the current precision level, so the dabs that differ
+ *  less than the limits share one entry. It lets the cache work when the
+ *  pressure goes up and down and in the next strokes of the same brush.
  */
 class PAINTOP_EXPORT KisDabCache
 {
+public:
+    /**
+     * The maximum difference between the requested dab and
+     * the dab taken from the cache
+     */
+    struct QuantizationLimits {
+        qreal angle;
+        qreal sizeFrac;
+        qreal subPixel;
+        qreal softnessFactor;
+    };
+
+    struct Statistics {
+        Statistics() : hits(0), misses(0), savedTime(0) {}
+
+        int hits;
+        int misses;
+
+        /**
+         * The time the hits would have spent generating the dabs,
+         * in nanoseconds
+         */
+        qint64 savedTime;
+    };
+
 public:
     KisDabCache(KisBrushSP brush);
     ~KisDabCache();
@@ -68,6 +100,25 @@ public:
      */
     void disableSubpixelPrecision();
 
+    /**
+     * Overrides the limits of the precision option
+     */
+    void setQuantizationLimits(const QuantizationLimits &limits);
+
+    /**
+     * The limits used for the precision level \p precisionLevel (1...5)
+     */
+    static QuantizationLimits precisionLevelLimits(int precisionLevel);
+
+    /**
+     * Sets the cache shared with the other strokes, null disables the
+     * sharing. By default it is KisDabLruCache::instance() for the brushes
+     * that can be identified across strokes and null for the others.
+     */
+    void setSharedCache(KisDabLruCache *cache);
+
+    Statistics statistics() const;
+
     bool needSeparateOriginal();
 
     KisFixedPaintDeviceSP fetchDab(const KoColorSpace *cs,
@@ -107,9 +158,21 @@ private:
     QRect correctDabRectWhenFetchedFromCache(const QRect &dabRect,
             const QSize &realDabSize);
 
+    inline QuantizationLimits currentLimits() const;
+
     inline KisFixedPaintDeviceSP tryFetchFromCache(const SavedDabParameters &params,
-            const KisPaintInformation& info,
-            QRect *dstDabRect);
+            const KoColorSpace *cs,
+            const QuantizationLimits &limits,
+            qint64 *generationTime);
+
+    inline KisDabLruCache::Key sharedCacheKey(const SavedDabParameters &params,
+                                              const KoColorSpace *cs,
+                                              const QuantizationLimits &limits) const;
+
+    inline KisFixedPaintDeviceSP finishDab(KisFixedPaintDeviceSP dab,
+                                           const KoColorSpace *cs,
+                                           const QPoint &dabTopLeft,
+                                           const KisPaintInformation& info);
 
     inline KisFixedPaintDeviceSP fetchDabCommon(const KoColorSpace *cs,
             const KisColorSource *colorSource,
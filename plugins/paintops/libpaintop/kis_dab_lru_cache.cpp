@@ -0,0 +1,219 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_dab_lru_cache.h"
+
+#include <list>
+
+#include <QGlobalStatic>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <kis_fixed_paint_device.h>
+#include <kis_image_config.h>
+
+Q_GLOBAL_STATIC(KisDabLruCache, s_instance)
+
+
+KisDabLruCache::Key::Key()
+    : colorSpace(0),
+      width(0),
+      height(0),
+      angle(0),
+      ratio(0),
+      softness(0),
+      subPixelX(0),
+      subPixelY(0),
+      brushIndex(0),
+      horizontalMirror(false),
+      verticalMirror(false)
+{
+}
+
+bool KisDabLruCache::Key::operator==(const Key &rhs) const
+{
+    return width == rhs.width &&
+        height == rhs.height &&
+        angle == rhs.angle &&
+        ratio == rhs.ratio &&
+        softness == rhs.softness &&
+        subPixelX == rhs.subPixelX &&
+        subPixelY == rhs.subPixelY &&
+        brushIndex == rhs.brushIndex &&
+        horizontalMirror == rhs.horizontalMirror &&
+        verticalMirror == rhs.verticalMirror &&
+        colorSpace == rhs.colorSpace &&
+        color == rhs.color &&
+        brushKey == rhs.brushKey;
+}
+
+uint qHash(const KisDabLruCache::Key &key, uint seed)
+{
+    uint hash = qHash(key.brushKey, seed);
+
+    hash ^= qHash(key.color, seed) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= qHash(quintptr(key.colorSpace), seed) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+    const int values[] = {key.width, key.height, key.angle, key.ratio,
+                          key.softness, key.subPixelX, key.subPixelY,
+                          key.brushIndex,
+                          (int(key.horizontalMirror) << 1) | int(key.verticalMirror)};
+
+    for (uint i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        hash ^= qHash(values[i], seed) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+
+    return hash;
+}
+
+namespace {
+
+struct Entry {
+    KisDabLruCache::Key key;
+    KisFixedPaintDeviceSP dab;
+    qint64 generationTime;
+    qint64 size;
+};
+
+typedef std::list<Entry> EntryList;
+
+}
+
+struct KisDabLruCache::Private
+{
+    // the most recently used entries are in the front
+    EntryList entries;
+    QHash<Key, EntryList::iterator> index;
+
+    qint64 memoryLimit = 0;
+    qint64 memoryUsage = 0;
+
+    mutable QMutex mutex;
+
+    void evict();
+};
+
+void KisDabLruCache::Private::evict()
+{
+    while (memoryUsage > memoryLimit && !entries.empty()) {
+        const Entry &entry = entries.back();
+
+        memoryUsage -= entry.size;
+        index.remove(entry.key);
+        entries.pop_back();
+    }
+}
+
+KisDabLruCache::KisDabLruCache()
+    : m_d(new Private)
+{
+    m_d->memoryLimit = qint64(KisImageConfig(true).dabCacheMemoryLimit()) * 1024 * 1024;
+}
+
+KisDabLruCache::KisDabLruCache(qint64 memoryLimit)
+    : m_d(new Private)
+{
+    m_d->memoryLimit = memoryLimit;
+}
+
+KisDabLruCache::~KisDabLruCache()
+{
+}
+
+KisDabLruCache* KisDabLruCache::instance()
+{
+    return s_instance;
+}
+
+KisFixedPaintDeviceSP KisDabLruCache::fetch(const Key &key, qint64 *generationTime)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    auto it = m_d->index.find(key);
+    if (it == m_d->index.end()) return 0;
+
+    EntryList::iterator entry = it.value();
+
+    // the list iterators stay valid when the element is moved
+    m_d->entries.splice(m_d->entries.begin(), m_d->entries, entry);
+
+    if (generationTime) {
+        *generationTime = entry->generationTime;
+    }
+
+    return entry->dab;
+}
+
+void KisDabLruCache::insert(const Key &key, KisFixedPaintDeviceSP dab, qint64 generationTime)
+{
+    const QRect bounds = dab->bounds();
+    const qint64 size = qint64(bounds.width()) * bounds.height() * dab->pixelSize();
+
+    QMutexLocker l(&m_d->mutex);
+
+    if (size > m_d->memoryLimit) return;
+
+    auto it = m_d->index.find(key);
+    if (it != m_d->index.end()) {
+        m_d->memoryUsage -= it.value()->size;
+        m_d->entries.erase(it.value());
+        m_d->index.erase(it);
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.dab = dab;
+    entry.generationTime = generationTime;
+    entry.size = size;
+
+    m_d->entries.push_front(entry);
+    m_d->index.insert(key, m_d->entries.begin());
+    m_d->memoryUsage += size;
+
+    m_d->evict();
+}
+
+void KisDabLruCache::setMemoryLimit(qint64 bytes)
+{
+    QMutexLocker l(&m_d->mutex);
+
+    m_d->memoryLimit = bytes;
+    m_d->evict();
+}
+
+qint64 KisDabLruCache::memoryUsage() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->memoryUsage;
+}
+
+int KisDabLruCache::numEntries() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->index.size();
+}
+
+void KisDabLruCache::clear()
+{
+    QMutexLocker l(&m_d->mutex);
+
+    m_d->entries.clear();
+    m_d->index.clear();
+    m_d->memoryUsage = 0;
+}
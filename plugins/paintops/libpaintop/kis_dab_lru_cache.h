@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_DAB_LRU_CACHE_H
+#define __KIS_DAB_LRU_CACHE_H
+
+#include <QByteArray>
+#include <QScopedPointer>
+
+#include "kritapaintop_export.h"
+#include "kis_types.h"
+
+class KoColorSpace;
+
+
+/**
+ * A bounded cache of the generated dabs, shared by all the dab caches
+ * of the paintops. The least recently used dabs are dropped when the
+ * memory limit (KisImageConfig::dabCacheMemoryLimit()) is exceeded.
+ *
+ * The cache knows nothing about the precision of the brush. KisDabCache
+ * quantizes the parameters of the dab before building the key, so all
+ * the dabs falling into the same bucket share one cache entry.
+ *
+ * The cached devices are shared, they must never be modified after
+ * they were inserted.
+ */
+class PAINTOP_EXPORT KisDabLruCache
+{
+public:
+    struct Key {
+        Key();
+
+        /**
+         * Identifies the brush, the dabs of the brushes with the same
+         * key are considered to be the same, even if they belong to
+         * different strokes
+         */
+        QByteArray brushKey;
+
+        const KoColorSpace *colorSpace;
+        QByteArray color;
+
+        int width;
+        int height;
+        int angle;
+        int ratio;
+        int softness;
+        int subPixelX;
+        int subPixelY;
+        int brushIndex;
+        bool horizontalMirror;
+        bool verticalMirror;
+
+        bool operator==(const Key &rhs) const;
+    };
+
+public:
+    KisDabLruCache();
+    KisDabLruCache(qint64 memoryLimit);
+    ~KisDabLruCache();
+
+    static KisDabLruCache* instance();
+
+    /**
+     * Returns the dab stored with \p key or null. \p generationTime
+     * receives the time (in nanoseconds) it took to generate the dab.
+     */
+    KisFixedPaintDeviceSP fetch(const Key &key, qint64 *generationTime = 0);
+
+    void insert(const Key &key, KisFixedPaintDeviceSP dab, qint64 generationTime);
+
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryUsage() const;
+    int numEntries() const;
+
+    void clear();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+PAINTOP_EXPORT uint qHash(const KisDabLruCache::Key &key, uint seed = 0);
+
+#endif /* __KIS_DAB_LRU_CACHE_H */
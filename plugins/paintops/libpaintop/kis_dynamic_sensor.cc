@@ -19,7 +19,9 @@
 #include "kis_dynamic_sensor.h"
 #include <QDomElement>
 
-#include "kis_algebra_2d.h"
+#include <algorithm>
+
+#include "kis_assert.h"
 
 #include "sensors/kis_dynamic_sensors.h"
 #include "sensors/kis_dynamic_sensor_distance.h"
@@ -410,30 +412,28 @@ void KisDynamicSensor::fromXML(const QDomElement& e)
     if (!curve_elt.isNull()) {
         m_customCurve = true;
         m_curve.fromString(curve_elt.text());
+        updateCurveLut();
     }
 }
 
 qreal KisDynamicSensor::parameter(const KisPaintInformation& info)
 {
-    const qreal val = value(info);
-    if (m_customCurve) {
-        qreal scaledVal = isAdditive() ? additiveToScaling(val) : val;
+    return transferValue(value(info), isAdditive());
+}
 
-        int offset = qRound(256.0 * qAbs(scaledVal));
-        qreal newValue =  m_curve.floatTransfer(257)[qBound(0, offset, 256)];
-        scaledVal = KisAlgebra2D::copysign(newValue, scaledVal);
+void KisDynamicSensor::updateCurveLut()
+{
+    const QVector<qreal> transfer = m_curve.floatTransfer(CurveLutSize);
+    KIS_SAFE_ASSERT_RECOVER_RETURN(transfer.size() == CurveLutSize);
 
-        return isAdditive() ? scalingToAdditive(scaledVal) : scaledVal;
-    }
-    else {
-        return val;
-    }
+    std::copy(transfer.constBegin(), transfer.constEnd(), m_curveLut);
 }
 
 void KisDynamicSensor::setCurve(const KisCubicCurve& curve)
 {
     m_customCurve = true;
     m_curve = curve;
+    updateCurveLut();
 }
 
 const KisCubicCurve& KisDynamicSensor::curve() const
@@ -197,19 +197,49 @@ public:
         return 0.5 * (1.0 + x);
     }
 
+    /**
+     * Maps the raw value of the sensor through its custom curve. The
+     * curve is flattened into a lookup table when it is set, so the
+     * mapping costs a linear interpolation between two samples.
+     *
+     * @param additive the value of isAdditive() for this sensor,
+     *                 passed by the caller to avoid a virtual call
+     */
+    inline qreal transferValue(qreal val, bool additive) const {
+        if (!m_customCurve) return val;
+
+        qreal scaledVal = additive ? additiveToScaling(val) : val;
+
+        const qreal pos = qMin(qAbs(scaledVal), qreal(1.0)) * (CurveLutSize - 1);
+        const int index = qMin(int(pos), CurveLutSize - 2);
+        const qreal newValue = m_curveLut[index] + (pos - index) * (m_curveLut[index + 1] - m_curveLut[index]);
+
+        scaledVal = scaledVal < 0 ? -newValue : newValue;
+
+        return additive ? scalingToAdditive(scaledVal) : scaledVal;
+    }
+
 protected:
 
     virtual qreal value(const KisPaintInformation& info) = 0;
 
     int m_length;
 
+private:
+    friend class KisCurveOption;
+
+    void updateCurveLut();
+
 private:
 
     Q_DISABLE_COPY(KisDynamicSensor)
 
+    static const int CurveLutSize = 257;
+
     DynamicSensorType m_type;
     bool m_customCurve;
     KisCubicCurve m_curve;
+    qreal m_curveLut[CurveLutSize];
     bool m_active;
 
 };
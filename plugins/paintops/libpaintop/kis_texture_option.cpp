@@ -30,11 +30,16 @@
 #include <QTransform>
 #include <QPainter>
 #include <QBoxLayout>
+#include <QGlobalStatic>
+#include <QMutex>
+#include <QMutexLocker>
 
 #include <klocalizedstring.h>
 
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
+#include <KoChannelInfo.h>
+#include <KoColorModelStandardIds.h>
 
 #include <kis_resource_server_provider.h>
 #include <kis_pattern_chooser.h>
@@ -42,9 +47,7 @@
 #include <kis_multipliers_double_slider_spinbox.h>
 #include <resources/KoPattern.h>
 #include <kis_paint_device.h>
-#include <kis_fill_painter.h>
 #include <kis_painter.h>
-#include <kis_iterator_ng.h>
 #include <kis_fixed_paint_device.h>
 #include <kis_gradient_slider.h>
 #include "kis_embedded_pattern_manager.h"
@@ -270,25 +273,104 @@ void KisTextureOption::resetGUI(KoResource* res)
     m_optionWidget->offsetSliderY->setRange(0, pattern->pattern().height() / 2);
 }
 
+struct KisTextureMask {
+    int width;
+    int height;
+    QVector<quint8> data;
+};
+
+namespace {
+
+#define TEXTURE_MASK_CACHE_MEMORY_LIMIT (32 * 1024 * 1024)
+
+/**
+ * Keeps the masks of the recently used patterns, so that the strokes
+ * of the same preset don't convert and scale the pattern again
+ */
+struct TextureMaskCache {
+    QSharedPointer<const KisTextureMask> fetch(const QByteArray &key) {
+        QMutexLocker l(&lock);
+
+        for (int i = 0; i < masks.size(); i++) {
+            if (masks[i].first == key) {
+                masks.move(i, 0);
+                return masks.first().second;
+            }
+        }
+
+        return QSharedPointer<const KisTextureMask>();
+    }
+
+    void insert(const QByteArray &key, QSharedPointer<const KisTextureMask> mask) {
+        QMutexLocker l(&lock);
+
+        masks.prepend(qMakePair(key, mask));
+        memoryUsage += mask->data.size();
+
+        while (memoryUsage > TEXTURE_MASK_CACHE_MEMORY_LIMIT && masks.size() > 1) {
+            memoryUsage -= masks.last().second->data.size();
+            masks.removeLast();
+        }
+    }
+
+    QMutex lock;
+    QList<QPair<QByteArray, QSharedPointer<const KisTextureMask>>> masks;
+    qint64 memoryUsage = 0;
+};
+
+Q_GLOBAL_STATIC(TextureMaskCache, s_textureMaskCache)
+
+inline int wrapToPattern(int x, int size)
+{
+    x %= size;
+    return x >= 0 ? x : x + size;
+}
+
+/**
+ * The offset of the alpha channel if it is a single byte, then
+ * opacityU8() and setOpacity() just read and write that byte
+ */
+int alphaU8Offset(const KoColorSpace *cs)
+{
+    if (cs->colorDepthId() != Integer8BitsColorDepthID) return -1;
+
+    Q_FOREACH (const KoChannelInfo *channel, cs->channels()) {
+        if (channel->channelType() == KoChannelInfo::ALPHA) {
+            return channel->pos();
+        }
+    }
+
+    return -1;
+}
+
+}
+
 KisTextureProperties::KisTextureProperties(int levelOfDetail)
     : m_pattern(0),
-      m_levelOfDetail(levelOfDetail)
+      m_levelOfDetail(levelOfDetail),
+      m_dabColorSpace(0),
+      m_dabAlphaU8Offset(-1)
 {
 }
 
-void KisTextureProperties::recalculateMask()
+QByteArray KisTextureProperties::maskCacheKey() const
 {
-    if (!m_pattern) return;
+    const QByteArray md5 = m_pattern->md5();
+    if (md5.isEmpty()) return QByteArray();
 
-    m_mask = 0;
+    const qreal scale = m_scale * KisLodTransform::lodToScale(m_levelOfDetail);
 
-    QImage mask = m_pattern->pattern();
-
-    if ((mask.format() != QImage::Format_RGB32) |
-        (mask.format() != QImage::Format_ARGB32)) {
+    return md5 + QString("/%1/%2/%3/%4/%5")
+        .arg(scale, 0, 'g', 12)
+        .arg(m_invert)
+        .arg(m_cutoffLeft)
+        .arg(m_cutoffRight)
+        .arg(m_cutoffPolicy).toLatin1();
+}
 
-        mask = mask.convertToFormat(QImage::Format_ARGB32);
-    }
+QSharedPointer<const KisTextureMask> KisTextureProperties::createMask() const
+{
+    QImage mask = m_pattern->pattern().convertToFormat(QImage::Format_ARGB32);
 
     qreal scale = m_scale * KisLodTransform::lodToScale(m_levelOfDetail);
 
@@ -303,9 +385,13 @@ void KisTextureProperties::recalculateMask()
     int height = mask.height();
 
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->alpha8();
-    m_mask = new KisPaintDevice(cs);
 
-    KisHLineIteratorSP iter = m_mask->createHLineIteratorNG(0, 0, width);
+    KisTextureMask *textureMask = new KisTextureMask();
+    textureMask->width = width;
+    textureMask->height = height;
+    textureMask->data.resize(width * height);
+
+    quint8 *dst = textureMask->data.data();
 
     for (int row = 0; row < height; ++row) {
         for (int col = 0; col < width; ++col) {
@@ -331,15 +417,36 @@ void KisTextureProperties::recalculateMask()
                 maskValue = OPACITY_OPAQUE_F;
             }
 
-            cs->setOpacity(iter->rawData(), maskValue, 1);
-            iter->nextPixel();
+            cs->setOpacity(dst, maskValue, 1);
+            dst++;
         }
-        iter->nextRow();
     }
 
-    m_maskBounds = QRect(0, 0, width, height);
+    return QSharedPointer<const KisTextureMask>(textureMask);
 }
 
+void KisTextureProperties::recalculateMask()
+{
+    m_mask.clear();
+
+    if (!m_pattern) return;
+
+    const QByteArray key = maskCacheKey();
+
+    if (key.isEmpty()) {
+        m_mask = createMask();
+        return;
+    }
+
+    TextureMaskCache *cache = s_textureMaskCache;
+
+    m_mask = cache->fetch(key);
+
+    if (!m_mask) {
+        m_mask = createMask();
+        cache->insert(key, m_mask);
+    }
+}
 
 void KisTextureProperties::fillProperties(const KisPropertiesConfigurationSP setting)
 {
@@ -374,41 +481,69 @@ void KisTextureProperties::fillProperties(const KisPropertiesConfigurationSP set
 
 void KisTextureProperties::apply(KisFixedPaintDeviceSP dab, const QPoint &offset, const KisPaintInformation & info)
 {
-    if (!m_enabled) return;
+    if (!m_enabled || !m_mask || m_mask->data.isEmpty()) return;
 
-    KisPaintDeviceSP fillDevice = new KisPaintDevice(KoColorSpaceRegistry::instance()->alpha8());
-    QRect rect = dab->bounds();
+    const QRect rect = dab->bounds();
+    const int maskWidth = m_mask->width;
+    const int maskHeight = m_mask->height;
 
-    int x = offset.x() % m_maskBounds.width() - m_offsetX;
-    int y = offset.y() % m_maskBounds.height() - m_offsetY;
+    /**
+     * The pattern is tiled over the whole image, find the pixel of
+     * the pattern under the top-left pixel of the dab
+     */
+    const int x = wrapToPattern(offset.x() % maskWidth - m_offsetX, maskWidth);
+    const int y = wrapToPattern(offset.y() % maskHeight - m_offsetY, maskHeight);
 
-    KisFillPainter fillPainter(fillDevice);
-    fillPainter.fillRect(x - 1, y - 1, rect.width() + 2, rect.height() + 2, m_mask, m_maskBounds);
-    fillPainter.end();
+    const qreal pressure = m_strengthOption.apply(info);
+    const int pressureOffset = (1.0 - pressure) * 255;
 
-    qreal pressure = m_strengthOption.apply(info);
+    const KoColorSpace *cs = dab->colorSpace();
+    const int pixelSize = dab->pixelSize();
+
+    if (cs != m_dabColorSpace) {
+        m_dabColorSpace = cs;
+        m_dabAlphaU8Offset = alphaU8Offset(cs);
+    }
+
+    m_maskRow.resize(rect.width());
+    quint8 *maskRow = m_maskRow.data();
     quint8 *dabData = dab->data();
 
-    KisHLineIteratorSP iter = fillDevice->createHLineIteratorNG(x, y, rect.width());
     for (int row = 0; row < rect.height(); ++row) {
-        for (int col = 0; col < rect.width(); ++col) {
-            if (m_texturingMode == MULTIPLY) {
-                dab->colorSpace()->multiplyAlpha(dabData, quint8(*iter->oldRawData() * pressure), 1);
+        const quint8 *patternRow = m_mask->data.constData() + ((y + row) % maskHeight) * maskWidth;
+
+        // the row of the pattern is copied in runs, a run ends where the pattern wraps
+        for (int col = 0, patternX = x; col < rect.width(); patternX = 0) {
+            const int run = qMin(rect.width() - col, maskWidth - patternX);
+            memcpy(maskRow + col, patternRow + patternX, run);
+            col += run;
+        }
+
+        if (m_texturingMode == MULTIPLY) {
+            for (int col = 0; col < rect.width(); ++col) {
+                maskRow[col] = quint8(maskRow[col] * pressure);
             }
-            else {
-                int pressureOffset = (1.0 - pressure) * 255;
 
-                qint16 maskA = *iter->oldRawData() + pressureOffset;
-                quint8 dabA = dab->colorSpace()->opacityU8(dabData);
+            cs->applyAlphaU8Mask(dabData, maskRow, rect.width());
+        }
+        else if (m_dabAlphaU8Offset >= 0) {
+            quint8 *alpha = dabData + m_dabAlphaU8Offset;
 
-                dabA = qMax(0, (qint16)dabA - maskA);
-                dab->colorSpace()->setOpacity(dabData, dabA, 1);
+            for (int col = 0; col < rect.width(); ++col) {
+                *alpha = qMax(0, int(*alpha) - (maskRow[col] + pressureOffset));
+                alpha += pixelSize;
             }
+        }
+        else {
+            quint8 *pixel = dabData;
 
-            iter->nextPixel();
-            dabData += dab->pixelSize();
+            for (int col = 0; col < rect.width(); ++col) {
+                const int dabA = cs->opacityU8(pixel);
+                cs->setOpacity(pixel, quint8(qMax(0, dabA - (maskRow[col] + pressureOffset))), 1);
+                pixel += pixelSize;
+            }
         }
-        iter->nextRow();
+
+        dabData += rect.width() * pixelSize;
     }
 }
-
@@ -28,12 +28,16 @@
 #include "kis_pressure_texture_strength_option.h"
 
 #include <QRect>
+#include <QSharedPointer>
+#include <QVector>
 
 class KisTextureOptionWidget;
 class KoPattern;
 class KoResource;
 class KisPropertiesConfiguration;
 class KisPaintopLodLimitations;
+class KoColorSpace;
+struct KisTextureMask;
 
 class PAINTOP_EXPORT KisTextureOption : public KisPaintOpOption
 {
@@ -95,9 +99,27 @@ private:
 
 private:
     KisPressureTextureStrengthOption m_strengthOption;
-    QRect m_maskBounds; // this can be different from the extent if we mask out too many pixels in a big mask!
-    KisPaintDeviceSP m_mask;
+
+    /**
+     * The pattern converted into the 8-bit mask values and scaled.
+     * The masks are immutable and shared between all the strokes
+     * painted with the same pattern settings.
+     */
+    QSharedPointer<const KisTextureMask> m_mask;
+    QVector<quint8> m_maskRow;
+
+    /**
+     * The color space of the last dab and the offset of its alpha
+     * channel if it is a single byte, -1 otherwise
+     */
+    const KoColorSpace *m_dabColorSpace;
+    int m_dabAlphaU8Offset;
+
+    QByteArray maskCacheKey() const;
+    QSharedPointer<const KisTextureMask> createMask() const;
     void recalculateMask();
+
+    friend class KisTextureOptionTest;
 };
 
 #endif // KIS_TEXTURE_OPTION_H
@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_curve_option_test.h"
+
+#include <QTest>
+
+#include <brushengine/kis_paint_information.h>
+#include <kis_algebra_2d.h>
+
+#include "kis_curve_option.h"
+
+
+namespace {
+
+KisCubicCurve testCurve()
+{
+    QList<QPointF> points;
+    points << QPointF(0.0, 0.0) << QPointF(0.3, 0.7) << QPointF(1.0, 1.0);
+    return KisCubicCurve(points);
+}
+
+/**
+ * The curve mapping as it was done before the lookup table was
+ * introduced: the nearest of the 257 samples of the curve
+ */
+qreal nearestSampleTransfer(const QVector<qreal> &samples, qreal val, bool additive)
+{
+    qreal scaledVal = additive ? KisDynamicSensor::additiveToScaling(val) : val;
+
+    int offset = qRound(256.0 * qAbs(scaledVal));
+    qreal newValue = samples[qBound(0, offset, 256)];
+    scaledVal = KisAlgebra2D::copysign(newValue, scaledVal);
+
+    return additive ? KisDynamicSensor::scalingToAdditive(scaledVal) : scaledVal;
+}
+
+/**
+ * At the sample points the lookup table should give exactly the old
+ * value. In between it interpolates, so it may differ from the nearest
+ * sample by no more than the distance between the two neighbouring ones.
+ */
+void compareToNearestSample(qreal lutValue, const QVector<qreal> &samples, qreal val, bool additive)
+{
+    const qreal scaledVal = additive ? KisDynamicSensor::additiveToScaling(val) : val;
+    const qreal pos = qAbs(scaledVal) * 256;
+    const int index = qMin(int(pos), 255);
+
+    const qreal expected = nearestSampleTransfer(samples, val, additive);
+    const qreal tolerance = pos == qRound(pos) ? 1e-9 :
+        (additive ? 2.0 : 1.0) * qAbs(samples[index + 1] - samples[index]) + 1e-9;
+
+    if (qAbs(lutValue - expected) > tolerance) {
+        qDebug() << "Failed: value" << val << "additive" << additive
+                 << "lut" << lutValue << "nearest sample" << expected;
+        QFAIL("the lookup table differs from the nearest sample");
+    }
+}
+
+}
+
+void KisCurveOptionTest::testCurveLut()
+{
+    const KisCubicCurve curve = testCurve();
+
+    KisDynamicSensorSP sensor = KisDynamicSensor::type2Sensor(PRESSURE);
+    sensor->setCurve(curve);
+
+    for (int i = 0; i <= 1000; i++) {
+        const qreal pressure = qreal(i) / 1000;
+        const qreal value = sensor->parameter(KisPaintInformation(QPointF(), pressure));
+
+        QVERIFY(qAbs(value - curve.value(pressure)) < 1e-3);
+    }
+}
+
+void KisCurveOptionTest::testLutVsNearestSample()
+{
+    const KisCubicCurve curve = testCurve();
+    const QVector<qreal> samples = curve.floatTransfer(257);
+
+    KisDynamicSensorSP sensor = KisDynamicSensor::type2Sensor(PRESSURE);
+    sensor->setCurve(curve);
+
+    Q_FOREACH (bool additive, QList<bool>() << false << true) {
+        // hits every sample point and three points in between
+        for (int i = -1024; i <= 1024; i++) {
+            const qreal val = qreal(i) / 1024;
+            compareToNearestSample(sensor->transferValue(val, additive), samples, val, additive);
+            if (QTest::currentTestFailed()) return;
+        }
+    }
+}
+
+void KisCurveOptionTest::testOptionLutVsNearestSample()
+{
+    const KisCubicCurve curve = testCurve();
+    const QVector<qreal> samples = curve.floatTransfer(257);
+
+    KisCurveOption option("Test", KisPaintOpOption::GENERAL, true, 1.0, 0.0, 1.0);
+    option.setCurve(PRESSURE, true, curve);
+
+    for (int i = 0; i <= 1024; i++) {
+        const qreal pressure = qreal(i) / 1024;
+        const qreal value = option.computeSizeLikeValue(KisPaintInformation(QPointF(), pressure));
+
+        compareToNearestSample(value, samples, pressure, false);
+        if (QTest::currentTestFailed()) return;
+    }
+}
+
+void KisCurveOptionTest::testSensorActivation()
+{
+    KisCurveOption option("Test", KisPaintOpOption::GENERAL, true, 1.0, 0.0, 1.0);
+    const KisPaintInformation info(QPointF(), 0.5, 30.0, 0.0, 0.0);
+
+    QCOMPARE(option.computeSizeLikeValue(info), 0.5);
+
+    /**
+     * The option widgets toggle the sensors directly, the option
+     * should notice that without being told
+     */
+    option.sensor(XTILT, false)->setActive(true);
+    QCOMPARE(option.computeSizeLikeValue(info), 0.25);
+
+    option.sensor(PRESSURE, false)->setActive(false);
+    QCOMPARE(option.computeSizeLikeValue(info), 0.5);
+}
+
+QTEST_MAIN(KisCurveOptionTest)
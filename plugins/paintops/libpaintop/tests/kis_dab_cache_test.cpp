@@ -0,0 +1,176 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_dab_cache_test.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_auto_brush.h>
+#include <kis_circle_mask_generator.h>
+#include <kis_fixed_paint_device.h>
+#include <brushengine/kis_paint_information.h>
+
+#include "kis_dab_cache.h"
+#include "kis_dab_lru_cache.h"
+
+
+KisFixedPaintDeviceSP createDab(int size)
+{
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+    dab->setRect(QRect(0, 0, size, size));
+    dab->initialize();
+    return dab;
+}
+
+KisDabLruCache::Key keyForWidth(int width)
+{
+    KisDabLruCache::Key key;
+    key.brushKey = "test";
+    key.width = width;
+    return key;
+}
+
+void KisDabCacheTest::testLruEviction()
+{
+    // space for three 10x10 RGBA dabs
+    KisDabLruCache cache(3 * 10 * 10 * 4);
+
+    cache.insert(keyForWidth(1), createDab(10), 100);
+    cache.insert(keyForWidth(2), createDab(10), 100);
+    cache.insert(keyForWidth(3), createDab(10), 100);
+
+    QCOMPARE(cache.numEntries(), 3);
+    QCOMPARE(cache.memoryUsage(), qint64(1200));
+
+    // makes the first dab the most recently used one
+    qint64 generationTime = 0;
+    QVERIFY(cache.fetch(keyForWidth(1), &generationTime));
+    QCOMPARE(generationTime, qint64(100));
+
+    cache.insert(keyForWidth(4), createDab(10), 100);
+
+    QCOMPARE(cache.numEntries(), 3);
+    QVERIFY(cache.fetch(keyForWidth(1)));
+    QVERIFY(!cache.fetch(keyForWidth(2)));
+    QVERIFY(cache.fetch(keyForWidth(3)));
+    QVERIFY(cache.fetch(keyForWidth(4)));
+
+    // the dabs bigger than the whole cache are not stored
+    cache.insert(keyForWidth(5), createDab(20), 100);
+    QVERIFY(!cache.fetch(keyForWidth(5)));
+    QCOMPARE(cache.numEntries(), 3);
+
+    cache.setMemoryLimit(10 * 10 * 4);
+    QCOMPARE(cache.numEntries(), 1);
+    QCOMPARE(cache.memoryUsage(), qint64(400));
+}
+
+KisBrushSP createBrush()
+{
+    KisCircleMaskGenerator *generator = new KisCircleMaskGenerator(50, 1.0, 0.5, 0.5, 2, true);
+    return new KisAutoBrush(generator, 0.0, 0.0);
+}
+
+void KisDabCacheTest::testReuseAcrossStrokes()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColor color(Qt::black, cs);
+    const QPointF pos(100, 100);
+
+    KisDabLruCache sharedCache(16 * 1024 * 1024);
+    QRect rect;
+
+    {
+        KisDabCache cache(createBrush());
+        cache.setSharedCache(&sharedCache);
+
+        cache.fetchDab(cs, color, pos, KisDabShape(1.0, 1.0, 0.0), KisPaintInformation(pos), 1.0, &rect);
+        cache.fetchDab(cs, color, pos, KisDabShape(0.5, 1.0, 0.0), KisPaintInformation(pos), 1.0, &rect);
+
+        // the pressure goes back, the first dab is taken from the shared cache
+        cache.fetchDab(cs, color, pos, KisDabShape(1.0, 1.0, 0.0), KisPaintInformation(pos), 1.0, &rect);
+
+        QCOMPARE(cache.statistics().misses, 2);
+        QCOMPARE(cache.statistics().hits, 1);
+    }
+
+    QCOMPARE(sharedCache.numEntries(), 2);
+
+    {
+        // the next stroke with the same brush
+        KisDabCache cache(createBrush());
+        cache.setSharedCache(&sharedCache);
+
+        KisFixedPaintDeviceSP dab =
+            cache.fetchDab(cs, color, pos, KisDabShape(0.5, 1.0, 0.0), KisPaintInformation(pos), 1.0, &rect);
+
+        QCOMPARE(cache.statistics().misses, 0);
+        QCOMPARE(cache.statistics().hits, 1);
+        QCOMPARE(dab->bounds().size(), rect.size());
+    }
+
+    {
+        // another color is another dab
+        KisDabCache cache(createBrush());
+        cache.setSharedCache(&sharedCache);
+
+        cache.fetchDab(cs, KoColor(Qt::red, cs), pos, KisDabShape(0.5, 1.0, 0.0), KisPaintInformation(pos), 1.0, &rect);
+
+        QCOMPARE(cache.statistics().misses, 1);
+        QCOMPARE(cache.statistics().hits, 0);
+    }
+}
+
+void KisDabCacheTest::testQuantizationLimits()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColor color(Qt::black, cs);
+    const QPointF pos(100, 100);
+
+    KisDabLruCache sharedCache(16 * 1024 * 1024);
+    QRect rect;
+
+    KisDabCache cache(createBrush());
+    cache.setSharedCache(&sharedCache);
+
+    KisDabCache::QuantizationLimits limits = KisDabCache::precisionLevelLimits(5);
+    cache.setQuantizationLimits(limits);
+
+    cache.fetchDab(cs, color, pos, KisDabShape(1.0, 1.0, 0.0), KisPaintInformation(pos), 1.0, &rect);
+    cache.fetchDab(cs, color, pos, KisDabShape(1.0, 1.0, 0.1), KisPaintInformation(pos), 1.0, &rect);
+    cache.fetchDab(cs, color, pos, KisDabShape(1.0, 1.0, 0.0), KisPaintInformation(pos), 1.0, &rect);
+
+    QCOMPARE(cache.statistics().misses, 2);
+    QCOMPARE(cache.statistics().hits, 1);
+
+    // with the coarse limits a small rotation is not noticed
+    limits = KisDabCache::precisionLevelLimits(1);
+    limits.angle = 0.2;
+    cache.setQuantizationLimits(limits);
+
+    cache.fetchDab(cs, color, pos, KisDabShape(1.0, 1.0, 0.02), KisPaintInformation(pos), 1.0, &rect);
+
+    QCOMPARE(cache.statistics().misses, 2);
+    QCOMPARE(cache.statistics().hits, 2);
+}
+
+QTEST_MAIN(KisDabCacheTest)
@@ -0,0 +1,250 @@
+/*
+ *  Copyright (c) 2018 Krita developers <kimageshop@kde.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_texture_option_test.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <resources/KoPattern.h>
+
+#include <kis_paint_device.h>
+#include <kis_fill_painter.h>
+#include <kis_fixed_paint_device.h>
+#include <kis_iterator_ng.h>
+#include <kis_algebra_2d.h>
+#include <brushengine/kis_paint_information.h>
+
+#include "kis_texture_option.h"
+
+namespace {
+
+QImage createPatternImage()
+{
+    QImage image(37, 23, QImage::Format_ARGB32);
+
+    for (int y = 0; y < image.height(); y++) {
+        for (int x = 0; x < image.width(); x++) {
+            image.setPixel(x, y, qRgba((x * 29) % 256, (y * 11) % 256, ((x + y) * 17) % 256, 255 - (x * y * 7) % 160));
+        }
+    }
+
+    return image;
+}
+
+KisFixedPaintDeviceSP createDab(const KoColorSpace *cs)
+{
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+    dab->setRect(QRect(0, 0, 61, 47));
+    dab->initialize();
+
+    quint8 *pixel = dab->data();
+
+    for (int y = 0; y < dab->bounds().height(); y++) {
+        for (int x = 0; x < dab->bounds().width(); x++) {
+            const KoColor color(QColor((x * 5) % 256, (y * 3) % 256, 128, 255 - (x + y) % 200), cs);
+            memcpy(pixel, color.data(), cs->pixelSize());
+            pixel += cs->pixelSize();
+        }
+    }
+
+    return dab;
+}
+
+/**
+ * The pattern mask as it was generated before the masks got cached
+ */
+KisPaintDeviceSP createReferenceMask(const QImage &pattern, qreal scale, QRect *maskBounds)
+{
+    QImage mask = pattern.convertToFormat(QImage::Format_ARGB32);
+
+    QTransform tf;
+    tf.scale(scale, scale);
+    QRect rc = KisAlgebra2D::ensureRectNotSmaller(tf.mapRect(mask.rect()), QSize(2,2));
+    mask = mask.scaled(rc.size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    const QRgb* pixel = reinterpret_cast<const QRgb*>(mask.constBits());
+    int width = mask.width();
+    int height = mask.height();
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->alpha8();
+    KisPaintDeviceSP maskDevice = new KisPaintDevice(cs);
+
+    KisHLineIteratorSP iter = maskDevice->createHLineIteratorNG(0, 0, width);
+
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            const QRgb currentPixel = pixel[row * width + col];
+
+            const int red = qRed(currentPixel);
+            const int green = qGreen(currentPixel);
+            const int blue = qBlue(currentPixel);
+            float alpha = qAlpha(currentPixel) / 255.0;
+
+            const int grayValue = (red * 11 + green * 16 + blue * 5) / 32;
+            float maskValue = (grayValue / 255.0) * alpha + (1 - alpha);
+
+            cs->setOpacity(iter->rawData(), maskValue, 1);
+            iter->nextPixel();
+        }
+        iter->nextRow();
+    }
+
+    *maskBounds = QRect(0, 0, width, height);
+    return maskDevice;
+}
+
+/**
+ * The way KisTextureProperties::apply() combined the pattern with the
+ * dab before: the pattern was tiled into a temporary device with
+ * KisFillPainter and the dab was modified pixel by pixel
+ */
+void referenceApply(KisFixedPaintDeviceSP dab, const QPoint &offset,
+                    KisPaintDeviceSP mask, const QRect &maskBounds,
+                    int offsetX, int offsetY,
+                    KisTextureProperties::TexturingMode texturingMode,
+                    qreal pressure)
+{
+    KisPaintDeviceSP fillDevice = new KisPaintDevice(KoColorSpaceRegistry::instance()->alpha8());
+    QRect rect = dab->bounds();
+
+    int x = offset.x() % maskBounds.width() - offsetX;
+    int y = offset.y() % maskBounds.height() - offsetY;
+
+    KisFillPainter fillPainter(fillDevice);
+    fillPainter.fillRect(x - 1, y - 1, rect.width() + 2, rect.height() + 2, mask, maskBounds);
+    fillPainter.end();
+
+    quint8 *dabData = dab->data();
+
+    KisHLineIteratorSP iter = fillDevice->createHLineIteratorNG(x, y, rect.width());
+    for (int row = 0; row < rect.height(); ++row) {
+        for (int col = 0; col < rect.width(); ++col) {
+            if (texturingMode == KisTextureProperties::MULTIPLY) {
+                dab->colorSpace()->multiplyAlpha(dabData, quint8(*iter->oldRawData() * pressure), 1);
+            }
+            else {
+                int pressureOffset = (1.0 - pressure) * 255;
+
+                qint16 maskA = *iter->oldRawData() + pressureOffset;
+                quint8 dabA = dab->colorSpace()->opacityU8(dabData);
+
+                dabA = qMax(0, (qint16)dabA - maskA);
+                dab->colorSpace()->setOpacity(dabData, dabA, 1);
+            }
+
+            iter->nextPixel();
+            dabData += dab->pixelSize();
+        }
+        iter->nextRow();
+    }
+}
+
+}
+
+void KisTextureOptionTest::testApplyImpl(int texturingMode)
+{
+    const QImage patternImage = createPatternImage();
+    KoPattern pattern(patternImage, "test_pattern", QString());
+
+    const qreal scale = 0.75;
+
+    QRect maskBounds;
+    KisPaintDeviceSP referenceMask = createReferenceMask(patternImage, scale, &maskBounds);
+
+    const QVector<const KoColorSpace*> colorSpaces = {
+        KoColorSpaceRegistry::instance()->rgb8(),
+        KoColorSpaceRegistry::instance()->rgb16(),
+        KoColorSpaceRegistry::instance()->lab16()
+    };
+
+    /**
+     * Dab positions on both sides of the origin and far away from it,
+     * so that the pattern wraps inside the dab in every case
+     */
+    const QVector<QPoint> dabOffsets = {
+        QPoint(0, 0),
+        QPoint(13, 7),
+        QPoint(-37, -91),
+        QPoint(-1, 5),
+        QPoint(1003, -517)
+    };
+
+    const QVector<QPoint> patternOffsets = {
+        QPoint(0, 0),
+        QPoint(5, 11),
+        QPoint(40, 30)
+    };
+
+    const QVector<qreal> pressures = {1.0, 0.4};
+
+    Q_FOREACH (const KoColorSpace *cs, colorSpaces) {
+        Q_FOREACH (const QPoint &patternOffset, patternOffsets) {
+            Q_FOREACH (qreal pressure, pressures) {
+                KisTextureProperties properties(0);
+
+                properties.m_enabled = true;
+                properties.m_pattern = &pattern;
+                properties.m_scale = scale;
+                properties.m_offsetX = patternOffset.x();
+                properties.m_offsetY = patternOffset.y();
+                properties.m_texturingMode = KisTextureProperties::TexturingMode(texturingMode);
+                properties.m_invert = false;
+                properties.m_cutoffLeft = 0;
+                properties.m_cutoffRight = 255;
+                properties.m_cutoffPolicy = 0;
+
+                properties.m_strengthOption.setChecked(pressure != 1.0);
+                properties.recalculateMask();
+
+                const KisPaintInformation info(QPointF(), pressure);
+                const qreal strength = properties.m_strengthOption.apply(info);
+
+                Q_FOREACH (const QPoint &dabOffset, dabOffsets) {
+                    KisFixedPaintDeviceSP dab = createDab(cs);
+                    KisFixedPaintDeviceSP referenceDab = new KisFixedPaintDevice(*dab);
+
+                    properties.apply(dab, dabOffset, info);
+                    referenceApply(referenceDab, dabOffset, referenceMask, maskBounds,
+                                   patternOffset.x(), patternOffset.y(),
+                                   KisTextureProperties::TexturingMode(texturingMode), strength);
+
+                    const int numBytes = dab->bounds().width() * dab->bounds().height() * cs->pixelSize();
+                    if (memcmp(dab->data(), referenceDab->data(), numBytes) != 0) {
+                        qDebug() << ppVar(cs->id()) << ppVar(patternOffset) << ppVar(pressure) << ppVar(dabOffset);
+                        QFAIL("The textured dab differs from the reference one");
+                    }
+                }
+            }
+        }
+    }
+}
+
+void KisTextureOptionTest::testMultiply()
+{
+    testApplyImpl(KisTextureProperties::MULTIPLY);
+}
+
+void KisTextureOptionTest::testSubtract()
+{
+    testApplyImpl(KisTextureProperties::SUBTRACT);
+}
+
+QTEST_MAIN(KisTextureOptionTest)
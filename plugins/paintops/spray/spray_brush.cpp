@@ -33,6 +33,7 @@
 
 #include <kis_random_accessor_ng.h>
 #include <kis_random_sub_accessor.h>
+#include <kis_scatter_writer.h>
 
 #include <kis_paint_device.h>
 
@@ -133,7 +134,7 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
 
     qreal x = info.pos().x();
     qreal y = info.pos().y();
-    KisRandomAccessorSP accessor = dab->createRandomAccessorNG(qRound(x), qRound(y));
+    KisScatterWriter writer(dab);
 
     Q_ASSERT(color.colorSpace()->pixelSize() == dab->pixelSize());
     m_inkColor = color;
@@ -291,15 +292,14 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
             }
             // wu-particle
             case 2: {
-                paintParticle(accessor, m_inkColor, nx + x, ny + y);
+                paintParticle(writer, m_inkColor, nx + x, ny + y);
                 break;
             }
             // pixel
             case 3: {
                 ix = qRound(nx + x);
                 iy = qRound(ny + y);
-                accessor->moveTo(ix, iy);
-                memcpy(accessor->rawData(), m_inkColor.data(), m_dabPixelSize);
+                writer.addSample(ix, iy, m_inkColor.data());
                 break;
             }
             case 4: {
@@ -374,13 +374,15 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
             m_inkColor=color;//reset color//
         }
     }
+
+    writer.flush();
     // recover from jittering of color,
     // m_inkColor.opacity is recovered with every paint
 }
 
 
 
-void SprayBrush::paintParticle(KisRandomAccessorSP &writeAccessor, const KoColor &color, qreal rx, qreal ry)
+void SprayBrush::paintParticle(KisScatterWriter &writer, const KoColor &color, qreal rx, qreal ry)
 {
     // opacity top left, right, bottom left, right
     KoColor pcolor(color);
@@ -401,20 +403,16 @@ void SprayBrush::paintParticle(KisRandomAccessorSP &writeAccessor, const KoColor
     // Maybe some kind of compositing using here would be cool
 
     pcolor.setOpacity(btl);
-    writeAccessor->moveTo(ipx  , ipy);
-    memcpy(writeAccessor->rawData(), pcolor.data(), m_dabPixelSize);
+    writer.addSample(ipx, ipy, pcolor.data());
 
     pcolor.setOpacity(btr);
-    writeAccessor->moveTo(ipx + 1, ipy);
-    memcpy(writeAccessor->rawData(), pcolor.data(), m_dabPixelSize);
+    writer.addSample(ipx + 1, ipy, pcolor.data());
 
     pcolor.setOpacity(bbl);
-    writeAccessor->moveTo(ipx, ipy + 1);
-    memcpy(writeAccessor->rawData(), pcolor.data(), m_dabPixelSize);
+    writer.addSample(ipx, ipy + 1, pcolor.data());
 
     pcolor.setOpacity(bbr);
-    writeAccessor->moveTo(ipx + 1, ipy + 1);
-    memcpy(writeAccessor->rawData(), pcolor.data(), m_dabPixelSize);
+    writer.addSample(ipx + 1, ipy + 1, pcolor.data());
 }
 
 void SprayBrush::paintCircle(KisPainter* painter, qreal x, qreal y, qreal radius)
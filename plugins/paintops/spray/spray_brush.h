@@ -35,6 +35,7 @@
 #include <kis_brush.h>
 
 class KisPaintInformation;
+class KisScatterWriter;
 
 class SprayBrush
 {
@@ -77,7 +78,7 @@ private:
     /// rotation in radians according the settings (gauss distribution, uniform distribution or fixed angle)
     qreal rotationAngle(KisRandomSourceSP randomSource);
     /// Paints Wu Particle
-    void paintParticle(KisRandomAccessorSP &writeAccessor, const KoColor &color, qreal rx, qreal ry);
+    void paintParticle(KisScatterWriter &writer, const KoColor &color, qreal rx, qreal ry);
     void paintCircle(KisPainter * painter, qreal x, qreal y, qreal radius);
     void paintEllipse(KisPainter * painter, qreal x, qreal y, qreal a, qreal b, qreal angle);
     void paintRectangle(KisPainter * painter, qreal x, qreal y, qreal width, qreal height, qreal angle);